@@ -0,0 +1,181 @@
+#include "calibration.h"
+#include "storage.h"
+
+//one per scale channel, written by the sampler, the web task only leaves requests and reads status
+struct CalChannel {
+  CalibrationState state;
+  CalibrationError error;
+  float reference_g;
+  bool tared;           //false until there is an offset, stored or measured
+  bool stored;
+  int32_t offset;       //raw counts, a float would round a 24 bit offset to a fraction of its step
+  float residual;       //zero tracking below a whole count, the offset in use is offset + residual
+  float counts_per_gram;
+  int32_t tare_offset;  //offset right after the last tare, drift is measured from it
+  int32_t saved_offset; //offset NVS holds
+  int64_t sum;          //raw counts averaged for a tare or reference
+  uint8_t summed;
+  float creep_g;
+  uint32_t last_ms;
+};
+static portMUX_TYPE cal_lock = portMUX_INITIALIZER_UNLOCKED;
+static CalChannel cals[SCALE_CHANNELS];
+
+//marks the calibration for NVS, caller holds cal_lock and hands *out to storage_set_calibration() once it lets go
+static void save(CalChannel *c, CalibrationData *out) {
+  out->offset = c->offset;
+  out->counts_per_gram = c->counts_per_gram;
+  c->saved_offset = c->offset;
+  c->stored = true;
+}
+
+//loads each channel's stored calibration, a channel without one tares its empty plate from the first CAL_AVERAGE_SAMPLES conversions
+void calibration_init() {
+  for (uint8_t ch = 0; ch < SCALE_CHANNELS; ch++) {
+    CalibrationData data;
+    cals[ch].counts_per_gram = SCALE_CALIBRATION_VAL;
+    if (storage_get_calibration(ch, &data)) {
+      calibration_reset(ch, &data);
+      cals[ch].stored = true;
+    }
+    else {
+      calibration_request_tare(ch);
+    }
+  }
+}
+
+//puts a calibration in place as if it had just been tared, host tests use this to start from known values
+void calibration_reset(uint8_t channel, const CalibrationData *data) {
+  CalChannel *c = &cals[channel];
+  portENTER_CRITICAL(&cal_lock);
+  c->offset = c->tare_offset = c->saved_offset = data->offset;
+  c->residual = 0;
+  c->counts_per_gram = data->counts_per_gram;
+  c->tared = true;
+  c->creep_g = 0;
+  c->state = CAL_IDLE;
+  c->error = CAL_ERR_NONE;
+  portEXIT_CRITICAL(&cal_lock);
+}
+
+//averages the next few conversions of an empty plate into the offset
+bool calibration_request_tare(uint8_t channel) {
+  if (channel >= SCALE_CHANNELS) return false;
+  CalChannel *c = &cals[channel];
+  portENTER_CRITICAL(&cal_lock);
+  bool ok = c->state == CAL_IDLE;
+  if (ok) {
+    c->state = CAL_TARE;
+    c->error = CAL_ERR_NONE;
+    c->sum = 0;
+    c->summed = 0;
+  }
+  portEXIT_CRITICAL(&cal_lock);
+  return ok;
+}
+
+//averages the next few conversions with grams on the plate into the scale factor, needs a tare first
+bool calibration_request_reference(uint8_t channel, float grams) {
+  if (channel >= SCALE_CHANNELS || grams < CAL_MIN_REFERENCE_G) return false;
+  CalChannel *c = &cals[channel];
+  portENTER_CRITICAL(&cal_lock);
+  bool ok = c->state == CAL_IDLE && c->tared;
+  if (ok) {
+    c->state = CAL_REFERENCE;
+    c->error = CAL_ERR_NONE;
+    c->reference_g = grams;
+    c->sum = 0;
+    c->summed = 0;
+  }
+  portEXIT_CRITICAL(&cal_lock);
+  return ok;
+}
+
+//an average finished, puts it to use, returns whether *out has a calibration to write
+static bool finish_average(CalChannel *c, CalibrationData *out) {
+  CalibrationState state = c->state;
+  c->state = CAL_IDLE;
+  if (state == CAL_TARE) {
+    //rounded, summed counts stay exact in 64 bits
+    int64_t half = (c->sum < 0) ? -(int64_t)c->summed / 2 : (int64_t)c->summed / 2;
+    c->offset = c->tare_offset = (int32_t)((c->sum + half) / c->summed);
+    c->residual = 0;
+    c->tared = true;
+    c->creep_g = 0;
+    save(c, out);
+    return true;
+  }
+
+  float delta = (float)(c->sum - (int64_t)c->offset * c->summed) / c->summed - c->residual;
+  //the old factor is roughly right even when it is the default, so it tells an empty plate or a reversed load apart
+  float grams = delta / c->counts_per_gram;
+  if (grams <= -CAL_MIN_REFERENCE_READ_G) c->error = CAL_ERR_WRONG_SIGN;
+  else if (grams < CAL_MIN_REFERENCE_READ_G) c->error = CAL_ERR_NO_LOAD;
+  if (c->error != CAL_ERR_NONE) return false;
+  c->counts_per_gram = delta / c->reference_g;
+  save(c, out);
+  return true;
+}
+
+//raw conversion to grams, only the sampler calls this, 0 until the channel's first tare finishes
+float calibration_apply(uint8_t channel, int32_t raw, uint32_t now_ms) {
+  CalChannel *c = &cals[channel];
+  CalibrationData data;
+  bool finished = false;
+  portENTER_CRITICAL(&cal_lock);
+  if (c->state != CAL_IDLE) {
+    c->sum += raw;
+    if (++c->summed >= CAL_AVERAGE_SAMPLES) finished = finish_average(c, &data);
+  }
+  if (!c->tared) {
+    c->last_ms = now_ms;
+    portEXIT_CRITICAL(&cal_lock);
+    return 0;
+  }
+  float grams = ((float)(raw - c->offset) - c->residual) / c->counts_per_gram;
+
+  //creep follows the load with a first order lag, the same lag brings it back once the load comes off
+  float dt = now_ms - c->last_ms;
+  float k = (dt < CAL_CREEP_TAU_MS) ? dt / CAL_CREEP_TAU_MS : 1;
+  float load = (grams > 0) ? grams - c->creep_g : 0;
+  c->creep_g += (load * CAL_CREEP_RATIO - c->creep_g) * k;
+  c->last_ms = now_ms;
+  grams -= c->creep_g;
+  portEXIT_CRITICAL(&cal_lock);
+  if (finished) storage_set_calibration(channel, &data);
+  return grams;
+}
+
+//folds slow zero drift into the offset while the plate sits empty and settled, only the sampler calls this
+//a bottle is far outside the band, so sips are never tracked away
+void calibration_track(uint8_t channel, float filtered, bool stable) {
+  if (!stable || fabsf(filtered) >= CAL_ZERO_BAND_G) return;
+  CalChannel *c = &cals[channel];
+  CalibrationData data;
+  bool moved = false;
+  portENTER_CRITICAL(&cal_lock);
+  if (c->state == CAL_IDLE && c->tared) {
+    //whole counts go into the offset, the rest waits in the residual
+    c->residual += filtered * c->counts_per_gram * CAL_ZERO_ALPHA;
+    int32_t whole = (int32_t)c->residual;
+    c->offset += whole;
+    c->residual -= whole;
+    moved = c->stored && fabsf((float)(c->offset - c->saved_offset) + c->residual) >= CAL_ZERO_SAVE_G * fabsf(c->counts_per_gram);
+    if (moved) save(c, &data);
+  }
+  portEXIT_CRITICAL(&cal_lock);
+  if (moved) storage_set_calibration(channel, &data);
+}
+
+void calibration_get_status(uint8_t channel, CalibrationStatus *out) {
+  const CalChannel *c = &cals[channel];
+  portENTER_CRITICAL(&cal_lock);
+  out->state = c->state;
+  out->error = c->error;
+  out->stored = c->stored;
+  out->data.offset = c->offset;
+  out->data.counts_per_gram = c->counts_per_gram;
+  out->zero_drift_g = c->tared ? ((float)(c->offset - c->tare_offset) + c->residual) / c->counts_per_gram : 0;
+  out->creep_g = c->creep_g;
+  portEXIT_CRITICAL(&cal_lock);
+}
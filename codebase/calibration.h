@@ -0,0 +1,18 @@
+#ifndef CALIBRATION_H
+#define CALIBRATION_H
+
+#include <Arduino.h>
+#include "config.h"
+
+//turns raw HX711 counts into grams: offset and scale factor from NVS, zero drift tracking and creep compensation
+//every scale channel is calibrated on its own
+
+void calibration_init();
+float calibration_apply(uint8_t channel, int32_t raw, uint32_t now_ms);
+void calibration_track(uint8_t channel, float filtered, bool stable);
+void calibration_reset(uint8_t channel, const CalibrationData *data);
+bool calibration_request_tare(uint8_t channel);
+bool calibration_request_reference(uint8_t channel, float grams);
+void calibration_get_status(uint8_t channel, CalibrationStatus *out);
+
+#endif // CALIBRATION_H
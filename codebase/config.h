@@ -7,9 +7,85 @@
 #define DEBUG 0
 
 //SCALE -----------------------------------------------------------
-#define SCALE_DATA_PIN 6
-#define SCALE_CLK_PIN 7
-#define SCALE_CALIBRATION_VAL -256.602600
+#ifndef SCALE_CHANNELS                // the build may set both, the host tests run with several channels too
+#define SCALE_CHANNELS 1              // HX711s on the shared clock, one bottle pad each
+#define SCALE_DATA_PINS { 6 }         // DOUT of each channel, SCALE_CHANNELS entries
+#endif
+#define SCALE_MAX_CHANNELS 8          // a clock burst stays well under the 60 us power down limit up to here
+#define SCALE_CLK_PIN 7               // SCK, shared so one clock burst reads every channel at once
+#define SCALE_SESSION_CHANNEL 0       // channel whose bottle runs the goal, pacing and alerts
+#define SCALE_CALIBRATION_VAL -256.602600   // counts per gram until one is learned from a reference weight
+#define SCALE_RING_SIZE 32            // samples buffered between the sampler and its consumers, power of two
+#define SCALE_READY_TIMEOUT_MS 150    // HX711 converts at 10 SPS, so no data ready edge for this long means it stalled
+
+//filter pipeline applied to every sample, stages are picked at compile time
+#define SCALE_FILTER_MEDIAN 1         // running median, knocks out single sample spikes
+#define SCALE_FILTER_EMA 0            // exponential moving average
+#define SCALE_FILTER_KALMAN 1         // 1-D Kalman filter with a constant weight model
+#define SCALE_MEDIAN_WINDOW 5         // samples in the running median, odd
+#define SCALE_EMA_ALPHA 0.3           // weight given to the newest sample
+#define SCALE_KALMAN_Q 0.5            // process noise (g^2 per sample), how fast the true weight may move
+#define SCALE_KALMAN_R 16.0           // measurement noise (g^2), HX711 noise at 10 SPS
+#define SCALE_KALMAN_RESET 40.0       // innovation (g) that means the weight jumped, restart the estimate
+#define SCALE_STABLE_WINDOW 8         // samples the stability detector looks back over
+#define SCALE_STABLE_MAX_SLOPE 10.0   // grams per second of trend allowed while stable
+#define SCALE_STABLE_MAX_STDDEV 5.0   // grams of spread allowed while stable
+
+#if SCALE_CHANNELS < 1 || SCALE_CHANNELS > SCALE_MAX_CHANNELS
+#error "SCALE_CHANNELS must be 1 to SCALE_MAX_CHANNELS"
+#endif
+
+// a single conversion from the scale, stamped with when it was read
+struct ScaleSample {
+  uint32_t time_ms;   // millis() at the time of the read
+  float grams;        // reading with tare, calibration and creep compensation applied
+  float filtered;     // output of the filter pipeline
+  bool stable;        // stability detector agrees the weight has settled
+};
+
+// sampling cost of one channel since boot, the shared clock burst is split evenly between channels
+struct ScaleChannelStats {
+  uint32_t samples;
+  uint64_t cycles;    // CPU cycles spent reading, calibrating and filtering this channel
+};
+
+//CALIBRATION ---------------------------------------------------------
+#define CAL_AVERAGE_SAMPLES 10        // conversions averaged for a tare or a reference weight
+#define CAL_MIN_REFERENCE_G 50        // smallest reference weight worth learning the scale factor from
+#define CAL_MIN_REFERENCE_READ_G (CAL_MIN_REFERENCE_G / 2)  // a reference must read at least this, with the old factor, to be learned
+#define CAL_ZERO_BAND_G 2.0           // a settled reading this close to zero is taken as drift on an empty plate
+#define CAL_ZERO_ALPHA 0.02           // share of that drift folded into the offset per settled sample
+#define CAL_ZERO_SAVE_G 1.0           // tracked zero that moved this far from the stored one is written back
+#define CAL_CREEP_RATIO 0.0005        // load cell creep once fully settled, as a share of the load
+#define CAL_CREEP_TAU_MS 600000       // time constant of creep and of its recovery once unloaded
+
+enum CalibrationState {
+  CAL_IDLE,
+  CAL_TARE,         // averaging an empty plate for the offset
+  CAL_REFERENCE     // averaging a known weight for the scale factor
+};
+
+// why the last reference weight was not learned, cleared by the next tare or reference
+enum CalibrationError {
+  CAL_ERR_NONE,
+  CAL_ERR_NO_LOAD,      // read as next to nothing, the plate was empty or the weight not on yet
+  CAL_ERR_WRONG_SIGN    // read as weight taken off, not put on
+};
+
+// what NVS keeps, a reboot with this stored skips the tare so a bottle may already be on the plate
+struct CalibrationData {
+  int32_t offset;           // raw HX711 count of an empty plate
+  float counts_per_gram;
+};
+
+struct CalibrationStatus {
+  CalibrationState state;
+  CalibrationError error;   // the last reference was rejected and the old factor kept
+  bool stored;              // NVS holds a calibration
+  CalibrationData data;     // in use now, offset includes tracked zero drift
+  float zero_drift_g;       // zero drift tracked since the last tare
+  float creep_g;            // creep currently taken off the reading
+};
 
 //HYDRATION -----------------------------------------------------------
 enum HydrationState {
@@ -19,15 +95,96 @@ enum HydrationState {
     CRITICAL
 };
 
+// coherent copy of the session numbers, published by hydration.cpp after every update
+struct HydrationSnapshot {
+  float goal;               // session water intake goal
+  float grams_left;         // grams left to reach goal
+  float pacer;              // "ideal" grams_left at this point in the session
+  float total_grams;        // total water intake so far during the session
+  HydrationState state;
+  uint32_t version;         // bumped on every publish
+};
+
+//PACING -----------------------------------------------------------
+// Shape of the ideal intake over a session, the pacer is the goal minus the curve's share of it
+enum PacingCurve {
+  PACING_LINEAR,        // same rate all session
+  PACING_FRONT_LOADED,  // drink more early on, 75% of the goal by the halfway point
+  PACING_MEALS,         // 40% spread evenly, 20% around each of three meals at 20%, 50% and 80% of the session
+  PACING_CUSTOM         // PACING_CUSTOM_LUT
+};
+#define PACING_DEFAULT_CURVE PACING_LINEAR
+#define PACING_ONE 65536          // Q16 fixed point 1.0, curve inputs and outputs are fractions of the session and goal
+#define PACING_LUT_POINTS 17      // lookup curves are sampled at every 1/16 of the session
+// Share of the goal that should be drunk by each 1/16 of the session, Q16, must not decrease
+#define PACING_MEALS_LUT {0, 1638, 3277, 9529, 19294, 21299, 22938, 24576, 32768, 40960, 42598, 44237, 46242, 56007, 62259, 63898, 65536}
+#define PACING_CUSTOM_LUT {0, 4096, 8192, 12288, 16384, 20480, 24576, 28672, 32768, 36864, 40960, 45056, 49152, 53248, 57344, 61440, 65536}
+
+// Session timing and fixed point goal, all integer so long sessions don't lose precision
+struct Pacer {
+  int64_t start_ms;     // pacing_now_ms() the session began, negative for one resumed soon after a reboot
+  int64_t length_ms;
+  int32_t goal_mg;      // milligrams, 1 mL of water is 1000 mg
+  PacingCurve curve;
+};
+
+//EVENTS -----------------------------------------------------------
+#define EVENT_EMPTY_GRAMS 30.0        // below this the plate counts as empty
+#define EVENT_SIP_MIN_GRAMS 10.0      // smallest drop that counts as a sip
+#define EVENT_REFILL_MIN_GRAMS 30.0   // smallest rise that counts as a refill
+#define EVENT_SETTLE_MS 500           // weight must stay settled this long before a change is classified
+#define EVENT_REMOVED_MS 300          // plate must read empty this long before the bottle counts as lifted
+#define EVENT_MAX_LISTENERS 4
+
+enum ScaleEventType {
+  EVENT_BOTTLE_REMOVED,
+  EVENT_BOTTLE_RETURNED,
+  EVENT_SIP,
+  EVENT_REFILL,
+  EVENT_DISTURBANCE
+};
+
+struct ScaleEvent {
+  ScaleEventType type;
+  float grams;            // weight change for sips and refills, bottle weight otherwise
+  uint32_t time_ms;       // when the scale first saw the change
+  uint32_t detected_ms;   // when the change was classified, detected_ms - time_ms is the detection latency
+  uint8_t channel;        // scale channel the bottle sits on
+};
+
+// what one channel's bottle did since the session started, kept for every channel by tracker.cpp
+struct ChannelTally {
+  float intake_grams;     // sips added up
+  uint32_t sips;
+};
+
 //SPEAKER -----------------------------------------------------------
 #define SPEAKER_PIN 21
-#define ALERT_FREQUENCY 1000  // Hz
-#define ALERT_DURATION 500    // ms
-#define ALERT_INTERVAL 30000  // 30 seconds between alerts
+#define ALERT_FREQUENCY 1000  // Hz, base note of the alert patterns
+#define ALERT_INTERVAL 30000  // 30 seconds between alerts at the first level, each level after halves it
+#define SPEAKER_DUTY 128      // 50% duty cycle at 8-bit resolution
+#define SPEAKER_QUEUE_LEN 4   // patterns waiting to play
+#define SPEAKER_ESCALATE_AFTER 3          // alerts the user ignores before the next, louder pattern
+#define SPEAKER_SNOOZE_MS (15UL * 60000)  // default snooze from the website
+#define SPEAKER_QUIET_START_MIN (22 * 60) // local minute of the day alerts stop, needs the phone's clock
+#define SPEAKER_QUIET_END_MIN (7 * 60)    // and start again
+#define SPEAKER_QUIET_RECHECK_MS 60000    // how often a held back alert checks again
 
-enum SpeakerState {
-  SPEAKER_IDLE,
-  SPEAKER_ALERTING
+// One note of a pattern, freq_hz 0 is a rest
+struct ToneStep {
+  uint16_t freq_hz;
+  uint16_t ms;
+};
+
+struct TonePattern {
+  const ToneStep *steps;
+  uint8_t count;
+};
+
+// Whatever makes the sound, LEDC on the device, swappable for a recording mock on the host
+struct SpeakerBackend {
+  void (*tone)(uint16_t freq_hz);
+  void (*silence)();
 };
 
 //STATUS LED -----------------------------------------------------------
@@ -49,6 +206,32 @@ struct LEDColor {
 #define COLOR_CRITICAL    {255, 0, 0}      // Red - drink water
 #define COLOR_COMPLETED    {128, 0, 128}      // Purple - goal met
 #define COLOR_OFF       {0, 0, 0}        // Off
+#define COLOR_WAITING   {120, 120, 120}  // White - waiting for a session
+
+// Animation timing, the engine only pushes a frame when its colour differs from the last one shown
+#define LED_FRAME_MS 20         // frame period while fading
+#define LED_BREATHE_FRAME_MS 50 // frame period while breathing, slow enough to look smooth
+#define LED_FADE_MS 400         // crossfade between two states
+#define LED_BREATHE_MS 3000     // one full breath
+#define LED_BREATHE_MIN 40      // dimmest point of a breath, out of 255
+#define LED_BLINK_MS 1000       // one on/off cycle
+
+enum LedEffect {
+  LED_SOLID,
+  LED_BREATHE,
+  LED_BLINK
+};
+
+// What pushes a frame out, the NeoPixel on the device, a recording mock on the host
+struct LedBackend {
+  void (*show)(LEDColor color);
+};
+
+struct LedStats {
+  uint32_t frames;        // frames pushed to the LED
+  uint32_t skipped;       // frames that matched the last one and were not pushed
+  uint64_t show_us;       // time spent in show()
+};
 
 //STORAGE -----------------------------------------------------------
 // Number of sessions to store
@@ -61,10 +244,205 @@ struct Entry {
   float goal;          // goal set for session
 };
 
+// Where the running session is, saved to NVS so a reboot picks the session back up
+struct SessionCheckpoint {
+  float goal;             // grams
+  uint32_t duration_s;    // session length the user set
+  uint32_t elapsed_ms;    // session time already run, time spent powered off isn't counted
+  float total_grams;      // intake so far
+  uint32_t curve;         // PacingCurve the session was started with
+};
+#define STORAGE_CHECKPOINT_MS 60000   // elapsed time alone only earns a new checkpoint this often
+#define STORAGE_COMMIT_MIN_MS 30000   // NVS commits are batched to at most one per this period
+
+// Session journal, an append only log on its own flash partition (see partitions.csv)
+#define JOURNAL_PARTITION "journal"   // label of the data partition
+#define JOURNAL_SEGMENT_SIZE 4096     // one flash sector, the unit of erase and rotation
+#define JOURNAL_MAX_SEGMENTS 64       // caps the RAM index, a bigger partition only uses the first 64
+#define JOURNAL_MAX_RECORD 1024       // largest payload journal_append accepts, a packed session series fits
+// Worst case sessions per full segment, every session followed by a full size series record (headers included)
+#define JOURNAL_SESSIONS_PER_SEGMENT ((JOURNAL_SEGMENT_SIZE - 32) / (JOURNAL_MAX_RECORD + 48))
+// Segments scanned at boot to rebuild the latest MAX_ENTRIES sessions, one more for a head holding only a series
+#define JOURNAL_RECENT_SEGMENTS ((MAX_ENTRIES + JOURNAL_SESSIONS_PER_SEGMENT - 1) / JOURNAL_SESSIONS_PER_SEGMENT + 1)
+
+// Journal record types
+enum JournalRecordType {
+  JREC_SESSION = 1,         // one finished session as a raw Entry, only written by older firmware
+  JREC_RESET = 2,           // history reset from the web page, sessions before it are hidden
+  JREC_SESSION_PACKED = 3,  // one finished session packed by entry_codec, keyframe first in each segment
+  JREC_SERIES = 4           // intake and pacer curve of a session, appended right after its session record
+};
+
+//SERIES -----------------------------------------------------------
+#define SERIES_MAX_BUCKETS 96         // RAM ring per session, also the most points /series returns
+#define SERIES_BASE_BUCKET_MS 5000    // starting resolution, doubles every time the ring fills
+
+// Range of values seen in one time bucket, in millilitres
+struct SeriesBucket {
+  uint16_t intake_min;
+  uint16_t intake_max;
+  uint16_t pacer_min;
+  uint16_t pacer_max;
+};
+
+// One session's curve, bucket i covers [i * bucket_ms, (i + 1) * bucket_ms) from the session start
+struct SeriesData {
+  uint32_t session;     // journal id of the session, 0 for the running one
+  uint32_t bucket_ms;
+  uint16_t count;
+  SeriesBucket buckets[SERIES_MAX_BUCKETS];
+};
+
+// A bucket range merged for a /series reply
+struct SeriesPoint {
+  uint32_t time_ms;     // start of the merged range
+  SeriesBucket value;
+};
+
+//STATS -----------------------------------------------------------
+#define STATS_DAYS 7      // daily totals kept, today first
+#define STATS_WEEKS 4     // weekly totals kept (weeks start Monday), this week first
+
+// Aggregates kept up to date as sessions finish, so reading them never walks the history
+struct StatsRollup {
+  int32_t last_day;                   // local day number (days since 1970) of day_ml[0]
+  int16_t tz_min;                     // browser's UTC offset, days are counted in local time
+  float day_ml[STATS_DAYS];
+  float week_ml[STATS_WEEKS];
+  uint32_t sessions;
+  uint32_t goals_hit;
+  float total_ml;
+  uint32_t total_s;                   // summed session lengths, for the average pace
+  int32_t last_goal_day;              // newest day a goal was met, -1 if never
+  uint16_t streak;                    // days in a row with a goal met, ending at last_goal_day
+  uint16_t longest_streak;
+};
+
+//EXPORT -----------------------------------------------------------
+#define EXPORT_LINE_SIZE 160   // longest CSV/NDJSON row the exporter formats
+
+//POWER -----------------------------------------------------------
+#define POWER_LIGHT_SLEEP 1           // 0 keeps the chip awake, accounting still runs
+#define POWER_MIN_SLEEP_MS 5          // not worth sleeping for less
+#define POWER_MAX_SLEEP_MS 1000       // wake at least this often even with nothing scheduled
+#define POWER_RECHECK_MS 100          // how often a held off sleep is tried again
+#define POWER_BATTERY_MAH 1000        // battery the life estimate is for
+
+// Estimated current of each rail at full level, mA
+#define POWER_CPU_ACTIVE_MA 25.0      // ESP32-C6 running at 160 MHz
+#define POWER_CPU_SLEEP_MA 0.2        // light sleep
+#define POWER_RADIO_MA 80.0           // softAP up, on top of the CPU
+#define POWER_LED_MA 36.0             // NeoPixel full white, scales with the colour shown
+#define POWER_SPEAKER_MA 30.0         // buzzer while a note plays
+#define POWER_SCALE_MA 1.5            // one HX711 and load cell, times SCALE_CHANNELS
+
+enum PowerRail {
+  POWER_RAIL_CPU,       // awake vs light sleep
+  POWER_RAIL_RADIO,
+  POWER_RAIL_LED,
+  POWER_RAIL_SPEAKER,
+  POWER_RAIL_SCALE,
+  POWER_RAIL_COUNT
+};
+
+// Reasons the chip has to stay awake, light sleep stops the radio and the LEDC clock
+#define POWER_HOLD_WEB      (1 << 0)
+#define POWER_HOLD_SPEAKER  (1 << 1)
+
+struct PowerRailReport {
+  uint16_t duty_permille;   // time-weighted level, 1000 is full level all the time
+  float avg_ma;
+};
+
+struct PowerReport {
+  uint32_t uptime_ms;
+  uint32_t sleeps;          // light sleeps entered
+  uint32_t slept_ms;        // total time in light sleep
+  bool sleep_enabled;
+  PowerRailReport rails[POWER_RAIL_COUNT];
+  float avg_ma;             // all rails together
+  float battery_hours;      // POWER_BATTERY_MAH at avg_ma
+};
+
+//METRICS -----------------------------------------------------------
+#define METRICS_BUCKETS 15        // log4 buckets, bucket b holds values below 4^b, the last one is +Inf
+#define METRICS_MAX_TASKS 8       // tasks whose stack high-water mark is reported
+#define METRICS_DUMP_MS 60000     // serial dump period while DEBUG is on, 'm' on the serial port dumps any time
+
+enum MetricCounter {
+  METRIC_SCALE_READS,         // HX711 conversions read
+  METRIC_DETECTOR_SAMPLES,    // samples run through the sip detector
+  METRIC_SETTLE_WAITS,        // detector passes spent waiting for a moved bottle to settle
+  METRIC_HTTP_REQUESTS,
+  METRIC_HTTP_BYTES_SENT,
+  METRIC_NVS_COMMITS,
+  METRIC_SNAPSHOT_RETRIES,    // hydration snapshot reads that raced an update and went again
+  METRIC_EXPORT_BYTES,        // /export payload bytes of finished exports
+  METRIC_EXPORT_MS,           // time those exports took, bytes over this is the throughput over the air
+  METRIC_COUNTER_COUNT
+};
+
+enum MetricHistogram {
+  METRIC_SCALE_READ_TIME,     // CPU cycles per clock burst over every HX711
+  METRIC_SETTLE_SAMPLES,      // samples from a bottle moving to it settling again
+  METRIC_HTTP_TIME,           // CPU cycles per HTTP request handled
+  METRIC_NVS_COMMIT_TIME,     // CPU cycles per nvs_commit()
+  METRIC_HISTOGRAM_COUNT
+};
+
+// Each histogram has one writer task, so recording is a couple of plain adds
+struct MetricHist {
+  uint32_t buckets[METRICS_BUCKETS];
+  uint32_t count;
+  uint64_t sum;
+};
+
+struct MetricsTask {
+  const char *name;
+  uint32_t stack_free;      // bytes of stack never touched so far
+};
+
+// Everything /metrics and the serial dump show, copied at one point in time
+struct MetricsSnapshot {
+  uint32_t uptime_ms;
+  uint32_t cpu_mhz;
+  uint32_t counters[METRIC_COUNTER_COUNT];
+  MetricHist hists[METRIC_HISTOGRAM_COUNT];
+  uint8_t task_count;
+  MetricsTask tasks[METRICS_MAX_TASKS];
+  uint32_t heap_free;
+  uint32_t heap_min_free;
+  uint32_t heap_largest_block;
+  LedStats led;
+  PowerReport power;
+};
+
 //WEB -----------------------------------------------------------
 #define BTN_PIN 5
 #define WEB_STATUS_PIN 4
 #define CLIENT_TIMEOUT_SECS 30
+#define WEB_WRITE_CHUNK 1436   // bytes per client.write(), one TCP segment on the softAP link
+#define WEB_DATA_JSON_SIZE (160 + 64 * MAX_ENTRIES)   // cached /data body
+#define WEB_SERIES_JSON_SIZE (64 + 40 * SERIES_MAX_BUCKETS)   // largest /series body
+#define WEB_STATS_JSON_SIZE (192 + 12 * (STATS_DAYS + STATS_WEEKS))   // /stats body
+#define WEB_POWER_JSON_SIZE (160 + 64 * POWER_RAIL_COUNT)   // /power body
+#define WEB_CHANNELS_JSON_SIZE (64 + 336 * SCALE_CHANNELS)   // /channels body, a channel with every float at -FLT_MAX is 328
+#define WEB_METRICS_CHUNK 1024   // /metrics is rendered and sent this many bytes at a time
+#define WEB_EXPORT_CHUNK 1024          // bytes per chunk of a streamed /export
+#define WEB_EXPORT_CHUNKS_PER_PASS 4     // chunks written per web task pass, keeps other clients served during an export
+#define WEB_SSE_MAX_CLIENTS 3   // open /events streams, one per dashboard tab
+#define WEB_EVENT_QUEUE 8       // sip/session end notices waiting for the web task
+#define WEB_SSE_PING_MS 15000   // keepalive comment on idle streams
+#define HTTP_MAX_HEADER 1024    // requests with a bigger header are refused with 431
+#define HTTP_MAX_PATH 32
+#define HTTP_MAX_QUERY 96
+#define HTTP_MAX_ETAG 32
+#define HTTP_READ_TIMEOUT_MS 2000   // how long a client gets to send its whole header
+#define WEB_MAX_CONNECTIONS 4   // client connections serviced at once, the rest wait in the listen backlog
+#define WEB_KEEPALIVE_MS 5000   // idle keep-alive connections are closed after this
+#define WEB_PORT 80
+#define WEB_LISTEN_BACKLOG 8    // connections waiting for a free pool slot
+#define WEB_STREAM_POLL_MS 50   // longest the web task sleeps while /events streams are open, new data reaches them this often
 
 //STATE -----------------------------------------------------------
 typedef enum {
@@ -72,4 +450,11 @@ typedef enum {
     STATE_RUNNING
 } SystemState;
 
+//events tasks can wait on instead of polling get_state()
+#define EVT_SESSION_START     (1 << 0)  // user submitted a goal, state went to running
+#define EVT_SESSION_END       (1 << 1)  // session finished, state went back to waiting
+#define EVT_WEB_BUTTON        (1 << 2)  // web page button pressed
+#define EVT_HYDRATION_CHANGE  (1 << 3)  // hydration state changed
+#define STATE_MAX_SUBSCRIBERS 6
+
 #endif
\ No newline at end of file
@@ -0,0 +1,29 @@
+#include "data_json.h"
+#include "entry_codec.h"
+
+//renders into out, returns the body length and sets *live_len to the length before the history array
+size_t data_json_render(char *out, size_t len, uint32_t version, bool waiting, float goal, float total,
+                        const Entry *entries, const uint32_t *ids, size_t *live_len) {
+  size_t n = snprintf(out, len, "{\"v\":%lu,\"waiting\":%s,", (unsigned long)version, waiting ? "true" : "false");
+  //when waiting for user input, don't display any goal or total water intake readings
+  if (waiting) {
+    n += snprintf(out + n, len - n, "\"web_goal_grams\":\"--\",\"web_total_grams\":\"--\"");
+  }
+  else {
+    n += snprintf(out + n, len - n, "\"web_goal_grams\":%.1f,\"web_total_grams\":%.1f", goal, total);
+  }
+  *live_len = n;
+
+  //send historical session data as an array
+  n += snprintf(out + n, len - n, ",\"history\":[");
+  for (int i = 0; i < MAX_ENTRIES; i++) {
+    //history is stored in whole millilitres, no point sending decimals
+    n += snprintf(out + n, len - n, "{\"id\":%lu,\"d\":%lu,\"g\":%lu,\"t\":%lu}%s",
+                  (unsigned long)ids[i],
+                  (unsigned long)entry_quantise_ml(entries[i].grams_drank), (unsigned long)entry_quantise_ml(entries[i].goal),
+                  (unsigned long)entries[i].duration,
+                  (i < MAX_ENTRIES - 1) ? "," : "");
+  }
+  n += snprintf(out + n, len - n, "]}");
+  return (n < len) ? n : len - 1;
+}
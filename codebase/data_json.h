@@ -0,0 +1,12 @@
+#ifndef DATA_JSON_H
+#define DATA_JSON_H
+
+#include <Arduino.h>
+#include "config.h"
+
+//the /data body, kept apart from web.cpp so it builds without WiFi and can be timed off the device
+//live fields come first so a history-free reply is just a prefix of the buffer
+size_t data_json_render(char *out, size_t len, uint32_t version, bool waiting, float goal, float total,
+                        const Entry *entries, const uint32_t *ids, size_t *live_len);
+
+#endif // DATA_JSON_H
@@ -0,0 +1,110 @@
+#include "entry_codec.h"
+
+//VARINTS --------------------------------------------------------------
+//little endian base 128, 7 bits per byte with the top bit set on all but the last
+size_t varint_put(uint8_t *out, uint32_t value) {
+  size_t n = 0;
+  while (value >= 0x80) {
+    out[n++] = (uint8_t)(value | 0x80);
+    value >>= 7;
+  }
+  out[n++] = (uint8_t)value;
+  return n;
+}
+
+//returns bytes used, 0 if the varint runs past len or past 32 bits
+size_t varint_get(const uint8_t *in, size_t len, uint32_t *value) {
+  uint32_t v = 0;
+  for (size_t n = 0; n < len && n < 5; n++) {
+    //the fifth byte only has room for the top 4 bits
+    if (n == 4 && in[n] > 0x0F) return 0;
+    v |= (uint32_t)(in[n] & 0x7F) << (7 * n);
+    if ((in[n] & 0x80) == 0) {
+      *value = v;
+      return n + 1;
+    }
+  }
+  return 0;
+}
+
+//maps small negative and positive numbers to small unsigned ones, -1 -> 1, 1 -> 2
+uint32_t zigzag_encode(int32_t value) {
+  return ((uint32_t)value << 1) ^ (uint32_t)(value >> 31);
+}
+
+int32_t zigzag_decode(uint32_t value) {
+  return (int32_t)(value >> 1) ^ -(int32_t)(value & 1);
+}
+
+//ENTRIES --------------------------------------------------------------
+void entry_codec_init(EntryCodec *codec) {
+  codec->duration = 0;
+  codec->drank_ml = 0;
+  codec->goal_ml = 0;
+  codec->primed = false;
+}
+
+//intake and goals are whole millilitres, 1 g of water is 1 mL
+uint32_t entry_quantise_ml(float grams) {
+  return (grams > 0) ? (uint32_t)lroundf(grams) : 0;
+}
+
+//writes entry to out (at least ENTRY_CODEC_MAX_BYTES), returns the bytes written
+//the first entry through a codec is always a keyframe
+size_t entry_encode(EntryCodec *codec, const Entry *entry, bool keyframe, uint8_t *out) {
+  uint32_t drank_ml = entry_quantise_ml(entry->grams_drank);
+  uint32_t goal_ml = entry_quantise_ml(entry->goal);
+  keyframe = keyframe || !codec->primed;
+
+  size_t n = 0;
+  out[n++] = ENTRY_CODEC_VERSION | (keyframe ? ENTRY_CODEC_KEYFRAME : 0);
+  if (keyframe) {
+    n += varint_put(out + n, entry->duration);
+    n += varint_put(out + n, drank_ml);
+    n += varint_put(out + n, goal_ml);
+  }
+  else {
+    n += varint_put(out + n, zigzag_encode((int32_t)(entry->duration - codec->duration)));
+    n += varint_put(out + n, zigzag_encode((int32_t)(drank_ml - codec->drank_ml)));
+    n += varint_put(out + n, zigzag_encode((int32_t)(goal_ml - codec->goal_ml)));
+  }
+
+  codec->duration = entry->duration;
+  codec->drank_ml = drank_ml;
+  codec->goal_ml = goal_ml;
+  codec->primed = true;
+  return n;
+}
+
+//reads one entry from in, returns the bytes used
+//0 means a bad record, an unknown version, or a delta with no keyframe before it
+size_t entry_decode(EntryCodec *codec, const uint8_t *in, size_t len, Entry *entry) {
+  if (len < 1 || (in[0] & ~ENTRY_CODEC_KEYFRAME) != ENTRY_CODEC_VERSION) return 0;
+  bool keyframe = in[0] & ENTRY_CODEC_KEYFRAME;
+  if (!keyframe && !codec->primed) return 0;
+
+  uint32_t fields[3];
+  size_t n = 1;
+  for (int i = 0; i < 3; i++) {
+    size_t used = varint_get(in + n, len - n, &fields[i]);
+    if (used == 0) return 0;
+    n += used;
+  }
+
+  if (keyframe) {
+    codec->duration = fields[0];
+    codec->drank_ml = fields[1];
+    codec->goal_ml = fields[2];
+  }
+  else {
+    codec->duration += zigzag_decode(fields[0]);
+    codec->drank_ml += zigzag_decode(fields[1]);
+    codec->goal_ml += zigzag_decode(fields[2]);
+  }
+  codec->primed = true;
+
+  entry->duration = codec->duration;
+  entry->grams_drank = codec->drank_ml;
+  entry->goal = codec->goal_ml;
+  return n;
+}
@@ -0,0 +1,31 @@
+#ifndef ENTRY_CODEC_H
+#define ENTRY_CODEC_H
+
+#include <Arduino.h>
+#include "config.h"
+
+//packed session records: a version byte then three varints
+//keyframes hold absolute values, the rest hold zigzag deltas from the session before
+#define ENTRY_CODEC_VERSION 1
+#define ENTRY_CODEC_KEYFRAME 0x80   //set in the version byte
+#define ENTRY_CODEC_MAX_BYTES 16    //version byte plus three 5 byte varints
+
+//encoder or decoder state, the previous session in whole millilitres
+struct EntryCodec {
+  uint32_t duration;
+  uint32_t drank_ml;
+  uint32_t goal_ml;
+  bool primed;  //false until a keyframe went through
+};
+
+void entry_codec_init(EntryCodec *codec);
+uint32_t entry_quantise_ml(float grams);
+size_t entry_encode(EntryCodec *codec, const Entry *entry, bool keyframe, uint8_t *out);
+size_t entry_decode(EntryCodec *codec, const uint8_t *in, size_t len, Entry *entry);
+
+size_t varint_put(uint8_t *out, uint32_t value);
+size_t varint_get(const uint8_t *in, size_t len, uint32_t *value);
+uint32_t zigzag_encode(int32_t value);
+int32_t zigzag_decode(uint32_t value);
+
+#endif // ENTRY_CODEC_H
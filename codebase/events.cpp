@@ -0,0 +1,140 @@
+#include "events.h"
+#include "metrics.h"
+
+//where the detector thinks the bottle is
+enum DetectorState {
+  DETECT_EMPTY,     //nothing on the plate yet, no baseline weight
+  DETECT_SETTLED,   //bottle resting, baseline is its weight
+  DETECT_MOVING,    //weight left the baseline, waiting for it to settle or the plate to empty
+  DETECT_REMOVED    //bottle lifted off, waiting for it to come back
+};
+
+static ScaleEventListener listeners[EVENT_MAX_LISTENERS];
+static int listener_count = 0;
+
+//detector for one scale channel
+struct Detector {
+  DetectorState state;
+  float baseline;           //settled bottle weight before the current change
+  uint32_t change_ms;       //when the weight left the baseline
+  uint32_t returned_ms;     //when the plate stopped reading empty
+  uint32_t empty_since;
+  uint32_t stable_since;
+  bool was_empty;
+  bool was_stable;
+  bool lifted;              //bottle left the plate during the current change
+  uint32_t settle_samples;  //samples seen since the weight left the baseline
+};
+static Detector detectors[SCALE_CHANNELS];
+
+void events_init() {
+  for (uint8_t ch = 0; ch < SCALE_CHANNELS; ch++) {
+    Detector *d = &detectors[ch];
+    d->state = DETECT_EMPTY;
+    d->baseline = 0;
+    d->was_empty = true;
+    d->was_stable = false;
+    d->lifted = false;
+  }
+}
+
+//registers a function to be called with every classified event, returns false when the table is full
+bool events_add_listener(ScaleEventListener listener) {
+  if (listener_count >= EVENT_MAX_LISTENERS) return false;
+  listeners[listener_count++] = listener;
+  return true;
+}
+
+static void events_emit(uint8_t channel, ScaleEventType type, float grams, uint32_t time_ms, uint32_t now) {
+  ScaleEvent event = { type, grams, time_ms, now, channel };
+  if (DEBUG) {
+    Serial.print("ch=");
+    Serial.print(channel);
+    Serial.print(" event=");
+    Serial.print(type);
+    Serial.print(" grams=");
+    Serial.print(grams);
+    Serial.print(" latency_ms=");
+    Serial.println(now - time_ms);
+  }
+  for (int i = 0; i < listener_count; i++) {
+    listeners[i](&event);
+  }
+}
+
+//compares the newly settled weight against the baseline and reports what happened in between
+static void events_classify(Detector *d, uint8_t channel, float weight, uint32_t now) {
+  float drop = d->baseline - weight;
+  if (drop >= EVENT_SIP_MIN_GRAMS) {
+    events_emit(channel, EVENT_SIP, drop, d->change_ms, now);
+  }
+  else if (-drop >= EVENT_REFILL_MIN_GRAMS) {
+    events_emit(channel, EVENT_REFILL, -drop, d->change_ms, now);
+  }
+  else if (!d->lifted) {
+    //the bottle wobbled but nothing was drunk or added
+    events_emit(channel, EVENT_DISTURBANCE, -drop, d->change_ms, now);
+  }
+  metrics_record(METRIC_SETTLE_SAMPLES, d->settle_samples);
+  d->baseline = weight;
+  d->state = DETECT_SETTLED;
+}
+
+//feeds one sample from a channel's scale ring through that channel's detector
+void events_process(uint8_t channel, const ScaleSample *sample) {
+  Detector *d = &detectors[channel];
+  uint32_t now = sample->time_ms;
+  float weight = sample->filtered;
+  metrics_count(METRIC_DETECTOR_SAMPLES);
+  bool empty = weight < EVENT_EMPTY_GRAMS;
+
+  if (empty && !d->was_empty) d->empty_since = now;
+  if (!empty && d->was_empty) d->returned_ms = now;
+  if (sample->stable && !d->was_stable) d->stable_since = now;
+  d->was_empty = empty;
+  d->was_stable = sample->stable;
+
+  //a change is only classified once the weight has held still for a while
+  bool settled = sample->stable && !empty && now - d->stable_since >= EVENT_SETTLE_MS;
+
+  switch (d->state) {
+    case DETECT_EMPTY:
+      if (settled) {
+        events_emit(channel, EVENT_BOTTLE_RETURNED, weight, d->returned_ms, now);
+        d->baseline = weight;
+        d->state = DETECT_SETTLED;
+      }
+      break;
+
+    case DETECT_SETTLED:
+      if (!sample->stable || empty || fabs(weight - d->baseline) >= EVENT_SIP_MIN_GRAMS) {
+        d->change_ms = now;
+        d->lifted = false;
+        d->settle_samples = 0;
+        d->state = DETECT_MOVING;
+      }
+      break;
+
+    case DETECT_MOVING:
+      d->settle_samples++;
+      metrics_count(METRIC_SETTLE_WAITS);
+      if (empty && now - d->empty_since >= EVENT_REMOVED_MS) {
+        events_emit(channel, EVENT_BOTTLE_REMOVED, d->baseline, d->change_ms, now);
+        d->lifted = true;
+        d->state = DETECT_REMOVED;
+      }
+      else if (settled) {
+        events_classify(d, channel, weight, now);
+      }
+      break;
+
+    case DETECT_REMOVED:
+      d->settle_samples++;
+      metrics_count(METRIC_SETTLE_WAITS);
+      if (settled) {
+        events_emit(channel, EVENT_BOTTLE_RETURNED, weight, d->returned_ms, now);
+        events_classify(d, channel, weight, now);
+      }
+      break;
+  }
+}
@@ -0,0 +1,13 @@
+#ifndef EVENTS_H
+#define EVENTS_H
+
+#include <Arduino.h>
+#include "config.h"
+
+typedef void (*ScaleEventListener)(const ScaleEvent *event);
+
+void events_init();
+bool events_add_listener(ScaleEventListener listener);
+void events_process(uint8_t channel, const ScaleSample *sample);
+
+#endif // EVENTS_H
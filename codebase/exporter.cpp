@@ -0,0 +1,154 @@
+#include "exporter.h"
+#include "series.h"
+#include <stdarg.h>
+
+#define EXPORT_BIN_VERSION 1
+
+static const char CSV_HEADER[] =
+  "kind,id,duration_s,drank_ml,goal_ml,t_s,intake_min_ml,intake_max_ml,pacer_min_ml,pacer_max_ml\n";
+
+void exporter_begin(Exporter *e, ExportFormat format) {
+  e->format = format;
+  journal_cursor_begin(&e->cursor);
+  entry_codec_init(&e->codec);
+  e->series.count = 0;
+  e->series_pos = 0;
+  e->record_pending = false;
+  e->pending = NULL;
+  e->pending_len = 0;
+  e->started = false;
+}
+
+bool exporter_parse_format(const char *name, ExportFormat *format) {
+  if (strcmp(name, "csv") == 0) *format = EXPORT_CSV;
+  else if (strcmp(name, "ndjson") == 0) *format = EXPORT_NDJSON;
+  else if (strcmp(name, "bin") == 0) *format = EXPORT_BIN;
+  else return false;
+  return true;
+}
+
+static void stage(Exporter *e, const void *data, size_t len) {
+  e->pending = (const uint8_t *)data;
+  e->pending_len = len;
+}
+
+//formats into e->line and stages it
+static void stage_line(Exporter *e, const char *fmt, ...) {
+  va_list args;
+  va_start(args, fmt);
+  int n = vsnprintf(e->line, sizeof(e->line), fmt, args);
+  va_end(args);
+  if (n < 0) n = 0;
+  if ((size_t)n >= sizeof(e->line)) n = sizeof(e->line) - 1;
+  stage(e, e->line, n);
+}
+
+static void stage_session(Exporter *e, uint32_t id, const Entry *entry) {
+  unsigned long d = entry->duration, g = entry_quantise_ml(entry->goal), m = entry_quantise_ml(entry->grams_drank);
+  if (e->format == EXPORT_CSV) {
+    stage_line(e, "session,%lu,%lu,%lu,%lu,,,,,\n", (unsigned long)id, d, m, g);
+  }
+  else {
+    stage_line(e, "{\"type\":\"session\",\"id\":%lu,\"duration_s\":%lu,\"drank_ml\":%lu,\"goal_ml\":%lu}\n",
+               (unsigned long)id, d, m, g);
+  }
+}
+
+static void stage_point(Exporter *e) {
+  const SeriesBucket *b = &e->series.buckets[e->series_pos];
+  unsigned long t = (unsigned long)e->series_pos * e->series.bucket_ms / 1000;
+  unsigned long session = e->series.session;
+  if (e->format == EXPORT_CSV) {
+    stage_line(e, "point,%lu,,,,%lu,%u,%u,%u,%u\n", session, t, b->intake_min, b->intake_max, b->pacer_min, b->pacer_max);
+  }
+  else {
+    stage_line(e, "{\"type\":\"point\",\"session\":%lu,\"t_s\":%lu,\"intake_ml\":[%u,%u],\"pacer_ml\":[%u,%u]}\n",
+               session, t, b->intake_min, b->intake_max, b->pacer_min, b->pacer_max);
+  }
+  e->series_pos++;
+}
+
+//stages the next piece of output, false at the end of the journal
+static bool exporter_next(Exporter *e) {
+  if (!e->started) {
+    e->started = true;
+    if (e->format == EXPORT_CSV) {
+      stage(e, CSV_HEADER, sizeof(CSV_HEADER) - 1);
+      return true;
+    }
+    if (e->format == EXPORT_BIN) {
+      e->line[0] = 'H';
+      e->line[1] = 'J';
+      e->line[2] = 'X';
+      e->line[3] = EXPORT_BIN_VERSION;
+      stage(e, e->line, 4);
+      return true;
+    }
+  }
+  if (e->record_pending) {
+    e->record_pending = false;
+    stage(e, e->record, e->record_len);
+    return true;
+  }
+  if (e->series_pos < e->series.count) {
+    stage_point(e);
+    return true;
+  }
+
+  //text formats skip records they can't show, so keep reading until something is staged
+  while (journal_cursor_next(&e->cursor, &e->record_type, &e->record_id, e->record, &e->record_len)) {
+    if (e->format == EXPORT_BIN) {
+      uint8_t *p = (uint8_t *)e->line;
+      p[0] = e->record_type;
+      for (int i = 0; i < 4; i++) p[1 + i] = e->record_id >> (8 * i);
+      p[5] = e->record_len;
+      p[6] = e->record_len >> 8;
+      stage(e, p, 7);
+      e->record_pending = e->record_len > 0;
+      return true;
+    }
+
+    Entry entry;
+    switch (e->record_type) {
+      case JREC_SESSION_PACKED:
+        if (entry_decode(&e->codec, e->record, e->record_len, &entry) == 0) break;
+        stage_session(e, e->record_id, &entry);
+        return true;
+
+      case JREC_SESSION:
+        if (e->record_len != sizeof(Entry)) break;
+        memcpy(&entry, e->record, sizeof(entry));
+        stage_session(e, e->record_id, &entry);
+        return true;
+
+      case JREC_RESET:
+        if (e->format == EXPORT_CSV) stage_line(e, "reset,%lu,,,,,,,,\n", (unsigned long)e->record_id);
+        else stage_line(e, "{\"type\":\"reset\",\"id\":%lu}\n", (unsigned long)e->record_id);
+        return true;
+
+      case JREC_SERIES:
+        if (!series_decode(e->record, e->record_len, &e->series) || e->series.count == 0) {
+          e->series.count = 0;
+          break;
+        }
+        e->series_pos = 0;
+        stage_point(e);
+        return true;
+    }
+  }
+  return false;
+}
+
+//fills out with up to len bytes of the export, 0 once everything was read
+size_t exporter_read(Exporter *e, uint8_t *out, size_t len) {
+  size_t n = 0;
+  while (n < len) {
+    if (e->pending_len == 0 && !exporter_next(e)) break;
+    size_t k = (e->pending_len < len - n) ? e->pending_len : len - n;
+    memcpy(out + n, e->pending, k);
+    e->pending += k;
+    e->pending_len -= k;
+    n += k;
+  }
+  return n;
+}
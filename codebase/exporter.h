@@ -0,0 +1,39 @@
+#ifndef EXPORTER_H
+#define EXPORTER_H
+
+#include <Arduino.h>
+#include "config.h"
+#include "journal.h"
+#include "entry_codec.h"
+
+//turns the whole journal into a byte stream, pulled a buffer at a time so nothing big sits in RAM
+//only depends on the journal, so a host tool can run it over a flash dump mounted through its own JournalFlash
+
+enum ExportFormat {
+  EXPORT_CSV,     //one row per session, reset and series point, kind in the first column
+  EXPORT_NDJSON,  //one JSON object per line, same rows as the CSV
+  EXPORT_BIN      //"HJX" + version byte, then each record as type, id (u32 LE), len (u16 LE), payload
+};
+
+struct Exporter {
+  ExportFormat format;
+  JournalCursor cursor;
+  EntryCodec codec;
+  SeriesData series;              //series being written out point by point
+  uint16_t series_pos;            //next point of series, series.count when there is none
+  uint8_t record[JOURNAL_MAX_RECORD];
+  uint8_t record_type;
+  uint32_t record_id;
+  uint16_t record_len;
+  bool record_pending;            //bin only, the payload still has to follow its prefix
+  char line[EXPORT_LINE_SIZE];
+  const uint8_t *pending;         //bytes staged for the next read
+  size_t pending_len;
+  bool started;
+};
+
+void exporter_begin(Exporter *e, ExportFormat format);
+size_t exporter_read(Exporter *e, uint8_t *out, size_t len);
+bool exporter_parse_format(const char *name, ExportFormat *format);
+
+#endif // EXPORTER_H
@@ -0,0 +1,179 @@
+#include "filters.h"
+
+//samples between full recomputes of the stability sums, bounds float drift from the running updates
+#define STABILITY_RESYNC_SAMPLES 64
+
+//MEDIAN ---------------------------------------------------------------
+void median_filter_init(MedianFilter *f) {
+  f->count = 0;
+  f->pos = 0;
+}
+
+//drops the oldest sample from the sorted window and inserts the new one, O(window) with a fixed window
+float median_filter_update(MedianFilter *f, float x) {
+  int n = f->count;
+  if (n == SCALE_MEDIAN_WINDOW) {
+    float oldest = f->history[f->pos];
+    int i = 0;
+    while (i < n - 1 && f->sorted[i] != oldest) i++;
+    for (; i < n - 1; i++) f->sorted[i] = f->sorted[i + 1];
+    n--;
+  }
+  else {
+    f->count++;
+  }
+  f->history[f->pos] = x;
+  f->pos = (f->pos + 1) % SCALE_MEDIAN_WINDOW;
+
+  int i = n;
+  while (i > 0 && f->sorted[i - 1] > x) {
+    f->sorted[i] = f->sorted[i - 1];
+    i--;
+  }
+  f->sorted[i] = x;
+  return f->sorted[f->count / 2];
+}
+
+//EMA ------------------------------------------------------------------
+void ema_filter_init(EmaFilter *f) {
+  f->value = 0;
+  f->primed = false;
+}
+
+float ema_filter_update(EmaFilter *f, float x, float alpha) {
+  if (!f->primed) {
+    f->value = x;
+    f->primed = true;
+  }
+  else {
+    f->value += alpha * (x - f->value);
+  }
+  return f->value;
+}
+
+//KALMAN ---------------------------------------------------------------
+void kalman_filter_init(KalmanFilter *f) {
+  f->estimate = 0;
+  f->variance = 0;
+  f->primed = false;
+}
+
+//constant weight model, a jump bigger than reset means the bottle moved so the estimate restarts there
+float kalman_filter_update(KalmanFilter *f, float x, float q, float r, float reset) {
+  if (!f->primed || fabs(x - f->estimate) > reset) {
+    f->estimate = x;
+    f->variance = r;
+    f->primed = true;
+    return f->estimate;
+  }
+  f->variance += q;
+  float gain = f->variance / (f->variance + r);
+  f->estimate += gain * (x - f->estimate);
+  f->variance *= 1 - gain;
+  return f->estimate;
+}
+
+//STABILITY ------------------------------------------------------------
+void stability_init(StabilityDetector *d) {
+  d->count = 0;
+  d->pos = 0;
+  d->since_resync = 0;
+  d->ref = 0;
+  d->sum = 0;
+  d->sum_sq = 0;
+  d->sum_ix = 0;
+  d->slope = 0;
+  d->stddev = 0;
+}
+
+//recomputes the sums from scratch over a full window, oldest sample sits at pos
+static void stability_resync(StabilityDetector *d) {
+  d->ref = d->history[(d->pos + SCALE_STABLE_WINDOW - 1) % SCALE_STABLE_WINDOW];
+  d->sum = 0;
+  d->sum_sq = 0;
+  d->sum_ix = 0;
+  for (int i = 0; i < SCALE_STABLE_WINDOW; i++) {
+    float x = d->history[(d->pos + i) % SCALE_STABLE_WINDOW] - d->ref;
+    d->sum += x;
+    d->sum_sq += x * x;
+    d->sum_ix += i * x;
+  }
+  d->since_resync = 0;
+}
+
+void stability_update(StabilityDetector *d, uint32_t time_ms, float x) {
+  const int n = SCALE_STABLE_WINDOW;
+
+  if (d->count < n) {
+    d->history[d->pos] = x;
+    d->times[d->pos] = time_ms;
+    d->pos = (d->pos + 1) % n;
+    d->count++;
+    if (d->count == n) stability_resync(d);
+    else return;
+  }
+  else {
+    //slide the window by one, every remaining sample's index drops by one
+    float oldest = d->history[d->pos] - d->ref;
+    float newest = x - d->ref;
+    d->sum_ix += -(d->sum - oldest) + (n - 1) * newest;
+    d->sum += newest - oldest;
+    d->sum_sq += newest * newest - oldest * oldest;
+    d->history[d->pos] = x;
+    d->times[d->pos] = time_ms;
+    d->pos = (d->pos + 1) % n;
+    if (++d->since_resync >= STABILITY_RESYNC_SAMPLES) stability_resync(d);
+  }
+
+  float mean = d->sum / n;
+  float variance = d->sum_sq / n - mean * mean;
+  d->stddev = (variance > 0) ? sqrtf(variance) : 0;
+
+  //least squares fit against the sample index, then scaled by the average sample spacing
+  const float sum_i = n * (n - 1) / 2.0f;
+  const float sum_ii = (n - 1) * n * (2 * n - 1) / 6.0f;
+  float per_sample = (n * d->sum_ix - sum_i * d->sum) / (n * sum_ii - sum_i * sum_i);
+  uint32_t span_ms = d->times[(d->pos + n - 1) % n] - d->times[d->pos];
+  d->slope = (span_ms > 0) ? per_sample * (n - 1) * 1000.0f / span_ms : 0;
+}
+
+bool stability_is_stable(const StabilityDetector *d, float max_slope, float max_stddev) {
+  return d->count == SCALE_STABLE_WINDOW && fabs(d->slope) <= max_slope && d->stddev <= max_stddev;
+}
+
+//PIPELINE -------------------------------------------------------------
+void scale_filter_init(ScaleFilter *f) {
+#if SCALE_FILTER_MEDIAN
+  median_filter_init(&f->median);
+#endif
+#if SCALE_FILTER_EMA
+  ema_filter_init(&f->ema);
+#endif
+#if SCALE_FILTER_KALMAN
+  kalman_filter_init(&f->kalman);
+#endif
+  stability_init(&f->stability);
+  f->value = 0;
+}
+
+//runs one sample through the enabled stages in order and returns the filtered weight
+float scale_filter_update(ScaleFilter *f, uint32_t time_ms, float grams) {
+  float x = grams;
+#if SCALE_FILTER_MEDIAN
+  x = median_filter_update(&f->median, x);
+#endif
+#if SCALE_FILTER_EMA
+  x = ema_filter_update(&f->ema, x, SCALE_EMA_ALPHA);
+#endif
+#if SCALE_FILTER_KALMAN
+  x = kalman_filter_update(&f->kalman, x, SCALE_KALMAN_Q, SCALE_KALMAN_R, SCALE_KALMAN_RESET);
+#endif
+  //stability is judged on the unsmoothed input so smoothing can't hide a moving bottle
+  stability_update(&f->stability, time_ms, grams);
+  f->value = x;
+  return x;
+}
+
+bool scale_filter_stable(const ScaleFilter *f) {
+  return stability_is_stable(&f->stability, SCALE_STABLE_MAX_SLOPE, SCALE_STABLE_MAX_STDDEV);
+}
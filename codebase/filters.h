@@ -0,0 +1,74 @@
+#ifndef FILTERS_H
+#define FILTERS_H
+
+#include <Arduino.h>
+#include "config.h"
+
+//streaming filters for scale samples, each one is fixed size and does constant work per sample
+
+//running median over the last SCALE_MEDIAN_WINDOW samples
+struct MedianFilter {
+  float history[SCALE_MEDIAN_WINDOW]; //samples in arrival order (circular)
+  float sorted[SCALE_MEDIAN_WINDOW];  //same samples kept sorted
+  uint8_t count;
+  uint8_t pos;
+};
+
+//exponential moving average
+struct EmaFilter {
+  float value;
+  bool primed;
+};
+
+//1-D Kalman filter assuming the weight stays constant between samples
+struct KalmanFilter {
+  float estimate;
+  float variance;
+  bool primed;
+};
+
+//least squares slope and variance over the last SCALE_STABLE_WINDOW samples
+struct StabilityDetector {
+  float history[SCALE_STABLE_WINDOW];
+  uint32_t times[SCALE_STABLE_WINDOW];    //sample times, used for the sample spacing
+  uint8_t count;
+  uint8_t pos;
+  uint16_t since_resync;
+  float ref;          //sums are taken relative to this to keep float precision
+  float sum;          //sum of samples
+  float sum_sq;       //sum of squared samples
+  float sum_ix;       //sum of index * sample, oldest sample has index 0
+  float slope;        //grams per second
+  float stddev;       //grams
+};
+
+//the compile time pipeline configured in config.h
+struct ScaleFilter {
+#if SCALE_FILTER_MEDIAN
+  MedianFilter median;
+#endif
+#if SCALE_FILTER_EMA
+  EmaFilter ema;
+#endif
+#if SCALE_FILTER_KALMAN
+  KalmanFilter kalman;
+#endif
+  StabilityDetector stability;
+  float value;  //latest pipeline output
+};
+
+void median_filter_init(MedianFilter *f);
+float median_filter_update(MedianFilter *f, float x);
+void ema_filter_init(EmaFilter *f);
+float ema_filter_update(EmaFilter *f, float x, float alpha);
+void kalman_filter_init(KalmanFilter *f);
+float kalman_filter_update(KalmanFilter *f, float x, float q, float r, float reset);
+void stability_init(StabilityDetector *d);
+void stability_update(StabilityDetector *d, uint32_t time_ms, float x);
+bool stability_is_stable(const StabilityDetector *d, float max_slope, float max_stddev);
+
+void scale_filter_init(ScaleFilter *f);
+float scale_filter_update(ScaleFilter *f, uint32_t time_ms, float grams);
+bool scale_filter_stable(const ScaleFilter *f);
+
+#endif // FILTERS_H
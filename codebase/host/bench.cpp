@@ -0,0 +1,294 @@
+#include "host.h"
+#include "scale.h"
+#include "hydration.h"
+#include "state.h"
+#include "storage.h"
+#include "data_json.h"
+#include "filters.h"
+#include "http_request.h"
+#include <malloc.h>
+#include <unistd.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <string>
+#include <vector>
+
+//microbenchmarks of the firmware's hot paths on the host build, prints one JSON object with ns/op, allocations/op
+//and peak heap per benchmark. iteration counts are fixed so only the timings move between runs
+//  ./build/bench [-r repeats] [name...]
+//  make bench-check compares a run against bench_baseline.json
+
+typedef std::chrono::steady_clock Clock;
+
+//ALLOCATION COUNTING --------------------------------------------------
+//malloc is interposed for the whole binary, operator new and the C library go through it too
+extern "C" void *__libc_malloc(size_t size);
+extern "C" void *__libc_calloc(size_t n, size_t size);
+extern "C" void *__libc_realloc(void *p, size_t size);
+extern "C" void __libc_free(void *p);
+
+static std::atomic<bool> counting(false);
+static std::atomic<uint64_t> allocs(0);
+static std::atomic<int64_t> live_bytes(0);
+static std::atomic<int64_t> peak_bytes(0);
+
+static void note_alloc(void *p) {
+  if (!p || !counting.load(std::memory_order_relaxed)) return;
+  allocs.fetch_add(1, std::memory_order_relaxed);
+  int64_t live = live_bytes.fetch_add(malloc_usable_size(p), std::memory_order_relaxed) + malloc_usable_size(p);
+  int64_t peak = peak_bytes.load(std::memory_order_relaxed);
+  while (live > peak && !peak_bytes.compare_exchange_weak(peak, live, std::memory_order_relaxed)) {
+  }
+}
+
+//frees of blocks from before the window take live_bytes below 0, peak only counts growth
+static void note_free(void *p) {
+  if (!p || !counting.load(std::memory_order_relaxed)) return;
+  live_bytes.fetch_sub(malloc_usable_size(p), std::memory_order_relaxed);
+}
+
+extern "C" void *malloc(size_t size) {
+  void *p = __libc_malloc(size);
+  note_alloc(p);
+  return p;
+}
+
+extern "C" void *calloc(size_t n, size_t size) {
+  void *p = __libc_calloc(n, size);
+  note_alloc(p);
+  return p;
+}
+
+extern "C" void *realloc(void *old, size_t size) {
+  note_free(old);
+  void *p = __libc_realloc(old, size);
+  note_alloc(p);
+  return p;
+}
+
+extern "C" void free(void *p) {
+  note_free(p);
+  __libc_free(p);
+}
+
+//BENCHMARKS -----------------------------------------------------------
+struct Bench {
+  const char *name;
+  uint32_t iterations;
+  void (*setup)();
+  void (*op)(uint32_t i);
+};
+
+struct BenchResult {
+  double ns_per_op;
+  double allocs_per_op;
+  int64_t peak_heap_bytes;
+};
+
+//scale_sample_poll(): a conversion from every channel through calibration, the filters and the stability detector
+static int32_t fake_raw[SCALE_CHANNELS];
+
+static bool fake_ready() {
+  return true;
+}
+
+static void fake_read(int32_t raw[SCALE_CHANNELS]) {
+  for (uint8_t ch = 0; ch < SCALE_CHANNELS; ch++) raw[ch] = fake_raw[ch];
+}
+
+static const ScaleDriver fake_driver = { fake_ready, fake_read };
+
+static void scale_setup() {
+  scale_init();
+  scale_set_driver(&fake_driver);
+}
+
+//a bottle at rest with a little noise, and now and then a sip
+static void scale_op(uint32_t i) {
+  uint32_t noise = (i * 2654435761u) >> 28;
+  for (uint8_t ch = 0; ch < SCALE_CHANNELS; ch++) fake_raw[ch] = 400000 + (int32_t)noise * 20 - ((i / 500) % 2) * 4000;
+  scale_sample_poll(i * 100);   //10 SPS
+  ScaleSample sample;
+  for (uint8_t ch = 0; ch < SCALE_CHANNELS; ch++) {
+    while (scale_pop_sample(ch, &sample)) {
+    }
+  }
+}
+
+//one sample through each filter stage on its own, a bottle at rest with noise and a knock now and then
+static float filter_input[1024];
+static MedianFilter bench_median;
+static EmaFilter bench_ema;
+static KalmanFilter bench_kalman;
+static StabilityDetector bench_stability;
+static ScaleFilter bench_pipeline;
+static volatile float filter_sink;
+
+static void filter_setup() {
+  for (int i = 0; i < 1024; i++) {
+    uint32_t noise = (i * 2654435761u) >> 24;
+    filter_input[i] = 650 + noise / 255.0f - 0.5f + ((i % 150 == 149) ? 25 : 0);
+  }
+  median_filter_init(&bench_median);
+  ema_filter_init(&bench_ema);
+  kalman_filter_init(&bench_kalman);
+  stability_init(&bench_stability);
+  scale_filter_init(&bench_pipeline);
+}
+
+static void median_op(uint32_t i) {
+  filter_sink = median_filter_update(&bench_median, filter_input[i % 1024]);
+}
+
+static void ema_op(uint32_t i) {
+  filter_sink = ema_filter_update(&bench_ema, filter_input[i % 1024], SCALE_EMA_ALPHA);
+}
+
+static void kalman_op(uint32_t i) {
+  filter_sink = kalman_filter_update(&bench_kalman, filter_input[i % 1024], SCALE_KALMAN_Q, SCALE_KALMAN_R, SCALE_KALMAN_RESET);
+}
+
+static void stability_op(uint32_t i) {
+  stability_update(&bench_stability, i * 100, filter_input[i % 1024]);
+  filter_sink = stability_is_stable(&bench_stability, SCALE_STABLE_MAX_SLOPE, SCALE_STABLE_MAX_STDDEV);
+}
+
+//the pipeline config.h selects, every stage plus stability
+static void pipeline_op(uint32_t i) {
+  filter_sink = scale_filter_update(&bench_pipeline, i * 100, filter_input[i % 1024]);
+}
+
+//update_hydration_status(): one tracker pass of a running session, the clock moving on 10 ms each time
+static void hydration_setup() {
+  set_goal(3000);
+  set_time_length(30 * 86400);
+  reset();
+  set_state(STATE_RUNNING);
+  update_hydration_status();
+}
+
+static void hydration_op(uint32_t i) {
+  host_advance_ms(10);
+  if (i % 1000 == 0) record_grams_drank(1);
+  update_hydration_status();
+}
+
+//data_json_render(): the /data body with a full history
+static Entry json_entries[MAX_ENTRIES];
+static uint32_t json_ids[MAX_ENTRIES];
+static char json_out[WEB_DATA_JSON_SIZE];
+
+static void json_setup() {
+  for (int i = 0; i < MAX_ENTRIES; i++) {
+    json_entries[i].grams_drank = 1500 + i * 17;
+    json_entries[i].goal = 2000 + (i % 4) * 250;
+    json_entries[i].duration = 28800;
+    json_ids[i] = 1000 - i;
+  }
+}
+
+static void json_op(uint32_t i) {
+  size_t live_len;
+  data_json_render(json_out, sizeof(json_out), i, false, 2500, 1234.5f, json_entries, json_ids, &live_len);
+}
+
+//http_request_feed(): what a browser sends for the dashboard's poll of /data
+static const char browser_get[] =
+  "GET /data HTTP/1.1\r\n"
+  "Host: 192.168.4.1\r\n"
+  "Connection: keep-alive\r\n"
+  "User-Agent: Mozilla/5.0 (Linux; Android 14; Pixel 8) AppleWebKit/537.36 (KHTML, like Gecko) Chrome/126.0 Mobile Safari/537.36\r\n"
+  "Accept: */*\r\n"
+  "Referer: http://192.168.4.1/\r\n"
+  "Accept-Encoding: gzip, deflate\r\n"
+  "Accept-Language: en-US,en;q=0.9\r\n"
+  "If-None-Match: \"v41\"\r\n"
+  "\r\n";
+
+static void http_setup() {
+}
+
+static void http_op(uint32_t i) {
+  HttpRequest req;
+  size_t consumed;
+  http_request_init(&req);
+  http_request_feed(&req, browser_get, sizeof(browser_get) - 1, &consumed);
+}
+
+//storage_add_entry(): a finished session into the stats and the journal, round the partition several times
+static void storage_setup() {
+  host_flash_clear();
+  host_nvs_clear();
+  storage_init();
+}
+
+static void storage_op(uint32_t i) {
+  storage_add_entry(1500 + i % 700, 2000, 28800);
+}
+
+static const Bench benches[] = {
+  { "scale_sample_poll", 200000, scale_setup, scale_op },
+  { "filter_median", 2000000, filter_setup, median_op },
+  { "filter_ema", 2000000, filter_setup, ema_op },
+  { "filter_kalman", 2000000, filter_setup, kalman_op },
+  { "filter_stability", 2000000, filter_setup, stability_op },
+  { "filter_pipeline", 2000000, filter_setup, pipeline_op },
+  { "update_hydration_status", 200000, hydration_setup, hydration_op },
+  { "data_json_render", 20000, json_setup, json_op },
+  { "http_request_feed", 200000, http_setup, http_op },
+  { "storage_add_entry", 20000, storage_setup, storage_op },
+};
+
+//fastest of the repeats, the others were slowed by something else on the machine
+static BenchResult run(const Bench &b, int repeats) {
+  BenchResult best = { 0, 0, 0 };
+  for (int r = 0; r < repeats; r++) {
+    b.setup();
+    //first calls set up thread locals and the like, that isn't per op cost
+    b.op(0);
+    allocs.store(0);
+    live_bytes.store(0);
+    peak_bytes.store(0);
+    counting.store(true);
+    Clock::time_point start = Clock::now();
+    for (uint32_t i = 0; i < b.iterations; i++) b.op(i);
+    double ns = std::chrono::duration<double, std::nano>(Clock::now() - start).count();
+    counting.store(false);
+    if (r == 0 || ns / b.iterations < best.ns_per_op) best.ns_per_op = ns / b.iterations;
+    best.allocs_per_op = std::max(best.allocs_per_op, (double)allocs.load() / b.iterations);
+    best.peak_heap_bytes = std::max(best.peak_heap_bytes, peak_bytes.load());
+  }
+  return best;
+}
+
+int main(int argc, char **argv) {
+  int repeats = 9;
+  int opt;
+  while ((opt = getopt(argc, argv, "r:")) != -1) {
+    if (opt == 'r') repeats = std::max(1, atoi(optarg));
+    else {
+      fprintf(stderr, "usage: %s [-r repeats] [name...]\n", argv[0]);
+      return 2;
+    }
+  }
+  std::vector<std::string> only(argv + optind, argv + argc);
+
+  static const uint8_t data_pins[SCALE_CHANNELS] = SCALE_DATA_PINS;
+  host_clock_reset(0);
+  host_serial_mute(true);
+  host_hx711_attach(SCALE_CLK_PIN, data_pins, SCALE_CHANNELS);
+
+  printf("{\n  \"benchmarks\": [");
+  bool first = true;
+  for (const Bench &b : benches) {
+    if (!only.empty() && std::find(only.begin(), only.end(), b.name) == only.end()) continue;
+    BenchResult r = run(b, repeats);
+    printf("%s\n    {\"name\": \"%s\", \"iterations\": %lu, \"ns_per_op\": %.1f, \"allocs_per_op\": %.3f, \"peak_heap_bytes\": %lld}",
+      first ? "" : ",", b.name, (unsigned long)b.iterations, r.ns_per_op, r.allocs_per_op, (long long)r.peak_heap_bytes);
+    fflush(stdout);
+    first = false;
+  }
+  printf("\n  ]\n}\n");
+  return 0;
+}
@@ -0,0 +1,58 @@
+#!/usr/bin/env python3
+"""Compares a run of build/bench against the committed baseline.
+
+Allocations per op and peak heap are deterministic, so any increase fails.
+Timings move with the machine and whatever else runs on it, so ns/op only
+fails past a tolerance, 50% by default:
+
+    python3 bench_compare.py bench_baseline.json build/bench.json [--tolerance 0.5]
+
+After an intended change, refresh the baseline with
+./build/bench > bench_baseline.json and commit it along with the change.
+"""
+import argparse
+import json
+import sys
+
+
+def load(path):
+    with open(path, encoding="utf-8") as f:
+        return {b["name"]: b for b in json.load(f)["benchmarks"]}
+
+
+def main():
+    parser = argparse.ArgumentParser()
+    parser.add_argument("baseline")
+    parser.add_argument("current")
+    parser.add_argument("--tolerance", type=float, default=0.5, help="allowed ns/op slowdown, 0.5 is 50%%")
+    args = parser.parse_args()
+
+    baseline = load(args.baseline)
+    current = load(args.current)
+    failures = []
+    print("%-26s %12s %12s %8s %10s %10s" % ("benchmark", "base ns/op", "ns/op", "change", "allocs/op", "peak heap"))
+    for name, base in baseline.items():
+        cur = current.get(name)
+        if cur is None:
+            failures.append("%s: missing from the run" % name)
+            continue
+        change = cur["ns_per_op"] / base["ns_per_op"] - 1 if base["ns_per_op"] else 0
+        print("%-26s %12.1f %12.1f %+7.0f%% %10.3f %10d" % (name, base["ns_per_op"], cur["ns_per_op"], change * 100,
+                                                           cur["allocs_per_op"], cur["peak_heap_bytes"]))
+        if change > args.tolerance:
+            failures.append("%s: %.1f ns/op, %.0f%% slower than the baseline" % (name, cur["ns_per_op"], change * 100))
+        if cur["allocs_per_op"] > base["allocs_per_op"]:
+            failures.append("%s: %.3f allocs/op, baseline %.3f" % (name, cur["allocs_per_op"], base["allocs_per_op"]))
+        if cur["peak_heap_bytes"] > base["peak_heap_bytes"]:
+            failures.append("%s: peak heap %d bytes, baseline %d" % (name, cur["peak_heap_bytes"], base["peak_heap_bytes"]))
+    for name in current:
+        if name not in baseline:
+            print("%-26s not in the baseline" % name)
+
+    for failure in failures:
+        print("REGRESSION " + failure)
+    return 1 if failures else 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,111 @@
+#include "host.h"
+#include "exporter.h"
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <chrono>
+#include <string>
+
+//exports a dumped journal partition with the firmware's exporter, the same bytes /export would stream
+//  ./build/export [-c chunk] [-o prefix] [-f csv|ndjson|bin] flash.bin
+//every format is run and timed, -o writes them to prefix.csv, prefix.ndjson and prefix.bin, -f writes one to stdout
+//a dump comes from esptool.py read_flash 0x290000 0x40000 flash.bin (the journal in partitions.csv),
+//or from ./build/sim -d flash.bin trace.csv
+
+typedef std::chrono::steady_clock Clock;
+
+//FILE BACKED FLASH ----------------------------------------------------
+//read only, the dump is never changed, so a blank image fails to mount instead of being formatted
+static int image_fd = -1;
+
+static bool file_read(uint32_t offset, void *buf, size_t len) {
+  return pread(image_fd, buf, len, offset) == (ssize_t)len;
+}
+
+static bool file_write(uint32_t offset, const void *buf, size_t len) {
+  return false;
+}
+
+static bool file_erase(uint32_t offset, size_t len) {
+  return false;
+}
+
+static JournalFlash file_flash = { file_read, file_write, file_erase, 0 };
+
+//EXPORT ---------------------------------------------------------------
+static const char *const format_names[] = { "csv", "ndjson", "bin" };
+
+//one full export pulled chunk bytes at a time like web_pump_export(), out may be NULL
+static size_t run_export(ExportFormat format, size_t chunk, FILE *out) {
+  static Exporter e;
+  static uint8_t buf[65536];
+  exporter_begin(&e, format);
+  size_t total = 0, n;
+  while ((n = exporter_read(&e, buf, chunk)) > 0) {
+    if (out) fwrite(buf, 1, n, out);
+    total += n;
+  }
+  return total;
+}
+
+int main(int argc, char **argv) {
+  size_t chunk = WEB_EXPORT_CHUNK;
+  const char *prefix = NULL;
+  const char *only = NULL;
+  int opt;
+  while ((opt = getopt(argc, argv, "c:o:f:")) != -1) {
+    if (opt == 'c') chunk = strtoul(optarg, NULL, 10);
+    else if (opt == 'o') prefix = optarg;
+    else if (opt == 'f') only = optarg;
+    else return 2;
+  }
+  ExportFormat only_format;
+  if (optind != argc - 1 || chunk == 0 || chunk > 65536 || (only && !exporter_parse_format(only, &only_format))) {
+    fprintf(stderr, "usage: %s [-c chunk] [-o prefix] [-f csv|ndjson|bin] flash.bin\n", argv[0]);
+    return 2;
+  }
+
+  image_fd = open(argv[optind], O_RDONLY);
+  struct stat st;
+  if (image_fd < 0 || fstat(image_fd, &st) != 0) {
+    perror(argv[optind]);
+    return 1;
+  }
+  file_flash.size = st.st_size;
+  host_clock_reset(0);
+  host_serial_mute(true);
+  if (!journal_mount(&file_flash)) {
+    fprintf(stderr, "%s: no journal in the image\n", argv[optind]);
+    return 1;
+  }
+
+  if (only) {
+    run_export(only_format, chunk, stdout);
+    return 0;
+  }
+  for (int f = EXPORT_CSV; f <= EXPORT_BIN; f++) {
+    FILE *out = NULL;
+    if (prefix) {
+      std::string path = std::string(prefix) + "." + format_names[f];
+      out = fopen(path.c_str(), "wb");
+      if (!out) {
+        perror(path.c_str());
+        return 1;
+      }
+    }
+    size_t bytes = run_export((ExportFormat)f, chunk, out);
+    if (out) fclose(out);
+    //repeated until a fifth of a second went by, a small dump exports in microseconds
+    uint32_t runs = 0;
+    Clock::time_point start = Clock::now();
+    double s;
+    do {
+      run_export((ExportFormat)f, chunk, NULL);
+      runs++;
+      s = std::chrono::duration<double>(Clock::now() - start).count();
+    } while (s < 0.2);
+    printf("%-6s %8lu bytes  %8.1f us/export  %8.1f MB/s\n", format_names[f], (unsigned long)bytes,
+      s * 1e6 / runs, bytes * (double)runs / s / 1e6);
+  }
+  return 0;
+}
@@ -0,0 +1,231 @@
+#include "host.h"
+#include "sim.h"
+#include "filters.h"
+#include "events.h"
+#include <string>
+#include <vector>
+
+//how each filter pipeline settles and which sips it lets the detector catch, over weight traces
+//  ./build/filter_report traces/*.csv
+//every pipeline sees the same samples: the trace's channel 0 weights at SIM_SAMPLE_MS, SIM_NOISE_G of noise,
+//a press and rebound whenever a bottle is put down, and now and then a knock. the output goes through the
+//firmware's stability detector and sip detector (events.cpp), only the smoothing stages change
+
+#define REPORT_SETTLE_G 1.0f      // a step counts as settled once stable and this close to the true weight
+#define REPORT_SIP_TOLERANCE_G 2.0f  // a sip counts as caught when its size is this close to the true drop
+#define REPORT_KNOCK_EVERY 150    // samples between knocks on the table
+#define REPORT_KNOCK_G 25.0f
+
+struct Pipeline {
+  const char *name;
+  bool median;
+  bool ema;
+  bool kalman;
+};
+
+static const Pipeline pipelines[] = {
+  { "none", false, false, false },
+  { "median", true, false, false },
+  { "ema", false, true, false },
+  { "kalman", false, false, true },
+  { "median+ema", true, true, false },
+  { "median+kalman", true, false, true },
+};
+
+struct PipelineState {
+  MedianFilter median;
+  EmaFilter ema;
+  KalmanFilter kalman;
+  StabilityDetector stability;
+};
+
+//same stage order as scale_filter_update(), stability on the unsmoothed input
+static float pipeline_update(const Pipeline &p, PipelineState *s, uint32_t time_ms, float grams) {
+  float x = grams;
+  if (p.median) x = median_filter_update(&s->median, x);
+  if (p.ema) x = ema_filter_update(&s->ema, x, SCALE_EMA_ALPHA);
+  if (p.kalman) x = kalman_filter_update(&s->kalman, x, SCALE_KALMAN_Q, SCALE_KALMAN_R, SCALE_KALMAN_RESET);
+  stability_update(&s->stability, time_ms, grams);
+  return x;
+}
+
+//TRACE ----------------------------------------------------------------
+struct WeightRow {
+  uint32_t ms;
+  float grams;
+};
+
+//weight rows of channel 0 and where the trace ends, other rows don't matter to the filters
+static bool load_trace(const char *path, std::vector<WeightRow> *rows, uint32_t *end_ms) {
+  FILE *f = fopen(path, "r");
+  if (!f) {
+    perror(path);
+    return false;
+  }
+  char line[256];
+  *end_ms = 0;
+  while (fgets(line, sizeof(line), f)) {
+    char *hash = strchr(line, '#');
+    if (hash) *hash = '\0';
+    char kind[16];
+    unsigned long ms;
+    float grams;
+    int n = sscanf(line, " %lu , %15[a-z] , %f", &ms, kind, &grams);
+    if (n < 2) continue;
+    if (strcmp(kind, "weight") == 0 && n == 3) rows->push_back(WeightRow{ (uint32_t)ms, grams });
+    if (strcmp(kind, "end") == 0) *end_ms = ms;
+  }
+  fclose(f);
+  if (rows->empty()) return false;
+  if (*end_ms == 0) *end_ms = rows->back().ms + 60000;
+  return true;
+}
+
+struct Sip {
+  uint32_t from_ms;   //bottle put back lighter
+  uint32_t until_ms;  //next weight row
+  float grams;
+};
+
+//drops between one resting bottle and the next, the ones the detector is meant to report
+static std::vector<Sip> true_sips(const std::vector<WeightRow> &rows, uint32_t end_ms) {
+  std::vector<Sip> sips;
+  float bottle = 0;
+  for (size_t i = 0; i < rows.size(); i++) {
+    if (rows[i].grams < EVENT_EMPTY_GRAMS) continue;
+    uint32_t until = (i + 1 < rows.size()) ? rows[i + 1].ms : end_ms;
+    if (bottle > 0 && bottle - rows[i].grams >= EVENT_SIP_MIN_GRAMS) sips.push_back(Sip{ rows[i].ms, until, bottle - rows[i].grams });
+    bottle = rows[i].grams;
+  }
+  return sips;
+}
+
+//SAMPLES --------------------------------------------------------------
+static uint32_t rng;
+
+static float uniform(float span) {
+  rng = rng * 1664525 + 1013904223;
+  return ((rng >> 8) / 16777216.0f * 2 - 1) * span;
+}
+
+//what the load cell reads: the press and rebound of a bottle being put down, noise, and knocks
+static std::vector<float> make_samples(const std::vector<WeightRow> &rows, uint32_t end_ms) {
+  static const float press[] = { 15, -8, 4, -2 };
+  std::vector<float> samples;
+  rng = 12345;
+  size_t row = 0;
+  float grams = 0;
+  uint32_t since_step = 0;
+  for (uint32_t t = 0, i = 0; t < end_ms; t += SIM_SAMPLE_MS, i++) {
+    while (row < rows.size() && rows[row].ms <= t) {
+      if (rows[row].grams >= EVENT_EMPTY_GRAMS && rows[row].grams != grams) since_step = 0;
+      grams = rows[row++].grams;
+    }
+    float x = grams + uniform(SIM_NOISE_G);
+    if (grams >= EVENT_EMPTY_GRAMS && since_step < sizeof(press) / sizeof(press[0])) x += press[since_step];
+    if (i % REPORT_KNOCK_EVERY == REPORT_KNOCK_EVERY - 1) x += (i / REPORT_KNOCK_EVERY % 2) ? REPORT_KNOCK_G : -REPORT_KNOCK_G;
+    since_step++;
+    samples.push_back(x);
+  }
+  return samples;
+}
+
+//REPORT ---------------------------------------------------------------
+static std::vector<ScaleEvent> events;
+
+static void collect(const ScaleEvent *event) {
+  if (event->type == EVENT_SIP) events.push_back(*event);
+}
+
+struct Report {
+  uint32_t steps;
+  uint32_t settle_sum;    //samples from a bottle being put down to settled, over the steps that settled
+  uint32_t settle_max;
+  uint32_t unsettled;     //steps that never settled before the next row
+  uint32_t caught;
+  uint32_t missed;
+  uint32_t spurious;      //sips reported where there was none, or the wrong size
+  float error_sum;        //grams off over the caught sips
+};
+
+static Report run(const Pipeline &p, const std::vector<WeightRow> &rows, const std::vector<Sip> &sips,
+                  const std::vector<float> &samples) {
+  PipelineState s;
+  median_filter_init(&s.median);
+  ema_filter_init(&s.ema);
+  kalman_filter_init(&s.kalman);
+  stability_init(&s.stability);
+  events_init();
+  events.clear();
+
+  Report r = {};
+  size_t row = 0;
+  float truth = 0;
+  int64_t step_at = -1;   //sample index of the unsettled step, -1 when there is none
+  for (size_t i = 0; i < samples.size(); i++) {
+    uint32_t t = i * SIM_SAMPLE_MS;
+    while (row < rows.size() && rows[row].ms <= t) {
+      if (step_at >= 0) r.unsettled++;
+      truth = rows[row++].grams;
+      step_at = (truth >= EVENT_EMPTY_GRAMS) ? (int64_t)i : -1;
+      if (step_at >= 0) r.steps++;
+    }
+    ScaleSample sample;
+    sample.time_ms = t;
+    sample.grams = samples[i];
+    sample.filtered = pipeline_update(p, &s, t, samples[i]);
+    sample.stable = stability_is_stable(&s.stability, SCALE_STABLE_MAX_SLOPE, SCALE_STABLE_MAX_STDDEV);
+    events_process(0, &sample);
+    if (step_at >= 0 && sample.stable && fabsf(sample.filtered - truth) <= REPORT_SETTLE_G) {
+      uint32_t n = i - step_at;
+      r.settle_sum += n;
+      if (n > r.settle_max) r.settle_max = n;
+      step_at = -1;
+    }
+  }
+  if (step_at >= 0) r.unsettled++;
+
+  std::vector<bool> used(events.size(), false);
+  for (const Sip &sip : sips) {
+    bool found = false;
+    for (size_t e = 0; e < events.size() && !found; e++) {
+      if (used[e] || events[e].detected_ms < sip.from_ms || events[e].detected_ms >= sip.until_ms) continue;
+      if (fabsf(events[e].grams - sip.grams) > REPORT_SIP_TOLERANCE_G) continue;
+      used[e] = found = true;
+      r.error_sum += fabsf(events[e].grams - sip.grams);
+    }
+    if (found) r.caught++;
+    else r.missed++;
+  }
+  for (size_t e = 0; e < events.size(); e++) r.spurious += !used[e];
+  return r;
+}
+
+int main(int argc, char **argv) {
+  if (argc < 2) {
+    fprintf(stderr, "usage: %s trace.csv...\n", argv[0]);
+    return 2;
+  }
+  host_clock_reset(0);
+  host_serial_mute(true);
+  events_add_listener(collect);
+
+  for (int a = 1; a < argc; a++) {
+    std::vector<WeightRow> rows;
+    uint32_t end_ms;
+    if (!load_trace(argv[a], &rows, &end_ms)) return 1;
+    std::vector<Sip> sips = true_sips(rows, end_ms);
+    std::vector<float> samples = make_samples(rows, end_ms);
+    printf("%s: %u samples, %u sips\n", argv[a], (unsigned)samples.size(), (unsigned)sips.size());
+    printf("  %-14s %10s %10s %10s %7s %7s %9s %10s\n", "pipeline", "settle avg", "settle max", "unsettled",
+      "caught", "missed", "spurious", "sip error");
+    for (const Pipeline &p : pipelines) {
+      Report r = run(p, rows, sips, samples);
+      uint32_t settled = r.steps - r.unsettled;
+      printf("  %-14s %10.1f %10u %10u %7u %7u %9u %9.2fg\n", p.name, settled ? (double)r.settle_sum / settled : 0.0,
+        (unsigned)r.settle_max, (unsigned)r.unsettled, (unsigned)r.caught, (unsigned)r.missed, (unsigned)r.spurious,
+        r.caught ? r.error_sum / r.caught : 0.0f);
+    }
+  }
+  return 0;
+}
@@ -0,0 +1,102 @@
+#include "host.h"
+#include "status_led.h"
+#include <unistd.h>
+
+//what the LED costs in CPU time per second, the old 100 ms loop against the change driven engine
+//  ./build/led_report [-d seconds] [-s show_us] [-w wake_us]
+//the engine runs off its esp_timer on the virtual clock, the old loop is a task that woke every 100 ms and
+//pushed the colour every time. both go through a backend that only counts, so the device time is a model:
+//each show() costs show_us (one pixel is 24 bits at 800 kHz, 30 us on the wire, which the RMT write waits
+//out, plus the driver around it) and each wakeup of the task or timer costs wake_us (the switch in and the
+//frame math). the counts are exact, a board's hydration_led_show_seconds_total over hydration_led_frames_total
+//in /metrics gives the real show_us to pass with -s
+
+#define REPORT_OLD_PERIOD_MS 100    // the LED task's vTaskDelay before the engine
+#define REPORT_SHOW_US 60.0
+#define REPORT_WAKE_US 15.0
+
+static uint32_t shows = 0;
+
+static void count_show(LEDColor color) {
+  shows++;
+}
+
+static const LedBackend counter = { count_show };
+
+struct Scenario {
+  const char *name;
+  LEDColor from;        //look it settles on first, for the crossfade
+  LedEffect from_effect;
+  LEDColor color;
+  LedEffect effect;
+};
+
+static const Scenario scenarios[] = {
+  { "solid",     COLOR_OK, LED_SOLID, COLOR_GOOD, LED_SOLID },
+  { "crossfade", COLOR_OK, LED_SOLID, COLOR_GOOD, LED_SOLID },
+  { "blink",     COLOR_OK, LED_SOLID, COLOR_CRITICAL, LED_BLINK },
+  { "breathe",   COLOR_OK, LED_SOLID, COLOR_WAITING, LED_BREATHE },
+};
+
+struct Cost {
+  double shows;   //per second
+  double wakes;   //per second
+};
+
+//the old loop: one wakeup and one show every period, whatever is showing
+static Cost old_loop(uint32_t seconds) {
+  uint32_t n = seconds * 1000 / REPORT_OLD_PERIOD_MS;
+  return Cost{ (double)n / seconds, (double)n / seconds };
+}
+
+//the engine off its timer, every tick is a wakeup whether or not the frame reached the LED
+//the solid row starts once the look has settled, the others include the change to it
+static Cost engine(const Scenario &s, uint32_t seconds) {
+  status_led_set(s.from, s.from_effect);
+  host_advance_ms(5000);
+  if (strcmp(s.name, "solid") == 0) {
+    status_led_set(s.color, s.effect);
+    host_advance_ms(5000);
+  }
+  LedStats before;
+  status_led_get_stats(&before);
+  shows = 0;
+  status_led_set(s.color, s.effect);
+  host_advance_ms(seconds * 1000);
+  LedStats after;
+  status_led_get_stats(&after);
+  double ticks = (after.frames - before.frames) + (after.skipped - before.skipped);
+  return Cost{ (double)shows / seconds, ticks / seconds };
+}
+
+int main(int argc, char **argv) {
+  uint32_t seconds = 60;
+  double show_us = REPORT_SHOW_US, wake_us = REPORT_WAKE_US;
+  int opt;
+  while ((opt = getopt(argc, argv, "d:s:w:")) != -1) {
+    if (opt == 'd') seconds = atoi(optarg);
+    else if (opt == 's') show_us = atof(optarg);
+    else if (opt == 'w') wake_us = atof(optarg);
+    else {
+      fprintf(stderr, "usage: %s [-d seconds] [-s show_us] [-w wake_us]\n", argv[0]);
+      return 2;
+    }
+  }
+  if (seconds == 0) return 2;
+  host_clock_reset(0);
+  host_serial_mute(true);
+  status_led_init();
+  status_led_set_backend(&counter);
+
+  printf("%lu s per look, show() %.0f us, wakeup %.0f us (model)\n", (unsigned long)seconds, show_us, wake_us);
+  printf("  %-10s %22s   %22s\n", "", "old 100 ms loop", "engine");
+  printf("  %-10s %7s %7s %7s   %7s %7s %7s\n", "look", "shows/s", "wakes/s", "us/s", "shows/s", "wakes/s", "us/s");
+  for (const Scenario &s : scenarios) {
+    Cost before = old_loop(seconds);
+    Cost after = engine(s, seconds);
+    printf("  %-10s %7.2f %7.2f %7.1f   %7.2f %7.2f %7.1f\n", s.name, before.shows, before.wakes,
+      before.shows * show_us + before.wakes * wake_us, after.shows, after.wakes,
+      after.shows * show_us + after.wakes * wake_us);
+  }
+  return 0;
+}
@@ -0,0 +1,163 @@
+#include "host.h"
+#include "web.h"
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <string>
+#include <thread>
+#include <vector>
+
+//load generator for the web server: the firmware's web.cpp runs its task loop on one thread on the real clock,
+//client threads send keep-alive GETs for a while, then request rate and latency percentiles are printed
+//  ./build/loadgen [-c clients] [-d seconds] [-t task_delay_ms] [-p path]
+//the task sleeps in webserver_wait() like the sketch, -t polls with a fixed vTaskDelay instead for comparison
+
+typedef std::chrono::steady_clock Clock;
+
+struct ClientResult {
+  std::vector<uint32_t> latency_us;
+  uint32_t errors;
+};
+
+static std::atomic<bool> stop(false);
+static uint32_t passes = 0;   //times round the web task loop
+
+static int connect_server() {
+  int fd = socket(AF_INET, SOCK_STREAM, 0);
+  sockaddr_in addr = {};
+  addr.sin_family = AF_INET;
+  addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+  addr.sin_port = htons(host_web_bound_port());
+  if (connect(fd, (sockaddr *)&addr, sizeof(addr)) < 0) {
+    close(fd);
+    return -1;
+  }
+  int on = 1;
+  setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &on, sizeof(on));
+  timeval tv = { 2, 0 };
+  setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+  return fd;
+}
+
+//reads one response, headers plus Content-Length bytes of body, false on error or close
+static bool read_response(int fd, std::string *buf) {
+  char chunk[2048];
+  while (true) {
+    size_t end = buf->find("\r\n\r\n");
+    if (end != std::string::npos) {
+      size_t body = 0;
+      size_t cl = buf->find("Content-Length: ");
+      if (cl != std::string::npos && cl < end) body = strtoul(buf->c_str() + cl + 16, NULL, 10);
+      if (buf->size() >= end + 4 + body) {
+        bool ok = buf->compare(0, 12, "HTTP/1.1 200") == 0 || buf->compare(0, 12, "HTTP/1.1 304") == 0;
+        buf->erase(0, end + 4 + body);
+        return ok;
+      }
+    }
+    ssize_t n = recv(fd, chunk, sizeof(chunk), 0);
+    if (n <= 0) return false;
+    buf->append(chunk, n);
+  }
+}
+
+static void client_loop(const std::string &path, ClientResult *out) {
+  std::string request = "GET " + path + " HTTP/1.1\r\nHost: loadgen\r\n\r\n";
+  std::string buf;
+  int fd = -1;
+  while (!stop.load()) {
+    if (fd < 0) {
+      fd = connect_server();
+      buf.clear();
+      if (fd < 0) {
+        out->errors++;
+        usleep(1000);
+        continue;
+      }
+    }
+    Clock::time_point start = Clock::now();
+    bool ok = send(fd, request.data(), request.size(), MSG_NOSIGNAL) == (ssize_t)request.size() && read_response(fd, &buf);
+    if (!ok) {
+      out->errors++;
+      close(fd);
+      fd = -1;
+      continue;
+    }
+    out->latency_us.push_back(std::chrono::duration_cast<std::chrono::microseconds>(Clock::now() - start).count());
+  }
+  if (fd >= 0) close(fd);
+}
+
+//the web task from the sketch, without the idle shutdown
+static void server_loop(int task_delay_ms) {
+  while (!stop.load()) {
+    passes++;
+    webserver_handle_client();
+    web_push_events();
+    if (task_delay_ms < 0) webserver_wait(100);
+    else if (task_delay_ms > 0) vTaskDelay(task_delay_ms);
+  }
+}
+
+static double percentile(const std::vector<uint32_t> &sorted, double p) {
+  if (sorted.empty()) return 0;
+  size_t i = std::min(sorted.size() - 1, (size_t)(p * sorted.size()));
+  return sorted[i] / 1000.0;
+}
+
+int main(int argc, char **argv) {
+  int clients = WEB_MAX_CONNECTIONS;
+  double seconds = 5;
+  int task_delay_ms = -1;
+  std::string path = "/data";
+  int opt;
+  while ((opt = getopt(argc, argv, "c:d:t:p:")) != -1) {
+    if (opt == 'c') clients = atoi(optarg);
+    else if (opt == 'd') seconds = atof(optarg);
+    else if (opt == 't') task_delay_ms = atoi(optarg);
+    else if (opt == 'p') path = optarg;
+    else {
+      fprintf(stderr, "usage: %s [-c clients] [-d seconds] [-t task_delay_ms] [-p path]\n", argv[0]);
+      return 2;
+    }
+  }
+
+  host_clock_realtime(true);
+  host_web_port = 0;
+  web_enable();
+  if (host_web_bound_port() == 0) return 1;
+  std::thread server(server_loop, task_delay_ms);
+
+  std::vector<ClientResult> results(clients);
+  std::vector<std::thread> threads;
+  Clock::time_point start = Clock::now();
+  for (int i = 0; i < clients; i++) threads.emplace_back(client_loop, path, &results[i]);
+  std::this_thread::sleep_for(std::chrono::duration<double>(seconds));
+  stop.store(true);
+  double elapsed = std::chrono::duration<double>(Clock::now() - start).count();
+  //clients left in the listen backlog only notice the stop when their read times out
+  for (std::thread &t : threads) t.join();
+  server.join();
+  web_disable();
+
+  std::vector<uint32_t> all;
+  uint32_t errors = 0;
+  for (const ClientResult &r : results) {
+    all.insert(all.end(), r.latency_us.begin(), r.latency_us.end());
+    errors += r.errors;
+  }
+  std::sort(all.begin(), all.end());
+  char wait[32];
+  if (task_delay_ms < 0) snprintf(wait, sizeof(wait), "select");
+  else snprintf(wait, sizeof(wait), "poll %dms", task_delay_ms);
+  printf("path=%s clients=%d wait=%s duration=%.1fs\n", path.c_str(), clients, wait, elapsed);
+  printf("requests=%zu errors=%lu rate=%.1f req/s passes=%.1f/s\n", all.size(), (unsigned long)errors, all.size() / elapsed,
+    passes / elapsed);
+  printf("latency p50=%.2fms p90=%.2fms p99=%.2fms max=%.2fms\n", percentile(all, 0.50), percentile(all, 0.90),
+    percentile(all, 0.99), all.empty() ? 0.0 : all.back() / 1000.0);
+  return 0;
+}
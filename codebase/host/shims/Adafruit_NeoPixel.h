@@ -0,0 +1,25 @@
+#ifndef HOST_ADAFRUIT_NEOPIXEL_H
+#define HOST_ADAFRUIT_NEOPIXEL_H
+
+#include <stdint.h>
+
+#define NEO_GRB 0x52
+#define NEO_KHZ800 0x0000
+
+//keeps the pixels in RAM, show() latches pixel 0 into shown and counts
+class Adafruit_NeoPixel {
+public:
+  Adafruit_NeoPixel(uint16_t count, int16_t pin, uint16_t type);
+  void begin() {}
+  void show();
+  void setPixelColor(uint16_t n, uint32_t color);
+  void setBrightness(uint8_t level) {}
+  static uint32_t Color(uint8_t r, uint8_t g, uint8_t b) { return ((uint32_t)r << 16) | ((uint32_t)g << 8) | b; }
+
+  uint32_t pixels[4];
+  uint32_t shown;
+  uint32_t shows;
+  uint16_t count;
+};
+
+#endif // HOST_ADAFRUIT_NEOPIXEL_H
@@ -0,0 +1,104 @@
+#ifndef HOST_ARDUINO_H
+#define HOST_ARDUINO_H
+
+//host stand-in for the Arduino-ESP32 core, only what the firmware uses
+//time comes from the host clock in host.h, pins from the fake GPIO there
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <math.h>
+#include <algorithm>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/semphr.h"
+#include "freertos/event_groups.h"
+#include "esp_err.h"
+
+#define IRAM_ATTR
+#define PROGMEM
+
+#define LOW 0
+#define HIGH 1
+#define INPUT 0x01
+#define OUTPUT 0x03
+#define INPUT_PULLUP 0x05
+#define RISING 0x01
+#define FALLING 0x02
+#define CHANGE 0x03
+#define DEC 10
+#define HEX 16
+
+typedef uint8_t byte;
+
+using std::min;
+using std::max;
+
+//TIME -----------------------------------------------------------------
+unsigned long millis();
+unsigned long micros();
+void delay(uint32_t ms);
+void delayMicroseconds(uint32_t us);
+uint32_t getCpuFrequencyMhz();
+
+//GPIO -----------------------------------------------------------------
+void pinMode(uint8_t pin, uint8_t mode);
+void digitalWrite(uint8_t pin, uint8_t level);
+int digitalRead(uint8_t pin);
+int digitalPinToInterrupt(uint8_t pin);
+void attachInterrupt(uint8_t pin, void (*isr)(), int mode);
+void detachInterrupt(uint8_t pin);
+
+//LEDC -----------------------------------------------------------------
+bool ledcAttach(uint8_t pin, uint32_t freq, uint8_t resolution);
+bool ledcChangeFrequency(uint8_t pin, uint32_t freq, uint8_t resolution);
+bool ledcWrite(uint8_t pin, uint32_t duty);
+bool ledcDetach(uint8_t pin);
+
+//SERIAL ---------------------------------------------------------------
+class Print;
+
+class Printable {
+public:
+  virtual ~Printable() {}
+  virtual size_t printTo(Print &p) const = 0;
+};
+
+class Print {
+public:
+  virtual ~Print() {}
+  virtual size_t write(uint8_t c);
+  virtual size_t write(const uint8_t *data, size_t len) = 0;
+  size_t write(const char *s) { return write((const uint8_t *)s, strlen(s)); }
+  size_t printf(const char *fmt, ...) __attribute__((format(printf, 2, 3)));
+
+  size_t print(const char *s) { return write(s); }
+  size_t print(char c) { return write((uint8_t)c); }
+  size_t print(int n, int base = DEC) { return print((long)n, base); }
+  size_t print(unsigned int n, int base = DEC) { return print((unsigned long)n, base); }
+  size_t print(long n, int base = DEC);
+  size_t print(unsigned long n, int base = DEC);
+  size_t print(double n, int digits = 2);
+  size_t print(const Printable &p) { return p.printTo(*this); }
+
+  size_t println() { return write("\r\n"); }
+  template <typename T> size_t println(T value) { size_t n = print(value); return n + println(); }
+  template <typename T> size_t println(T value, int format) { size_t n = print(value, format); return n + println(); }
+};
+
+//writes to stdout, reads come from host_serial_feed()
+class HardwareSerial : public Print {
+public:
+  using Print::write;
+  void begin(unsigned long baud) {}
+  size_t write(const uint8_t *data, size_t len) override;
+  int available();
+  int read();
+  void flush();
+};
+extern HardwareSerial Serial;
+
+#endif // HOST_ARDUINO_H
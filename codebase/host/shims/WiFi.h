@@ -0,0 +1,52 @@
+#ifndef HOST_WIFI_H
+#define HOST_WIFI_H
+
+#include <Arduino.h>
+#include <memory>
+
+//host stand-in for the softAP and its client sockets, backed by POSIX sockets on 127.0.0.1
+//the web server's listening socket is plain BSD sockets, see lwip/sockets.h
+
+#define WIFI_OFF 0
+#define WIFI_AP 2
+
+class IPAddress : public Printable {
+public:
+  IPAddress(uint8_t a = 0, uint8_t b = 0, uint8_t c = 0, uint8_t d = 0) : bytes{a, b, c, d} {}
+  size_t printTo(Print &p) const override;
+  uint8_t bytes[4];
+};
+
+//shared socket like the Arduino core's, copies of a client refer to the same connection
+struct HostSocket;
+
+class WiFiClient : public Print {
+public:
+  using Print::write;
+  WiFiClient() {}
+  explicit WiFiClient(int fd);
+  size_t write(const uint8_t *data, size_t len) override;
+  int available();
+  int read();
+  int read(uint8_t *buf, size_t len);
+  uint8_t connected();
+  void stop();
+  void setNoDelay(bool on);
+  int fd() const;
+  operator bool() const;
+  bool operator==(const WiFiClient &other) const { return sock == other.sock; }
+
+private:
+  std::shared_ptr<HostSocket> sock;
+};
+
+class WiFiClass {
+public:
+  bool softAP(const char *ssid, const char *password) { return true; }
+  bool softAPdisconnect(bool wifioff) { return true; }
+  IPAddress softAPIP() { return IPAddress(127, 0, 0, 1); }
+  bool mode(int mode) { return true; }
+};
+extern WiFiClass WiFi;
+
+#endif // HOST_WIFI_H
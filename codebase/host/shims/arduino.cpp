@@ -0,0 +1,296 @@
+#include <Arduino.h>
+#include <esp_cpu.h>
+#include <esp_heap_caps.h>
+#include <esp_sleep.h>
+#include <driver/gpio.h>
+#include <Adafruit_NeoPixel.h>
+#include <stdarg.h>
+#include <unistd.h>
+#include <atomic>
+#include <chrono>
+#include <string>
+#include <thread>
+#include "host.h"
+
+//CLOCK ----------------------------------------------------------------
+static std::atomic<uint64_t> virtual_us(0);
+static std::atomic<bool> realtime(false);
+static std::chrono::steady_clock::time_point real_epoch = std::chrono::steady_clock::now();
+static uint64_t real_base_us = 0;
+
+//esp.cpp fires the timers, it needs to move the clock to each deadline on the way
+void host_clock_set(uint64_t now_us) {
+  virtual_us.store(now_us);
+}
+
+uint64_t host_now_us() {
+  if (!realtime.load()) return virtual_us.load();
+  auto d = std::chrono::steady_clock::now() - real_epoch;
+  return real_base_us + std::chrono::duration_cast<std::chrono::microseconds>(d).count();
+}
+
+void host_clock_realtime(bool on) {
+  uint64_t now = host_now_us();
+  real_epoch = std::chrono::steady_clock::now();
+  real_base_us = now;
+  virtual_us.store(now);
+  realtime.store(on);
+}
+
+unsigned long millis() {
+  return (uint32_t)(host_now_us() / 1000);  //wraps like the device's 32 bit millis()
+}
+
+unsigned long micros() {
+  return (uint32_t)host_now_us();
+}
+
+void delay(uint32_t ms) {
+  if (realtime.load()) std::this_thread::sleep_for(std::chrono::milliseconds(ms));
+  else host_advance_ms(ms);
+}
+
+//bit banging only needs the edges in order, virtual time moves without firing timers
+void delayMicroseconds(uint32_t us) {
+  if (!realtime.load()) virtual_us.fetch_add(us);
+}
+
+uint32_t getCpuFrequencyMhz() {
+  return 1000;
+}
+
+esp_cpu_cycle_count_t esp_cpu_get_cycle_count() {
+  auto d = std::chrono::steady_clock::now().time_since_epoch();
+  return (esp_cpu_cycle_count_t)std::chrono::duration_cast<std::chrono::nanoseconds>(d).count();
+}
+
+size_t heap_caps_get_free_size(uint32_t caps) { return 256 * 1024; }
+size_t heap_caps_get_minimum_free_size(uint32_t caps) { return 256 * 1024; }
+size_t heap_caps_get_largest_free_block(uint32_t caps) { return 128 * 1024; }
+
+//GPIO -----------------------------------------------------------------
+#define HOST_PINS 64
+static uint8_t pin_level[HOST_PINS];
+static void (*pin_isr[HOST_PINS])();
+static int pin_isr_mode[HOST_PINS];
+
+//HX711 on a shared clock, a pin maps to the chip driving it
+#define HOST_MAX_HX711 8
+struct HostHx711 {
+  uint8_t dout;
+  uint32_t bits;    //latched conversion, MSB goes out first
+  uint8_t shifted;  //bits clocked out of it so far
+  bool ready;
+};
+static HostHx711 chips[HOST_MAX_HX711];
+static uint8_t chip_count = 0;
+static int clk_pin = -1;
+static uint32_t pulses = 0, last_pulses = 0, readouts = 0;
+
+static void set_level(uint8_t pin, uint8_t level) {
+  uint8_t old = pin_level[pin];
+  pin_level[pin] = level;
+  if (pin_isr[pin] && old != level) {
+    bool falling = old == HIGH && level == LOW;
+    int mode = pin_isr_mode[pin];
+    if (mode == CHANGE || (mode == FALLING && falling) || (mode == RISING && !falling)) pin_isr[pin]();
+  }
+}
+
+void host_pin_set(uint8_t pin, uint8_t level) {
+  set_level(pin, level);
+}
+
+uint8_t host_pin_get(uint8_t pin) {
+  return pin_level[pin];
+}
+
+void host_hx711_attach(uint8_t clk, const uint8_t *dout_pins, uint8_t count) {
+  clk_pin = clk;
+  chip_count = count;
+  for (uint8_t i = 0; i < count; i++) {
+    chips[i] = { dout_pins[i], 0, 0, false };
+    pin_level[dout_pins[i]] = HIGH;
+  }
+}
+
+void host_hx711_convert(const int32_t *raw) {
+  for (uint8_t i = 0; i < chip_count; i++) {
+    chips[i].bits = (uint32_t)raw[i] & 0xFFFFFF;
+    chips[i].shifted = 0;
+    chips[i].ready = true;
+  }
+  pulses = 0;
+  for (uint8_t i = 0; i < chip_count; i++) set_level(chips[i].dout, LOW);
+}
+
+uint32_t host_hx711_pulses() {
+  return last_pulses;
+}
+
+uint32_t host_hx711_readouts() {
+  return readouts;
+}
+
+//a rising SCK shifts the next bit onto DOUT, the 25th puts DOUT back high until the next conversion
+static void hx711_clock() {
+  pulses++;
+  bool done = false;
+  for (uint8_t i = 0; i < chip_count; i++) {
+    HostHx711 *c = &chips[i];
+    if (!c->ready) continue;
+    if (c->shifted < 24) {
+      set_level(c->dout, (c->bits >> (23 - c->shifted)) & 1);
+      c->shifted++;
+    }
+    else {
+      c->ready = false;
+      set_level(c->dout, HIGH);
+      done = true;
+    }
+  }
+  if (done) {
+    last_pulses = pulses;
+    readouts++;
+  }
+}
+
+void pinMode(uint8_t pin, uint8_t mode) {
+  if (mode == INPUT_PULLUP) pin_level[pin] = HIGH;
+}
+
+void digitalWrite(uint8_t pin, uint8_t level) {
+  uint8_t old = pin_level[pin];
+  pin_level[pin] = level;
+  if (pin == clk_pin && old == LOW && level == HIGH) hx711_clock();
+}
+
+int digitalRead(uint8_t pin) {
+  return pin_level[pin];
+}
+
+int digitalPinToInterrupt(uint8_t pin) {
+  return pin;
+}
+
+void attachInterrupt(uint8_t pin, void (*isr)(), int mode) {
+  pin_isr[pin] = isr;
+  pin_isr_mode[pin] = mode;
+}
+
+void detachInterrupt(uint8_t pin) {
+  pin_isr[pin] = NULL;
+}
+
+esp_err_t gpio_wakeup_enable(gpio_num_t pin, gpio_int_type_t type) { return ESP_OK; }
+esp_err_t gpio_wakeup_disable(gpio_num_t pin) { return ESP_OK; }
+esp_err_t gpio_set_intr_type(gpio_num_t pin, gpio_int_type_t type) { return ESP_OK; }
+esp_err_t gpio_hold_en(gpio_num_t pin) { return ESP_OK; }
+esp_err_t gpio_hold_dis(gpio_num_t pin) { return ESP_OK; }
+
+//LEDC -----------------------------------------------------------------
+bool ledcAttach(uint8_t pin, uint32_t freq, uint8_t resolution) { return true; }
+bool ledcChangeFrequency(uint8_t pin, uint32_t freq, uint8_t resolution) { return true; }
+bool ledcWrite(uint8_t pin, uint32_t duty) { return true; }
+bool ledcDetach(uint8_t pin) { return true; }
+
+//NEOPIXEL -------------------------------------------------------------
+Adafruit_NeoPixel::Adafruit_NeoPixel(uint16_t count, int16_t pin, uint16_t type)
+  : pixels{}, shown(0), shows(0), count(count) {}
+
+void Adafruit_NeoPixel::show() {
+  shown = pixels[0];
+  shows++;
+}
+
+void Adafruit_NeoPixel::setPixelColor(uint16_t n, uint32_t color) {
+  if (n < sizeof(pixels) / sizeof(pixels[0])) pixels[n] = color;
+}
+
+//LIGHT SLEEP ----------------------------------------------------------
+static uint64_t sleep_timer_us = 0;
+static esp_sleep_wakeup_cause_t wakeup_cause = ESP_SLEEP_WAKEUP_UNDEFINED;
+
+esp_err_t esp_sleep_enable_timer_wakeup(uint64_t time_us) {
+  sleep_timer_us = time_us;
+  return ESP_OK;
+}
+
+esp_err_t esp_sleep_enable_gpio_wakeup() {
+  return ESP_OK;
+}
+
+//nothing else runs while the chip sleeps, so the clock jumps straight to the wakeup
+esp_err_t esp_light_sleep_start() {
+  if (realtime.load()) std::this_thread::sleep_for(std::chrono::microseconds(sleep_timer_us));
+  else host_advance_us(sleep_timer_us);
+  wakeup_cause = ESP_SLEEP_WAKEUP_TIMER;
+  return ESP_OK;
+}
+
+esp_sleep_wakeup_cause_t esp_sleep_get_wakeup_cause() {
+  return wakeup_cause;
+}
+
+//SERIAL ---------------------------------------------------------------
+HardwareSerial Serial;
+static std::string serial_input;
+static std::atomic<bool> serial_muted(false);
+
+void host_serial_feed(const char *text) {
+  serial_input += text;
+}
+
+void host_serial_mute(bool on) {
+  serial_muted.store(on);
+}
+
+size_t HardwareSerial::write(const uint8_t *data, size_t len) {
+  if (!serial_muted.load()) fwrite(data, 1, len, stdout);
+  return len;
+}
+
+int HardwareSerial::available() {
+  return serial_input.size();
+}
+
+int HardwareSerial::read() {
+  if (serial_input.empty()) return -1;
+  int c = (uint8_t)serial_input[0];
+  serial_input.erase(0, 1);
+  return c;
+}
+
+void HardwareSerial::flush() {
+  fflush(stdout);
+}
+
+size_t Print::write(uint8_t c) {
+  return write(&c, 1);
+}
+
+size_t Print::printf(const char *fmt, ...) {
+  char buf[256];
+  va_list args;
+  va_start(args, fmt);
+  int n = vsnprintf(buf, sizeof(buf), fmt, args);
+  va_end(args);
+  if (n < 0) return 0;
+  return write((const uint8_t *)buf, ((size_t)n < sizeof(buf)) ? n : sizeof(buf) - 1);
+}
+
+size_t Print::print(long n, int base) {
+  if (base != DEC) return print((unsigned long)n, base);
+  char buf[24];
+  return write((const uint8_t *)buf, snprintf(buf, sizeof(buf), "%ld", n));
+}
+
+size_t Print::print(unsigned long n, int base) {
+  char buf[24];
+  return write((const uint8_t *)buf, snprintf(buf, sizeof(buf), (base == HEX) ? "%lX" : "%lu", n));
+}
+
+size_t Print::print(double n, int digits) {
+  char buf[48];
+  return write((const uint8_t *)buf, snprintf(buf, sizeof(buf), "%.*f", digits, n));
+}
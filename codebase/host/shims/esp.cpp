@@ -0,0 +1,267 @@
+#include <Arduino.h>
+#include <esp_timer.h>
+#include <esp_partition.h>
+#include <nvs.h>
+#include <nvs_flash.h>
+#include <map>
+#include <mutex>
+#include <string>
+#include <vector>
+#include "host.h"
+
+void host_clock_set(uint64_t now_us);
+
+//ESP_TIMER ------------------------------------------------------------
+struct esp_timer {
+  esp_timer_cb_t callback;
+  void *arg;
+  bool active;
+  int64_t deadline_us;
+  uint64_t period_us;   //0 for one shot
+};
+
+static std::recursive_mutex timer_lock;
+static std::vector<esp_timer *> timers;
+static void (*before_start)(esp_timer_handle_t) = NULL;
+
+int64_t esp_timer_get_time() {
+  return host_now_us();
+}
+
+esp_err_t esp_timer_create(const esp_timer_create_args_t *args, esp_timer_handle_t *out) {
+  if (args == NULL || args->callback == NULL || out == NULL) return ESP_ERR_INVALID_ARG;
+  esp_timer *t = new esp_timer{ args->callback, args->arg, false, 0, 0 };
+  std::lock_guard<std::recursive_mutex> lock(timer_lock);
+  timers.push_back(t);
+  *out = t;
+  return ESP_OK;
+}
+
+static esp_err_t arm(esp_timer_handle_t timer, uint64_t timeout_us, uint64_t period_us) {
+  std::lock_guard<std::recursive_mutex> lock(timer_lock);
+  if (timer->active) return ESP_ERR_INVALID_STATE;
+  timer->active = true;
+  timer->deadline_us = host_now_us() + timeout_us;
+  timer->period_us = period_us;
+  return ESP_OK;
+}
+
+esp_err_t esp_timer_start_once(esp_timer_handle_t timer, uint64_t timeout_us) {
+  if (timer == NULL) return ESP_ERR_INVALID_ARG;
+  void (*hook)(esp_timer_handle_t) = before_start;
+  before_start = NULL;
+  if (hook) hook(timer);
+  return arm(timer, timeout_us, 0);
+}
+
+esp_err_t esp_timer_start_periodic(esp_timer_handle_t timer, uint64_t period_us) {
+  if (timer == NULL) return ESP_ERR_INVALID_ARG;
+  return arm(timer, period_us, period_us);
+}
+
+//like ESP-IDF, only a running timer can be restarted
+esp_err_t esp_timer_restart(esp_timer_handle_t timer, uint64_t timeout_us) {
+  if (timer == NULL) return ESP_ERR_INVALID_ARG;
+  std::lock_guard<std::recursive_mutex> lock(timer_lock);
+  if (!timer->active) return ESP_ERR_INVALID_STATE;
+  timer->deadline_us = host_now_us() + timeout_us;
+  if (timer->period_us) timer->period_us = timeout_us;
+  return ESP_OK;
+}
+
+esp_err_t esp_timer_stop(esp_timer_handle_t timer) {
+  if (timer == NULL) return ESP_ERR_INVALID_ARG;
+  std::lock_guard<std::recursive_mutex> lock(timer_lock);
+  if (!timer->active) return ESP_ERR_INVALID_STATE;
+  timer->active = false;
+  return ESP_OK;
+}
+
+esp_err_t esp_timer_delete(esp_timer_handle_t timer) {
+  std::lock_guard<std::recursive_mutex> lock(timer_lock);
+  if (timer->active) return ESP_ERR_INVALID_STATE;
+  for (size_t i = 0; i < timers.size(); i++) {
+    if (timers[i] == timer) timers.erase(timers.begin() + i);
+  }
+  delete timer;
+  return ESP_OK;
+}
+
+bool esp_timer_is_active(esp_timer_handle_t timer) {
+  std::lock_guard<std::recursive_mutex> lock(timer_lock);
+  return timer->active;
+}
+
+//earliest armed timer, NULL if none is due by limit_us
+static esp_timer *next_due(int64_t limit_us) {
+  esp_timer *next = NULL;
+  for (esp_timer *t : timers) {
+    if (t->active && t->deadline_us <= limit_us && (next == NULL || t->deadline_us < next->deadline_us)) next = t;
+  }
+  return next;
+}
+
+int64_t esp_timer_get_next_alarm_for_wake_up() {
+  std::lock_guard<std::recursive_mutex> lock(timer_lock);
+  esp_timer *next = next_due(INT64_MAX);
+  return next ? next->deadline_us : INT64_MAX;
+}
+
+int64_t host_timer_deadline_us(esp_timer_handle_t timer) {
+  std::lock_guard<std::recursive_mutex> lock(timer_lock);
+  return timer->active ? timer->deadline_us : -1;
+}
+
+void host_timer_before_start(void (*hook)(esp_timer_handle_t timer)) {
+  before_start = hook;
+}
+
+//fires every timer due by target_us in deadline order, the clock stands at each deadline while its callback runs
+static void run_until(int64_t target_us) {
+  while (true) {
+    esp_timer_cb_t callback;
+    void *arg;
+    {
+      std::lock_guard<std::recursive_mutex> lock(timer_lock);
+      esp_timer *t = next_due(target_us);
+      if (t == NULL) break;
+      if ((int64_t)host_now_us() < t->deadline_us) host_clock_set(t->deadline_us);
+      if (t->period_us) t->deadline_us += t->period_us;
+      else t->active = false;
+      callback = t->callback;
+      arg = t->arg;
+    }
+    callback(arg);
+  }
+}
+
+void host_timers_run() {
+  run_until(host_now_us());
+}
+
+void host_advance_us(uint64_t us) {
+  int64_t target = host_now_us() + us;
+  run_until(target);
+  if ((int64_t)host_now_us() < target) host_clock_set(target);
+}
+
+void host_advance_ms(uint32_t ms) {
+  host_advance_us((uint64_t)ms * 1000);
+}
+
+void host_clock_reset(uint64_t now_us) {
+  host_clock_realtime(false);
+  host_clock_set(now_us);
+}
+
+//NVS ------------------------------------------------------------------
+//working copy the firmware reads and writes, and what the last commit left on flash
+static std::map<std::string, std::vector<uint8_t>> nvs_working, nvs_committed;
+static std::vector<std::string> namespaces;
+static std::mutex nvs_lock;
+
+esp_err_t nvs_flash_init() {
+  return ESP_OK;
+}
+
+esp_err_t nvs_open(const char *name, nvs_open_mode_t mode, nvs_handle_t *out) {
+  std::lock_guard<std::mutex> lock(nvs_lock);
+  namespaces.push_back(name);
+  *out = namespaces.size();
+  return ESP_OK;
+}
+
+void nvs_close(nvs_handle_t handle) {}
+
+static std::string nvs_key(nvs_handle_t handle, const char *key) {
+  return namespaces[handle - 1] + "/" + key;
+}
+
+esp_err_t nvs_get_blob(nvs_handle_t handle, const char *key, void *out, size_t *len) {
+  std::lock_guard<std::mutex> lock(nvs_lock);
+  auto it = nvs_working.find(nvs_key(handle, key));
+  if (it == nvs_working.end()) return ESP_ERR_NVS_NOT_FOUND;
+  if (out == NULL) {
+    *len = it->second.size();
+    return ESP_OK;
+  }
+  if (*len < it->second.size()) return ESP_ERR_NVS_INVALID_LENGTH;
+  *len = it->second.size();
+  memcpy(out, it->second.data(), *len);
+  return ESP_OK;
+}
+
+esp_err_t nvs_set_blob(nvs_handle_t handle, const char *key, const void *value, size_t len) {
+  std::lock_guard<std::mutex> lock(nvs_lock);
+  const uint8_t *p = (const uint8_t *)value;
+  nvs_working[nvs_key(handle, key)] = std::vector<uint8_t>(p, p + len);
+  return ESP_OK;
+}
+
+esp_err_t nvs_erase_key(nvs_handle_t handle, const char *key) {
+  std::lock_guard<std::mutex> lock(nvs_lock);
+  return nvs_working.erase(nvs_key(handle, key)) ? ESP_OK : ESP_ERR_NVS_NOT_FOUND;
+}
+
+esp_err_t nvs_commit(nvs_handle_t handle) {
+  std::lock_guard<std::mutex> lock(nvs_lock);
+  nvs_committed = nvs_working;
+  return ESP_OK;
+}
+
+void host_nvs_clear() {
+  std::lock_guard<std::mutex> lock(nvs_lock);
+  nvs_working.clear();
+  nvs_committed.clear();
+}
+
+//PARTITION ------------------------------------------------------------
+#define HOST_JOURNAL_SIZE 0x40000
+#define HOST_SECTOR_SIZE 4096
+static const esp_partition_t journal_partition = {
+  ESP_PARTITION_TYPE_DATA, (esp_partition_subtype_t)0x40, 0x290000, HOST_JOURNAL_SIZE, HOST_SECTOR_SIZE, "journal"
+};
+static std::vector<uint8_t> flash(HOST_JOURNAL_SIZE, 0xFF);
+
+const esp_partition_t *esp_partition_find_first(esp_partition_type_t type, esp_partition_subtype_t subtype, const char *label) {
+  if (label && strcmp(label, journal_partition.label) != 0) return NULL;
+  if (type != ESP_PARTITION_TYPE_ANY && type != journal_partition.type) return NULL;
+  return &journal_partition;
+}
+
+esp_err_t esp_partition_read(const esp_partition_t *partition, size_t offset, void *dst, size_t size) {
+  if (offset + size > partition->size) return ESP_ERR_INVALID_SIZE;
+  memcpy(dst, flash.data() + offset, size);
+  return ESP_OK;
+}
+
+//programming can only clear bits, writing over unerased data is caught by the crc like it is on the chip
+esp_err_t esp_partition_write(const esp_partition_t *partition, size_t offset, const void *src, size_t size) {
+  if (offset + size > partition->size) return ESP_ERR_INVALID_SIZE;
+  const uint8_t *p = (const uint8_t *)src;
+  for (size_t i = 0; i < size; i++) flash[offset + i] &= p[i];
+  return ESP_OK;
+}
+
+esp_err_t esp_partition_erase_range(const esp_partition_t *partition, size_t offset, size_t size) {
+  if (offset % HOST_SECTOR_SIZE || size % HOST_SECTOR_SIZE || offset + size > partition->size) return ESP_ERR_INVALID_ARG;
+  memset(flash.data() + offset, 0xFF, size);
+  return ESP_OK;
+}
+
+void host_flash_clear() {
+  memset(flash.data(), 0xFF, flash.size());
+}
+
+//REBOOT ---------------------------------------------------------------
+void host_reboot() {
+  {
+    std::lock_guard<std::mutex> lock(nvs_lock);
+    nvs_working = nvs_committed;
+  }
+  {
+    std::lock_guard<std::recursive_mutex> lock(timer_lock);
+    for (esp_timer *t : timers) t->active = false;
+  }
+  host_clock_reset(0);
+}
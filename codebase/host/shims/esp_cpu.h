@@ -0,0 +1,10 @@
+#ifndef HOST_ESP_CPU_H
+#define HOST_ESP_CPU_H
+
+#include <stdint.h>
+
+//nanoseconds of the host's monotonic clock, getCpuFrequencyMhz() reports 1000 to match
+typedef uint32_t esp_cpu_cycle_count_t;
+esp_cpu_cycle_count_t esp_cpu_get_cycle_count();
+
+#endif // HOST_ESP_CPU_H
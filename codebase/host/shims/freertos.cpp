@@ -0,0 +1,150 @@
+#include <Arduino.h>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <string>
+#include <thread>
+
+//TASKS ----------------------------------------------------------------
+//a task is a thread plus the notification value FreeRTOS keeps in its TCB
+struct HostTask {
+  std::mutex m;
+  std::condition_variable cv;
+  uint32_t value = 0;
+  bool pending = false;   //notified since the last wait, for xTaskNotifyWait
+  std::string name;
+};
+
+//threads the host made itself (main, test threads) get a task the first time they ask
+static thread_local HostTask *current = NULL;
+
+struct TaskStart {
+  TaskFunction_t fn;
+  void *arg;
+  HostTask *task;
+};
+
+BaseType_t xTaskCreate(TaskFunction_t fn, const char *name, uint32_t stack, void *arg, UBaseType_t priority, TaskHandle_t *handle) {
+  HostTask *task = new HostTask();
+  task->name = name;
+  if (handle) *handle = task;
+  TaskStart start = { fn, arg, task };
+  std::thread([start]() {
+    current = start.task;
+    start.fn(start.arg);
+  }).detach();
+  return pdPASS;
+}
+
+TaskHandle_t xTaskGetCurrentTaskHandle() {
+  if (current == NULL) {
+    current = new HostTask();
+    current->name = "host";
+  }
+  return current;
+}
+
+void vTaskDelay(TickType_t ticks) {
+  delay(ticks);
+}
+
+TickType_t xTaskGetTickCount() {
+  return millis();
+}
+
+UBaseType_t uxTaskGetStackHighWaterMark(TaskHandle_t task) {
+  return 0;
+}
+
+const char *pcTaskGetName(TaskHandle_t task) {
+  return task ? task->name.c_str() : "";
+}
+
+//NOTIFICATIONS --------------------------------------------------------
+//waits on the host's real clock, portMAX_DELAY waits for good and 0 only polls like on FreeRTOS
+template <typename Pred>
+static bool wait_for(HostTask *task, std::unique_lock<std::mutex> &lock, TickType_t ticks, Pred ready) {
+  if (ticks == 0) return ready();
+  if (ticks == portMAX_DELAY) {
+    task->cv.wait(lock, ready);
+    return true;
+  }
+  return task->cv.wait_for(lock, std::chrono::milliseconds(ticks), ready);
+}
+
+BaseType_t xTaskNotify(TaskHandle_t task, uint32_t value, eNotifyAction action) {
+  if (task == NULL) return pdFAIL;
+  {
+    std::lock_guard<std::mutex> lock(task->m);
+    switch (action) {
+      case eSetBits: task->value |= value; break;
+      case eIncrement: task->value++; break;
+      case eSetValueWithOverwrite: task->value = value; break;
+      case eSetValueWithoutOverwrite:
+        if (task->pending) return pdFAIL;
+        task->value = value;
+        break;
+      case eNoAction:
+      default: break;
+    }
+    task->pending = true;
+  }
+  task->cv.notify_all();
+  return pdPASS;
+}
+
+BaseType_t xTaskNotifyFromISR(TaskHandle_t task, uint32_t value, eNotifyAction action, BaseType_t *woken) {
+  if (woken) *woken = pdTRUE;
+  return xTaskNotify(task, value, action);
+}
+
+BaseType_t xTaskNotifyGive(TaskHandle_t task) {
+  return xTaskNotify(task, 0, eIncrement);
+}
+
+void vTaskNotifyGiveFromISR(TaskHandle_t task, BaseType_t *woken) {
+  xTaskNotifyFromISR(task, 0, eIncrement, woken);
+}
+
+BaseType_t xTaskNotifyWait(uint32_t clear_on_entry, uint32_t clear_on_exit, uint32_t *value, TickType_t ticks) {
+  HostTask *task = xTaskGetCurrentTaskHandle();
+  std::unique_lock<std::mutex> lock(task->m);
+  if (!task->pending) task->value &= ~clear_on_entry;
+  if (!wait_for(task, lock, ticks, [task] { return task->pending; })) return pdFALSE;
+  if (value) *value = task->value;
+  task->value &= ~clear_on_exit;
+  task->pending = false;
+  return pdTRUE;
+}
+
+uint32_t ulTaskNotifyTake(BaseType_t clear, TickType_t ticks) {
+  HostTask *task = xTaskGetCurrentTaskHandle();
+  std::unique_lock<std::mutex> lock(task->m);
+  wait_for(task, lock, ticks, [task] { return task->value != 0; });
+  uint32_t value = task->value;
+  if (value) task->value = clear ? 0 : value - 1;
+  task->pending = false;
+  return value;
+}
+
+//SEMAPHORES -----------------------------------------------------------
+struct HostSemaphore {
+  std::timed_mutex m;
+};
+
+SemaphoreHandle_t xSemaphoreCreateMutex() {
+  return new HostSemaphore();
+}
+
+BaseType_t xSemaphoreTake(SemaphoreHandle_t sem, TickType_t ticks) {
+  if (ticks == portMAX_DELAY) {
+    sem->m.lock();
+    return pdTRUE;
+  }
+  return sem->m.try_lock_for(std::chrono::milliseconds(ticks)) ? pdTRUE : pdFALSE;
+}
+
+BaseType_t xSemaphoreGive(SemaphoreHandle_t sem) {
+  sem->m.unlock();
+  return pdTRUE;
+}
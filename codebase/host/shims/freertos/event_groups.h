@@ -0,0 +1,8 @@
+#ifndef HOST_EVENT_GROUPS_H
+#define HOST_EVENT_GROUPS_H
+
+#include "FreeRTOS.h"
+
+//nothing in the firmware uses event groups any more, the header is here because Arduino.h pulls it in
+
+#endif // HOST_EVENT_GROUPS_H
@@ -0,0 +1,45 @@
+#ifndef HOST_H
+#define HOST_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <esp_timer.h>
+
+//controls for the host build, the tests, the simulator and the benchmark drive the shims through these
+
+//CLOCK ----------------------------------------------------------------
+//virtual by default: time only moves when told to, and esp_timer callbacks fire on the way in deadline order
+void host_clock_reset(uint64_t now_us);
+void host_clock_realtime(bool on);      //follow the host's monotonic clock instead, for the socket tests
+uint64_t host_now_us();
+void host_advance_us(uint64_t us);
+void host_advance_ms(uint32_t ms);
+void host_timers_run();                 //fires whatever is due at the current time
+
+//TIMERS ---------------------------------------------------------------
+int64_t host_timer_deadline_us(esp_timer_handle_t timer);  //-1 when the timer isn't armed
+//runs once at the start of the next esp_timer_start_once(), as if the timer task got in right before it
+void host_timer_before_start(void (*hook)(esp_timer_handle_t timer));
+
+//GPIO AND HX711 -------------------------------------------------------
+void host_pin_set(uint8_t pin, uint8_t level);   //drives an input, a falling edge runs its interrupt
+uint8_t host_pin_get(uint8_t pin);               //last level the firmware wrote
+//HX711s on one shared clock, each shifts out its latched conversion MSB first on SCK rising edges
+void host_hx711_attach(uint8_t clk_pin, const uint8_t *dout_pins, uint8_t count);
+void host_hx711_convert(const int32_t *raw);     //one 24 bit conversion per chip, DOUT falls on all of them
+uint32_t host_hx711_pulses();                    //SCK pulses of the last readout
+uint32_t host_hx711_readouts();
+
+//STORAGE --------------------------------------------------------------
+void host_nvs_clear();
+void host_flash_clear();
+//what survives a power cycle: committed NVS and the flash, the clock and armed timers start over
+void host_reboot();
+
+//SERIAL AND WEB -------------------------------------------------------
+void host_serial_feed(const char *text);
+void host_serial_mute(bool on);
+extern int host_web_port;
+uint16_t host_web_bound_port();
+
+#endif // HOST_H
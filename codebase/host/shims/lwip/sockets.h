@@ -0,0 +1,20 @@
+#ifndef HOST_LWIP_SOCKETS_H
+#define HOST_LWIP_SOCKETS_H
+
+//host stand-in for lwIP's BSD socket API, the host's own sockets
+//bind() goes through host_bind(), which listens on 127.0.0.1 and host_web_port (0 picks a free port,
+//-1 keeps the firmware's own), host_web_bound_port() says which one it got
+
+#include <arpa/inet.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/select.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+int host_bind(int fd, const struct sockaddr *addr, socklen_t len);
+#define bind(fd, addr, len) host_bind(fd, addr, len)
+
+#endif // HOST_LWIP_SOCKETS_H
@@ -0,0 +1,8 @@
+#ifndef HOST_NVS_FLASH_H
+#define HOST_NVS_FLASH_H
+
+#include "esp_err.h"
+
+esp_err_t nvs_flash_init();
+
+#endif // HOST_NVS_FLASH_H
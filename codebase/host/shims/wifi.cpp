@@ -0,0 +1,121 @@
+#include <WiFi.h>
+#include <arpa/inet.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/ioctl.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <atomic>
+#include "host.h"
+
+#define HOST_TCP_SND_BUF 5744   // CONFIG_LWIP_TCP_SND_BUF_DEFAULT in the Arduino core's sdkconfig
+
+WiFiClass WiFi;
+int host_web_port = 0;
+static std::atomic<uint16_t> bound_port(0);
+
+uint16_t host_web_bound_port() {
+  return bound_port.load();
+}
+
+size_t IPAddress::printTo(Print &p) const {
+  return p.printf("%u.%u.%u.%u", bytes[0], bytes[1], bytes[2], bytes[3]);
+}
+
+//CLIENT ---------------------------------------------------------------
+struct HostSocket {
+  int fd;
+  explicit HostSocket(int fd) : fd(fd) {}
+  ~HostSocket() { if (fd >= 0) close(fd); }
+};
+
+//the send buffer is held to lwIP's TCP_SND_BUF on the ESP32, loopback would otherwise take megabytes before a write waits
+WiFiClient::WiFiClient(int fd) : sock(std::make_shared<HostSocket>(fd)) {
+  int size = HOST_TCP_SND_BUF;
+  setsockopt(fd, SOL_SOCKET, SO_SNDBUF, &size, sizeof(size));
+}
+
+//blocks until everything is handed to the kernel, like the Arduino core's write with its default timeout
+size_t WiFiClient::write(const uint8_t *data, size_t len) {
+  if (!sock || sock->fd < 0) return 0;
+  size_t sent = 0;
+  while (sent < len) {
+    ssize_t n = send(sock->fd, data + sent, len - sent, MSG_NOSIGNAL);
+    if (n > 0) {
+      sent += n;
+      continue;
+    }
+    if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR)) {
+      usleep(100);
+      continue;
+    }
+    break;
+  }
+  return sent;
+}
+
+int WiFiClient::available() {
+  if (!sock || sock->fd < 0) return 0;
+  int n = 0;
+  if (ioctl(sock->fd, FIONREAD, &n) < 0) return 0;
+  return n;
+}
+
+int WiFiClient::read() {
+  uint8_t c;
+  return (read(&c, 1) == 1) ? c : -1;
+}
+
+int WiFiClient::read(uint8_t *buf, size_t len) {
+  if (!sock || sock->fd < 0) return -1;
+  ssize_t n = recv(sock->fd, buf, len, MSG_DONTWAIT);
+  return (n < 0) ? -1 : (int)n;
+}
+
+//a peer that closed its end reads as end of file
+uint8_t WiFiClient::connected() {
+  if (!sock || sock->fd < 0) return 0;
+  char c;
+  ssize_t n = recv(sock->fd, &c, 1, MSG_PEEK | MSG_DONTWAIT);
+  if (n > 0) return 1;
+  if (n == 0) return 0;
+  return errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR;
+}
+
+void WiFiClient::stop() {
+  if (!sock || sock->fd < 0) return;
+  close(sock->fd);
+  sock->fd = -1;
+}
+
+void WiFiClient::setNoDelay(bool on) {
+  if (!sock || sock->fd < 0) return;
+  int flag = on;
+  setsockopt(sock->fd, IPPROTO_TCP, TCP_NODELAY, &flag, sizeof(flag));
+}
+
+int WiFiClient::fd() const {
+  return sock ? sock->fd : -1;
+}
+
+WiFiClient::operator bool() const {
+  return sock && sock->fd >= 0;
+}
+
+//SERVER ---------------------------------------------------------------
+//the firmware binds its listening socket to WEB_PORT on any address, here it goes on 127.0.0.1 and host_web_port
+int host_bind(int fd, const struct sockaddr *addr, socklen_t len) {
+  sockaddr_in in = *(const sockaddr_in *)addr;
+  in.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+  if (host_web_port >= 0) in.sin_port = htons(host_web_port);
+  if (::bind(fd, (const sockaddr *)&in, sizeof(in)) < 0) {
+    perror("bind");
+    return -1;
+  }
+  socklen_t n = sizeof(in);
+  getsockname(fd, (sockaddr *)&in, &n);
+  bound_port.store(ntohs(in.sin_port));
+  return 0;
+}
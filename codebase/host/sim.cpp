@@ -0,0 +1,223 @@
+#include "sim.h"
+#include "host.h"
+#include "scale.h"
+#include "events.h"
+#include "hydration.h"
+#include "pacing.h"
+#include "power.h"
+#include "speaker.h"
+#include "state.h"
+#include "status_led.h"
+#include "storage.h"
+#include "tracker.h"
+#include <stdarg.h>
+
+//one parsed trace row
+enum SimRowKind {
+  ROW_WEIGHT,
+  ROW_START,
+  ROW_END
+};
+
+struct SimRow {
+  uint32_t ms;
+  SimRowKind kind;
+  float values[SCALE_CHANNELS];   //weight rows
+  float goal;                     //start rows
+  uint32_t duration_s;
+  PacingCurve curve;
+};
+
+static FILE *log_out = NULL;
+static SimResult *result = NULL;
+static uint32_t rng = 12345;
+
+//same noise every run, so the replay is deterministic
+static float noise() {
+  rng = rng * 1664525 + 1013904223;
+  return ((rng >> 8) / 16777216.0f * 2 - 1) * SIM_NOISE_G;
+}
+
+static void logf_at(const char *fmt, ...) __attribute__((format(printf, 1, 2)));
+static void logf_at(const char *fmt, ...) {
+  if (log_out == NULL) return;
+  fprintf(log_out, "%9.1fs ", millis() / 1000.0);
+  va_list args;
+  va_start(args, fmt);
+  vfprintf(log_out, fmt, args);
+  va_end(args);
+  fputc('\n', log_out);
+}
+
+//CONSOLE BACKENDS -----------------------------------------------------
+static void console_show(LEDColor color) {
+  result->led_frames++;
+}
+
+static void console_tone(uint16_t freq_hz) {
+  result->tones++;
+  logf_at("speaker %u Hz", freq_hz);
+}
+
+static void console_silence() {}
+
+static const LedBackend console_led = { console_show };
+static const SpeakerBackend console_speaker = { console_tone, console_silence };
+
+//TRACE ----------------------------------------------------------------
+static bool parse_row(char *line, SimRow *row) {
+  char *hash = strchr(line, '#');
+  if (hash) *hash = '\0';
+  char *fields[SCALE_CHANNELS + 3];
+  int n = 0;
+  for (char *tok = strtok(line, ", \t\r\n"); tok && n < SCALE_CHANNELS + 3; tok = strtok(NULL, ", \t\r\n")) {
+    fields[n++] = tok;
+  }
+  if (n < 2) return false;
+  memset(row, 0, sizeof(*row));
+  row->ms = strtoul(fields[0], NULL, 10);
+  if (strcmp(fields[1], "weight") == 0) {
+    row->kind = ROW_WEIGHT;
+    for (int i = 2; i < n && i - 2 < SCALE_CHANNELS; i++) row->values[i - 2] = strtof(fields[i], NULL);
+  }
+  else if (strcmp(fields[1], "start") == 0 && n >= 4) {
+    row->kind = ROW_START;
+    row->goal = strtof(fields[2], NULL);
+    row->duration_s = strtoul(fields[3], NULL, 10);
+    row->curve = PACING_DEFAULT_CURVE;
+    if (n >= 5 && !pacing_parse_curve(fields[4], &row->curve)) return false;
+  }
+  else if (strcmp(fields[1], "end") == 0) {
+    row->kind = ROW_END;
+  }
+  else {
+    return false;
+  }
+  return true;
+}
+
+//LISTENERS ------------------------------------------------------------
+static void sim_on_scale_event(const ScaleEvent *event) {
+  static const char *const names[] = { "removed", "returned", "sip", "refill", "disturbance" };
+  logf_at("ch%u %s %.1f g", event->channel, names[event->type], event->grams);
+  if (event->type == EVENT_SIP && get_state() == STATE_RUNNING) {
+    result->sips[event->channel]++;
+    result->sipped_grams[event->channel] += event->grams;
+  }
+  if (event->type == EVENT_REFILL) result->refills++;
+}
+
+//what taskUpdateStatusLED and taskAlertUser do when the state changes
+static void sim_on_state(HydrationState prev) {
+  bool running = get_state() == STATE_RUNNING;
+  HydrationState state = get_hydration_state();
+  if (!running) status_led_show_waiting();
+  else status_led_update(state);
+  speaker_set_alerting(running && state == CRITICAL);
+  if (running && state == COMPLETED && prev != COMPLETED) speaker_play_done();
+}
+
+//SETUP AND STEP -------------------------------------------------------
+static void sim_setup() {
+  static const uint8_t data_pins[SCALE_CHANNELS] = SCALE_DATA_PINS;
+  host_clock_reset(0);
+  host_hx711_attach(SCALE_CLK_PIN, data_pins, SCALE_CHANNELS);
+  power_init();
+  storage_init();
+  scale_init();
+  status_led_init();
+  status_led_set_backend(&console_led);
+  speaker_init();
+  speaker_set_backend(&console_speaker);
+  events_init();
+  hydration_init();
+  tracker_init();
+  events_add_listener(sim_on_scale_event);
+  status_led_show_waiting();
+}
+
+//one conversion period: the HX711s convert, the sampler reads them, the tracker runs, then the timers catch up
+static void sim_step(const float grams[SCALE_CHANNELS]) {
+  int32_t raw[SCALE_CHANNELS];
+  for (uint8_t ch = 0; ch < SCALE_CHANNELS; ch++) {
+    raw[ch] = SIM_OFFSET + lroundf((grams[ch] + noise()) * (float)SCALE_CALIBRATION_VAL);
+  }
+  host_hx711_convert(raw);
+  scale_sample_poll(millis());
+
+  SystemState state = get_state();
+  HydrationState hydration = get_hydration_state();
+  tracker_step();
+  if (get_state() != state) {
+    result->state_changes++;
+    logf_at("state %s", get_state() == STATE_RUNNING ? "running" : "waiting");
+  }
+  if (get_hydration_state() != hydration) {
+    static const char *const names[] = { "completed", "hydrated", "needs_water", "critical" };
+    result->hydration_changes++;
+    logf_at("hydration %s", names[get_hydration_state()]);
+  }
+  if (get_state() != state || get_hydration_state() != hydration) sim_on_state(hydration);
+  if (state == STATE_RUNNING && get_state() != STATE_RUNNING) {
+    result->sessions++;
+    Entry entries[MAX_ENTRIES];
+    storage_load_entries(entries);
+    logf_at("session stored drank=%.0f goal=%.0f duration=%lus", entries[0].grams_drank, entries[0].goal,
+      (unsigned long)entries[0].duration);
+  }
+  host_advance_ms(SIM_SAMPLE_MS);
+}
+
+static void sim_start(const SimRow *row) {
+  logf_at("start goal=%.0f g duration=%lu s", row->goal, (unsigned long)row->duration_s);
+  set_pacing_curve(row->curve);
+  set_goal(row->goal);
+  set_time_length(row->duration_s);
+  reset();
+  set_state(STATE_RUNNING);
+  result->state_changes++;
+  sim_on_state(get_hydration_state());
+}
+
+bool sim_run(const char *trace_path, FILE *log, SimResult *out) {
+  FILE *trace = fopen(trace_path, "r");
+  if (trace == NULL) {
+    perror(trace_path);
+    return false;
+  }
+  memset(out, 0, sizeof(*out));
+  result = out;
+  log_out = log;
+  sim_setup();
+
+  float grams[SCALE_CHANNELS] = {};
+  char line[256];
+  unsigned line_no = 0;
+  bool ok = true, ended = false;
+  while (!ended && fgets(line, sizeof(line), trace)) {
+    line_no++;
+    SimRow row;
+    char copy[sizeof(line)];
+    strcpy(copy, line);
+    if (!parse_row(copy, &row)) {
+      //blank and comment lines parse as nothing
+      char *p = line + strspn(line, " \t\r\n");
+      if (*p == '\0' || *p == '#') continue;
+      fprintf(stderr, "%s:%u: bad row\n", trace_path, line_no);
+      ok = false;
+      break;
+    }
+    while (millis() < row.ms) sim_step(grams);
+    if (row.kind == ROW_WEIGHT) memcpy(grams, row.values, sizeof(grams));
+    else if (row.kind == ROW_START) sim_start(&row);
+    else ended = true;
+  }
+  fclose(trace);
+
+  storage_load_entries(out->entries);
+  PowerReport power;
+  power_get_report(millis(), &power);
+  out->avg_ma = power.avg_ma;
+  out->end_ms = millis();
+  return ok;
+}
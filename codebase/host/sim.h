@@ -0,0 +1,34 @@
+#ifndef SIM_H
+#define SIM_H
+
+#include <stdio.h>
+#include "config.h"
+
+//replays a weight trace through the firmware on the host clock: fake HX711s, RAM NVS and flash, console LED and speaker
+//every module keeps static state, so a process replays one trace
+
+//trace rows, times in ms from boot, # starts a comment
+//  <ms>,weight,<grams ch0>[,<grams ch1>...]   what sits on each pad from then on
+//  <ms>,start,<goal g>,<duration s>[,<curve>] the user submits the session form
+//  <ms>,end                                   replay stops here
+#define SIM_SAMPLE_MS 100     // HX711 at 10 SPS
+#define SIM_OFFSET 84000      // raw counts of an empty pad
+#define SIM_NOISE_G 0.5f      // uniform noise added to every conversion
+
+struct SimResult {
+  uint32_t sips[SCALE_CHANNELS];
+  float sipped_grams[SCALE_CHANNELS];
+  uint32_t refills;
+  uint32_t sessions;            // sessions that ended and were stored
+  uint32_t state_changes;       // waiting <-> running
+  uint32_t hydration_changes;   // state the LED and speaker follow
+  uint32_t tones;               // notes the speaker started
+  uint32_t led_frames;
+  Entry entries[MAX_ENTRIES];   // stored history at the end, newest first
+  float avg_ma;
+  uint32_t end_ms;
+};
+
+bool sim_run(const char *trace_path, FILE *log, SimResult *out);
+
+#endif // SIM_H
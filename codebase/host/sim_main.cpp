@@ -0,0 +1,53 @@
+#include "sim.h"
+#include <esp_partition.h>
+#include <unistd.h>
+#include <vector>
+
+//the journal partition as the device would hold it, for ./build/export
+static bool dump_journal(const char *path) {
+  const esp_partition_t *p = esp_partition_find_first(ESP_PARTITION_TYPE_DATA, ESP_PARTITION_SUBTYPE_ANY, JOURNAL_PARTITION);
+  std::vector<uint8_t> image(p->size);
+  esp_partition_read(p, 0, image.data(), image.size());
+  FILE *f = fopen(path, "wb");
+  if (!f) {
+    perror(path);
+    return false;
+  }
+  bool ok = fwrite(image.data(), 1, image.size(), f) == image.size();
+  return fclose(f) == 0 && ok;
+}
+
+//replays one trace and prints what the device would have done, -q prints only the summary, -d dumps the journal
+int main(int argc, char **argv) {
+  bool quiet = false;
+  const char *dump = NULL;
+  int opt;
+  while ((opt = getopt(argc, argv, "qd:")) != -1) {
+    if (opt == 'q') quiet = true;
+    else if (opt == 'd') dump = optarg;
+    else return 2;
+  }
+  if (optind != argc - 1) {
+    fprintf(stderr, "usage: %s [-q] [-d flash.bin] trace.csv\n", argv[0]);
+    return 2;
+  }
+
+  SimResult r;
+  if (!sim_run(argv[optind], quiet ? NULL : stdout, &r)) return 1;
+  if (dump && !dump_journal(dump)) return 1;
+
+  printf("replayed %.1f s\n", r.end_ms / 1000.0);
+  for (uint8_t ch = 0; ch < SCALE_CHANNELS; ch++) {
+    printf("ch%u sips=%u intake=%.1f g\n", ch, (unsigned)r.sips[ch], r.sipped_grams[ch]);
+  }
+  printf("refills=%u state_changes=%u hydration_changes=%u tones=%u led_frames=%u avg_ma=%.2f\n",
+    (unsigned)r.refills, (unsigned)r.state_changes, (unsigned)r.hydration_changes, (unsigned)r.tones,
+    (unsigned)r.led_frames, r.avg_ma);
+  printf("sessions=%u\n", (unsigned)r.sessions);
+  for (int i = 0; i < MAX_ENTRIES; i++) {
+    if (r.entries[i].duration == 0) continue;
+    printf("  entry %d drank=%.0f goal=%.0f duration=%lus\n", i, r.entries[i].grams_drank, r.entries[i].goal,
+      (unsigned long)r.entries[i].duration);
+  }
+  return 0;
+}
@@ -0,0 +1,115 @@
+#include "host.h"
+#include "state.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <vector>
+#include <unistd.h>
+
+//how soon a task sees a session start or end, and how often it wakes when nothing happens
+//  ./build/state_latency [-n events] [-i idle_seconds] [-p poll_ms]
+//two tasks watch the system state on the real clock: one polls get_state() every poll_ms like the tasks did
+//before the notification hub, the other blocks in state_wait(). the main thread flips the state at uneven
+//gaps longer than the poll, then leaves it alone for the idle window. latency is from set_state() to the
+//watcher noticing, on the host it is a thread wakeup rather than a FreeRTOS context switch
+
+typedef std::chrono::steady_clock Clock;
+
+struct Watcher {
+  std::vector<double> latency_ms;
+  std::atomic<uint32_t> wakeups;
+  std::atomic<bool> done;
+};
+
+static std::atomic<bool> stop(false);
+static std::atomic<int64_t> changed_ns(0);   //when the state last changed
+static uint32_t poll_ms = 100;
+static Watcher poller, subscriber;
+
+static int64_t now_ns() {
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now().time_since_epoch()).count();
+}
+
+static void record(Watcher *w, SystemState *seen) {
+  SystemState state = get_state();
+  if (state == *seen || stop.load()) return;
+  *seen = state;
+  w->latency_ms.push_back((now_ns() - changed_ns.load()) / 1e6);
+}
+
+static void task_poller(void *pv) {
+  SystemState seen = get_state();
+  while (!stop.load()) {
+    vTaskDelay(poll_ms);
+    poller.wakeups++;
+    record(&poller, &seen);
+  }
+  poller.done = true;
+}
+
+static void task_subscriber(void *pv) {
+  state_subscribe(EVT_SESSION_START | EVT_SESSION_END);
+  SystemState seen = get_state();
+  while (!stop.load()) {
+    state_wait(portMAX_DELAY);
+    subscriber.wakeups++;
+    record(&subscriber, &seen);
+  }
+  subscriber.done = true;
+}
+
+static void report(const char *name, Watcher *w, uint32_t idle_wakeups, double idle_s, int events) {
+  std::vector<double> &l = w->latency_ms;
+  std::sort(l.begin(), l.end());
+  double sum = 0;
+  for (double x : l) sum += x;
+  printf("  %-10s %6zu/%-4d %9.3f %9.3f %9.3f %9.3f %12.1f\n", name, l.size(), events, l.empty() ? 0 : sum / l.size(),
+    l.empty() ? 0 : l[l.size() / 2], l.empty() ? 0 : l[std::min(l.size() - 1, l.size() * 99 / 100)],
+    l.empty() ? 0 : l.back(), idle_wakeups / idle_s);
+}
+
+int main(int argc, char **argv) {
+  int events = 40;
+  double idle_s = 3;
+  int opt;
+  while ((opt = getopt(argc, argv, "n:i:p:")) != -1) {
+    if (opt == 'n') events = atoi(optarg);
+    else if (opt == 'i') idle_s = atof(optarg);
+    else if (opt == 'p') poll_ms = atoi(optarg);
+    else {
+      fprintf(stderr, "usage: %s [-n events] [-i idle_seconds] [-p poll_ms]\n", argv[0]);
+      return 2;
+    }
+  }
+  host_clock_realtime(true);
+  host_serial_mute(true);
+  xTaskCreate(task_poller, "poller", 2048, NULL, 1, NULL);
+  xTaskCreate(task_subscriber, "subscriber", 2048, NULL, 1, NULL);
+  std::this_thread::sleep_for(std::chrono::milliseconds(50));
+
+  //gaps of 1.5 to 4 polls, so every change is seen by the poller and lands anywhere in its period
+  uint32_t rng = 12345;
+  for (int i = 0; i < events; i++) {
+    rng = rng * 1664525 + 1013904223;
+    std::this_thread::sleep_for(std::chrono::microseconds(poll_ms * 1500 + (rng >> 8) % (poll_ms * 2500)));
+    changed_ns.store(now_ns());
+    set_state(get_state() == STATE_RUNNING ? STATE_WAITING_USER_INPUT : STATE_RUNNING);
+  }
+  std::this_thread::sleep_for(std::chrono::milliseconds(poll_ms * 2));
+
+  uint32_t poll_before = poller.wakeups.load(), sub_before = subscriber.wakeups.load();
+  std::this_thread::sleep_for(std::chrono::duration<double>(idle_s));
+  uint32_t poll_idle = poller.wakeups.load() - poll_before, sub_idle = subscriber.wakeups.load() - sub_before;
+
+  //one last change lets the subscriber see the stop
+  stop.store(true);
+  set_state(get_state() == STATE_RUNNING ? STATE_WAITING_USER_INPUT : STATE_RUNNING);
+  while (!poller.done || !subscriber.done) std::this_thread::sleep_for(std::chrono::milliseconds(1));
+
+  printf("%d state changes, %.1f s idle, poll every %lu ms\n", events, idle_s, (unsigned long)poll_ms);
+  printf("  %-10s %11s %9s %9s %9s %9s %12s\n", "watcher", "seen", "avg ms", "p50 ms", "p99 ms", "max ms", "idle wakes/s");
+  report("get_state", &poller, poll_idle, idle_s, events);
+  report("state_wait", &subscriber, sub_idle, idle_s, events);
+  return 0;
+}
@@ -0,0 +1,44 @@
+#ifndef CHECK_H
+#define CHECK_H
+
+#include <stdio.h>
+#include <math.h>
+#include <string.h>
+
+//minimal assertions for the host tests, a failed check reports and the test carries on
+//each test file has its own main() that runs its cases and returns check_report()
+
+static int check_failures = 0;
+static int check_count = 0;
+
+#define CHECK(cond) do { \
+  check_count++; \
+  if (!(cond)) { check_failures++; fprintf(stderr, "%s:%d: CHECK(%s) failed\n", __FILE__, __LINE__, #cond); } \
+} while (0)
+
+#define CHECK_EQ(a, b) do { \
+  check_count++; \
+  long long va_ = (long long)(a), vb_ = (long long)(b); \
+  if (va_ != vb_) { check_failures++; fprintf(stderr, "%s:%d: %s == %s failed, %lld != %lld\n", __FILE__, __LINE__, #a, #b, va_, vb_); } \
+} while (0)
+
+#define CHECK_NEAR(a, b, tol) do { \
+  check_count++; \
+  double va_ = (double)(a), vb_ = (double)(b); \
+  if (!(fabs(va_ - vb_) <= (tol))) { check_failures++; fprintf(stderr, "%s:%d: %s ~= %s failed, %g != %g\n", __FILE__, __LINE__, #a, #b, va_, vb_); } \
+} while (0)
+
+#define CHECK_STR(a, b) do { \
+  check_count++; \
+  const char *va_ = (a), *vb_ = (b); \
+  if (strcmp(va_, vb_) != 0) { check_failures++; fprintf(stderr, "%s:%d: %s == %s failed, \"%s\" != \"%s\"\n", __FILE__, __LINE__, #a, #b, va_, vb_); } \
+} while (0)
+
+#define RUN(test) do { int before_ = check_failures; test(); printf("%s %s\n", check_failures == before_ ? "ok  " : "FAIL", #test); } while (0)
+
+static int check_report() {
+  printf("%d checks, %d failed\n", check_count, check_failures);
+  return check_failures ? 1 : 0;
+}
+
+#endif // CHECK_H
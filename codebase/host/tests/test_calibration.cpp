@@ -0,0 +1,180 @@
+#include "check.h"
+#include "host.h"
+#include "calibration.h"
+#include "storage.h"
+
+//tare and reference averaging, rejected references, and zero tracking on a 24 bit offset
+//every conversion is at the same time so creep stays at 0
+
+static const int32_t OFFSET = 8000000;   //float steps are half a count up here
+static const float CPG = 420;
+
+static void start(int32_t offset, float counts_per_gram) {
+  CalibrationData data = { offset, counts_per_gram };
+  calibration_reset(0, &data);
+}
+
+//feeds n conversions of raw, returns the grams of the last one
+static float feed(int32_t raw, int n) {
+  float grams = 0;
+  for (int i = 0; i < n; i++) grams = calibration_apply(0, raw, 0);
+  return grams;
+}
+
+static CalibrationStatus status() {
+  CalibrationStatus s;
+  calibration_get_status(0, &s);
+  return s;
+}
+
+//what NVS holds after a flush, offset 0 and no factor when nothing was written
+static CalibrationData persisted() {
+  storage_flush(millis(), true);
+  CalibrationData data = { 0, 0 };
+  storage_get_calibration(0, &data);
+  return data;
+}
+
+//the offset is the rounded average in whole counts, and goes to NVS
+static void test_tare() {
+  host_nvs_clear();
+  storage_init();
+  start(0, CPG);
+  CHECK(calibration_request_tare(0));
+  CHECK_EQ(status().state, CAL_TARE);
+  feed(OFFSET, CAL_AVERAGE_SAMPLES / 2);
+  feed(OFFSET + 1, CAL_AVERAGE_SAMPLES - CAL_AVERAGE_SAMPLES / 2);
+  CalibrationStatus s = status();
+  CHECK_EQ(s.state, CAL_IDLE);
+  CHECK_EQ(s.error, CAL_ERR_NONE);
+  CHECK_EQ(s.data.offset, OFFSET + 1);
+  CHECK(s.stored);
+  CHECK_EQ(persisted().offset, OFFSET + 1);
+  CHECK_NEAR(feed(OFFSET + 1 + 4200, 1), 10, 1e-3);
+}
+
+//a reference that reads roughly as the weight sets the factor from the counts it moved, sign and all
+static void test_reference() {
+  host_nvs_clear();
+  //this load cell is wired so weight lowers the count, the default factor is negative
+  start(OFFSET, SCALE_CALIBRATION_VAL);
+  const int32_t counts = lroundf(500 * SCALE_CALIBRATION_VAL * 1.05f);
+  CHECK(calibration_request_reference(0, 500));
+  feed(OFFSET + counts, CAL_AVERAGE_SAMPLES);
+  CalibrationStatus s = status();
+  CHECK_EQ(s.state, CAL_IDLE);
+  CHECK_EQ(s.error, CAL_ERR_NONE);
+  CHECK_NEAR(s.data.counts_per_gram, counts / 500.0, 1e-3);
+  CHECK_EQ(s.data.offset, OFFSET);
+  CalibrationData saved = persisted();
+  CHECK_EQ(saved.offset, OFFSET);
+  CHECK_NEAR(saved.counts_per_gram, counts / 500.0, 1e-3);
+  CHECK_NEAR(feed(OFFSET + counts / 5, 1), 100, 1e-2);
+  //the other way round once the factor is positive
+  start(OFFSET, CPG);
+  CHECK(calibration_request_reference(0, 500));
+  feed(OFFSET + 500 * 410, CAL_AVERAGE_SAMPLES);
+  CHECK_EQ(status().error, CAL_ERR_NONE);
+  CHECK_NEAR(status().data.counts_per_gram, 410, 1e-3);
+  persisted();
+}
+
+//the reference is averaged, rejected with why, and nothing reaches NVS
+static void check_rejected(int32_t raw, float grams, CalibrationError error) {
+  host_nvs_clear();
+  start(OFFSET, CPG);
+  CHECK(calibration_request_reference(0, grams));
+  feed(raw, CAL_AVERAGE_SAMPLES);
+  CalibrationStatus s = status();
+  CHECK_EQ(s.state, CAL_IDLE);
+  CHECK_EQ(s.error, error);
+  CHECK_NEAR(s.data.counts_per_gram, CPG, 1e-6);
+  CHECK_EQ(persisted().counts_per_gram, 0);
+  //the next request clears it
+  CHECK(calibration_request_tare(0));
+  CHECK_EQ(status().error, CAL_ERR_NONE);
+  feed(OFFSET, CAL_AVERAGE_SAMPLES);
+  storage_flush(millis(), true);
+}
+
+static void test_reference_rejected() {
+  //the weight wasn't on the plate yet
+  check_rejected(OFFSET, 500, CAL_ERR_NO_LOAD);
+  //a few counts of noise are still nothing
+  check_rejected(OFFSET + 300, 500, CAL_ERR_NO_LOAD);
+  //20 g read is not a 500 g weight, just under the least a reference has to read
+  check_rejected(OFFSET + 20 * 420, 500, CAL_ERR_NO_LOAD);
+  check_rejected(OFFSET + (CAL_MIN_REFERENCE_READ_G - 1) * 420, 500, CAL_ERR_NO_LOAD);
+  //read as taken off, the plate was tared with something on it
+  check_rejected(OFFSET - 500 * 420, 500, CAL_ERR_WRONG_SIGN);
+  //a reference that reads far from what the old factor expects but still as weight put on is learned
+  start(OFFSET, CPG);
+  CHECK(calibration_request_reference(0, 500));
+  feed(OFFSET + CAL_MIN_REFERENCE_READ_G * 420 + 42, CAL_AVERAGE_SAMPLES);
+  CHECK_EQ(status().error, CAL_ERR_NONE);
+  CHECK_NEAR(status().data.counts_per_gram, (CAL_MIN_REFERENCE_READ_G * 420 + 42) / 500.0, 1e-3);
+}
+
+//settled readings near zero move the offset by a fraction of a count each, they add up instead of rounding away
+static void test_zero_tracking_precision() {
+  start(OFFSET, CPG);
+  const int steps = 600;
+  for (int i = 0; i < steps; i++) calibration_track(0, 0.01f, true);
+  float moved = steps * 0.01 * CPG * CAL_ZERO_ALPHA;   //50.4 counts
+  CalibrationStatus s = status();
+  CHECK_EQ(s.data.offset, OFFSET + (int32_t)moved);
+  CHECK_NEAR(s.zero_drift_g, moved / CPG, 1e-3);
+  //the part below a count still comes off the reading
+  CHECK_NEAR(feed(OFFSET + (int32_t)moved, 1), -(moved - (int32_t)moved) / CPG, 1e-4);
+  CHECK_NEAR(feed(OFFSET + 420 + (int32_t)moved, 1), 1 - (moved - (int32_t)moved) / CPG, 1e-4);
+  //negative drift the same way
+  start(OFFSET, CPG);
+  for (int i = 0; i < steps; i++) calibration_track(0, -0.01f, true);
+  CHECK_EQ(status().data.offset, OFFSET - (int32_t)moved);
+}
+
+//a bottle on the plate or a reading still moving is left alone
+static void test_zero_tracking_ignored() {
+  start(OFFSET, CPG);
+  for (int i = 0; i < 100; i++) calibration_track(0, CAL_ZERO_BAND_G, true);
+  for (int i = 0; i < 100; i++) calibration_track(0, -CAL_ZERO_BAND_G, true);
+  for (int i = 0; i < 100; i++) calibration_track(0, 1.0f, false);
+  CalibrationStatus s = status();
+  CHECK_EQ(s.data.offset, OFFSET);
+  CHECK_NEAR(s.zero_drift_g, 0, 1e-6);
+  //nor while a tare is averaging
+  CHECK(calibration_request_tare(0));
+  for (int i = 0; i < 100; i++) calibration_track(0, 1.0f, true);
+  CHECK_EQ(status().data.offset, OFFSET);
+  feed(OFFSET, CAL_AVERAGE_SAMPLES);
+}
+
+//once the tracked zero is CAL_ZERO_SAVE_G from the stored one it is written back
+static void test_zero_tracking_saved() {
+  host_nvs_clear();
+  start(0, CPG);
+  CHECK(calibration_request_tare(0));
+  feed(OFFSET, CAL_AVERAGE_SAMPLES);
+  CHECK_EQ(persisted().offset, OFFSET);
+  //12.6 counts a step, the threshold is 420
+  float per_step = 1.5 * CPG * CAL_ZERO_ALPHA;
+  int steps = (int)(CAL_ZERO_SAVE_G * CPG / per_step);
+  for (int i = 0; i < steps; i++) calibration_track(0, 1.5f, true);
+  CHECK_EQ(persisted().offset, OFFSET);
+  calibration_track(0, 1.5f, true);
+  CHECK_EQ(persisted().offset, status().data.offset);
+  CHECK(status().data.offset >= OFFSET + CAL_ZERO_SAVE_G * CPG);
+}
+
+int main() {
+  host_clock_reset(0);
+  host_serial_mute(true);
+  storage_init();
+  RUN(test_tare);
+  RUN(test_reference);
+  RUN(test_reference_rejected);
+  RUN(test_zero_tracking_precision);
+  RUN(test_zero_tracking_ignored);
+  RUN(test_zero_tracking_saved);
+  return check_report();
+}
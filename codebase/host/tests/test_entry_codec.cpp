@@ -0,0 +1,163 @@
+#include "check.h"
+#include "entry_codec.h"
+#include <stdint.h>
+
+//varints at every length boundary, zigzag, and keyframe/delta records through a codec
+
+static void test_varint_boundaries() {
+  struct { uint32_t value; size_t bytes; } cases[] = {
+    { 0, 1 }, { 1, 1 }, { 127, 1 }, { 128, 2 }, { 16383, 2 }, { 16384, 3 },
+    { (1u << 21) - 1, 3 }, { 1u << 21, 4 }, { (1u << 28) - 1, 4 }, { 1u << 28, 5 }, { UINT32_MAX, 5 },
+  };
+  for (auto &c : cases) {
+    uint8_t buf[8];
+    size_t n = varint_put(buf, c.value);
+    CHECK_EQ(n, c.bytes);
+    for (size_t i = 0; i + 1 < n; i++) CHECK(buf[i] & 0x80);
+    CHECK(!(buf[n - 1] & 0x80));
+
+    uint32_t back = 0;
+    CHECK_EQ(varint_get(buf, n, &back), n);
+    CHECK_EQ(back, c.value);
+    //cut short, it has to say so rather than return part of the value
+    CHECK_EQ(varint_get(buf, n - 1, &back), 0);
+  }
+}
+
+static void test_varint_rejects() {
+  uint32_t v = 7;
+  //six bytes with continuation bits
+  const uint8_t too_long[] = { 0x80, 0x80, 0x80, 0x80, 0x80, 0x01 };
+  CHECK_EQ(varint_get(too_long, sizeof(too_long), &v), 0);
+  //five bytes, but the last one carries bits above bit 31
+  const uint8_t too_wide[] = { 0xFF, 0xFF, 0xFF, 0xFF, 0x1F };
+  CHECK_EQ(varint_get(too_wide, sizeof(too_wide), &v), 0);
+  CHECK_EQ(v, 7);
+  CHECK_EQ(varint_get(too_long, 0, &v), 0);
+}
+
+static void test_zigzag() {
+  CHECK_EQ(zigzag_encode(0), 0);
+  CHECK_EQ(zigzag_encode(-1), 1);
+  CHECK_EQ(zigzag_encode(1), 2);
+  CHECK_EQ(zigzag_encode(-2), 3);
+  CHECK_EQ(zigzag_encode(INT32_MAX), UINT32_MAX - 1);
+  CHECK_EQ(zigzag_encode(INT32_MIN), UINT32_MAX);
+  const int32_t values[] = { 0, 1, -1, 63, -64, 64, -65, 100000, -100000, INT32_MAX, INT32_MIN };
+  for (int32_t x : values) CHECK_EQ(zigzag_decode(zigzag_encode(x)), x);
+}
+
+static const Entry sessions[] = {
+  { 3600, 1500.2f, 2000 }, { 3600, 1720.7f, 2000 }, { 1800, 400, 500 }, { 7200, 0, 3000 },
+  { 0, 0, 0 }, { UINT32_MAX, 16777215.0f, 16777215.0f }, { 60, 250, 250 },
+};
+static const int SESSION_COUNT = sizeof(sessions) / sizeof(sessions[0]);
+
+static bool same(const Entry &a, const Entry &b) {
+  return a.duration == b.duration && entry_quantise_ml(a.grams_drank) == b.grams_drank
+    && entry_quantise_ml(a.goal) == b.goal;
+}
+
+//a run of deltas decodes back to the whole millilitre values, including swings to the extremes
+static void test_round_trip() {
+  EntryCodec enc, dec;
+  entry_codec_init(&enc);
+  entry_codec_init(&dec);
+  uint8_t buf[SESSION_COUNT * ENTRY_CODEC_MAX_BYTES];
+  size_t len = 0;
+  for (int i = 0; i < SESSION_COUNT; i++) {
+    size_t n = entry_encode(&enc, &sessions[i], false, buf + len);
+    CHECK(n <= ENTRY_CODEC_MAX_BYTES);
+    //the first one goes out as a keyframe even though a delta was asked for
+    CHECK_EQ((buf[len] & ENTRY_CODEC_KEYFRAME) != 0, i == 0);
+    len += n;
+  }
+  size_t off = 0;
+  for (int i = 0; i < SESSION_COUNT; i++) {
+    Entry e;
+    size_t n = entry_decode(&dec, buf + off, len - off, &e);
+    CHECK(n > 0);
+    CHECK(same(sessions[i], e));
+    off += n;
+  }
+  CHECK_EQ(off, len);
+}
+
+//similar sessions back to back are what the deltas are for
+static void test_delta_is_small() {
+  EntryCodec enc;
+  entry_codec_init(&enc);
+  uint8_t buf[ENTRY_CODEC_MAX_BYTES];
+  CHECK_EQ(entry_encode(&enc, &sessions[0], true, buf), 7);
+  //same duration and goal are one byte each, +221 mL is two
+  CHECK_EQ(entry_encode(&enc, &sessions[1], false, buf), 5);
+  CHECK(!(buf[0] & ENTRY_CODEC_KEYFRAME));
+}
+
+//a decoder that starts late (after a reset, or on a later segment) can't use a delta until a keyframe comes
+static void test_keyframe_after_reset() {
+  EntryCodec enc, dec;
+  entry_codec_init(&enc);
+  uint8_t a[ENTRY_CODEC_MAX_BYTES], b[ENTRY_CODEC_MAX_BYTES], c[ENTRY_CODEC_MAX_BYTES];
+  size_t na = entry_encode(&enc, &sessions[0], false, a);
+  size_t nb = entry_encode(&enc, &sessions[1], false, b);
+
+  entry_codec_init(&dec);
+  Entry e;
+  CHECK_EQ(entry_decode(&dec, b, nb, &e), 0);
+  CHECK_EQ(entry_decode(&dec, a, na, &e), na);
+  CHECK_EQ(entry_decode(&dec, b, nb, &e), nb);
+  CHECK(same(sessions[1], e));
+
+  //the encoder is reset too: its next record is a keyframe and a fresh decoder reads it alone
+  entry_codec_init(&enc);
+  size_t nc = entry_encode(&enc, &sessions[2], false, c);
+  CHECK(c[0] & ENTRY_CODEC_KEYFRAME);
+  entry_codec_init(&dec);
+  CHECK_EQ(entry_decode(&dec, c, nc, &e), nc);
+  CHECK(same(sessions[2], e));
+
+  //a forced keyframe mid run resyncs a decoder that holds a stale base
+  size_t nk = entry_encode(&enc, &sessions[3], true, c);
+  CHECK(c[0] & ENTRY_CODEC_KEYFRAME);
+  EntryCodec stale;
+  entry_codec_init(&stale);
+  entry_decode(&stale, a, na, &e);
+  CHECK_EQ(entry_decode(&stale, c, nk, &e), nk);
+  CHECK(same(sessions[3], e));
+}
+
+static void test_decode_rejects() {
+  EntryCodec enc, dec;
+  entry_codec_init(&enc);
+  uint8_t buf[ENTRY_CODEC_MAX_BYTES];
+  size_t n = entry_encode(&enc, &sessions[0], true, buf);
+  Entry e;
+  for (size_t cut = 0; cut < n; cut++) {
+    entry_codec_init(&dec);
+    CHECK_EQ(entry_decode(&dec, buf, cut, &e), 0);
+  }
+  buf[0] = (ENTRY_CODEC_VERSION + 1) | ENTRY_CODEC_KEYFRAME;
+  entry_codec_init(&dec);
+  CHECK_EQ(entry_decode(&dec, buf, n, &e), 0);
+}
+
+static void test_quantise() {
+  CHECK_EQ(entry_quantise_ml(0), 0);
+  CHECK_EQ(entry_quantise_ml(-12.5f), 0);
+  CHECK_EQ(entry_quantise_ml(0.49f), 0);
+  CHECK_EQ(entry_quantise_ml(0.5f), 1);
+  CHECK_EQ(entry_quantise_ml(1499.6f), 1500);
+}
+
+int main() {
+  RUN(test_varint_boundaries);
+  RUN(test_varint_rejects);
+  RUN(test_zigzag);
+  RUN(test_round_trip);
+  RUN(test_delta_is_small);
+  RUN(test_keyframe_after_reset);
+  RUN(test_decode_rejects);
+  RUN(test_quantise);
+  return check_report();
+}
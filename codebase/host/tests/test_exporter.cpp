@@ -0,0 +1,167 @@
+#include "check.h"
+#include "host.h"
+#include "exporter.h"
+#include "series.h"
+#include <string>
+#include <vector>
+
+//framing of the three export formats, read through buffers of every size
+
+struct Record {
+  uint8_t type;
+  uint32_t id;
+  std::vector<uint8_t> payload;
+};
+
+static EntryCodec encoder;
+
+static uint32_t append_session(uint32_t duration, float drank, float goal, bool keyframe) {
+  Entry e = { duration, drank, goal };
+  uint8_t packed[ENTRY_CODEC_MAX_BYTES];
+  size_t n = entry_encode(&encoder, &e, keyframe, packed);
+  return journal_append(JREC_SESSION_PACKED, packed, n);
+}
+
+//two sessions, a reset, then one with a full series after it, long enough that the BIN length needs both bytes
+static void fill_journal() {
+  host_flash_clear();
+  CHECK(journal_mount(NULL));
+  entry_codec_init(&encoder);
+  append_session(3600, 1500, 2000, true);
+  append_session(1800, 420, 500, false);
+  journal_append(JREC_RESET, NULL, 0);
+  uint32_t id = append_session(600, 250, 300, false);
+  for (uint32_t t = 0; t < SERIES_MAX_BUCKETS * SERIES_BASE_BUCKET_MS; t += 1000) {
+    series_record(t, (t / 1000) * 7 % 1000, 300 + (t / 1000) * 13 % 700);
+  }
+  series_end(id);
+}
+
+static bool collect(uint8_t type, uint32_t id, const uint8_t *data, uint16_t len, void *ctx) {
+  ((std::vector<Record> *)ctx)->push_back(Record{ type, id, std::vector<uint8_t>(data, data + len) });
+  return true;
+}
+
+static std::string export_all(ExportFormat format, size_t chunk) {
+  static Exporter e;
+  exporter_begin(&e, format);
+  std::string out;
+  std::vector<uint8_t> buf(chunk);
+  size_t n;
+  while ((n = exporter_read(&e, buf.data(), chunk)) > 0) {
+    if (n > chunk) return "overrun";
+    out.append((const char *)buf.data(), n);
+  }
+  //stays at the end
+  if (exporter_read(&e, buf.data(), chunk) != 0) return "read past end";
+  return out;
+}
+
+static std::vector<std::string> lines(const std::string &text) {
+  std::vector<std::string> out;
+  size_t start = 0, nl;
+  while ((nl = text.find('\n', start)) != std::string::npos) {
+    out.push_back(text.substr(start, nl - start));
+    start = nl + 1;
+  }
+  if (start < text.size()) out.push_back(text.substr(start));   //unterminated tail, a framing bug
+  return out;
+}
+
+static bool starts_with(const std::string &s, const char *prefix) {
+  return s.compare(0, strlen(prefix), prefix) == 0;
+}
+
+//a 1 byte read, odd sizes, and sizes bigger than the whole export all give the same bytes
+static void test_read_sizes() {
+  fill_journal();
+  const size_t sizes[] = { 1, 2, 3, 7, 64, 1000, 65536 };
+  for (ExportFormat f : { EXPORT_CSV, EXPORT_NDJSON, EXPORT_BIN }) {
+    std::string whole = export_all(f, 4096);
+    CHECK(!whole.empty());
+    for (size_t s : sizes) CHECK(export_all(f, s) == whole);
+  }
+}
+
+static void test_csv() {
+  fill_journal();
+  std::string csv = export_all(EXPORT_CSV, 5);
+  CHECK(csv.back() == '\n');
+  std::vector<std::string> rows = lines(csv);
+  CHECK_STR(rows[0].c_str(), "kind,id,duration_s,drank_ml,goal_ml,t_s,intake_min_ml,intake_max_ml,pacer_min_ml,pacer_max_ml");
+  //every row has the header's ten columns
+  int bad = 0;
+  for (const std::string &r : rows) bad += std::count(r.begin(), r.end(), ',') != 9;
+  CHECK_EQ(bad, 0);
+  CHECK_EQ(rows.size(), 1 + 4 + SERIES_MAX_BUCKETS);
+  CHECK_STR(rows[1].c_str(), "session,1,3600,1500,2000,,,,,");
+  CHECK_STR(rows[2].c_str(), "session,2,1800,420,500,,,,,");
+  CHECK_STR(rows[3].c_str(), "reset,3,,,,,,,,");
+  CHECK_STR(rows[4].c_str(), "session,4,600,250,300,,,,,");
+  CHECK(starts_with(rows[5], "point,4,,,,0,"));
+  CHECK(starts_with(rows.back(), "point,4,,,,475,"));
+}
+
+static void test_ndjson() {
+  fill_journal();
+  std::string nd = export_all(EXPORT_NDJSON, 3);
+  CHECK(nd.back() == '\n');
+  std::vector<std::string> rows = lines(nd);
+  CHECK_EQ(rows.size(), 4 + SERIES_MAX_BUCKETS);
+  int bad = 0;
+  for (const std::string &r : rows) bad += r.front() != '{' || r.back() != '}' || r.find('\n') != std::string::npos;
+  CHECK_EQ(bad, 0);
+  CHECK_STR(rows[0].c_str(), "{\"type\":\"session\",\"id\":1,\"duration_s\":3600,\"drank_ml\":1500,\"goal_ml\":2000}");
+  CHECK_STR(rows[2].c_str(), "{\"type\":\"reset\",\"id\":3}");
+  CHECK(starts_with(rows[4], "{\"type\":\"point\",\"session\":4,\"t_s\":0,\"intake_ml\":["));
+}
+
+//the binary form is the journal itself: prefix, then every record framed as type, id, len, payload
+static void test_bin() {
+  fill_journal();
+  std::vector<Record> records;
+  journal_iterate(collect, &records);
+  CHECK_EQ(records.size(), 5);
+  CHECK(records.back().payload.size() > 255);
+
+  std::string bin = export_all(EXPORT_BIN, 7);
+  const uint8_t *p = (const uint8_t *)bin.data();
+  size_t len = bin.size();
+  CHECK(len >= 4 && memcmp(p, "HJX\x01", 4) == 0);
+  size_t off = 4;
+  size_t i = 0;
+  int bad = 0;
+  while (off + 7 <= len) {
+    uint8_t type = p[off];
+    uint32_t id = p[off + 1] | p[off + 2] << 8 | p[off + 3] << 16 | (uint32_t)p[off + 4] << 24;
+    uint16_t n = p[off + 5] | p[off + 6] << 8;
+    off += 7;
+    if (off + n > len || i >= records.size()) {
+      bad++;
+      break;
+    }
+    const Record &r = records[i++];
+    if (r.type != type || r.id != id || r.payload.size() != n || memcmp(r.payload.data(), p + off, n) != 0) bad++;
+    off += n;
+  }
+  CHECK_EQ(bad, 0);
+  CHECK_EQ(i, records.size());
+  CHECK_EQ(off, len);
+}
+
+static void test_empty_journal() {
+  host_flash_clear();
+  CHECK(journal_mount(NULL));
+  CHECK_EQ(lines(export_all(EXPORT_CSV, 16)).size(), 1);
+  CHECK_EQ(export_all(EXPORT_NDJSON, 16).size(), 0);
+  CHECK_EQ(export_all(EXPORT_BIN, 16).size(), 4);
+}
+
+int main() {
+  RUN(test_read_sizes);
+  RUN(test_csv);
+  RUN(test_ndjson);
+  RUN(test_bin);
+  RUN(test_empty_journal);
+  return check_report();
+}
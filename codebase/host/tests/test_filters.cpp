@@ -0,0 +1,165 @@
+#include "check.h"
+#include "filters.h"
+#include <algorithm>
+
+//streaming filters against straightforward reference versions
+
+static uint32_t rng = 1;
+static float uniform(float span) {
+  rng = rng * 1664525 + 1013904223;
+  return ((rng >> 8) / 16777216.0f * 2 - 1) * span;
+}
+
+static void test_median_matches_sort() {
+  MedianFilter f;
+  median_filter_init(&f);
+  float history[1000];
+  int mismatches = 0;
+  for (int i = 0; i < 1000; i++) {
+    //whole grams so equal values show up and exercise the removal path
+    history[i] = roundf(uniform(10));
+    float got = median_filter_update(&f, history[i]);
+    int n = std::min(i + 1, SCALE_MEDIAN_WINDOW);
+    float window[SCALE_MEDIAN_WINDOW];
+    std::copy(history + i + 1 - n, history + i + 1, window);
+    std::sort(window, window + n);
+    if (got != window[n / 2]) mismatches++;
+  }
+  CHECK_EQ(mismatches, 0);
+}
+
+static void test_median_rejects_spike() {
+  MedianFilter f;
+  median_filter_init(&f);
+  for (int i = 0; i < SCALE_MEDIAN_WINDOW; i++) median_filter_update(&f, 500);
+  CHECK_EQ(median_filter_update(&f, 5000), 500);
+  CHECK_EQ(median_filter_update(&f, 500), 500);
+}
+
+static void test_ema() {
+  EmaFilter f;
+  ema_filter_init(&f);
+  CHECK_EQ(ema_filter_update(&f, 100, 0.5f), 100);  //first sample primes it
+  CHECK_NEAR(ema_filter_update(&f, 200, 0.5f), 150, 1e-4);
+  CHECK_NEAR(ema_filter_update(&f, 200, 0.5f), 175, 1e-4);
+  for (int i = 0; i < 40; i++) ema_filter_update(&f, 200, 0.5f);
+  CHECK_NEAR(f.value, 200, 1e-3);
+}
+
+static void test_kalman_smooths_noise() {
+  KalmanFilter f;
+  kalman_filter_init(&f);
+  double in_sq = 0, out_sq = 0;
+  for (int i = 0; i < 2000; i++) {
+    float x = 700 + uniform(8);
+    float y = kalman_filter_update(&f, x, SCALE_KALMAN_Q, SCALE_KALMAN_R, SCALE_KALMAN_RESET);
+    if (i >= 100) {
+      in_sq += (x - 700) * (x - 700);
+      out_sq += (y - 700) * (y - 700);
+    }
+  }
+  CHECK(out_sq < in_sq / 4);
+  CHECK_NEAR(f.estimate, 700, 3);
+}
+
+static void test_kalman_resets_on_jump() {
+  KalmanFilter f;
+  kalman_filter_init(&f);
+  for (int i = 0; i < 50; i++) kalman_filter_update(&f, 700, SCALE_KALMAN_Q, SCALE_KALMAN_R, SCALE_KALMAN_RESET);
+  //bottle lifted, the estimate goes straight there instead of easing down
+  CHECK_EQ(kalman_filter_update(&f, 0, SCALE_KALMAN_Q, SCALE_KALMAN_R, SCALE_KALMAN_RESET), 0);
+  CHECK_EQ(f.variance, SCALE_KALMAN_R);
+  //a small step is followed gradually
+  float y = kalman_filter_update(&f, 20, SCALE_KALMAN_Q, SCALE_KALMAN_R, SCALE_KALMAN_RESET);
+  CHECK(y > 0 && y < 20);
+}
+
+static void test_stability_constant() {
+  StabilityDetector d;
+  stability_init(&d);
+  for (int i = 0; i < SCALE_STABLE_WINDOW - 1; i++) {
+    stability_update(&d, i * 100, 500);
+    CHECK(!stability_is_stable(&d, SCALE_STABLE_MAX_SLOPE, SCALE_STABLE_MAX_STDDEV));  //window not full yet
+  }
+  stability_update(&d, SCALE_STABLE_WINDOW * 100, 500);
+  CHECK(stability_is_stable(&d, SCALE_STABLE_MAX_SLOPE, SCALE_STABLE_MAX_STDDEV));
+  CHECK_NEAR(d.slope, 0, 1e-3);
+  CHECK_NEAR(d.stddev, 0, 1e-3);
+}
+
+static void test_stability_ramp() {
+  StabilityDetector d;
+  stability_init(&d);
+  //20 g/s at 10 SPS
+  for (int i = 0; i < 100; i++) stability_update(&d, i * 100, 300 + i * 2.0f);
+  CHECK_NEAR(d.slope, 20, 0.05);
+  CHECK(!stability_is_stable(&d, SCALE_STABLE_MAX_SLOPE, SCALE_STABLE_MAX_STDDEV));
+}
+
+//the sliding sums drift in float, the periodic resync has to keep them next to a fresh computation
+static void test_stability_matches_reference() {
+  StabilityDetector d;
+  stability_init(&d);
+  const int n = SCALE_STABLE_WINDOW;
+  float xs[n];
+  uint32_t ts[n];
+  double worst_std = 0, worst_slope = 0;
+  for (int i = 0; i < 20000; i++) {
+    float x = 4000 + 30 * sinf(i * 0.01f) + uniform(3);
+    uint32_t t = i * 100 + (i % 3);
+    stability_update(&d, t, x);
+    xs[i % n] = x;
+    ts[i % n] = t;
+    if (i < n) continue;
+
+    double mean = 0;
+    for (int k = 0; k < n; k++) mean += xs[k];
+    mean /= n;
+    double var = 0, sxy = 0, sxx = 0;
+    for (int k = 0; k < n; k++) {
+      int idx = (i - (n - 1) + k) % n;   //oldest first
+      var += (xs[idx] - mean) * (xs[idx] - mean);
+      sxy += (k - (n - 1) / 2.0) * (xs[idx] - mean);
+      sxx += (k - (n - 1) / 2.0) * (k - (n - 1) / 2.0);
+    }
+    double stddev = sqrt(var / n);
+    double span = ts[i % n] - ts[(i + 1) % n];
+    double slope = sxy / sxx * (n - 1) * 1000.0 / span;
+    worst_std = std::max(worst_std, fabs(stddev - d.stddev));
+    worst_slope = std::max(worst_slope, fabs(slope - d.slope));
+  }
+  CHECK(worst_std < 0.05);
+  CHECK(worst_slope < 0.5);
+}
+
+//a bottle set down: the pipeline lands on the new weight and only calls it stable once the window has settled
+static void test_pipeline_step() {
+  ScaleFilter f;
+  scale_filter_init(&f);
+  uint32_t t = 0;
+  for (int i = 0; i < 30; i++, t += 100) scale_filter_update(&f, t, uniform(0.5));
+  CHECK(scale_filter_stable(&f));
+
+  int stable_after = -1;
+  float y = 0;
+  for (int i = 0; i < 30; i++, t += 100) {
+    y = scale_filter_update(&f, t, 650 + uniform(0.5));
+    if (i < 2) CHECK(!scale_filter_stable(&f));
+    if (stable_after < 0 && scale_filter_stable(&f)) stable_after = i;
+  }
+  CHECK_NEAR(y, 650, 1);
+  CHECK(stable_after >= SCALE_STABLE_WINDOW - 2 && stable_after <= SCALE_STABLE_WINDOW);
+}
+
+int main() {
+  RUN(test_median_matches_sort);
+  RUN(test_median_rejects_spike);
+  RUN(test_ema);
+  RUN(test_kalman_smooths_noise);
+  RUN(test_kalman_resets_on_jump);
+  RUN(test_stability_constant);
+  RUN(test_stability_ramp);
+  RUN(test_stability_matches_reference);
+  RUN(test_pipeline_step);
+  return check_report();
+}
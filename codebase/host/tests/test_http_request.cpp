@@ -0,0 +1,166 @@
+#include "check.h"
+#include "http_request.h"
+#include <string>
+
+//the incremental request parser: reads split anywhere, pipelined requests, and the refusals
+
+static const char REQUEST[] =
+  "GET /set_goal?goal=750&duration=3600&curve=front HTTP/1.1\r\n"
+  "Host: 192.168.4.1\r\n"
+  "Accept: */*\r\n"
+  "If-None-Match:   \"5a-3\"  \r\n"
+  "Connection: keep-alive\r\n"
+  "\r\n";
+
+static HttpParseResult parse(HttpRequest *req, const std::string &text, size_t *consumed = NULL) {
+  http_request_init(req);
+  return http_request_feed(req, text.data(), text.size(), consumed);
+}
+
+static void check_request(const HttpRequest *req) {
+  CHECK_STR(req->method, "GET");
+  CHECK_STR(req->path, "/set_goal");
+  CHECK_STR(req->query, "goal=750&duration=3600&curve=front");
+  CHECK_STR(req->if_none_match, "\"5a-3\"");
+  CHECK(req->keep_alive);
+}
+
+static void test_whole() {
+  HttpRequest req;
+  size_t consumed = 0;
+  CHECK_EQ(parse(&req, REQUEST, &consumed), HTTP_PARSE_DONE);
+  CHECK_EQ(consumed, sizeof(REQUEST) - 1);
+  check_request(&req);
+}
+
+//a TCP read can end anywhere, including between \r and \n
+static void test_split_everywhere() {
+  const size_t len = sizeof(REQUEST) - 1;
+  int wrong = 0;
+  for (size_t cut = 0; cut <= len; cut++) {
+    HttpRequest req;
+    http_request_init(&req);
+    size_t a = 0, b = 0;
+    HttpParseResult first = http_request_feed(&req, REQUEST, cut, &a);
+    HttpParseResult second = http_request_feed(&req, REQUEST + cut, len - cut, &b);
+    if ((cut < len && first != HTTP_PARSE_MORE) || second != HTTP_PARSE_DONE || a + b != len) wrong++;
+    else check_request(&req);
+  }
+  CHECK_EQ(wrong, 0);
+
+  HttpRequest req;
+  http_request_init(&req);
+  HttpParseResult r = HTTP_PARSE_MORE;
+  for (size_t i = 0; i < len && r == HTTP_PARSE_MORE; i++) r = http_request_feed(&req, REQUEST + i, 1, NULL);
+  CHECK_EQ(r, HTTP_PARSE_DONE);
+  check_request(&req);
+}
+
+//the parser stops right after the blank line, the rest is the next request
+static void test_pipelined() {
+  std::string two = std::string("GET /data HTTP/1.1\r\n\r\n") + REQUEST;
+  HttpRequest req;
+  size_t consumed = 0;
+  CHECK_EQ(parse(&req, two, &consumed), HTTP_PARSE_DONE);
+  CHECK_EQ(consumed, strlen("GET /data HTTP/1.1\r\n\r\n"));
+  CHECK_STR(req.path, "/data");
+  CHECK_STR(req.query, "");
+
+  //a finished parser takes nothing more until it is reset
+  size_t more = 1;
+  CHECK_EQ(http_request_feed(&req, two.data() + consumed, two.size() - consumed, &more), HTTP_PARSE_DONE);
+  CHECK_EQ(more, 0);
+
+  size_t rest = 0;
+  CHECK_EQ(parse(&req, two.substr(consumed), &rest), HTTP_PARSE_DONE);
+  CHECK_EQ(rest, two.size() - consumed);
+  check_request(&req);
+}
+
+static void test_keep_alive() {
+  HttpRequest req;
+  CHECK_EQ(parse(&req, "GET / HTTP/1.0\r\n\r\n"), HTTP_PARSE_DONE);
+  CHECK(!req.keep_alive);
+  CHECK_EQ(parse(&req, "GET / HTTP/1.0\r\nConnection: Keep-Alive\r\n\r\n"), HTTP_PARSE_DONE);
+  CHECK(req.keep_alive);
+  CHECK_EQ(parse(&req, "GET / HTTP/1.1\r\nconnection:close\r\n\r\n"), HTTP_PARSE_DONE);
+  CHECK(!req.keep_alive);
+  //bare \n line endings are accepted too
+  CHECK_EQ(parse(&req, "GET / HTTP/1.1\nHost: x\n\n"), HTTP_PARSE_DONE);
+  CHECK(req.keep_alive);
+}
+
+static void test_bad() {
+  HttpRequest req;
+  CHECK_EQ(parse(&req, "get / HTTP/1.1\r\n\r\n"), HTTP_PARSE_BAD);
+  CHECK_EQ(parse(&req, " / HTTP/1.1\r\n\r\n"), HTTP_PARSE_BAD);
+  CHECK_EQ(parse(&req, "GET  HTTP/1.1\r\n\r\n"), HTTP_PARSE_BAD);
+  CHECK_EQ(parse(&req, "GET /\r\n\r\n"), HTTP_PARSE_BAD);
+  CHECK_EQ(parse(&req, "GET / SPDY/3\r\n\r\n"), HTTP_PARSE_BAD);
+  CHECK_EQ(parse(&req, "GET / HTTP/1.1\r\nno colon here\r\n\r\n"), HTTP_PARSE_BAD);
+  CHECK_EQ(parse(&req, "VERYLONGMETHOD / HTTP/1.1\r\n\r\n"), HTTP_PARSE_BAD);
+}
+
+static void test_too_large() {
+  HttpRequest req;
+  std::string path(HTTP_MAX_PATH, 'a');
+  CHECK_EQ(parse(&req, "GET /" + path + " HTTP/1.1\r\n\r\n"), HTTP_PARSE_TOO_LARGE);
+  std::string query(HTTP_MAX_QUERY, 'q');
+  CHECK_EQ(parse(&req, "GET /?" + query + " HTTP/1.1\r\n\r\n"), HTTP_PARSE_TOO_LARGE);
+
+  //one byte under the limit still parses, one over is refused, however it arrives
+  std::string head = "GET / HTTP/1.1\r\nX-Pad: ";
+  std::string tail = "\r\n\r\n";
+  std::string fits = head + std::string(HTTP_MAX_HEADER - head.size() - tail.size(), 'p') + tail;
+  CHECK_EQ(fits.size(), HTTP_MAX_HEADER);
+  CHECK_EQ(parse(&req, fits), HTTP_PARSE_DONE);
+  std::string over = head + std::string(HTTP_MAX_HEADER + 1 - head.size() - tail.size(), 'p') + tail;
+  CHECK_EQ(parse(&req, over), HTTP_PARSE_TOO_LARGE);
+  http_request_init(&req);
+  HttpParseResult r = HTTP_PARSE_MORE;
+  for (size_t i = 0; i < over.size() && r == HTTP_PARSE_MORE; i += 100) {
+    r = http_request_feed(&req, over.data() + i, std::min<size_t>(100, over.size() - i), NULL);
+  }
+  CHECK_EQ(r, HTTP_PARSE_TOO_LARGE);
+
+  //a long header name is only kept as a prefix, not refused
+  CHECK_EQ(parse(&req, "GET / HTTP/1.1\r\n" + std::string(60, 'N') + ": v\r\n\r\n"), HTTP_PARSE_DONE);
+}
+
+static void test_query() {
+  HttpRequest req;
+  parse(&req, "GET /q?goal=750&go=1&empty=&f=2.5&neg=-40&bad=12x&long=123456789012345678 HTTP/1.1\r\n\r\n");
+  char value[8];
+  CHECK(http_query_get(&req, "go", value, sizeof(value)));   //not fooled by "goal"
+  CHECK_STR(value, "1");
+  CHECK(http_query_get(&req, "empty", value, sizeof(value)));
+  CHECK_STR(value, "");
+  CHECK(!http_query_get(&req, "g", value, sizeof(value)));
+  CHECK(!http_query_get(&req, "missing", value, sizeof(value)));
+  CHECK(!http_query_get(&req, "long", value, sizeof(value)));   //doesn't fit
+
+  long n = 0;
+  CHECK(http_query_get_long(&req, "goal", &n));
+  CHECK_EQ(n, 750);
+  CHECK(http_query_get_long(&req, "neg", &n));
+  CHECK_EQ(n, -40);
+  CHECK(!http_query_get_long(&req, "bad", &n));
+  CHECK(!http_query_get_long(&req, "empty", &n));
+  CHECK(!http_query_get_long(&req, "long", &n));
+
+  float f = 0;
+  CHECK(http_query_get_float(&req, "f", &f));
+  CHECK_NEAR(f, 2.5, 1e-6);
+  CHECK(!http_query_get_float(&req, "bad", &f));
+}
+
+int main() {
+  RUN(test_whole);
+  RUN(test_split_everywhere);
+  RUN(test_pipelined);
+  RUN(test_keep_alive);
+  RUN(test_bad);
+  RUN(test_too_large);
+  RUN(test_query);
+  return check_report();
+}
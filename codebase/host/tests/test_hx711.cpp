@@ -0,0 +1,96 @@
+#include "check.h"
+#include "host.h"
+#include "scale.h"
+#include "calibration.h"
+
+//the shared clock readout in scale.cpp against the simulated HX711s: 25 pulses per conversion, 24 bit two's
+//complement, and every channel's bits kept apart. make test also runs this with four channels
+
+static const uint8_t pins[SCALE_CHANNELS] = SCALE_DATA_PINS;
+
+//one conversion per channel through the sampler, with a unit calibration grams are the raw counts
+//every sample is taken at the same time so creep stays at 0
+static bool read_back(const int32_t raw[SCALE_CHANNELS], float out[SCALE_CHANNELS]) {
+  CalibrationData unit = { 0, 1.0f };
+  for (uint8_t ch = 0; ch < SCALE_CHANNELS; ch++) calibration_reset(ch, &unit);
+  host_hx711_convert(raw);
+  if (!scale_sample_poll(0)) return false;
+  for (uint8_t ch = 0; ch < SCALE_CHANNELS; ch++) {
+    ScaleSample s;
+    if (!scale_pop_sample(ch, &s)) return false;
+    out[ch] = s.grams;
+    //the rings only hold what was just read
+    if (scale_pop_sample(ch, &s)) return false;
+  }
+  return true;
+}
+
+//a conversion takes 24 clocks for the bits and a 25th for gain 128, then DOUT is high until the next
+static void test_pulses() {
+  int32_t raw[SCALE_CHANNELS] = {};
+  float grams[SCALE_CHANNELS];
+  uint32_t readouts = host_hx711_readouts();
+  CHECK(read_back(raw, grams));
+  CHECK_EQ(host_hx711_pulses(), 25);
+  CHECK_EQ(host_hx711_readouts(), readouts + 1);
+  for (uint8_t ch = 0; ch < SCALE_CHANNELS; ch++) CHECK_EQ(digitalRead(pins[ch]), HIGH);
+  CHECK(!scale_all_ready());
+  CHECK(!scale_sample_poll(0));
+}
+
+//the extremes and the values either side of zero, each tried on every channel
+static void test_decode() {
+  static const int32_t values[] = { 0, 1, -1, 0x7FFFFF, -0x800000, 0x123456, -0x123456, 0x400000, -0x400001 };
+  const int count = sizeof(values) / sizeof(values[0]);
+  for (int shift = 0; shift < count; shift++) {
+    int32_t raw[SCALE_CHANNELS];
+    float grams[SCALE_CHANNELS];
+    for (uint8_t ch = 0; ch < SCALE_CHANNELS; ch++) raw[ch] = values[(shift + ch) % count];
+    CHECK(read_back(raw, grams));
+    for (uint8_t ch = 0; ch < SCALE_CHANNELS; ch++) CHECK_EQ((int32_t)grams[ch], raw[ch]);
+  }
+}
+
+//neighbouring channels with opposite bit patterns, a bit read from the wrong DOUT shows up in both
+static void test_channels_apart() {
+  int32_t raw[SCALE_CHANNELS];
+  float grams[SCALE_CHANNELS];
+  for (uint8_t ch = 0; ch < SCALE_CHANNELS; ch++) raw[ch] = (ch % 2) ? -0x555556 : 0x555555;
+  CHECK(read_back(raw, grams));
+  for (uint8_t ch = 0; ch < SCALE_CHANNELS; ch++) CHECK_EQ((int32_t)grams[ch], raw[ch]);
+  for (uint8_t ch = 0; ch < SCALE_CHANNELS; ch++) raw[ch] = 1000 * (ch + 1) - 0x400000 * (ch % 2);
+  CHECK(read_back(raw, grams));
+  for (uint8_t ch = 0; ch < SCALE_CHANNELS; ch++) CHECK_EQ((int32_t)grams[ch], raw[ch]);
+}
+
+//the burst only starts once every chip has a conversion, one still converting holds all of them back
+static void test_waits_for_every_channel() {
+  int32_t raw[SCALE_CHANNELS];
+  for (uint8_t ch = 0; ch < SCALE_CHANNELS; ch++) raw[ch] = 4242 + ch;
+  for (uint8_t late = 0; late < SCALE_CHANNELS; late++) {
+    uint32_t readouts = host_hx711_readouts();
+    host_hx711_convert(raw);
+    host_pin_set(pins[late], HIGH);
+    CHECK(!scale_all_ready());
+    CHECK(!scale_sample_poll(0));
+    CHECK_EQ(host_hx711_readouts(), readouts);
+    host_pin_set(pins[late], LOW);
+    CHECK(scale_all_ready());
+    float grams[SCALE_CHANNELS];
+    CHECK(read_back(raw, grams));
+    for (uint8_t ch = 0; ch < SCALE_CHANNELS; ch++) CHECK_EQ((int32_t)grams[ch], raw[ch]);
+  }
+}
+
+int main() {
+  host_clock_reset(0);
+  host_serial_mute(true);
+  host_hx711_attach(SCALE_CLK_PIN, pins, SCALE_CHANNELS);
+  scale_init();
+  printf("%d channels\n", SCALE_CHANNELS);
+  RUN(test_pulses);
+  RUN(test_decode);
+  RUN(test_channels_apart);
+  RUN(test_waits_for_every_channel);
+  return check_report();
+}
@@ -0,0 +1,136 @@
+#include "check.h"
+#include "host.h"
+#include "storage.h"
+#include "journal.h"
+#include "entry_codec.h"
+#include <deque>
+
+//session history rebuilt from the journal at boot, with series records between the sessions pushing them across segments
+
+static std::deque<Entry> expected;   //newest first
+
+static void add_session(uint32_t i, uint16_t series_len) {
+  static uint8_t series[JOURNAL_MAX_RECORD];
+  Entry e;
+  e.grams_drank = 400 + (i * 37) % 900;
+  e.goal = 1000 + (i % 4) * 250;
+  e.duration = 1800 + (i % 5) * 600;
+  uint32_t id = storage_add_entry(e.grams_drank, e.goal, e.duration);
+  CHECK(id != 0);
+  //what series_end() appends after every session, the replay only needs it to take up room
+  memset(series, (uint8_t)i, series_len);
+  CHECK(journal_append(JREC_SERIES, series, series_len) != 0);
+  expected.push_front(e);
+  if (expected.size() > MAX_ENTRIES) expected.pop_back();
+}
+
+//what the cache holds matches the newest sessions appended
+static int mismatches() {
+  Entry got[MAX_ENTRIES];
+  storage_load_entries(got);
+  int wrong = 0;
+  for (int i = 0; i < MAX_ENTRIES; i++) {
+    if (i >= (int)expected.size()) {
+      if (got[i].duration != 0) wrong++;
+      continue;
+    }
+    if (got[i].duration != expected[i].duration || got[i].grams_drank != expected[i].grams_drank
+        || got[i].goal != expected[i].goal) {
+      wrong++;
+    }
+  }
+  return wrong;
+}
+
+struct DecodeCount {
+  EntryCodec codec;
+  int decoded;
+  int undecodable;
+};
+
+static bool count_sessions(uint8_t type, uint32_t id, const uint8_t *data, uint16_t len, void *ctx) {
+  DecodeCount *c = (DecodeCount *)ctx;
+  if (type != JREC_SESSION_PACKED) return true;
+  Entry e;
+  if (entry_decode(&c->codec, data, len, &e) > 0) c->decoded++;
+  else c->undecodable++;
+  return true;
+}
+
+//walking from any segment on, every session decodes: each segment's first session is a keyframe
+static int undecodable_from_any_segment() {
+  int bad = 0;
+  for (uint32_t segments = 1; segments <= JOURNAL_MAX_SEGMENTS; segments++) {
+    DecodeCount c = {};
+    entry_codec_init(&c.codec);
+    journal_iterate_recent(segments, count_sessions, &c);
+    bad += c.undecodable;
+  }
+  return bad;
+}
+
+static void boot() {
+  host_reboot();
+  storage_init();
+}
+
+//full size series after every session, the case where a session's delta base ended up a segment back
+static void test_remount_full_series() {
+  host_flash_clear();
+  host_nvs_clear();
+  expected.clear();
+  boot();
+  for (uint32_t i = 0; i < 40; i++) add_session(i, JOURNAL_MAX_RECORD);
+  CHECK_EQ(mismatches(), 0);
+
+  boot();
+  CHECK_EQ(mismatches(), 0);
+  CHECK_EQ(undecodable_from_any_segment(), 0);
+
+  DecodeCount c = {};
+  entry_codec_init(&c.codec);
+  journal_iterate_recent(JOURNAL_RECENT_SEGMENTS, count_sessions, &c);
+  CHECK(c.decoded >= MAX_ENTRIES);
+  CHECK_EQ(c.undecodable, 0);
+}
+
+//series of every size, rebooting after each session, across several trips round the partition
+static void test_remount_every_session() {
+  host_flash_clear();
+  host_nvs_clear();
+  expected.clear();
+  boot();
+  uint32_t rng = 99;
+  int wrong = 0;
+  for (uint32_t i = 0; i < 600; i++) {
+    rng = rng * 1664525 + 1013904223;
+    uint16_t len = (rng >> 8) % (JOURNAL_MAX_RECORD + 1);
+    if (i % 3 == 0) len = JOURNAL_MAX_RECORD;
+    add_session(i, len);
+    boot();
+    wrong += mismatches();
+  }
+  CHECK_EQ(wrong, 0);
+  CHECK_EQ(undecodable_from_any_segment(), 0);
+}
+
+//sessions keep decoding across a reboot in the middle of a segment, the encoder starts over with a keyframe
+static void test_reboot_mid_segment() {
+  host_flash_clear();
+  host_nvs_clear();
+  expected.clear();
+  boot();
+  for (uint32_t i = 0; i < 5; i++) add_session(i, 16);
+  boot();
+  for (uint32_t i = 5; i < 9; i++) add_session(i, 16);
+  boot();
+  CHECK_EQ(mismatches(), 0);
+  CHECK_EQ(undecodable_from_any_segment(), 0);
+}
+
+int main() {
+  RUN(test_remount_full_series);
+  RUN(test_remount_every_session);
+  RUN(test_reboot_mid_segment);
+  return check_report();
+}
@@ -0,0 +1,170 @@
+#include "check.h"
+#include "host.h"
+#include "power.h"
+#include "hydration.h"
+#include "state.h"
+
+//rail accounting driven with explicit times, then power_idle() sleeping on the virtual clock
+
+static void all_rails(uint8_t level, uint32_t now_ms) {
+  for (int i = 0; i < POWER_RAIL_COUNT; i++) power_set_level((PowerRail)i, level, now_ms);
+}
+
+//a rail's duty is its level x time over 255 x uptime, its current is that share of the rail's draw
+static void test_duty() {
+  all_rails(0, 0);
+  power_reset_accounting(0);
+  //times only move forward, like millis()
+  power_set_level(POWER_RAIL_CPU, 255, 0);
+  power_set_level(POWER_RAIL_LED, 51, 0);          //a fifth of full white
+  power_set_level(POWER_RAIL_CPU, 0, 500);
+  power_set_level(POWER_RAIL_RADIO, 255, 750);
+
+  PowerReport r;
+  power_get_report(1000, &r);
+  CHECK_EQ(r.uptime_ms, 1000);
+  CHECK_EQ(r.rails[POWER_RAIL_CPU].duty_permille, 500);
+  CHECK_EQ(r.rails[POWER_RAIL_LED].duty_permille, 200);
+  CHECK_EQ(r.rails[POWER_RAIL_RADIO].duty_permille, 250);
+  CHECK_EQ(r.rails[POWER_RAIL_SPEAKER].duty_permille, 0);
+  //the CPU draws its sleep current the rest of the time
+  CHECK_NEAR(r.rails[POWER_RAIL_CPU].avg_ma, 0.5 * POWER_CPU_ACTIVE_MA + 0.5 * POWER_CPU_SLEEP_MA, 1e-3);
+  CHECK_NEAR(r.rails[POWER_RAIL_LED].avg_ma, 0.2 * POWER_LED_MA, 1e-3);
+  CHECK_NEAR(r.rails[POWER_RAIL_RADIO].avg_ma, 0.25 * POWER_RADIO_MA, 1e-3);
+  float sum = 0;
+  for (int i = 0; i < POWER_RAIL_COUNT; i++) sum += r.rails[i].avg_ma;
+  CHECK_NEAR(r.avg_ma, sum, 1e-3);
+  CHECK_NEAR(r.battery_hours, POWER_BATTERY_MAH / sum, 1e-3);
+}
+
+//a reset starts the sums over but keeps the levels, a report with no time gone by is all sleep current
+static void test_reset_keeps_levels() {
+  all_rails(0, 0);
+  power_set_level(POWER_RAIL_SCALE, 255, 0);
+  power_reset_accounting(5000);
+  PowerReport r;
+  power_get_report(5000, &r);
+  CHECK_EQ(r.uptime_ms, 0);
+  CHECK_EQ(r.rails[POWER_RAIL_SCALE].duty_permille, 0);
+  CHECK_NEAR(r.avg_ma, POWER_CPU_SLEEP_MA, 1e-3);
+  power_get_report(6000, &r);
+  CHECK_EQ(r.rails[POWER_RAIL_SCALE].duty_permille, 1000);
+  CHECK_NEAR(r.rails[POWER_RAIL_SCALE].avg_ma, POWER_SCALE_MA * SCALE_CHANNELS, 1e-3);
+  CHECK_EQ(r.sleeps, 0);
+}
+
+//millis() wraps after 49 days, the interval across it still counts once
+static void test_millis_wrap() {
+  all_rails(0, 0);
+  power_reset_accounting(0xFFFFFF00);
+  power_set_level(POWER_RAIL_CPU, 255, 0xFFFFFF00);
+  PowerReport r;
+  power_get_report(0x100, &r);
+  CHECK_EQ(r.uptime_ms, 0x200);
+  CHECK_EQ(r.rails[POWER_RAIL_CPU].duty_permille, 1000);
+}
+
+//light sleep: the CPU rail is off for exactly the time asleep, and each sleep is counted
+static void test_idle_sleeps() {
+  power_init();
+  power_set_level(POWER_RAIL_SCALE, 0, millis());
+  uint32_t t0 = millis();
+  //nothing scheduled, so the longest sleep
+  CHECK_EQ(power_idle(), 1);
+  CHECK_EQ(millis(), t0 + POWER_MAX_SLEEP_MS);
+  host_advance_ms(POWER_MAX_SLEEP_MS);
+  PowerReport r;
+  power_get_report(millis(), &r);
+  CHECK_EQ(r.sleeps, 1);
+  CHECK_EQ(r.slept_ms, POWER_MAX_SLEEP_MS);
+  CHECK_EQ(r.rails[POWER_RAIL_CPU].duty_permille, 500);
+}
+
+static int fired = 0;
+static void count_fire(void *arg) {
+  fired++;
+}
+
+//an armed esp_timer ends the sleep when it's due and still runs, one closer than POWER_MIN_SLEEP_MS stops it
+static void test_idle_wakes_for_timer() {
+  esp_timer_create_args_t args = {};
+  args.callback = count_fire;
+  args.name = "test";
+  esp_timer_handle_t timer;
+  esp_timer_create(&args, &timer);
+
+  power_reset_accounting(millis());
+  uint32_t t0 = millis();
+  esp_timer_start_once(timer, 200 * 1000);
+  power_idle();
+  CHECK_EQ(millis(), t0 + 200);
+  CHECK_EQ(fired, 1);
+
+  t0 = millis();
+  esp_timer_start_once(timer, (POWER_MIN_SLEEP_MS - 1) * 1000);
+  CHECK_EQ(power_idle(), 1);
+  CHECK_EQ(millis(), t0);
+  esp_timer_stop(timer);
+  esp_timer_delete(timer);
+
+  PowerReport r;
+  power_get_report(millis(), &r);
+  CHECK_EQ(r.sleeps, 1);
+  CHECK_EQ(r.slept_ms, 200);
+}
+
+//the web server or a playing note hold sleep off, a ready conversion or a pressed button skip it
+static void test_idle_held_off() {
+  power_reset_accounting(millis());
+  uint32_t t0 = millis();
+  power_hold(POWER_HOLD_WEB, true);
+  CHECK_EQ(power_idle(), POWER_RECHECK_MS);
+  power_hold(POWER_HOLD_SPEAKER, true);
+  power_hold(POWER_HOLD_WEB, false);
+  CHECK_EQ(power_idle(), POWER_RECHECK_MS);
+  power_hold(POWER_HOLD_SPEAKER, false);
+
+  host_pin_set(BTN_PIN, LOW);
+  CHECK_EQ(power_idle(), 1);
+  host_pin_set(BTN_PIN, HIGH);
+  static const uint8_t data_pins[SCALE_CHANNELS] = SCALE_DATA_PINS;
+  for (uint8_t ch = 0; ch < SCALE_CHANNELS; ch++) host_pin_set(data_pins[ch], LOW);
+  CHECK_EQ(power_idle(), 1);
+  for (uint8_t ch = 0; ch < SCALE_CHANNELS; ch++) host_pin_set(data_pins[ch], HIGH);
+  CHECK_EQ(millis(), t0);
+  PowerReport r;
+  power_get_report(millis(), &r);
+  CHECK_EQ(r.sleeps, 0);
+}
+
+//a running session's next state change ends the sleep so the LED and speaker react on time
+static void test_idle_wakes_for_pacing() {
+  //a one second session for 1000 g, behind by a fifth of the goal 200 ms in
+  set_goal(1000);
+  set_time_length(1);
+  reset();
+  set_state(STATE_RUNNING);
+  update_hydration_status();
+  int64_t deadline = hydration_next_deadline_ms();
+  CHECK(deadline > (int64_t)millis() && deadline < (int64_t)millis() + POWER_MAX_SLEEP_MS);
+  power_idle();
+  CHECK_EQ(millis(), deadline);
+  set_state(STATE_WAITING_USER_INPUT);
+}
+
+int main() {
+  static const uint8_t data_pins[SCALE_CHANNELS] = SCALE_DATA_PINS;
+  host_clock_reset(0);
+  host_hx711_attach(SCALE_CLK_PIN, data_pins, SCALE_CHANNELS);
+  host_pin_set(BTN_PIN, HIGH);
+  host_serial_mute(true);
+
+  RUN(test_duty);
+  RUN(test_reset_keeps_levels);
+  RUN(test_millis_wrap);
+  RUN(test_idle_sleeps);
+  RUN(test_idle_wakes_for_timer);
+  RUN(test_idle_held_off);
+  RUN(test_idle_wakes_for_pacing);
+  return check_report();
+}
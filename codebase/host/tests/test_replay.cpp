@@ -0,0 +1,41 @@
+#include "check.h"
+#include "sim.h"
+
+//replays traces/two_sessions.csv through the whole firmware and checks what ended up in the history
+static SimResult r;
+
+static void test_sessions_stored() {
+  CHECK_EQ(r.sessions, 2);
+  //newest first
+  CHECK_NEAR(r.entries[0].grams_drank, 100, 1);
+  CHECK_NEAR(r.entries[0].goal, 500, 0);
+  CHECK_EQ(r.entries[0].duration, 300);
+  CHECK_NEAR(r.entries[1].grams_drank, 320, 1);
+  CHECK_NEAR(r.entries[1].goal, 300, 0);
+  CHECK_EQ(r.entries[1].duration, 600);
+  CHECK_EQ(r.entries[2].duration, 0);
+}
+
+static void test_sips_and_refill() {
+  CHECK_EQ(r.sips[0], 6);
+  CHECK_NEAR(r.sipped_grams[0], 420, 2);
+  CHECK_EQ(r.refills, 1);
+}
+
+static void test_feedback() {
+  //start, end, start, end
+  CHECK_EQ(r.state_changes, 4);
+  CHECK(r.hydration_changes >= 4);
+  //the second session goes critical and the alerts escalate until it ends
+  CHECK(r.tones > 20);
+  CHECK(r.led_frames > 0);
+  CHECK(r.avg_ma > POWER_CPU_SLEEP_MA && r.avg_ma < POWER_CPU_ACTIVE_MA + POWER_LED_MA + POWER_SPEAKER_MA);
+}
+
+int main() {
+  if (!sim_run(HOST_DIR "/traces/two_sessions.csv", NULL, &r)) return 1;
+  RUN(test_sessions_stored);
+  RUN(test_sips_and_refill);
+  RUN(test_feedback);
+  return check_report();
+}
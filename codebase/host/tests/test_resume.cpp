@@ -0,0 +1,103 @@
+#include "check.h"
+#include "host.h"
+#include "storage.h"
+#include "hydration.h"
+#include "tracker.h"
+#include "state.h"
+
+//a session interrupted by a reboot picks up with its elapsed time, the pacing timer restarts at 0 on every boot
+
+static const uint32_t MINUTE_MS = 60000;
+
+//what tracker_step() checkpoints, written out straight away
+static void checkpoint() {
+  SessionCheckpoint cp;
+  cp.goal = get_goal_grams();
+  cp.duration_s = get_time_length();
+  cp.elapsed_ms = get_elapsed_ms();
+  cp.total_grams = get_total_grams();
+  cp.curve = get_pacing_curve();
+  storage_checkpoint_session(&cp);
+  storage_flush(millis(), true);
+}
+
+static void boot() {
+  host_reboot();
+  storage_init();
+  tracker_init();
+}
+
+static void test_resume_after_reboot() {
+  host_flash_clear();
+  host_nvs_clear();
+  host_reboot();
+  storage_init();
+
+  //a one hour linear session, 20 minutes and 200 mL in
+  set_goal(1000);
+  set_time_length(3600);
+  set_pacing_curve(PACING_LINEAR);
+  reset();
+  set_state(STATE_RUNNING);
+  update_hydration_status();
+  host_advance_ms(20 * MINUTE_MS);
+  record_grams_drank(200);
+  update_hydration_status();
+  CHECK_EQ(get_elapsed_ms(), 20 * MINUTE_MS);
+  checkpoint();
+
+  boot();
+  CHECK_EQ(get_state(), STATE_RUNNING);
+  CHECK_EQ(get_elapsed_ms(), 20 * MINUTE_MS);
+  update_hydration_status();
+  CHECK_NEAR(get_total_grams(), 200, 0.01);
+  CHECK_NEAR(get_pacer(), 1000 * 2 / 3.0, 0.5);
+  CHECK_EQ(get_hydration_state(), NEEDS_WATER);
+
+  //the next checkpoint carries the whole elapsed time on, not just what ran since the reboot
+  host_advance_ms(10 * MINUTE_MS);
+  checkpoint();
+  boot();
+  CHECK_EQ(get_elapsed_ms(), 30 * MINUTE_MS);
+  update_hydration_status();
+  CHECK_NEAR(get_pacer(), 500, 0.5);
+
+  //and the session ends on time: 30 minutes left after this boot
+  CHECK(!hydration_session_over());
+  host_advance_ms(30 * MINUTE_MS - 1);
+  CHECK(!hydration_session_over());
+  host_advance_ms(1);
+  CHECK(hydration_session_over());
+}
+
+//the state deadline the power code sleeps towards is on the new boot's clock
+static void test_deadline_after_reboot() {
+  host_flash_clear();
+  host_nvs_clear();
+  host_reboot();
+  storage_init();
+
+  //400 mL drunk 10 minutes into an hour for 1000 mL, hydrated until the pacer falls to 600 at 24 minutes
+  set_goal(1000);
+  set_time_length(3600);
+  set_pacing_curve(PACING_LINEAR);
+  reset();
+  set_state(STATE_RUNNING);
+  update_hydration_status();
+  host_advance_ms(10 * MINUTE_MS);
+  record_grams_drank(400);
+  update_hydration_status();
+  checkpoint();
+
+  boot();
+  update_hydration_status();
+  CHECK_EQ(get_hydration_state(), HYDRATED);
+  //Q16 curve steps, within a tenth of a second
+  CHECK_NEAR(hydration_next_deadline_ms(), 14 * MINUTE_MS, 100);
+}
+
+int main() {
+  RUN(test_resume_after_reboot);
+  RUN(test_deadline_after_reboot);
+  return check_report();
+}
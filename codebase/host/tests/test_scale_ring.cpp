@@ -0,0 +1,130 @@
+#include "check.h"
+#include "host.h"
+#include "scale.h"
+#include "calibration.h"
+#include <atomic>
+#include <thread>
+
+//the sampler to consumer ring in scale.cpp: order, drop-oldest when full, and one producer against one consumer
+
+//fake HX711 that always has a conversion, each read is the next count
+static std::atomic<int32_t> next_raw(0);
+static bool fake_ready() { return true; }
+static void fake_read(int32_t raw[SCALE_CHANNELS]) {
+  int32_t value = next_raw.fetch_add(1);
+  for (uint8_t ch = 0; ch < SCALE_CHANNELS; ch++) raw[ch] = value;
+}
+static const ScaleDriver fake_driver = { fake_ready, fake_read };
+
+static void drain() {
+  ScaleSample s;
+  while (scale_pop_sample(0, &s)) {}
+}
+
+static void test_order() {
+  drain();
+  for (uint32_t t = 1; t <= 10; t++) CHECK(scale_sample_poll(t));
+  ScaleSample s;
+  for (uint32_t t = 1; t <= 10; t++) {
+    CHECK(scale_pop_sample(0, &s));
+    CHECK_EQ(s.time_ms, t);
+  }
+  CHECK(!scale_pop_sample(0, &s));
+}
+
+static void test_drop_oldest() {
+  drain();
+  const uint32_t extra = 5;
+  for (uint32_t t = 0; t < SCALE_RING_SIZE + extra; t++) scale_sample_poll(1000 + t);
+  //the sampler never waits, the first extra samples were overwritten
+  ScaleSample s;
+  uint32_t popped = 0, first = 0, last = 0;
+  while (scale_pop_sample(0, &s)) {
+    if (popped == 0) first = s.time_ms;
+    last = s.time_ms;
+    popped++;
+  }
+  CHECK_EQ(popped, SCALE_RING_SIZE);
+  CHECK_EQ(first, 1000 + extra);
+  CHECK_EQ(last, 1000 + SCALE_RING_SIZE + extra - 1);
+}
+
+//grams follow the raw counts with a unit calibration, so a sample's reading says which conversion it was
+static void test_sample_contents() {
+  drain();
+  next_raw.store(500);
+  scale_sample_poll(2000);
+  ScaleSample s;
+  CHECK(scale_pop_sample(0, &s));
+  CHECK_NEAR(s.grams, 500, 0.5);
+}
+
+//the consumer must see samples in order, never twice, and never a half written slot
+static void test_concurrent() {
+  drain();
+  const uint32_t total = 200000;
+  std::atomic<bool> done(false);
+  std::thread producer([&] {
+    for (uint32_t t = 1; t <= total; t++) scale_sample_poll(10000 + t);
+    done.store(true);
+  });
+
+  uint32_t popped = 0, last = 0, out_of_order = 0;
+  ScaleSample s;
+  while (true) {
+    bool finished = done.load();
+    while (scale_pop_sample(0, &s)) {
+      if (s.time_ms <= last) out_of_order++;
+      last = s.time_ms;
+      popped++;
+    }
+    if (finished) break;
+  }
+  producer.join();
+  CHECK_EQ(out_of_order, 0);
+  CHECK_EQ(last, 10000 + total);
+  CHECK(popped > 0 && popped <= total);
+}
+
+//a falling DOUT wakes the sampler task through the interrupt, edges from clocking the bits out don't
+static void test_data_ready_wakes_sampler() {
+  static const uint8_t pins[SCALE_CHANNELS] = SCALE_DATA_PINS;
+  scale_set_driver(NULL);
+  host_hx711_attach(SCALE_CLK_PIN, pins, SCALE_CHANNELS);
+  scale_set_sampler_task(xTaskGetCurrentTaskHandle());
+  drain();
+  //the concurrent test left creep behind from its huge readings
+  CalibrationData unit = { 0, 1.0f };
+  calibration_reset(0, &unit);
+
+  CHECK(!scale_wait_ready(0));
+  int32_t raw[SCALE_CHANNELS];
+  for (uint8_t ch = 0; ch < SCALE_CHANNELS; ch++) raw[ch] = 1234;
+  host_hx711_convert(raw);
+  CHECK(scale_wait_ready(0));
+  CHECK(scale_sample_poll(10000 + 200000));
+  CHECK(!scale_all_ready());
+  //bits clocked out toggled DOUT, none of that may look like a new conversion
+  CHECK_EQ(ulTaskNotifyTake(pdTRUE, 0), 0);
+
+  ScaleSample s;
+  CHECK(scale_pop_sample(0, &s));
+  CHECK_NEAR(s.grams, 1234, 0.5);
+  scale_set_sampler_task(NULL);
+  scale_set_driver(&fake_driver);
+}
+
+int main() {
+  host_clock_reset(0);
+  scale_init();
+  CalibrationData unit = { 0, 1.0f };
+  for (uint8_t ch = 0; ch < SCALE_CHANNELS; ch++) calibration_reset(ch, &unit);
+  scale_set_driver(&fake_driver);
+
+  RUN(test_order);
+  RUN(test_drop_oldest);
+  RUN(test_sample_contents);
+  RUN(test_concurrent);
+  RUN(test_data_ready_wakes_sampler);
+  return check_report();
+}
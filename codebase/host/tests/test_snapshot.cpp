@@ -0,0 +1,111 @@
+#include "check.h"
+#include "hydration.h"
+#include "metrics.h"
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <vector>
+
+//the seqlock around the hydration snapshot: readers on other threads never see a half published update
+
+static int32_t mg(float grams) {
+  return lroundf(grams * 1000);
+}
+
+static void test_publish() {
+  HydrationSnapshot a, b;
+  set_goal(500);
+  reset();
+  hydration_get_snapshot(&a);
+  CHECK_EQ(mg(a.goal), 500000);
+  CHECK_EQ(mg(a.grams_left), 500000);
+  CHECK_EQ(mg(a.total_grams), 0);
+  CHECK_EQ(a.state, NEEDS_WATER);
+
+  record_grams_drank(120.5f);
+  hydration_get_snapshot(&b);
+  CHECK_EQ(b.version, a.version + 1);
+  CHECK_EQ(mg(b.grams_left), 379500);
+  CHECK_EQ(mg(b.total_grams), 120500);
+}
+
+//every field of one publish comes from the same update: total is always goal - left, and versions never go back
+static void test_concurrent_writer() {
+  set_goal(1000);
+  reset();
+  const int updates = 200000;
+  std::atomic<bool> done(false);
+  std::thread writer([&] {
+    for (int i = 1; i <= updates; i++) {
+      record_grams_drank((i & 1) ? 3.0f : -1.0f);
+      if (i % 7 == 0) set_goal((i % 14) ? 2000 : 1000);   //the web task moving the goal under the scale task
+    }
+    done.store(true);
+  });
+
+  std::atomic<int> torn(0), backwards(0), reads(0);
+  std::vector<std::thread> readers;
+  for (int r = 0; r < 2; r++) {
+    readers.emplace_back([&] {
+      uint32_t last = 0;
+      HydrationSnapshot s;
+      while (!done.load()) {
+        hydration_get_snapshot(&s);
+        if (mg(s.total_grams) != mg(s.goal) - mg(s.grams_left)) torn++;
+        if (s.goal != 1000 && s.goal != 2000) torn++;
+        if (s.version < last) backwards++;
+        last = s.version;
+        reads++;
+      }
+    });
+  }
+  writer.join();
+  for (std::thread &t : readers) t.join();
+  CHECK_EQ(torn.load(), 0);
+  CHECK_EQ(backwards.load(), 0);
+  CHECK(reads.load() > 0);
+
+  HydrationSnapshot s;
+  hydration_get_snapshot(&s);
+  CHECK_EQ(mg(s.total_grams), mg(get_total_grams()));
+  CHECK_EQ(mg(s.goal), mg(get_goal_grams()));
+}
+
+//runs until the readers have had to go again a few times, which needs the writer to land inside a read
+//on a single core (like the C6) that only happens when a time slice ends mid copy, so this keeps going for a while
+static void test_reader_retries() {
+  set_goal(1000);
+  reset();
+  uint32_t retries_before = metrics_counters[METRIC_SNAPSHOT_RETRIES].load();
+  std::atomic<bool> done(false);
+  std::thread writer([&] {
+    //net zero, so however long it runs the numbers stay small enough for exact float compares
+    for (int i = 1; !done.load(); i++) {
+      record_grams_drank((i & 1) ? 3.0f : -3.0f);
+      set_goal((i & 2) ? 2000 : 1000);
+    }
+  });
+
+  int torn = 0;
+  uint32_t retries = 0;
+  HydrationSnapshot s;
+  auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(20);
+  while (retries < 20 && std::chrono::steady_clock::now() < deadline) {
+    for (int i = 0; i < 10000; i++) {
+      hydration_get_snapshot(&s);
+      if (mg(s.total_grams) != mg(s.goal) - mg(s.grams_left)) torn++;
+    }
+    retries = metrics_counters[METRIC_SNAPSHOT_RETRIES].load() - retries_before;
+  }
+  done.store(true);
+  writer.join();
+  CHECK_EQ(torn, 0);
+  CHECK(retries >= 20);
+}
+
+int main() {
+  RUN(test_publish);
+  RUN(test_concurrent_writer);
+  RUN(test_reader_retries);
+  return check_report();
+}
@@ -0,0 +1,176 @@
+#include "check.h"
+#include "host.h"
+#include "speaker.h"
+#include <vector>
+
+//the tone sequencer: first speaker_tick() driven by hand, then off its esp_timer on the virtual clock
+
+struct Note {
+  uint32_t ms;
+  uint16_t freq;   //0 for silence
+};
+
+static std::vector<Note> notes;
+
+static void record_tone(uint16_t freq_hz) {
+  notes.push_back(Note{ (uint32_t)millis(), freq_hz });
+}
+
+static void record_silence() {
+  notes.push_back(Note{ (uint32_t)millis(), 0 });
+}
+
+static const SpeakerBackend recorder = { record_tone, record_silence };
+
+//tones started in [from, to)
+static std::vector<Note> tones(uint32_t from, uint32_t to) {
+  std::vector<Note> out;
+  for (const Note &n : notes) {
+    if (n.freq && n.ms >= from && n.ms < to) out.push_back(n);
+  }
+  return out;
+}
+
+static void advance_to(uint32_t ms) {
+  host_advance_ms(ms - millis());
+}
+
+//each step starts when the one before ends, the return value is the time to the next step
+static void test_tick_sequence() {
+  notes.clear();
+  speaker_play_done();
+  CHECK_EQ(speaker_tick(0), 100);
+  CHECK_EQ(speaker_tick(50), 50);
+  CHECK_EQ(speaker_tick(100), 100);
+  CHECK_EQ(speaker_tick(200), 100);
+  CHECK_EQ(speaker_tick(300), 250);
+  CHECK_EQ(speaker_tick(550), 0);
+  CHECK_EQ(notes.size(), 5);
+  if (notes.size() == 5) {
+    CHECK_EQ(notes[0].freq, ALERT_FREQUENCY);
+    CHECK_EQ(notes[1].freq, ALERT_FREQUENCY * 5 / 4);
+    CHECK_EQ(notes[2].freq, ALERT_FREQUENCY * 3 / 2);
+    CHECK_EQ(notes[3].freq, ALERT_FREQUENCY * 2);
+    CHECK_EQ(notes[4].freq, 0);
+  }
+  //nothing queued, nothing to wait for
+  CHECK_EQ(speaker_tick(10000), 0);
+  CHECK_EQ(notes.size(), 5);
+}
+
+//queued patterns play back to back, a full queue refuses more
+static void test_queue() {
+  notes.clear();
+  for (int i = 0; i < SPEAKER_QUEUE_LEN; i++) speaker_play_done();
+  CHECK(!speaker_play(NULL));
+  uint32_t now = 20000;
+  uint32_t wait;
+  while ((wait = speaker_tick(now)) != 0) now += wait;
+  CHECK_EQ(now, 20000 + SPEAKER_QUEUE_LEN * 550);
+  CHECK_EQ(tones(0, UINT32_MAX).size(), SPEAKER_QUEUE_LEN * 4);
+}
+
+//ignored alerts move up a level every SPEAKER_ESCALATE_AFTER, each level halves the interval
+static void test_escalation() {
+  notes.clear();
+  uint32_t t0 = millis();
+  speaker_set_alerting(true);
+  host_timers_run();
+  advance_to(t0 + 200 * 1000);
+
+  uint32_t firm_at = t0 + SPEAKER_ESCALATE_AFTER * ALERT_INTERVAL;
+  uint32_t urgent_at = firm_at + SPEAKER_ESCALATE_AFTER * (ALERT_INTERVAL / 2);
+  //gentle: two base notes, at the start and every interval
+  for (uint32_t i = 0; i < SPEAKER_ESCALATE_AFTER; i++) {
+    std::vector<Note> gentle = tones(t0 + i * ALERT_INTERVAL, t0 + (i + 1) * ALERT_INTERVAL);
+    CHECK_EQ(gentle.size(), 2);
+    if (gentle.size() == 2) {
+      CHECK_EQ(gentle[0].ms, t0 + i * ALERT_INTERVAL);
+      CHECK_EQ(gentle[1].freq, ALERT_FREQUENCY);
+    }
+  }
+  //firm: a rising triad, at half the interval
+  std::vector<Note> firm = tones(firm_at, firm_at + ALERT_INTERVAL / 2);
+  CHECK_EQ(firm.size(), 3);
+  if (firm.size() == 3) {
+    CHECK_EQ(firm[0].ms, firm_at);
+    CHECK_EQ(firm[2].freq, ALERT_FREQUENCY * 3 / 2);
+  }
+  CHECK_EQ(tones(firm_at, urgent_at).size(), 3 * SPEAKER_ESCALATE_AFTER);
+  //urgent: five high notes, at a quarter, and it stays there
+  std::vector<Note> urgent = tones(urgent_at, urgent_at + ALERT_INTERVAL / 4);
+  CHECK_EQ(urgent.size(), 5);
+  if (urgent.size() == 5) {
+    CHECK_EQ(urgent[0].ms, urgent_at);
+    CHECK_EQ(urgent[0].freq, ALERT_FREQUENCY * 2);
+  }
+  CHECK_EQ(tones(urgent_at, urgent_at + 8 * (ALERT_INTERVAL / 4)).size(), 8 * 5);
+
+  //catching up cuts the alert mid pattern and nothing more plays
+  speaker_set_alerting(false);
+  host_timers_run();
+  uint32_t off_at = millis();
+  CHECK_EQ(notes.back().freq, 0);
+  advance_to(off_at + 5 * ALERT_INTERVAL);
+  CHECK_EQ(tones(off_at, UINT32_MAX).size(), 0);
+}
+
+//a snooze holds the next alert back until it ends, and a fresh critical spell starts gentle again
+static void test_snooze() {
+  notes.clear();
+  uint32_t t0 = millis();
+  speaker_set_alerting(true);
+  host_timers_run();
+  advance_to(t0 + 1000);
+  speaker_snooze(60000);
+  host_timers_run();
+  advance_to(t0 + 120000);
+  CHECK_EQ(tones(t0, t0 + 1000).size(), 2);
+  CHECK_EQ(tones(t0 + 1000, t0 + 61000).size(), 0);
+  std::vector<Note> after = tones(t0 + 61000, t0 + 61000 + ALERT_INTERVAL);
+  CHECK_EQ(after.size(), 2);
+  if (after.size() == 2) CHECK_EQ(after[0].ms, t0 + 61000);
+
+  speaker_set_alerting(false);
+  host_timers_run();
+  advance_to(millis() + 1000);
+}
+
+static esp_timer_handle_t rearmed = NULL;
+
+//what the timer callback does when it wins the race: re-arms itself for its own next deadline
+static void rearm_first(esp_timer_handle_t timer) {
+  rearmed = timer;
+  esp_timer_start_once(timer, (uint64_t)ALERT_INTERVAL * 1000);
+}
+
+//a request made while the callback re-arms itself still runs straight away, not at the old deadline
+static void test_kick_race() {
+  notes.clear();
+  uint32_t t0 = millis();
+  host_timer_before_start(rearm_first);
+  speaker_play_done();
+  CHECK(rearmed != NULL);
+  CHECK_EQ(host_timer_deadline_us(rearmed), (int64_t)t0 * 1000);
+  host_timers_run();
+  std::vector<Note> played = tones(t0, t0 + 1);
+  CHECK_EQ(played.size(), 1);
+  advance_to(t0 + 1000);
+  CHECK_EQ(tones(t0, UINT32_MAX).size(), 4);
+  host_timer_before_start(NULL);
+}
+
+int main() {
+  host_clock_reset(0);
+  speaker_set_backend(&recorder);
+  //no timer yet, requests only wait for the next speaker_tick()
+  RUN(test_tick_sequence);
+  RUN(test_queue);
+
+  speaker_init();
+  host_advance_ms(1000);
+  RUN(test_escalation);
+  RUN(test_snooze);
+  RUN(test_kick_race);
+  return check_report();
+}
@@ -0,0 +1,83 @@
+#include "check.h"
+#include "state.h"
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <vector>
+
+//task wakeups through state_subscribe/state_notify: who gets woken, with which bits, and that bits latch until the wait
+
+static void test_set_state_events() {
+  //the main thread stands in for taskUpdateStatusLED
+  state_subscribe(EVT_SESSION_START | EVT_SESSION_END);
+  CHECK_EQ(state_wait(0), 0);
+
+  set_state(STATE_RUNNING);
+  CHECK_EQ(state_wait(0), EVT_SESSION_START);
+  set_state(STATE_RUNNING);   //no change, no wakeup
+  CHECK_EQ(state_wait(0), 0);
+  set_state(STATE_WAITING_USER_INPUT);
+  CHECK_EQ(state_wait(0), EVT_SESSION_END);
+}
+
+//nobody waiting when both fire, the next wait sees both and clears them
+static void test_bits_latch() {
+  set_state(STATE_RUNNING);
+  set_state(STATE_WAITING_USER_INPUT);
+  CHECK_EQ(state_wait(0), EVT_SESSION_START | EVT_SESSION_END);
+  CHECK_EQ(state_wait(0), 0);
+}
+
+static void test_unsubscribed_bits_ignored() {
+  state_notify(EVT_HYDRATION_CHANGE | EVT_WEB_BUTTON);
+  CHECK_EQ(state_wait(0), 0);
+  //only the bits this task asked for are delivered
+  state_notify(EVT_HYDRATION_CHANGE | EVT_SESSION_END);
+  CHECK_EQ(state_wait(0), EVT_SESSION_END);
+}
+
+static void test_wait_timeout() {
+  //notification waits run on the host's real clock, not the virtual one
+  auto start = std::chrono::steady_clock::now();
+  CHECK_EQ(state_wait(20), 0);
+  CHECK(std::chrono::steady_clock::now() - start >= std::chrono::milliseconds(19));
+}
+
+//tasks blocked forever in their own threads, subscribing at the same time, each woken only for its bits
+static void test_tasks_in_threads() {
+  const int tasks = STATE_MAX_SUBSCRIBERS - 1;   //the main thread already holds one slot
+  std::atomic<int> subscribed(0);
+  std::atomic<uint32_t> got[tasks];
+  std::vector<std::thread> threads;
+  for (int i = 0; i < tasks; i++) {
+    got[i].store(0);
+    threads.emplace_back([&, i] {
+      uint32_t mine = (i % 2) ? EVT_WEB_BUTTON : EVT_HYDRATION_CHANGE;
+      state_subscribe(mine);
+      subscribed++;
+      got[i].store(state_wait(portMAX_DELAY));
+    });
+  }
+  while (subscribed.load() < tasks) delay(1);
+
+  //table full, the extra subscriber is dropped instead of overrunning it
+  state_subscribe(EVT_WEB_BUTTON);
+
+  state_notify(EVT_HYDRATION_CHANGE);
+  state_notify_from_isr(EVT_WEB_BUTTON);
+  for (std::thread &t : threads) t.join();
+  for (int i = 0; i < tasks; i++) {
+    CHECK_EQ(got[i].load(), (uint32_t)((i % 2) ? EVT_WEB_BUTTON : EVT_HYDRATION_CHANGE));
+  }
+  //the main thread is subscribed to session events only
+  CHECK_EQ(state_wait(0), 0);
+}
+
+int main() {
+  RUN(test_set_state_events);
+  RUN(test_bits_latch);
+  RUN(test_unsubscribed_bits_ignored);
+  RUN(test_wait_timeout);
+  RUN(test_tasks_in_threads);
+  return check_report();
+}
@@ -0,0 +1,169 @@
+#include "check.h"
+#include "host.h"
+#include "status_led.h"
+#include <vector>
+
+//the LED engine: status_led_tick() driven by hand, then off its esp_timer on the virtual clock,
+//counting what reaches the LED for each effect
+
+struct Frame {
+  uint32_t ms;
+  LEDColor color;
+};
+
+static std::vector<Frame> frames;
+
+static void record_show(LEDColor color) {
+  frames.push_back(Frame{ (uint32_t)millis(), color });
+}
+
+static const LedBackend recorder = { record_show };
+
+static LedStats stats_since(const LedStats &before) {
+  LedStats now;
+  status_led_get_stats(&now);
+  now.frames -= before.frames;
+  now.skipped -= before.skipped;
+  return now;
+}
+
+static bool same(LEDColor a, LEDColor b) {
+  return a.red == b.red && a.green == b.green && a.blue == b.blue;
+}
+
+//a new look fades in a frame every LED_FRAME_MS, then the LED is left alone
+static void test_fade_frames() {
+  frames.clear();
+  status_led_set(COLOR_GOOD, LED_SOLID);
+  uint32_t now = 0, wait, ticks = 0;
+  while ((wait = status_led_tick(now)) != 0) {
+    CHECK_EQ(wait, LED_FRAME_MS);
+    now += wait;
+    ticks++;
+  }
+  CHECK_EQ(now, LED_FADE_MS);
+  CHECK_EQ(ticks, LED_FADE_MS / LED_FRAME_MS);
+  //off to full green, eased and never stepping back
+  int backwards = 0;
+  for (size_t i = 1; i < frames.size(); i++) backwards += frames[i].color.green < frames[i - 1].color.green;
+  CHECK_EQ(backwards, 0);
+  LEDColor green = { 0, 255, 0 };
+  CHECK(same(frames.back().color, green));
+  //dark greens that gamma maps to the same level aren't pushed twice
+  CHECK(frames.size() <= ticks + 1 && frames.size() > ticks / 2);
+
+  //nothing changed, the frame is skipped
+  LedStats before;
+  status_led_get_stats(&before);
+  CHECK_EQ(status_led_tick(now + 1000), 0);
+  CHECK_EQ(stats_since(before).frames, 0);
+  CHECK_EQ(stats_since(before).skipped, 1);
+}
+
+//gamma on the way out: the dimmest breath level is far below its linear value
+static void test_gamma() {
+  frames.clear();
+  status_led_set({ 255, 255, 255 }, LED_BREATHE);
+  uint32_t t0 = 10000;
+  status_led_tick(t0);
+  //a breath starts at its dimmest, LED_BREATHE_MIN before gamma, and peaks halfway
+  status_led_tick(t0 + LED_BREATHE_MS);
+  CHECK(frames.back().color.red < LED_BREATHE_MIN / 2);
+  status_led_tick(t0 + LED_BREATHE_MS + LED_BREATHE_MS / 2);
+  CHECK_EQ(frames.back().color.red, 255);
+}
+
+//what reaches the LED over a minute of each effect, after its fade
+static void run_effect(LEDColor color, LedEffect effect, LedStats *out) {
+  status_led_set(color, effect);
+  host_timers_run();
+  host_advance_ms(LED_FADE_MS + 1000);
+  LedStats before;
+  status_led_get_stats(&before);
+  host_advance_ms(60000);
+  *out = stats_since(before);
+}
+
+//solid: nothing, blink: every half period, breathe: every LED_BREATHE_FRAME_MS less the repeats
+static void test_effects_per_minute() {
+  LedStats s;
+  run_effect(COLOR_OK, LED_SOLID, &s);
+  CHECK_EQ(s.frames + s.skipped, 0);
+  run_effect(COLOR_CRITICAL, LED_BLINK, &s);
+  CHECK_EQ(s.frames, 60 * 2);
+  CHECK_EQ(s.skipped, 0);
+  run_effect(COLOR_WAITING, LED_BREATHE, &s);
+  CHECK_EQ(s.frames + s.skipped, 60000 / LED_BREATHE_FRAME_MS);
+  CHECK_EQ(s.frames, 60 * 16);
+  CHECK_EQ(s.skipped, 60 * 4);
+}
+
+//a crossfade draws one fade's worth of frames once, then nothing for the rest of the minute
+static void test_crossfade() {
+  LedStats before;
+  status_led_get_stats(&before);
+  frames.clear();
+  uint32_t t0 = millis();
+  status_led_set(COLOR_COMPLETED, LED_SOLID);
+  host_timers_run();
+  host_advance_ms(60000);
+  LedStats s = stats_since(before);
+  CHECK_EQ(s.frames + s.skipped, LED_FADE_MS / LED_FRAME_MS + 1);
+  CHECK(s.frames >= LED_FADE_MS / LED_FRAME_MS * 3 / 4);
+  CHECK(!frames.empty() && frames.back().ms == t0 + LED_FADE_MS);
+  LEDColor purple = { 56, 0, 56 };   //128 through gamma
+  CHECK(!frames.empty() && same(frames.back().color, purple));
+}
+
+//asking for what is already showing neither wakes the timer nor draws
+static void test_repeat_request() {
+  LedStats before;
+  status_led_get_stats(&before);
+  for (int i = 0; i < 100; i++) status_led_update(COMPLETED);
+  host_advance_ms(1000);
+  LedStats s = stats_since(before);
+  CHECK_EQ(s.frames + s.skipped, 0);
+}
+
+static esp_timer_handle_t rearmed = NULL;
+
+//what the timer callback does when it wins the race: re-arms itself for its next blink
+static void rearm_first(esp_timer_handle_t timer) {
+  rearmed = timer;
+  esp_timer_start_once(timer, (uint64_t)LED_BLINK_MS * 1000);
+}
+
+//a new look asked for while the callback re-arms itself starts fading in straight away
+static void test_kick_race() {
+  frames.clear();
+  LedStats before;
+  status_led_get_stats(&before);
+  uint32_t t0 = millis();
+  host_timer_before_start(rearm_first);
+  status_led_update(CRITICAL);
+  CHECK(rearmed != NULL);
+  CHECK_EQ(host_timer_deadline_us(rearmed), (int64_t)t0 * 1000);
+  //the fade's first frame is what's already showing, so it counts as skipped
+  host_timers_run();
+  LedStats s = stats_since(before);
+  CHECK_EQ(s.frames + s.skipped, 1);
+  host_advance_ms(LED_FADE_MS);
+  LEDColor red = { 255, 0, 0 };
+  CHECK(!frames.empty() && same(frames.back().color, red));
+  host_timer_before_start(NULL);
+}
+
+int main() {
+  host_clock_reset(0);
+  status_led_set_backend(&recorder);
+  RUN(test_fade_frames);
+  RUN(test_gamma);
+
+  status_led_init();
+  status_led_set_backend(&recorder);
+  RUN(test_effects_per_minute);
+  RUN(test_crossfade);
+  RUN(test_repeat_request);
+  RUN(test_kick_race);
+  return check_report();
+}
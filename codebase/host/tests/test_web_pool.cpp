@@ -0,0 +1,370 @@
+#include "check.h"
+#include "host.h"
+#include "web.h"
+#include "series.h"
+#include "exporter.h"
+#include "entry_codec.h"
+#include <arpa/inet.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <chrono>
+#include <string>
+#include <vector>
+
+//the connection pool in web.cpp over real loopback sockets, on the virtual clock so the timeouts are exact
+//everything runs on one thread: the test writes, then drives webserver_handle_client() like the web task loop
+//also the range edges of /series and a streamed /export, which go through the same loop
+
+static int connect_client() {
+  int fd = socket(AF_INET, SOCK_STREAM, 0);
+  sockaddr_in addr = {};
+  addr.sin_family = AF_INET;
+  addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+  addr.sin_port = htons(host_web_bound_port());
+  if (connect(fd, (sockaddr *)&addr, sizeof(addr)) < 0) {
+    perror("connect");
+    close(fd);
+    return -1;
+  }
+  fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK);
+  return fd;
+}
+
+static void send_all(int fd, const std::string &text) {
+  size_t sent = 0;
+  while (sent < text.size()) {
+    ssize_t n = send(fd, text.data() + sent, text.size() - sent, MSG_NOSIGNAL);
+    if (n > 0) sent += n;
+    else if (n < 0 && errno != EAGAIN) break;
+  }
+}
+
+//a few passes of the web task loop, with a real pause so loopback data has landed
+static void pump(int passes = 3) {
+  for (int i = 0; i < passes; i++) {
+    usleep(1000);
+    webserver_handle_client();
+  }
+}
+
+//whatever has arrived, -1 once the server closed its end
+static int drain(int fd, std::string *out) {
+  char buf[4096];
+  while (true) {
+    ssize_t n = recv(fd, buf, sizeof(buf), 0);
+    if (n > 0) out->append(buf, n);
+    else if (n == 0) return -1;
+    else return 0;
+  }
+}
+
+//splits the complete responses off the front of a buffer, returns their status codes
+static std::vector<int> take_responses(std::string *buf) {
+  std::vector<int> codes;
+  while (true) {
+    size_t end = buf->find("\r\n\r\n");
+    if (end == std::string::npos) break;
+    size_t body = 0;
+    size_t cl = buf->find("Content-Length: ");
+    if (cl != std::string::npos && cl < end) body = strtoul(buf->c_str() + cl + 16, NULL, 10);
+    if (buf->size() < end + 4 + body) break;
+    codes.push_back(atoi(buf->c_str() + 9));
+    buf->erase(0, end + 4 + body);
+  }
+  return codes;
+}
+
+//pumps until n responses came back, or gives up
+static std::vector<int> responses(int fd, size_t n, bool *closed = NULL) {
+  std::string buf;
+  std::vector<int> codes;
+  bool eof = false;
+  for (int tries = 0; tries < 200 && codes.size() < n && !eof; tries++) {
+    pump(1);
+    eof = drain(fd, &buf) < 0;
+    std::vector<int> got = take_responses(&buf);
+    codes.insert(codes.end(), got.begin(), got.end());
+  }
+  if (closed) *closed = eof;
+  return codes;
+}
+
+static bool server_closed(int fd) {
+  std::string buf;
+  for (int tries = 0; tries < 20; tries++) {
+    pump(1);
+    if (drain(fd, &buf) < 0) return true;
+  }
+  return false;
+}
+
+//header dribbled in over many reads, nothing is answered until the blank line
+static void test_partial_reads() {
+  int fd = connect_client();
+  const std::string req = "GET /data HTTP/1.1\r\nHost: tracker\r\nIf-None-Match: \"v0\"\r\n\r\n";
+  std::string buf;
+  for (size_t i = 0; i + 1 < req.size(); i++) {
+    send_all(fd, req.substr(i, 1));
+    pump(1);
+    drain(fd, &buf);
+  }
+  CHECK(buf.empty());
+  send_all(fd, req.substr(req.size() - 1));
+  std::vector<int> codes = responses(fd, 1);
+  CHECK_EQ(codes.size(), 1);
+  if (codes.size() == 1) CHECK_EQ(codes[0], 200);
+  close(fd);
+  pump();
+}
+
+//several requests in one segment come back in order on the same connection
+static void test_pipelined() {
+  int fd = connect_client();
+  send_all(fd, "GET /data HTTP/1.1\r\n\r\nGET /nope HTTP/1.1\r\n\r\nGET /quiet HTTP/1.1\r\n\r\n"
+               "GET /data HTTP/1.1\r\nConnection: close\r\n\r\n");
+  bool closed = false;
+  std::vector<int> codes = responses(fd, 4, &closed);
+  CHECK_EQ(codes.size(), 4);
+  if (codes.size() == 4) {
+    CHECK_EQ(codes[0], 200);
+    CHECK_EQ(codes[1], 404);
+    CHECK_EQ(codes[2], 400);
+    CHECK_EQ(codes[3], 200);
+  }
+  //the last one asked to close
+  CHECK(closed || server_closed(fd));
+  close(fd);
+}
+
+//only WEB_MAX_CONNECTIONS are serviced at once, the rest wait in the backlog until a slot frees up
+static void test_concurrent_clients() {
+  const int total = WEB_MAX_CONNECTIONS + 2;
+  int fds[total];
+  for (int i = 0; i < total; i++) fds[i] = connect_client();
+  pump();
+  for (int i = 0; i < total; i++) send_all(fds[i], "GET /data HTTP/1.1\r\n\r\n");
+
+  int answered = 0;
+  for (int i = 0; i < WEB_MAX_CONNECTIONS; i++) answered += responses(fds[i], 1).size();
+  CHECK_EQ(answered, WEB_MAX_CONNECTIONS);
+  std::string waiting;
+  for (int i = WEB_MAX_CONNECTIONS; i < total; i++) drain(fds[i], &waiting);
+  CHECK(waiting.empty());
+
+  //keep-alive clients hang up, their slots go to the ones in the backlog
+  for (int i = 0; i < total - WEB_MAX_CONNECTIONS; i++) close(fds[i]);
+  pump();
+  for (int i = WEB_MAX_CONNECTIONS; i < total; i++) CHECK_EQ(responses(fds[i], 1).size(), 1);
+  for (int i = total - WEB_MAX_CONNECTIONS; i < total; i++) close(fds[i]);
+  pump();
+}
+
+//a client stuck mid header neither holds up the others nor keeps its slot past HTTP_READ_TIMEOUT_MS
+static void test_slow_client() {
+  int slow = connect_client();
+  send_all(slow, "GET /da");
+  pump();
+  int fast = connect_client();
+  send_all(fast, "GET /data HTTP/1.1\r\n\r\n");
+  CHECK_EQ(responses(fast, 1).size(), 1);
+
+  host_advance_ms(HTTP_READ_TIMEOUT_MS - 100);
+  CHECK(!server_closed(slow));
+  host_advance_ms(200);
+  CHECK(server_closed(slow));
+  close(slow);
+
+  //an idle keep-alive connection gets the longer WEB_KEEPALIVE_MS
+  host_advance_ms(WEB_KEEPALIVE_MS - HTTP_READ_TIMEOUT_MS - 200);
+  CHECK(!server_closed(fast));
+  host_advance_ms(200);
+  CHECK(server_closed(fast));
+  close(fast);
+}
+
+static void test_refused() {
+  int fd = connect_client();
+  send_all(fd, "BAD\r\n\r\n");
+  bool closed = false;
+  std::vector<int> codes = responses(fd, 1, &closed);
+  CHECK(codes.size() == 1 && codes[0] == 400);
+  CHECK(closed || server_closed(fd));
+  close(fd);
+
+  fd = connect_client();
+  send_all(fd, "GET / HTTP/1.1\r\nX-Pad: " + std::string(HTTP_MAX_HEADER, 'p') + "\r\n\r\n");
+  codes = responses(fd, 1);
+  CHECK(codes.size() == 1 && codes[0] == 431);
+  CHECK(server_closed(fd));
+  close(fd);
+}
+
+//real milliseconds webserver_wait() slept
+static double timed_wait(uint32_t timeout_ms) {
+  std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+  webserver_wait(timeout_ms);
+  return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+//the web task sleeps in select() until a socket has something for it, or a pooled connection's timeout is due
+static void test_wait() {
+  CHECK(timed_wait(50) >= 45);
+  //a new connection
+  int fd = connect_client();
+  CHECK(timed_wait(2000) < 500);
+  pump();
+  //nothing sent yet, the wait lasts until the timeout
+  CHECK(timed_wait(50) >= 45);
+  //request bytes
+  send_all(fd, "GET /data HTTP/1.1\r\n\r\n");
+  CHECK(timed_wait(2000) < 500);
+  CHECK_EQ(responses(fd, 1).size(), 1);
+  //an idle keep-alive connection wakes the task when it is due to be closed
+  host_advance_ms(WEB_KEEPALIVE_MS - 30);
+  double slept = timed_wait(2000);
+  CHECK(slept >= 20 && slept < 500);
+  host_advance_ms(40);
+  CHECK(server_closed(fd));
+  close(fd);
+  //a hang up
+  fd = connect_client();
+  pump();
+  close(fd);
+  CHECK(timed_wait(2000) < 500);
+  pump();
+}
+
+//one request on its own connection, the body of the reply
+static std::string fetch(const std::string &path) {
+  int fd = connect_client();
+  send_all(fd, "GET " + path + " HTTP/1.1\r\nConnection: close\r\n\r\n");
+  std::string buf;
+  for (int tries = 0; tries < 200 && drain(fd, &buf) >= 0; tries++) pump(1);
+  close(fd);
+  size_t end = buf.find("\r\n\r\n");
+  return (end == std::string::npos) ? "" : buf.substr(end + 4);
+}
+
+//seconds too large for a uint32_t of milliseconds mean past the end, not wrapped round to the start
+static void test_series_range() {
+  for (uint32_t s = 0; s < 10; s++) series_record(s * SERIES_BASE_BUCKET_MS, s * 10, s * 12);
+  const std::string all = "{\"session\":0,\"bucket_s\":5,\"points\":[[0,0,0,0,0],[5,10,10,12,12],[10,20,20,24,24],"
+    "[15,30,30,36,36],[20,40,40,48,48],[25,50,50,60,60],[30,60,60,72,72],[35,70,70,84,84],[40,80,80,96,96],"
+    "[45,90,90,108,108]]}";
+  const std::string empty = "{\"session\":0,\"bucket_s\":5,\"points\":[]}";
+  std::string body = fetch("/series?session=0");
+  CHECK_STR(body.c_str(), all.c_str());
+  body = fetch("/series?session=0&from=4294968");
+  CHECK_STR(body.c_str(), empty.c_str());
+  body = fetch("/series?session=0&from=99999999999");
+  CHECK_STR(body.c_str(), empty.c_str());
+  body = fetch("/series?session=0&to=4294968");
+  CHECK_STR(body.c_str(), all.c_str());
+  body = fetch("/series?session=0&to=4294967");
+  CHECK_STR(body.c_str(), all.c_str());
+  //a partial bucket at the end still counts
+  body = fetch("/series?session=0&from=40&to=41");
+  CHECK_STR(body.c_str(), "{\"session\":0,\"bucket_s\":5,\"points\":[[40,80,80,96,96]]}");
+}
+
+//sessions with a series each, enough that the export outgrows the socket buffers
+static void fill_journal(int sessions) {
+  host_flash_clear();
+  CHECK(journal_mount(NULL));
+  EntryCodec encoder;
+  entry_codec_init(&encoder);
+  for (int i = 0; i < sessions; i++) {
+    Entry e = { 600 + (uint32_t)i, 250.0f + i, 300 };
+    uint8_t packed[ENTRY_CODEC_MAX_BYTES];
+    uint32_t id = journal_append(JREC_SESSION_PACKED, packed, entry_encode(&encoder, &e, i == 0, packed));
+    for (uint32_t t = 0; t < SERIES_MAX_BUCKETS * SERIES_BASE_BUCKET_MS; t += 5000) {
+      series_record(t, (t / 1000 + i) * 7 % 1000, 300 + (t / 1000) * 13 % 700);
+    }
+    series_end(id);
+  }
+}
+
+//a chunked body put back together
+static std::string dechunk(const std::string &body, bool *complete) {
+  std::string out;
+  size_t pos = 0;
+  *complete = false;
+  while (pos < body.size()) {
+    size_t line = body.find("\r\n", pos);
+    if (line == std::string::npos) break;
+    size_t n = strtoul(body.c_str() + pos, NULL, 16);
+    if (n == 0) {
+      *complete = body.compare(line, 4, "\r\n\r\n") == 0;
+      break;
+    }
+    out.append(body, line + 2, n);
+    pos = line + 2 + n + 2;
+  }
+  return out;
+}
+
+//a reader that lets its receive buffer fill up gets every byte once it reads again, and doesn't hold up the pool
+static void test_export_slow_reader() {
+  fill_journal(150);
+  static Exporter e;
+  static uint8_t buf[4096];
+  exporter_begin(&e, EXPORT_NDJSON);
+  std::string expect;
+  size_t k;
+  while ((k = exporter_read(&e, buf, sizeof(buf))) > 0) expect.append((const char *)buf, k);
+
+  int slow = socket(AF_INET, SOCK_STREAM, 0);
+  int small = 4096;
+  setsockopt(slow, SOL_SOCKET, SO_RCVBUF, &small, sizeof(small));
+  sockaddr_in addr = {};
+  addr.sin_family = AF_INET;
+  addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+  addr.sin_port = htons(host_web_bound_port());
+  CHECK(connect(slow, (sockaddr *)&addr, sizeof(addr)) == 0);
+  fcntl(slow, F_SETFL, fcntl(slow, F_GETFL) | O_NONBLOCK);
+  send_all(slow, "GET /export?format=ndjson HTTP/1.1\r\n\r\n");
+  //the export stalls on the full socket, other clients are answered meanwhile
+  pump(50);
+  int fast = connect_client();
+  send_all(fast, "GET /data HTTP/1.1\r\n\r\n");
+  CHECK_EQ(responses(fast, 1).size(), 1);
+  close(fast);
+
+  std::string got;
+  bool closed = false;
+  for (int tries = 0; tries < 5000 && !closed; tries++) {
+    pump(1);
+    closed = drain(slow, &got) < 0;
+  }
+  close(slow);
+  CHECK(closed);
+  CHECK(expect.size() > 256 * 1024);
+  size_t end = got.find("\r\n\r\n");
+  CHECK(end != std::string::npos);
+  bool complete = false;
+  std::string body = dechunk(got.substr(end + 4), &complete);
+  CHECK(complete);
+  CHECK_EQ(body.size(), expect.size());
+  CHECK(body == expect);
+}
+
+int main() {
+  host_clock_reset(0);
+  host_web_port = 0;
+  web_enable();
+  CHECK(host_web_bound_port() != 0);
+
+  RUN(test_partial_reads);
+  RUN(test_pipelined);
+  RUN(test_concurrent_clients);
+  RUN(test_slow_client);
+  RUN(test_refused);
+  RUN(test_series_range);
+  RUN(test_wait);
+  RUN(test_export_slow_reader);
+  web_disable();
+  return check_report();
+}
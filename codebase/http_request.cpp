@@ -0,0 +1,218 @@
+#include "http_request.h"
+
+//where the parser is within the header
+enum HttpParseState {
+  PARSE_METHOD,
+  PARSE_PATH,
+  PARSE_QUERY,
+  PARSE_VERSION,
+  PARSE_NAME,
+  PARSE_VALUE_START,
+  PARSE_VALUE,
+  PARSE_DONE
+};
+
+//headers the server cares about, the rest are skipped
+enum HttpHeader {
+  HEADER_OTHER,
+  HEADER_IF_NONE_MATCH,
+  HEADER_CONNECTION
+};
+
+void http_request_init(HttpRequest *req) {
+  req->method[0] = '\0';
+  req->path[0] = '\0';
+  req->query[0] = '\0';
+  req->if_none_match[0] = '\0';
+  req->keep_alive = true;
+  req->header_bytes = 0;
+  req->state = PARSE_METHOD;
+  req->len = 0;
+  req->header = HEADER_OTHER;
+  req->name[0] = '\0';
+}
+
+//appends c to a fixed field, returns false if it would overflow
+static bool append(char *field, size_t size, uint8_t *len, char c) {
+  if ((size_t)*len + 1 >= size) return false;
+  field[(*len)++] = c;
+  field[*len] = '\0';
+  return true;
+}
+
+//called at the end of a header line with the value sitting in req->name (or req->if_none_match)
+static void finish_header(HttpRequest *req) {
+  if (req->header == HEADER_CONNECTION) {
+    if (strcasecmp(req->name, "close") == 0) req->keep_alive = false;
+    else if (strcasecmp(req->name, "keep-alive") == 0) req->keep_alive = true;
+  }
+  else if (req->header == HEADER_IF_NONE_MATCH) {
+    //drop trailing whitespace
+    while (req->len > 0 && req->if_none_match[req->len - 1] == ' ') {
+      req->if_none_match[--req->len] = '\0';
+    }
+  }
+}
+
+//feeds bytes into the parser, stops right after the blank line that ends the header
+//consumed (optional) is set to how many bytes were used, anything after belongs to the body or the next request
+HttpParseResult http_request_feed(HttpRequest *req, const char *data, size_t len, size_t *consumed) {
+  size_t i = 0;
+  HttpParseResult result = HTTP_PARSE_MORE;
+  if (req->state == PARSE_DONE) {
+    if (consumed) *consumed = 0;
+    return HTTP_PARSE_DONE;
+  }
+
+  for (; i < len && result == HTTP_PARSE_MORE; i++) {
+    char c = data[i];
+    if (++req->header_bytes > HTTP_MAX_HEADER) {
+      result = HTTP_PARSE_TOO_LARGE;
+      break;
+    }
+
+    switch (req->state) {
+      case PARSE_METHOD:
+        if (c == ' ') {
+          if (req->len == 0) result = HTTP_PARSE_BAD;
+          req->state = PARSE_PATH;
+          req->len = 0;
+        }
+        else if (c < 'A' || c > 'Z' || !append(req->method, sizeof(req->method), &req->len, c)) {
+          result = HTTP_PARSE_BAD;
+        }
+        break;
+
+      case PARSE_PATH:
+        if (c == ' ' || c == '?') {
+          if (req->len == 0) result = HTTP_PARSE_BAD;
+          req->state = (c == '?') ? PARSE_QUERY : PARSE_VERSION;
+          req->len = 0;
+        }
+        else if (c == '\r' || c == '\n') {
+          result = HTTP_PARSE_BAD;
+        }
+        else if (!append(req->path, sizeof(req->path), &req->len, c)) {
+          result = HTTP_PARSE_TOO_LARGE;
+        }
+        break;
+
+      case PARSE_QUERY:
+        if (c == ' ') {
+          req->state = PARSE_VERSION;
+          req->len = 0;
+        }
+        else if (c == '\r' || c == '\n') {
+          result = HTTP_PARSE_BAD;
+        }
+        else if (!append(req->query, sizeof(req->query), &req->len, c)) {
+          result = HTTP_PARSE_TOO_LARGE;
+        }
+        break;
+
+      case PARSE_VERSION:
+        if (c == '\n') {
+          //HTTP/1.0 closes by default
+          if (strcmp(req->name, "HTTP/1.0") == 0) req->keep_alive = false;
+          else if (strncmp(req->name, "HTTP/1.", 7) != 0) result = HTTP_PARSE_BAD;
+          req->state = PARSE_NAME;
+          req->len = 0;
+          req->name[0] = '\0';
+        }
+        else if (c != '\r' && !append(req->name, sizeof(req->name), &req->len, c)) {
+          result = HTTP_PARSE_BAD;
+        }
+        break;
+
+      case PARSE_NAME:
+        if (c == '\r') break;
+        if (c == '\n') {
+          //blank line ends the header, a name with no colon is malformed
+          result = (req->len == 0) ? HTTP_PARSE_DONE : HTTP_PARSE_BAD;
+          req->state = PARSE_DONE;
+        }
+        else if (c == ':') {
+          if (strcmp(req->name, "if-none-match") == 0) req->header = HEADER_IF_NONE_MATCH;
+          else if (strcmp(req->name, "connection") == 0) req->header = HEADER_CONNECTION;
+          else req->header = HEADER_OTHER;
+          req->state = PARSE_VALUE_START;
+          req->len = 0;
+          req->name[0] = '\0';
+        }
+        else {
+          //names longer than the buffer can't be one we care about, keep the prefix and move on
+          append(req->name, sizeof(req->name), &req->len, (c >= 'A' && c <= 'Z') ? c + ('a' - 'A') : c);
+        }
+        break;
+
+      case PARSE_VALUE_START:
+        if (c == ' ' || c == '\t') break;
+        req->state = PARSE_VALUE;
+        //c is the first value byte
+        // fall through
+      case PARSE_VALUE:
+        if (c == '\r') break;
+        if (c == '\n') {
+          finish_header(req);
+          req->state = PARSE_NAME;
+          req->header = HEADER_OTHER;
+          req->len = 0;
+          req->name[0] = '\0';
+        }
+        else if (req->header == HEADER_IF_NONE_MATCH) {
+          append(req->if_none_match, sizeof(req->if_none_match), &req->len, c);
+        }
+        else if (req->header == HEADER_CONNECTION) {
+          append(req->name, sizeof(req->name), &req->len, c);
+        }
+        break;
+
+      case PARSE_DONE:
+        break;
+    }
+  }
+
+  if (consumed) *consumed = i;
+  return result;
+}
+
+//copies the raw value of key from the query string, returns false if the key is missing or doesn't fit
+bool http_query_get(const HttpRequest *req, const char *key, char *out, size_t out_len) {
+  size_t key_len = strlen(key);
+  const char *p = req->query;
+  while (*p) {
+    const char *end = strchr(p, '&');
+    if (end == NULL) end = p + strlen(p);
+    if ((size_t)(end - p) > key_len && strncmp(p, key, key_len) == 0 && p[key_len] == '=') {
+      const char *value = p + key_len + 1;
+      size_t n = end - value;
+      if (n >= out_len) return false;
+      memcpy(out, value, n);
+      out[n] = '\0';
+      return true;
+    }
+    p = (*end == '&') ? end + 1 : end;
+  }
+  return false;
+}
+
+//integer query parameter, the whole value has to parse
+bool http_query_get_long(const HttpRequest *req, const char *key, long *out) {
+  char value[16];
+  if (!http_query_get(req, key, value, sizeof(value)) || value[0] == '\0') return false;
+  char *end;
+  long v = strtol(value, &end, 10);
+  if (*end != '\0') return false;
+  *out = v;
+  return true;
+}
+
+bool http_query_get_float(const HttpRequest *req, const char *key, float *out) {
+  char value[16];
+  if (!http_query_get(req, key, value, sizeof(value)) || value[0] == '\0') return false;
+  char *end;
+  float v = strtof(value, &end);
+  if (*end != '\0') return false;
+  *out = v;
+  return true;
+}
@@ -0,0 +1,37 @@
+#ifndef HTTP_REQUEST_H
+#define HTTP_REQUEST_H
+
+#include <Arduino.h>
+#include "config.h"
+
+//incremental HTTP/1.1 request header parser, works on fixed buffers and never allocates
+
+enum HttpParseResult {
+  HTTP_PARSE_MORE,        //header not finished, feed more bytes
+  HTTP_PARSE_DONE,        //blank line reached, request is ready
+  HTTP_PARSE_BAD,         //malformed request line or header
+  HTTP_PARSE_TOO_LARGE    //header went past HTTP_MAX_HEADER or a field overflowed
+};
+
+struct HttpRequest {
+  char method[8];
+  char path[HTTP_MAX_PATH];
+  char query[HTTP_MAX_QUERY];             //raw text after '?', without the '?'
+  char if_none_match[HTTP_MAX_ETAG];
+  bool keep_alive;                        //HTTP/1.1 default unless "Connection: close"
+  uint16_t header_bytes;                  //bytes consumed so far, capped at HTTP_MAX_HEADER
+
+  //parser state
+  uint8_t state;
+  uint8_t len;                            //length of the field currently being filled
+  uint8_t header;                         //which header the current value belongs to
+  char name[24];                          //current header name, lowercased and truncated
+};
+
+void http_request_init(HttpRequest *req);
+HttpParseResult http_request_feed(HttpRequest *req, const char *data, size_t len, size_t *consumed);
+bool http_query_get(const HttpRequest *req, const char *key, char *out, size_t out_len);
+bool http_query_get_long(const HttpRequest *req, const char *key, long *out);
+bool http_query_get_float(const HttpRequest *req, const char *key, float *out);
+
+#endif // HTTP_REQUEST_H
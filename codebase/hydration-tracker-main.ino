@@ -6,38 +6,49 @@
 #include "storage.h"
 #include "web.h"
 #include "state.h"
+#include "events.h"
+#include "tracker.h"
+#include "power.h"
+#include "metrics.h"
 
 /*
 Updates onboard LED to show various conditions
 */
 void taskUpdateStatusLED(void *pv) {
+  state_subscribe(EVT_SESSION_START | EVT_SESSION_END | EVT_HYDRATION_CHANGE);
   while(1) {
     //until user enters required input for the session, make LED turn white
-    while (get_state() == STATE_WAITING_USER_INPUT) {
+    if (get_state() == STATE_WAITING_USER_INPUT) {
       status_led_show_waiting();
-      vTaskDelay(pdMS_TO_TICKS(100));
     }
     //updates LED based on hydration state
-    status_led_update(get_hydration_state());
-    vTaskDelay(pdMS_TO_TICKS(100));
+    else {
+      status_led_update(get_hydration_state());
+    }
+    //sleep until the session or hydration state changes
+    state_wait(portMAX_DELAY);
   }
 }
 
 /*
 Speaker that audibly alerts the user when the LED is red and the user needs to drink water
+The patterns play off a timer inside speaker.cpp, this task only tells it what changed
 */
 void taskAlertUser(void *pv) {
+  state_subscribe(EVT_SESSION_START | EVT_SESSION_END | EVT_HYDRATION_CHANGE);
+  HydrationState prev_state = get_hydration_state();
   while(1) {
-    //while waiting for user input don't use the speaker
-    while (get_state() == STATE_WAITING_USER_INPUT) {
-      speaker_stop();
-      vTaskDelay(pdMS_TO_TICKS(100));
-    }
-    //if hydration state is critical then sound speaker
-    if (get_hydration_state() == CRITICAL) {
-      speaker_alert();
+    bool running = get_state() == STATE_RUNNING;
+    HydrationState hydration_state = get_hydration_state();
+    //alerts repeat and escalate inside the sequencer for as long as the user stays critical
+    speaker_set_alerting(running && hydration_state == CRITICAL);
+    //chime once when the goal is reached
+    if (running && hydration_state == COMPLETED && prev_state != COMPLETED) {
+      speaker_play_done();
     }
-    vTaskDelay(pdMS_TO_TICKS(1000));
+    prev_state = hydration_state;
+    //sleep until the session or hydration state changes
+    state_wait(portMAX_DELAY);
   }
 }
 
@@ -45,6 +56,7 @@ void taskAlertUser(void *pv) {
 Generates HTML page allowing user to view hydration data and interact with system wirelessly through Wifi
 */
 void taskHTMLPage(void *pv) {
+  state_subscribe(EVT_WEB_BUTTON);
   while(1) {   
     //if user presses web page button, turn on web page
     if (get_web_request()) { 
@@ -53,88 +65,94 @@ void taskHTMLPage(void *pv) {
       
       while(1) {
         bool no_client = false;
-        //if waiting for user input then don't read from hydration.cpp
-        if (get_state() == STATE_RUNNING) {
-          set_goal_grams(get_goal_grams());
-          set_total_grams(get_total_grams());
-        }
-        
         //if true, then there is a client connected
         if (webserver_handle_client()) {
           client_connect_time = millis();
         }
+        //open dashboards count as connected clients too
+        if (web_push_events()) {
+          client_connect_time = millis();
+        }
         //keep web page on until CLIENT_TIMEOUT_SECS seconds pass with no client
-        if (millis() - client_connect_time > CLIENT_TIMEOUT_SECS * 1000) {
+        unsigned long idle = millis() - client_connect_time;
+        if (idle > CLIENT_TIMEOUT_SECS * 1000) {
           break;
         }
-        vTaskDelay(5);
+        //sleep in select() until a client needs answering, at the latest when the page is due to turn off
+        webserver_wait(CLIENT_TIMEOUT_SECS * 1000 - idle + 1);
       }
       //disable the website
       set_web_request(false);
       web_disable();
     }
-    vTaskDelay(10);
+    //sleep until the user presses the web page button
+    else {
+      state_wait(portMAX_DELAY);
+    }
   }
 }
 
 /*
-Detects scale changes and stores meaningful changes in non-volatile memory
+Reads the HX711 whenever it signals a conversion is ready and feeds the sample ring
 */
-void taskReadScale(void *pv) {
-  float prev_weight = 0;  //stores last weight detected
-  Entry html_page_entries[MAX_ENTRIES]; //holds data from storage to be populated to web
-  storage_load_entries(html_page_entries);  //load entries from non-volatile memory to html_page_entries
-  set_history(html_page_entries); //sends data to website
+void taskSampleScale(void *pv) {
+  scale_set_sampler_task(xTaskGetCurrentTaskHandle());
   while (1) {
-    //while waiting for user input, do not use the scale
-    while (get_state() == STATE_WAITING_USER_INPUT) {
-      vTaskDelay(pdMS_TO_TICKS(100));
-    }
-    //read the weight on the scale
-    float current_weight = scale_read_weight();
-    
-    // If there is something on the scale, weight decreased, and difference is meaningful
-    if (current_weight > 30.0 && current_weight < prev_weight && prev_weight - current_weight > 30.0) {
-      record_grams_drank(prev_weight - current_weight);  //record the difference in weight between previous reading and current reading
+    if (scale_wait_ready(pdMS_TO_TICKS(SCALE_READY_TIMEOUT_MS)) && scale_sample_poll(millis())) {
+      tracker_notify();
     }
+  }
+}
 
-    if (current_weight > 30.0)
-      prev_weight = current_weight; //save current weight as previous weight to detect drops in weight
-
-    update_hydration_status();
-
-    //if the pacer is 0, then that means the session ended
-    if (get_pacer() == 0) {
-      //store the sessions total water intake, the goal, and the session length in memory
-      storage_add_entry(get_total_grams(), get_goal_grams(), get_time_length());
+/*
+Detects scale changes and stores meaningful changes in non-volatile memory
+*/
+void taskReadScale(void *pv) {
+  tracker_set_task(xTaskGetCurrentTaskHandle());
+  tracker_init();
+  while (1) {
+    tracker_step();
+    metrics_poll_serial(millis());
+    //runs again for each new sample, or after 100 ms if the scale goes quiet
+    ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(100));
+  }
+}
 
-      //load past sessions into web page
-      storage_load_entries(html_page_entries);
-      set_history(html_page_entries);
-      
-      //refresh when session ends so user input overlay appear automatically
-      set_refresh_flag(true);
-      //user needs to input new information for new session after this session ends
-      set_state(STATE_WAITING_USER_INPUT);
-    }
-    vTaskDelay(pdMS_TO_TICKS(100));
+/*
+Lowest priority, only runs once every other task is blocked and then light sleeps until the next thing to do
+*/
+void taskPowerManager(void *pv) {
+  while (1) {
+    vTaskDelay(pdMS_TO_TICKS(power_idle()));
   }
 }
 
+//creates a task and registers it for the stack high-water marks in /metrics
+static void start_task(TaskFunction_t task, const char *name, uint32_t stack, UBaseType_t priority) {
+  TaskHandle_t handle = NULL;
+  xTaskCreate(task, name, stack, NULL, priority, &handle);
+  metrics_register_task(handle);
+}
+
 void setup() {
   //init
   Serial.begin(115200);
+  power_init();
+  storage_init();   //before the scale, which reads its calibration from NVS
   scale_init();
   status_led_init();
   web_init();
   speaker_init();
-  storage_init();
+  events_init();
+  hydration_init();
   
   //task creation
-  xTaskCreate(taskUpdateStatusLED, "taskUpdateStatusLED", 2048, NULL, 3, NULL);
-  xTaskCreate(taskAlertUser, "taskAlertUser", 2048, NULL, 3, NULL);
-  xTaskCreate(taskReadScale, "taskReadScale", 4096, NULL, 1, NULL);
-  xTaskCreate(taskHTMLPage, "taskHTMLPage", 4096, NULL, 2, NULL);
+  start_task(taskUpdateStatusLED, "taskUpdateStatusLED", 2048, 3);
+  start_task(taskAlertUser, "taskAlertUser", 2048, 3);
+  start_task(taskSampleScale, "taskSampleScale", 2048, 4);
+  start_task(taskReadScale, "taskReadScale", 4096, 1);
+  start_task(taskHTMLPage, "taskHTMLPage", 4096, 2);
+  start_task(taskPowerManager, "taskPowerManager", 2048, 0);
 }
 
 void loop() {
@@ -1,97 +1,219 @@
 #include "hydration.h"
 #include "storage.h"
+#include "events.h"
+#include "state.h"
+#include "pacing.h"
+#include "metrics.h"
 #include <Arduino.h>
+#include <atomic>
 
 HydrationState hydration_state = NEEDS_WATER;
-float initial_time; //used to determine elapsed time
-float goal; //session water intake goal
-float grams_left; //grams left to reach goal
-float pacer;  //mainly used to determine hydration state, acts as an "ideal" grams_left
-float total_grams;  //total water intake so far during the session
-unsigned long time_period_ms; //duration of session in milliseconds
+int32_t goal_mg; //session water intake goal, milligrams
+int32_t left_mg; //milligrams left to reach goal
+int32_t pacer_mg;  //mainly used to determine hydration state, acts as an "ideal" left_mg
+uint64_t time_period_ms; //duration of session in milliseconds
+PacingCurve pacing_curve_choice = PACING_DEFAULT_CURVE; //curve the next session uses
+static Pacer plan;  //timing of the running session
+static bool started = false;  //plan holds the running session, set by the first status update
+static int64_t next_transition_ms;  //state can't change before this unless the user drinks, written under writer_lock
+//set by anything that moves left_mg or the plan, the state is recomputed on the next update
+static std::atomic<bool> state_dirty(true);
+
+//sequence lock around the published snapshot, odd while the writer is mid update
+static HydrationSnapshot snapshot;
+static std::atomic<uint32_t> snapshot_seq(0);
+//the scale task and the web task both update the session, writers take this briefly
+static portMUX_TYPE writer_lock = portMUX_INITIALIZER_UNLOCKED;
+
+//copies the globals into the snapshot, caller holds writer_lock
+static void hydration_publish() {
+  uint32_t seq = snapshot_seq.load(std::memory_order_relaxed);
+  snapshot_seq.store(seq + 1, std::memory_order_relaxed);
+  std::atomic_thread_fence(std::memory_order_release);
+  snapshot.goal = goal_mg / 1000.0f;
+  snapshot.grams_left = left_mg / 1000.0f;
+  snapshot.pacer = pacer_mg / 1000.0f;
+  snapshot.total_grams = (goal_mg - left_mg) / 1000.0f;
+  snapshot.state = hydration_state;
+  snapshot.version = seq / 2 + 1;
+  std::atomic_thread_fence(std::memory_order_release);
+  snapshot_seq.store(seq + 2, std::memory_order_release);
+}
+
+//coherent copy of the session numbers, never blocks the writer, retries if it raced an update
+void hydration_get_snapshot(HydrationSnapshot *out) {
+  uint32_t before, after;
+  while (true) {
+    before = snapshot_seq.load(std::memory_order_acquire);
+    *out = snapshot;
+    std::atomic_thread_fence(std::memory_order_acquire);
+    after = snapshot_seq.load(std::memory_order_relaxed);
+    if (!(before & 1) && before == after) break;
+    metrics_count(METRIC_SNAPSHOT_RETRIES);
+  }
+}
 
 //adds the grams_drank parameter to total water intake
 void record_grams_drank(float grams_drank) {
-  grams_left = grams_left - grams_drank;
-  total_grams += grams_drank;
+  portENTER_CRITICAL(&writer_lock);
+  left_mg -= (int32_t)lroundf(grams_drank * 1000);
+  state_dirty.store(true);
+  hydration_publish();
+  portEXIT_CRITICAL(&writer_lock);
+}
+
+//scale event listener, sips from the session channel only count while a session is running
+static void hydration_on_scale_event(const ScaleEvent *event) {
+  if (event->type == EVENT_SIP && event->channel == SCALE_SESSION_CHANNEL && get_state() == STATE_RUNNING) {
+    record_grams_drank(event->grams);
+  }
+}
+
+//hooks hydration tracking up to the scale event detector
+void hydration_init() {
+  events_add_listener(hydration_on_scale_event);
 }
 
 //gets called every time a new session starts, resets variables and locks in new user inputs from website
 void reset() {
-  initial_time = 0;
-  pacer = goal;
-  grams_left = goal;
-  total_grams = 0;
+  portENTER_CRITICAL(&writer_lock);
+  started = false;
+  pacer_mg = goal_mg;
+  left_mg = goal_mg;
   hydration_state = NEEDS_WATER;
+  state_dirty.store(true);
+  hydration_publish();
+  portEXIT_CRITICAL(&writer_lock);
+}
+
+//picks a session back up after a reboot, call after reset() with the checkpointed progress
+void hydration_resume(uint32_t elapsed_ms, float total) {
+  int64_t now = pacing_now_ms();
+  portENTER_CRITICAL(&writer_lock);
+  //the timer restarted at 0 with the reboot, so the session began before it, don't clamp or the time is lost
+  pacing_start(&plan, now - (int64_t)elapsed_ms, time_period_ms, goal_mg, pacing_curve_choice);
+  started = true;
+  left_mg = goal_mg - (int32_t)lroundf(total * 1000);
+  state_dirty.store(true);
+  hydration_publish();
+  portEXIT_CRITICAL(&writer_lock);
 }
 
 //determines hydration status based on time left and how much the user has drank so far
+//the pacer is cheap to follow every pass, the state is only worked out again when it can have changed
 void update_hydration_status() {
-  if (initial_time == 0) {
-    initial_time = millis();
+  HydrationState prev_state = hydration_state;
+  int64_t now = pacing_now_ms();
+
+  portENTER_CRITICAL(&writer_lock);
+  if (!started) {
+    pacing_start(&plan, now, time_period_ms, goal_mg, pacing_curve_choice);
+    started = true;
+    state_dirty.store(true);
   }
-  
-  float time_now = millis();
-  float time_since_start = time_now - initial_time;
-  
-  // the pacer linearly decreases from the goal, represents an ideal grams_left
-  float subtract = goal/time_period_ms * time_since_start;
-  pacer = (goal - subtract < 0) ? 0 : goal - subtract;
+  pacer_mg = pacing_target_mg(&plan, now);
+  int32_t left = left_mg;
+  int32_t pacer = pacer_mg;
+  //reset() and a resume on another task replace the plan, the state is worked out from this copy
+  Pacer session = plan;
+  portEXIT_CRITICAL(&writer_lock);
 
   if (DEBUG) {
     Serial.print("grams_left=");
-    Serial.print(grams_left);
+    Serial.print(left / 1000.0f);
     Serial.print(" pacer=");
-    Serial.println(pacer);
+    Serial.println(pacer / 1000.0f);
   }
 
-  //if met goal, then set state to COMPLETED
-  if (grams_left <= 0) {
-    hydration_state = COMPLETED;
+  //a sip, a reset or the next deadline passing, the search for the new deadline stays off the per tick path
+  //only this task writes next_transition_ms, so it may read it without the lock
+  bool recompute = state_dirty.exchange(false) || now >= next_transition_ms;
+  HydrationState state = prev_state;
+  int64_t next = 0;
+  if (recompute) {
+    state = pacing_state(&session, pacer, left);
+    next = pacing_next_transition(&session, left, now);
   }
-  // Update hydration state based on deviation from ideal drink pacer
-  else {
-    if (pacer - grams_left <= -1 * goal / 5) {
-      hydration_state = CRITICAL;
-    }
-    else if (pacer - grams_left <= 0) {
-      hydration_state = NEEDS_WATER;
-    }
-    else {
-      hydration_state = HYDRATED;
-    }
+
+  portENTER_CRITICAL(&writer_lock);
+  if (recompute) {
+    hydration_state = state;
+    next_transition_ms = next;
+  }
+  hydration_publish();
+  portEXIT_CRITICAL(&writer_lock);
+
+  //wake the LED and speaker tasks only when something they show actually changed
+  if (state != prev_state) {
+    state_notify(EVT_HYDRATION_CHANGE);
   }
 }
 
+//pacing time (pacing_now_ms()) the hydration state next changes by itself, 0 when no session is running
+//the power task asks, and a 64 bit value can tear on the 32 bit core, so it's read under the writer's lock
+int64_t hydration_next_deadline_ms() {
+  if (get_state() != STATE_RUNNING) return 0;
+  portENTER_CRITICAL(&writer_lock);
+  int64_t deadline = started ? next_transition_ms : 0;
+  portEXIT_CRITICAL(&writer_lock);
+  return deadline;
+}
+
+//true once the running session has used up its time
+bool hydration_session_over() {
+  return started && pacing_now_ms() >= pacing_end_ms(&plan);
+}
+
 //GETTERS AND SETTERS
 HydrationState get_hydration_state() {
   return hydration_state;
 }
 
 HydrationState set_hydration_state(HydrationState state_param) {
+  portENTER_CRITICAL(&writer_lock);
   hydration_state = state_param;
+  hydration_publish();
+  portEXIT_CRITICAL(&writer_lock);
+  return hydration_state;
 }
 
 float get_pacer() {
-  return pacer;
+  return pacer_mg / 1000.0f;
+}
+
+//session time run so far, 0 before the first status update
+uint32_t get_elapsed_ms() {
+  return started ? (uint32_t)(pacing_now_ms() - plan.start_ms) : 0;
 }
 
 float get_total_grams() {
-  return goal - grams_left;
+  return (goal_mg - left_mg) / 1000.0f;
 }
 
 float get_goal_grams() {
-  return goal;
+  return goal_mg / 1000.0f;
 }
 
 void set_goal(int goal_param) {
-  goal = goal_param;
+  portENTER_CRITICAL(&writer_lock);
+  goal_mg = goal_param * 1000;
+  hydration_publish();
+  portEXIT_CRITICAL(&writer_lock);
 }
 
 void set_time_length(int seconds) {
-  time_period_ms = seconds * 1000;
+  time_period_ms = (uint64_t)seconds * 1000;
 }
 
 int get_time_length() {
   return time_period_ms/1000;
+}
+
+//takes effect at the next reset(), a running session keeps its curve
+void set_pacing_curve(PacingCurve curve) {
+  pacing_curve_choice = curve;
+}
+
+PacingCurve get_pacing_curve() {
+  return pacing_curve_choice;
 }
\ No newline at end of file
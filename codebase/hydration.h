@@ -5,14 +5,21 @@
 
 void hydration_init();
 void update_hydration_status();
+bool hydration_session_over();
+int64_t hydration_next_deadline_ms();
 HydrationState get_hydration_state();
 void record_grams_drank(float grams_drank);
 float get_pacer();
 float get_goal_grams();
 void reset();
+void hydration_resume(uint32_t elapsed_ms, float total);
+uint32_t get_elapsed_ms();
 float get_total_grams();
 void set_goal(int goal);
 void set_time_length(int seconds);
 int get_time_length();
+void set_pacing_curve(PacingCurve curve);
+PacingCurve get_pacing_curve();
 HydrationState set_hydration_state(HydrationState state_param);
+void hydration_get_snapshot(HydrationSnapshot *out);
 #endif
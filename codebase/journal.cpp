@@ -0,0 +1,368 @@
+#include "journal.h"
+#include <esp_partition.h>
+
+#define JOURNAL_MAGIC 0x314A5348  //"HSJ1"
+#define RECORD_ALIGN 4
+
+//first bytes of every segment, seq only ever grows so the highest valid one is the head
+struct SegmentHeader {
+  uint32_t magic;
+  uint32_t seq;
+  uint32_t erase_count;
+  uint32_t first_id;    //id of the first record written to this segment
+  uint32_t crc;
+};
+
+//in front of every payload, crc covers the first 8 bytes and the payload
+//unwritten flash reads back as 0xFF so a len of 0xFFFF marks the end of a segment
+struct RecordHeader {
+  uint16_t len;
+  uint8_t type;
+  uint8_t reserved;
+  uint32_t id;
+  uint32_t crc;
+};
+
+static const esp_partition_t *partition = NULL;
+static const JournalFlash *flash = NULL;
+static SemaphoreHandle_t lock = NULL;  //flash calls can't run inside a critical section
+
+static uint32_t seg_count = 0;
+static uint32_t seg_seq[JOURNAL_MAX_SEGMENTS];  //0 while a segment holds no valid header
+static uint32_t seg_first_id[JOURNAL_MAX_SEGMENTS];
+static uint32_t head_seg = 0;   //segment appends go to
+static uint32_t head_off = 0;   //next free byte in the head segment
+static uint32_t next_seq = 1;
+static uint32_t next_id = 1;
+
+//header plus the largest payload, shared by append and iterate under lock
+static uint8_t record_buf[sizeof(RecordHeader) + JOURNAL_MAX_RECORD + RECORD_ALIGN];
+
+//DEFAULT FLASH --------------------------------------------------------
+static bool partition_read(uint32_t offset, void *buf, size_t len) {
+  return esp_partition_read(partition, offset, buf, len) == ESP_OK;
+}
+
+static bool partition_write(uint32_t offset, const void *buf, size_t len) {
+  return esp_partition_write(partition, offset, buf, len) == ESP_OK;
+}
+
+static bool partition_erase(uint32_t offset, size_t len) {
+  return esp_partition_erase_range(partition, offset, len) == ESP_OK;
+}
+
+static JournalFlash partition_flash = { partition_read, partition_write, partition_erase, 0 };
+
+//CRC ------------------------------------------------------------------
+//standard CRC-32 (zlib), a nibble at a time to keep the table small
+static uint32_t crc32_update(uint32_t crc, const void *data, size_t len) {
+  static const uint32_t table[16] = {
+    0x00000000, 0x1DB71064, 0x3B6E20C8, 0x26D930AC, 0x76DC4190, 0x6B6B51F4, 0x4DB26158, 0x5005713C,
+    0xEDB88320, 0xF00F9344, 0xD6D6A3E8, 0xCB61B38C, 0x9B64C2B0, 0x86D3D2D4, 0xA00AE278, 0xBDBDF21C
+  };
+  const uint8_t *p = (const uint8_t *)data;
+  crc = ~crc;
+  for (size_t i = 0; i < len; i++) {
+    crc = table[(crc ^ p[i]) & 0x0F] ^ (crc >> 4);
+    crc = table[(crc ^ (p[i] >> 4)) & 0x0F] ^ (crc >> 4);
+  }
+  return ~crc;
+}
+
+static uint32_t record_crc(const RecordHeader *h, const uint8_t *payload) {
+  return crc32_update(crc32_update(0, h, offsetof(RecordHeader, crc)), payload, h->len);
+}
+
+static uint32_t record_size(uint16_t len) {
+  return (sizeof(RecordHeader) + len + RECORD_ALIGN - 1) & ~(uint32_t)(RECORD_ALIGN - 1);
+}
+
+//SEGMENTS -------------------------------------------------------------
+static bool read_segment_header(uint32_t index, SegmentHeader *h) {
+  if (!flash->read(index * JOURNAL_SEGMENT_SIZE, h, sizeof(*h))) return false;
+  return h->magic == JOURNAL_MAGIC && h->crc == crc32_update(0, h, offsetof(SegmentHeader, crc));
+}
+
+//erases index and makes it the head, the erase count carries over from its old header
+static bool start_segment(uint32_t index) {
+  SegmentHeader h;
+  uint32_t erase_count = read_segment_header(index, &h) ? h.erase_count + 1 : 1;
+
+  seg_seq[index] = 0;
+  if (!flash->erase(index * JOURNAL_SEGMENT_SIZE, JOURNAL_SEGMENT_SIZE)) return false;
+
+  h.magic = JOURNAL_MAGIC;
+  h.seq = next_seq;
+  h.erase_count = erase_count;
+  h.first_id = next_id;
+  h.crc = crc32_update(0, &h, offsetof(SegmentHeader, crc));
+  if (!flash->write(index * JOURNAL_SEGMENT_SIZE, &h, sizeof(h))) return false;
+
+  seg_seq[index] = next_seq++;
+  seg_first_id[index] = next_id;
+  head_seg = index;
+  head_off = sizeof(SegmentHeader);
+  return true;
+}
+
+//reads the record at off in segment index into record_buf
+//returns 1 for a good record, 0 at the clean end of the segment, -1 for a torn or corrupt record
+static int read_record(uint32_t index, uint32_t off) {
+  RecordHeader *h = (RecordHeader *)record_buf;
+  if (off + sizeof(RecordHeader) > JOURNAL_SEGMENT_SIZE) return 0;
+  if (!flash->read(index * JOURNAL_SEGMENT_SIZE + off, h, sizeof(RecordHeader))) return -1;
+  if (h->len == 0xFFFF && h->type == 0xFF && h->id == 0xFFFFFFFF) return 0;
+  if (h->len > JOURNAL_MAX_RECORD || off + record_size(h->len) > JOURNAL_SEGMENT_SIZE) return -1;
+  uint8_t *payload = record_buf + sizeof(RecordHeader);
+  if (h->len > 0 && !flash->read(index * JOURNAL_SEGMENT_SIZE + off + sizeof(RecordHeader), payload, h->len)) return -1;
+  return (h->crc == record_crc(h, payload)) ? 1 : -1;
+}
+
+//calls visitor for every good record in one segment, returns false if the visitor stopped
+static bool walk_segment(uint32_t index, JournalVisitor visitor, void *ctx) {
+  const RecordHeader *h = (const RecordHeader *)record_buf;
+  uint32_t off = sizeof(SegmentHeader);
+  while (read_record(index, off) == 1) {
+    if (!visitor(h->type, h->id, record_buf + sizeof(RecordHeader), h->len, ctx)) return false;
+    off += record_size(h->len);
+  }
+  return true;
+}
+
+//MOUNT ----------------------------------------------------------------
+//passing NULL uses the JOURNAL_PARTITION partition, recovery only reads segment headers and the head segment
+bool journal_mount(const JournalFlash *flash_param) {
+  if (lock == NULL) lock = xSemaphoreCreateMutex();
+
+  if (flash_param == NULL) {
+    partition = esp_partition_find_first(ESP_PARTITION_TYPE_DATA, ESP_PARTITION_SUBTYPE_ANY, JOURNAL_PARTITION);
+    if (partition == NULL) {
+      if (DEBUG) Serial.println("journal partition missing");
+      flash = NULL;
+      return false;
+    }
+    partition_flash.size = partition->size;
+    flash_param = &partition_flash;
+  }
+  flash = flash_param;
+
+  seg_count = flash->size / JOURNAL_SEGMENT_SIZE;
+  if (seg_count > JOURNAL_MAX_SEGMENTS) seg_count = JOURNAL_MAX_SEGMENTS;
+  //rotation needs somewhere to go
+  if (seg_count < 2) {
+    flash = NULL;
+    return false;
+  }
+
+  xSemaphoreTake(lock, portMAX_DELAY);
+  //newest valid header is the head
+  SegmentHeader head_header = {};
+  bool found = false;
+  for (uint32_t i = 0; i < seg_count; i++) {
+    SegmentHeader h;
+    seg_seq[i] = read_segment_header(i, &h) ? h.seq : 0;
+    seg_first_id[i] = h.first_id;
+    if (seg_seq[i] != 0 && (!found || h.seq > head_header.seq)) {
+      head_header = h;
+      head_seg = i;
+      found = true;
+    }
+  }
+
+  bool ok = true;
+  if (!found) {
+    //blank or foreign partition
+    next_seq = 1;
+    next_id = 1;
+    ok = start_segment(0);
+  }
+  else {
+    //walk the head to find the end of the log
+    next_seq = head_header.seq + 1;
+    next_id = head_header.first_id;
+    head_off = sizeof(SegmentHeader);
+    int result;
+    while ((result = read_record(head_seg, head_off)) == 1) {
+      next_id = ((RecordHeader *)record_buf)->id + 1;
+      head_off += record_size(((RecordHeader *)record_buf)->len);
+    }
+    //a torn write left programmed bytes behind, the rest of the segment can't be written safely
+    if (result < 0) head_off = JOURNAL_SEGMENT_SIZE;
+  }
+  xSemaphoreGive(lock);
+
+  if (DEBUG) {
+    Serial.print("journal head=");
+    Serial.print(head_seg);
+    Serial.print(" off=");
+    Serial.print(head_off);
+    Serial.print(" next_id=");
+    Serial.println(next_id);
+  }
+  if (!ok) flash = NULL;
+  return ok;
+}
+
+//APPEND AND READ ------------------------------------------------------
+//writes one record, moving to the next segment (and erasing the oldest) when the head is full
+//returns the new record's id, 0 if it wasn't written
+uint32_t journal_append(uint8_t type, const void *data, uint16_t len) {
+  if (flash == NULL || len > JOURNAL_MAX_RECORD) return 0;
+  uint32_t id = 0;
+  uint32_t size = record_size(len);
+
+  xSemaphoreTake(lock, portMAX_DELAY);
+  bool ok = true;
+  if (head_off + size > JOURNAL_SEGMENT_SIZE) {
+    ok = start_segment((head_seg + 1) % seg_count);
+  }
+  if (ok) {
+    //header and payload go out in one write, a tear anywhere in it fails the crc
+    RecordHeader *h = (RecordHeader *)record_buf;
+    uint8_t *payload = record_buf + sizeof(RecordHeader);
+    h->len = len;
+    h->type = type;
+    h->reserved = 0;
+    h->id = next_id;
+    if (len > 0) memcpy(payload, data, len);
+    memset(payload + len, 0xFF, size - sizeof(RecordHeader) - len);
+    h->crc = record_crc(h, payload);
+    ok = flash->write(head_seg * JOURNAL_SEGMENT_SIZE + head_off, record_buf, size);
+    if (ok) {
+      head_off += size;
+      id = next_id++;
+    }
+    else {
+      //don't write after a failed program, the next append starts a fresh segment
+      head_off = JOURNAL_SEGMENT_SIZE;
+    }
+  }
+  xSemaphoreGive(lock);
+
+  if (!ok && DEBUG) Serial.println("journal append failed");
+  return id;
+}
+
+//whether a record of len bytes still goes in the head segment, otherwise appending it starts a new one
+bool journal_fits(uint16_t len) {
+  return head_off + record_size(len) <= JOURNAL_SEGMENT_SIZE;
+}
+
+//oldest segment still holding records, caller holds lock
+static uint32_t oldest_segment() {
+  uint32_t start = head_seg;
+  for (uint32_t n = 1; n < seg_count; n++) {
+    uint32_t prev = (start + seg_count - 1) % seg_count;
+    if (seg_seq[prev] == 0 || seg_seq[prev] >= seg_seq[start]) break;
+    start = prev;
+  }
+  return start;
+}
+
+//visits records in the newest segments (head included) oldest first
+//the journal is locked for the whole walk, so the visitor must not append
+void journal_iterate_recent(uint32_t segments, JournalVisitor visitor, void *ctx) {
+  if (flash == NULL || segments == 0) return;
+
+  xSemaphoreTake(lock, portMAX_DELAY);
+  //step back from the head while the segments behind it are older
+  uint32_t start = head_seg;
+  for (uint32_t n = 1; n < segments && n < seg_count; n++) {
+    uint32_t prev = (start + seg_count - 1) % seg_count;
+    if (seg_seq[prev] == 0 || seg_seq[prev] >= seg_seq[start]) break;
+    start = prev;
+  }
+
+  uint32_t index = start;
+  while (walk_segment(index, visitor, ctx) && index != head_seg) {
+    index = (index + 1) % seg_count;
+  }
+  xSemaphoreGive(lock);
+}
+
+//CURSORS --------------------------------------------------------------
+//puts the cursor on the oldest record, the journal is only locked inside each call
+void journal_cursor_begin(JournalCursor *cursor) {
+  cursor->done = (flash == NULL);
+  if (cursor->done) return;
+  xSemaphoreTake(lock, portMAX_DELAY);
+  cursor->seg = oldest_segment();
+  cursor->seq = seg_seq[cursor->seg];
+  cursor->off = sizeof(SegmentHeader);
+  xSemaphoreGive(lock);
+}
+
+//copies the next record into data (JOURNAL_MAX_RECORD bytes), false once the end of the log is reached
+//if rotation recycled the cursor's segment meanwhile, it carries on from the oldest record left
+bool journal_cursor_next(JournalCursor *cursor, uint8_t *type, uint32_t *id, uint8_t *data, uint16_t *len) {
+  if (cursor->done || flash == NULL) return false;
+
+  xSemaphoreTake(lock, portMAX_DELAY);
+  bool found = false;
+  while (!found) {
+    if (seg_seq[cursor->seg] != cursor->seq) {
+      cursor->seg = oldest_segment();
+      cursor->seq = seg_seq[cursor->seg];
+      cursor->off = sizeof(SegmentHeader);
+    }
+    if (read_record(cursor->seg, cursor->off) == 1) {
+      const RecordHeader *h = (const RecordHeader *)record_buf;
+      *type = h->type;
+      *id = h->id;
+      *len = h->len;
+      memcpy(data, record_buf + sizeof(RecordHeader), h->len);
+      cursor->off += record_size(h->len);
+      found = true;
+    }
+    else if (cursor->seg == head_seg) {
+      break;
+    }
+    else {
+      cursor->seg = (cursor->seg + 1) % seg_count;
+      cursor->seq = seg_seq[cursor->seg];
+      cursor->off = sizeof(SegmentHeader);
+    }
+  }
+  xSemaphoreGive(lock);
+
+  if (!found) cursor->done = true;
+  return found;
+}
+
+//visits every record still on flash, oldest first
+void journal_iterate(JournalVisitor visitor, void *ctx) {
+  journal_iterate_recent(seg_count, visitor, ctx);
+}
+
+//visits records starting at the segment that holds id, the visitor skips anything before id itself
+//segment headers know their first id, so this only reads from that segment on
+void journal_iterate_from(uint32_t id, JournalVisitor visitor, void *ctx) {
+  if (flash == NULL || id >= next_id) return;
+
+  xSemaphoreTake(lock, portMAX_DELAY);
+  uint32_t start = head_seg;
+  for (uint32_t n = 1; n < seg_count && seg_first_id[start] > id; n++) {
+    uint32_t prev = (start + seg_count - 1) % seg_count;
+    if (seg_seq[prev] == 0 || seg_seq[prev] >= seg_seq[start]) break;
+    start = prev;
+  }
+
+  //id already dropped off with the oldest segment
+  if (seg_first_id[start] <= id) {
+    uint32_t index = start;
+    while (walk_segment(index, visitor, ctx) && index != head_seg) {
+      index = (index + 1) % seg_count;
+    }
+  }
+  xSemaphoreGive(lock);
+}
+
+//id the next append will get, 1 on an empty journal
+uint32_t journal_next_id() {
+  return next_id;
+}
+
+//seq of the segment appends go to, changes whenever the journal moves on to a new segment
+uint32_t journal_head_seq() {
+  return seg_seq[head_seg];
+}
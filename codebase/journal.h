@@ -0,0 +1,40 @@
+#ifndef JOURNAL_H
+#define JOURNAL_H
+
+#include <Arduino.h>
+#include "config.h"
+
+//append only, CRC protected record log split into sector sized segments
+//segments are used round robin so every sector sees the same number of erases
+
+//flash access, the default uses the JOURNAL_PARTITION partition
+struct JournalFlash {
+  bool (*read)(uint32_t offset, void *buf, size_t len);
+  bool (*write)(uint32_t offset, const void *buf, size_t len);
+  bool (*erase)(uint32_t offset, size_t len);
+  uint32_t size;  //bytes
+};
+
+//position of a reader that doesn't hold the journal between records
+struct JournalCursor {
+  uint32_t seg;
+  uint32_t seq;   //seq of seg when the cursor got there, a different one means it was recycled
+  uint32_t off;
+  bool done;
+};
+
+//called once per record in append order, return false to stop early
+typedef bool (*JournalVisitor)(uint8_t type, uint32_t id, const uint8_t *data, uint16_t len, void *ctx);
+
+bool journal_mount(const JournalFlash *flash_param);
+uint32_t journal_append(uint8_t type, const void *data, uint16_t len);
+bool journal_fits(uint16_t len);
+void journal_iterate(JournalVisitor visitor, void *ctx);
+void journal_iterate_recent(uint32_t segments, JournalVisitor visitor, void *ctx);
+void journal_iterate_from(uint32_t id, JournalVisitor visitor, void *ctx);
+uint32_t journal_next_id();
+uint32_t journal_head_seq();
+void journal_cursor_begin(JournalCursor *cursor);
+bool journal_cursor_next(JournalCursor *cursor, uint8_t *type, uint32_t *id, uint8_t *data, uint16_t *len);
+
+#endif // JOURNAL_H
@@ -0,0 +1,197 @@
+#include "metrics.h"
+#include "status_led.h"
+#include "power.h"
+#include <esp_heap_caps.h>
+#include <stdarg.h>
+
+std::atomic<uint32_t> metrics_counters[METRIC_COUNTER_COUNT];
+MetricHist metrics_hists[METRIC_HISTOGRAM_COUNT];
+
+static TaskHandle_t tasks[METRICS_MAX_TASKS];
+static uint8_t task_count = 0;
+
+static const char *const counter_names[METRIC_COUNTER_COUNT] = {
+  "scale_reads_total", "detector_samples_total", "settle_waits_total", "http_requests_total", "http_sent_bytes_total",
+  "nvs_commits_total", "snapshot_retries_total", "export_bytes_total", "export_milliseconds_total"
+};
+static const char *const counter_help[METRIC_COUNTER_COUNT] = {
+  "HX711 conversions read",
+  "Samples run through the sip detector",
+  "Detector passes spent waiting for a moved bottle to settle",
+  "HTTP requests handled",
+  "Bytes written to HTTP clients",
+  "NVS commits",
+  "Hydration snapshot reads retried because an update was in progress",
+  "Payload bytes of finished /export downloads",
+  "Time finished /export downloads took"
+};
+
+struct HistInfo {
+  const char *name;
+  const char *help;
+  bool cycles;    //value is CPU cycles, shown in seconds
+};
+static const HistInfo hist_info[METRIC_HISTOGRAM_COUNT] = {
+  { "scale_read_seconds", "Time to clock one conversion out of every HX711", true },
+  { "settle_samples", "Samples from the bottle moving to it settling again", false },
+  { "http_request_seconds", "Time to answer one HTTP request", true },
+  { "nvs_commit_seconds", "Time spent in nvs_commit()", true },
+};
+
+//tasks report their stack high-water mark, register each one once after creating it
+void metrics_register_task(TaskHandle_t task) {
+  if (task != NULL && task_count < METRICS_MAX_TASKS) tasks[task_count++] = task;
+}
+
+void metrics_snapshot(MetricsSnapshot *out) {
+  out->uptime_ms = millis();
+  out->cpu_mhz = getCpuFrequencyMhz();
+  for (int i = 0; i < METRIC_COUNTER_COUNT; i++) {
+    out->counters[i] = metrics_counters[i].load(std::memory_order_relaxed);
+  }
+  memcpy(out->hists, metrics_hists, sizeof(out->hists));
+  out->task_count = task_count;
+  for (int i = 0; i < task_count; i++) {
+    out->tasks[i].name = pcTaskGetName(tasks[i]);
+    out->tasks[i].stack_free = uxTaskGetStackHighWaterMark(tasks[i]);
+  }
+  out->heap_free = heap_caps_get_free_size(MALLOC_CAP_8BIT);
+  out->heap_min_free = heap_caps_get_minimum_free_size(MALLOC_CAP_8BIT);
+  out->heap_largest_block = heap_caps_get_largest_free_block(MALLOC_CAP_8BIT);
+  status_led_get_stats(&out->led);
+  power_get_report(out->uptime_ms, &out->power);
+}
+
+//PROMETHEUS -----------------------------------------------------------
+//renders the whole page a line at a time and keeps only the bytes from offset on, so a small buffer can send it in pieces
+struct Emitter {
+  char *out;
+  size_t len;
+  size_t offset;  //bytes of the page to skip
+  size_t pos;     //bytes of the page rendered so far
+  size_t n;       //bytes written to out
+};
+
+static void emit(Emitter *e, const char *fmt, ...) {
+  char line[128];
+  va_list args;
+  va_start(args, fmt);
+  int k = vsnprintf(line, sizeof(line), fmt, args);
+  va_end(args);
+  if (k < 0) return;
+  if ((size_t)k >= sizeof(line)) k = sizeof(line) - 1;
+  for (int i = 0; i < k; i++, e->pos++) {
+    if (e->pos >= e->offset && e->n < e->len) e->out[e->n++] = line[i];
+  }
+}
+
+static void emit_metric(Emitter *e, const char *name, const char *type, const char *help) {
+  emit(e, "# HELP hydration_%s %s\n", name, help);
+  emit(e, "# TYPE hydration_%s %s\n", name, type);
+}
+
+static void emit_hist(Emitter *e, const MetricsSnapshot *s, int i) {
+  const HistInfo *info = &hist_info[i];
+  const MetricHist *h = &s->hists[i];
+  double scale = info->cycles ? 1.0 / (s->cpu_mhz * 1e6) : 1.0;
+  emit_metric(e, info->name, "histogram", info->help);
+  uint32_t cumulative = 0;
+  for (int b = 0; b < METRICS_BUCKETS - 1; b++) {
+    cumulative += h->buckets[b];
+    //bucket b holds values up to 4^b - 1
+    uint32_t bound = (1UL << (2 * b)) - 1;
+    emit(e, "hydration_%s_bucket{le=\"%.6g\"} %lu\n", info->name, bound * scale, (unsigned long)cumulative);
+  }
+  emit(e, "hydration_%s_bucket{le=\"+Inf\"} %lu\n", info->name, (unsigned long)h->count);
+  emit(e, "hydration_%s_sum %.6g\n", info->name, h->sum * scale);
+  emit(e, "hydration_%s_count %lu\n", info->name, (unsigned long)h->count);
+}
+
+//copies up to len bytes of the page starting at offset into out, returns how many, 0 past the end
+size_t metrics_render(const MetricsSnapshot *s, char *out, size_t len, size_t offset) {
+  Emitter e = { out, len, offset, 0, 0 };
+
+  emit_metric(&e, "uptime_seconds", "gauge", "Time since boot");
+  emit(&e, "hydration_uptime_seconds %lu\n", (unsigned long)(s->uptime_ms / 1000));
+  for (int i = 0; i < METRIC_COUNTER_COUNT; i++) {
+    emit_metric(&e, counter_names[i], "counter", counter_help[i]);
+    emit(&e, "hydration_%s %lu\n", counter_names[i], (unsigned long)s->counters[i]);
+  }
+  for (int i = 0; i < METRIC_HISTOGRAM_COUNT; i++) emit_hist(&e, s, i);
+
+  emit_metric(&e, "task_stack_free_bytes", "gauge", "Smallest free stack a task has had");
+  for (int i = 0; i < s->task_count; i++) {
+    emit(&e, "hydration_task_stack_free_bytes{task=\"%s\"} %lu\n", s->tasks[i].name, (unsigned long)s->tasks[i].stack_free);
+  }
+  emit_metric(&e, "heap_free_bytes", "gauge", "Free heap");
+  emit(&e, "hydration_heap_free_bytes %lu\n", (unsigned long)s->heap_free);
+  emit_metric(&e, "heap_min_free_bytes", "gauge", "Lowest free heap since boot");
+  emit(&e, "hydration_heap_min_free_bytes %lu\n", (unsigned long)s->heap_min_free);
+  emit_metric(&e, "heap_largest_block_bytes", "gauge", "Largest allocatable block");
+  emit(&e, "hydration_heap_largest_block_bytes %lu\n", (unsigned long)s->heap_largest_block);
+
+  emit_metric(&e, "led_frames_total", "counter", "Frames pushed to the status LED");
+  emit(&e, "hydration_led_frames_total %lu\n", (unsigned long)s->led.frames);
+  emit_metric(&e, "led_skipped_frames_total", "counter", "Frames that matched the LED and were not pushed");
+  emit(&e, "hydration_led_skipped_frames_total %lu\n", (unsigned long)s->led.skipped);
+  emit_metric(&e, "led_show_seconds_total", "counter", "Time spent pushing frames to the LED");
+  emit(&e, "hydration_led_show_seconds_total %.6f\n", s->led.show_us / 1e6);
+
+  emit_metric(&e, "power_avg_milliamps", "gauge", "Estimated average current since boot");
+  emit(&e, "hydration_power_avg_milliamps %.3f\n", s->power.avg_ma);
+  emit_metric(&e, "power_slept_seconds_total", "counter", "Time spent in light sleep");
+  emit(&e, "hydration_power_slept_seconds_total %lu\n", (unsigned long)(s->power.slept_ms / 1000));
+  emit_metric(&e, "power_rail_duty_ratio", "gauge", "Share of time each rail was on at full level");
+  for (int i = 0; i < POWER_RAIL_COUNT; i++) {
+    emit(&e, "hydration_power_rail_duty_ratio{rail=\"%s\"} %.3f\n", power_rail_name((PowerRail)i),
+         s->power.rails[i].duty_permille / 1000.0f);
+  }
+  return e.n;
+}
+
+//SERIAL ---------------------------------------------------------------
+//upper bound of the bucket holding quantile q
+static uint32_t hist_quantile(const MetricHist *h, float q) {
+  if (h->count == 0) return 0;
+  uint32_t target = h->count * q, cumulative = 0;
+  for (int b = 0; b < METRICS_BUCKETS; b++) {
+    cumulative += h->buckets[b];
+    if (cumulative > target) return (1UL << (2 * b)) - 1;
+  }
+  return UINT32_MAX;
+}
+
+//a few lines, histograms as count and p50/p99 upper bounds (us for times)
+void metrics_dump_serial(const MetricsSnapshot *s) {
+  Serial.printf("metrics up=%lus heap=%lu min=%lu blk=%lu\n", (unsigned long)(s->uptime_ms / 1000),
+                (unsigned long)s->heap_free, (unsigned long)s->heap_min_free, (unsigned long)s->heap_largest_block);
+  for (int i = 0; i < METRIC_COUNTER_COUNT; i++) {
+    Serial.printf(" %s=%lu", counter_names[i], (unsigned long)s->counters[i]);
+  }
+  Serial.println();
+  for (int i = 0; i < METRIC_HISTOGRAM_COUNT; i++) {
+    const MetricHist *h = &s->hists[i];
+    uint32_t div = hist_info[i].cycles ? s->cpu_mhz : 1;
+    Serial.printf(" %s n=%lu p50<=%lu p99<=%lu\n", hist_info[i].name, (unsigned long)h->count,
+                  (unsigned long)(hist_quantile(h, 0.5f) / div), (unsigned long)(hist_quantile(h, 0.99f) / div));
+  }
+  Serial.print(" stack_free");
+  for (int i = 0; i < s->task_count; i++) {
+    Serial.printf(" %s=%lu", s->tasks[i].name, (unsigned long)s->tasks[i].stack_free);
+  }
+  Serial.println();
+}
+
+//dumps on 'm' from the serial port, and every METRICS_DUMP_MS while DEBUG is on
+void metrics_poll_serial(uint32_t now_ms) {
+  static uint32_t last_dump_ms = 0;
+  bool requested = false;
+  while (Serial.available() > 0) {
+    if (Serial.read() == 'm') requested = true;
+  }
+  if (!requested && !(DEBUG && now_ms - last_dump_ms >= METRICS_DUMP_MS)) return;
+  last_dump_ms = now_ms;
+  MetricsSnapshot s;
+  metrics_snapshot(&s);
+  metrics_dump_serial(&s);
+}
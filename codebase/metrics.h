@@ -0,0 +1,49 @@
+#ifndef METRICS_H
+#define METRICS_H
+
+#include <Arduino.h>
+#include <atomic>
+#include <esp_cpu.h>
+#include "config.h"
+
+//counters and latency histograms for field debugging, served as Prometheus text at /metrics
+
+extern std::atomic<uint32_t> metrics_counters[METRIC_COUNTER_COUNT];
+extern MetricHist metrics_hists[METRIC_HISTOGRAM_COUNT];
+
+//recording is inline so a counter is a single atomic add and a histogram sample a few adds
+
+static inline void metrics_count(MetricCounter counter, uint32_t n = 1) {
+  metrics_counters[counter].fetch_add(n, std::memory_order_relaxed);
+}
+
+static inline uint8_t metrics_bucket(uint32_t value) {
+  uint32_t bits = value ? 32 - __builtin_clz(value) : 0;
+  uint32_t bucket = (bits + 1) / 2;
+  return bucket < METRICS_BUCKETS ? bucket : METRICS_BUCKETS - 1;
+}
+
+//only the histogram's own writer task may call this
+static inline void metrics_record(MetricHistogram hist, uint32_t value) {
+  MetricHist *h = &metrics_hists[hist];
+  h->buckets[metrics_bucket(value)]++;
+  h->count++;
+  h->sum += value;
+}
+
+static inline uint32_t metrics_cycles() {
+  return esp_cpu_get_cycle_count();
+}
+
+//cycles since start, for the *_TIME histograms
+static inline void metrics_record_since(MetricHistogram hist, uint32_t start_cycles) {
+  metrics_record(hist, esp_cpu_get_cycle_count() - start_cycles);
+}
+
+void metrics_register_task(TaskHandle_t task);
+void metrics_snapshot(MetricsSnapshot *out);
+size_t metrics_render(const MetricsSnapshot *s, char *out, size_t len, size_t offset);
+void metrics_dump_serial(const MetricsSnapshot *s);
+void metrics_poll_serial(uint32_t now_ms);
+
+#endif // METRICS_H
@@ -0,0 +1,98 @@
+#include "pacing.h"
+#include <esp_timer.h>
+
+static const uint32_t meals_lut[PACING_LUT_POINTS] = PACING_MEALS_LUT;
+static const uint32_t custom_lut[PACING_LUT_POINTS] = PACING_CUSTOM_LUT;
+
+//microsecond timer since boot, doesn't wrap like millis() does after 49 days
+int64_t pacing_now_ms() {
+  return esp_timer_get_time() / 1000;
+}
+
+void pacing_start(Pacer *p, int64_t now_ms, int64_t length_ms, int32_t goal_mg, PacingCurve curve) {
+  p->start_ms = now_ms;
+  p->length_ms = length_ms;
+  p->goal_mg = goal_mg;
+  p->curve = curve;
+}
+
+int64_t pacing_end_ms(const Pacer *p) {
+  return p->start_ms + p->length_ms;
+}
+
+bool pacing_parse_curve(const char *name, PacingCurve *curve) {
+  if (strcmp(name, "linear") == 0) *curve = PACING_LINEAR;
+  else if (strcmp(name, "front") == 0) *curve = PACING_FRONT_LOADED;
+  else if (strcmp(name, "meals") == 0) *curve = PACING_MEALS;
+  else if (strcmp(name, "custom") == 0) *curve = PACING_CUSTOM;
+  else return false;
+  return true;
+}
+
+//piecewise linear between the 1/16 samples
+static uint32_t lut_curve(const uint32_t *lut, uint32_t u) {
+  uint32_t i = u >> 12;
+  if (i >= PACING_LUT_POINTS - 1) return lut[PACING_LUT_POINTS - 1];
+  uint32_t frac = u & 0xFFF;
+  return lut[i] + (((lut[i + 1] - lut[i]) * frac) >> 12);
+}
+
+//share of the goal that should be drunk by fraction u of the session, both Q16
+uint32_t pacing_curve(PacingCurve curve, uint32_t u) {
+  if (u >= PACING_ONE) return PACING_ONE;
+  switch (curve) {
+    case PACING_FRONT_LOADED:
+      //1 - (1 - u)^2
+      return (uint32_t)(((uint64_t)u * (2 * PACING_ONE - u)) >> 16);
+    case PACING_MEALS:
+      return lut_curve(meals_lut, u);
+    case PACING_CUSTOM:
+      return lut_curve(custom_lut, u);
+    case PACING_LINEAR:
+    default:
+      return u;
+  }
+}
+
+//the pacer: grams the user should still have left to drink at now_ms, never increases over time
+int32_t pacing_target_mg(const Pacer *p, int64_t now_ms) {
+  if (now_ms <= p->start_ms) return p->goal_mg;
+  int64_t t = now_ms - p->start_ms;
+  if (t >= p->length_ms) return 0;
+  uint32_t u = (uint32_t)((t << 16) / p->length_ms);
+  int64_t drunk = ((int64_t)p->goal_mg * pacing_curve(p->curve, u)) >> 16;
+  return p->goal_mg - (int32_t)drunk;
+}
+
+//earliest time the pacer is down to target_mg, the session end if it never gets there
+//binary search over the session, only run when the state can change
+int64_t pacing_time_for(const Pacer *p, int32_t target_mg) {
+  int64_t lo = p->start_ms, hi = pacing_end_ms(p);
+  if (target_mg < 0) return hi;
+  while (lo < hi) {
+    int64_t mid = lo + (hi - lo) / 2;
+    if (pacing_target_mg(p, mid) <= target_mg) hi = mid;
+    else lo = mid + 1;
+  }
+  return lo;
+}
+
+//same thresholds as before: behind by a fifth of the goal is critical, behind at all needs water
+HydrationState pacing_state(const Pacer *p, int32_t pacer_mg, int32_t left_mg) {
+  if (left_mg <= 0) return COMPLETED;
+  int32_t ahead = pacer_mg - left_mg;
+  if (ahead <= -p->goal_mg / 5) return CRITICAL;
+  if (ahead <= 0) return NEEDS_WATER;
+  return HYDRATED;
+}
+
+//when the state next changes if the user drinks nothing more, the pacer only falls so states only get worse
+int64_t pacing_next_transition(const Pacer *p, int32_t left_mg, int64_t now_ms) {
+  int64_t end = pacing_end_ms(p);
+  HydrationState state = pacing_state(p, pacing_target_mg(p, now_ms), left_mg);
+  int64_t next = end;
+  if (state == HYDRATED) next = pacing_time_for(p, left_mg);
+  else if (state == NEEDS_WATER) next = pacing_time_for(p, left_mg - p->goal_mg / 5);
+  if (next <= now_ms) next = now_ms + 1;
+  return (next < end) ? next : end;
+}
@@ -0,0 +1,20 @@
+#ifndef PACING_H
+#define PACING_H
+
+#include <Arduino.h>
+#include "config.h"
+
+//integer pacing engine, times are signed 64 bit milliseconds and amounts are milligrams
+//a session resumed after a reboot starts before the timer's zero, so start_ms can be negative
+
+int64_t pacing_now_ms();
+void pacing_start(Pacer *p, int64_t now_ms, int64_t length_ms, int32_t goal_mg, PacingCurve curve);
+uint32_t pacing_curve(PacingCurve curve, uint32_t u);
+int32_t pacing_target_mg(const Pacer *p, int64_t now_ms);
+int64_t pacing_time_for(const Pacer *p, int32_t target_mg);
+HydrationState pacing_state(const Pacer *p, int32_t pacer_mg, int32_t left_mg);
+int64_t pacing_next_transition(const Pacer *p, int32_t left_mg, int64_t now_ms);
+int64_t pacing_end_ms(const Pacer *p);
+bool pacing_parse_curve(const char *name, PacingCurve *curve);
+
+#endif // PACING_H
@@ -0,0 +1,172 @@
+#include "power.h"
+#include "hydration.h"
+#include "scale.h"
+#include "tracker.h"
+#include "web.h"
+#include "state.h"
+#include <esp_timer.h>
+#include <esp_sleep.h>
+#include <driver/gpio.h>
+#include <atomic>
+
+//ACCOUNTING -----------------------------------------------------------
+//each rail has a level out of 255, level x time is summed so duty and average current fall out at report time
+static portMUX_TYPE account_lock = portMUX_INITIALIZER_UNLOCKED;
+static uint8_t rail_level[POWER_RAIL_COUNT];
+static uint64_t rail_level_ms[POWER_RAIL_COUNT];
+static uint64_t total_ms = 0;
+static uint32_t last_ms = 0;
+static uint32_t sleeps = 0;
+static uint32_t slept_ms = 0;
+
+static const float rail_ma[POWER_RAIL_COUNT] = {
+  POWER_CPU_ACTIVE_MA, POWER_RADIO_MA, POWER_LED_MA, POWER_SPEAKER_MA, POWER_SCALE_MA * SCALE_CHANNELS
+};
+static const char *const rail_names[POWER_RAIL_COUNT] = { "cpu", "radio", "led", "speaker", "scale" };
+
+//brings every rail up to now_ms at its current level, caller holds account_lock
+static void accrue(uint32_t now_ms) {
+  uint32_t dt = now_ms - last_ms;
+  for (int i = 0; i < POWER_RAIL_COUNT; i++) {
+    rail_level_ms[i] += (uint64_t)rail_level[i] * dt;
+  }
+  total_ms += dt;
+  last_ms = now_ms;
+}
+
+//starts counting from now_ms, levels are kept
+void power_reset_accounting(uint32_t now_ms) {
+  portENTER_CRITICAL(&account_lock);
+  for (int i = 0; i < POWER_RAIL_COUNT; i++) rail_level_ms[i] = 0;
+  total_ms = 0;
+  last_ms = now_ms;
+  sleeps = 0;
+  slept_ms = 0;
+  portEXIT_CRITICAL(&account_lock);
+}
+
+void power_set_level(PowerRail rail, uint8_t level, uint32_t now_ms) {
+  portENTER_CRITICAL(&account_lock);
+  accrue(now_ms);
+  rail_level[rail] = level;
+  portEXIT_CRITICAL(&account_lock);
+}
+
+void power_record_sleep(uint32_t ms) {
+  portENTER_CRITICAL(&account_lock);
+  sleeps++;
+  slept_ms += ms;
+  portEXIT_CRITICAL(&account_lock);
+}
+
+const char *power_rail_name(PowerRail rail) {
+  return rail_names[rail];
+}
+
+void power_get_report(uint32_t now_ms, PowerReport *out) {
+  uint64_t level_ms[POWER_RAIL_COUNT];
+  uint64_t total;
+  portENTER_CRITICAL(&account_lock);
+  accrue(now_ms);
+  for (int i = 0; i < POWER_RAIL_COUNT; i++) level_ms[i] = rail_level_ms[i];
+  total = total_ms;
+  out->sleeps = sleeps;
+  out->slept_ms = slept_ms;
+  portEXIT_CRITICAL(&account_lock);
+
+  out->uptime_ms = total;
+  out->sleep_enabled = POWER_LIGHT_SLEEP;
+  out->avg_ma = 0;
+  for (int i = 0; i < POWER_RAIL_COUNT; i++) {
+    float duty = (total > 0) ? (float)level_ms[i] / (255.0f * total) : 0;
+    out->rails[i].duty_permille = duty * 1000 + 0.5f;
+    out->rails[i].avg_ma = duty * rail_ma[i];
+  }
+  //the CPU still draws a little while asleep
+  float cpu_duty = out->rails[POWER_RAIL_CPU].avg_ma / POWER_CPU_ACTIVE_MA;
+  out->rails[POWER_RAIL_CPU].avg_ma += (1 - cpu_duty) * POWER_CPU_SLEEP_MA;
+  for (int i = 0; i < POWER_RAIL_COUNT; i++) out->avg_ma += out->rails[i].avg_ma;
+  out->battery_hours = (out->avg_ma > 0) ? POWER_BATTERY_MAH / out->avg_ma : 0;
+}
+
+//SLEEP ----------------------------------------------------------------
+static std::atomic<uint32_t> holds(0);
+
+void power_init() {
+  uint32_t now = millis();
+  power_set_level(POWER_RAIL_CPU, 255, now);
+  power_set_level(POWER_RAIL_SCALE, 255, now);
+  power_reset_accounting(now);
+}
+
+//anything that needs the chip awake (radio, LEDC tone) holds off sleep while it runs
+void power_hold(uint32_t reason, bool held) {
+  if (held) holds.fetch_or(reason);
+  else holds.fetch_and(~reason);
+}
+
+//when light sleep has to end: the next esp_timer alarm (LED frames, speaker notes), the next pacing deadline or POWER_MAX_SLEEP_MS
+static int64_t wake_deadline_us(int64_t now_us) {
+  int64_t wake_us = now_us + (int64_t)POWER_MAX_SLEEP_MS * 1000;
+  int64_t alarm_us = esp_timer_get_next_alarm_for_wake_up();
+  if (alarm_us < wake_us) wake_us = alarm_us;
+  int64_t pacing_us = hydration_next_deadline_ms() * 1000;
+  if (pacing_us > now_us && pacing_us < wake_us) wake_us = pacing_us;
+  return wake_us;
+}
+
+//run by the lowest priority task, so everything else is blocked when it gets here
+//light sleeps until DOUT falls, the web button is pressed or the next deadline, returns ms to wait before the next try
+uint32_t power_idle() {
+  if (!POWER_LIGHT_SLEEP || holds.load() != 0) return POWER_RECHECK_MS;
+  //every channel has a conversion waiting or the button is held, sleeping would wake straight away
+  if (scale_all_ready() || digitalRead(BTN_PIN) == LOW) return 1;
+
+  int64_t now_us = esp_timer_get_time();
+  int64_t sleep_us = wake_deadline_us(now_us) - now_us;
+  if (sleep_us < (int64_t)POWER_MIN_SLEEP_MS * 1000) return 1;
+
+  if (DEBUG) Serial.flush();
+  esp_sleep_enable_timer_wakeup(sleep_us);
+  //level wakeups share the pin's interrupt type, the edge interrupts are put back after
+  //only channels still converting can wake us, a ready one holds DOUT low until the burst reads them all
+  bool waiting[SCALE_CHANNELS];
+  for (uint8_t ch = 0; ch < SCALE_CHANNELS; ch++) {
+    waiting[ch] = digitalRead(scale_data_pin(ch)) == HIGH;
+    if (waiting[ch]) gpio_wakeup_enable((gpio_num_t)scale_data_pin(ch), GPIO_INTR_LOW_LEVEL);
+  }
+  gpio_wakeup_enable((gpio_num_t)BTN_PIN, GPIO_INTR_LOW_LEVEL);
+  esp_sleep_enable_gpio_wakeup();
+  //a high SCK for over 60 us powers the HX711 down
+  gpio_hold_en((gpio_num_t)SCALE_CLK_PIN);
+
+  uint32_t before = millis();
+  power_set_level(POWER_RAIL_CPU, 0, before);
+  esp_light_sleep_start();
+  uint32_t after = millis();
+  power_set_level(POWER_RAIL_CPU, 255, after);
+  power_record_sleep(after - before);
+
+  gpio_hold_dis((gpio_num_t)SCALE_CLK_PIN);
+  for (uint8_t ch = 0; ch < SCALE_CHANNELS; ch++) {
+    if (!waiting[ch]) continue;
+    gpio_wakeup_disable((gpio_num_t)scale_data_pin(ch));
+    gpio_set_intr_type((gpio_num_t)scale_data_pin(ch), GPIO_INTR_NEGEDGE);
+  }
+  gpio_wakeup_disable((gpio_num_t)BTN_PIN);
+  gpio_set_intr_type((gpio_num_t)BTN_PIN, GPIO_INTR_NEGEDGE);
+
+  //the edge that woke us happened while asleep, so its interrupt never ran
+  if (esp_sleep_get_wakeup_cause() == ESP_SLEEP_WAKEUP_GPIO) {
+    if (scale_all_ready()) scale_notify_ready();
+    if (digitalRead(BTN_PIN) == LOW) {
+      set_web_request(true);
+      state_notify(EVT_WEB_BUTTON);
+    }
+  }
+  //a timer wake may be the pacing deadline, let the tracker look at it
+  else {
+    tracker_notify();
+  }
+  return 1;
+}
@@ -0,0 +1,20 @@
+#ifndef POWER_H
+#define POWER_H
+
+#include <Arduino.h>
+#include "config.h"
+
+//light sleep between HX711 conversions, and a running estimate of what each rail costs the battery
+
+void power_init();
+void power_hold(uint32_t reason, bool held);
+uint32_t power_idle();
+
+//accounting, takes the time so a host simulator can drive it with a virtual clock
+void power_reset_accounting(uint32_t now_ms);
+void power_set_level(PowerRail rail, uint8_t level, uint32_t now_ms);
+void power_record_sleep(uint32_t slept_ms);
+void power_get_report(uint32_t now_ms, PowerReport *out);
+const char *power_rail_name(PowerRail rail);
+
+#endif // POWER_H
@@ -5,32 +5,205 @@
 //     URL: https://github.com/RobTillaart/HX711
 
 
-#include "HX711.h"
+#include <atomic>
 #include "scale.h"
+#include "filters.h"
 #include "config.h"
+#include "metrics.h"
+#include "calibration.h"
 
-HX711 scale;
-float w1, w2, previous = 0;
+static const uint8_t data_pins[SCALE_CHANNELS] = SCALE_DATA_PINS;
+float previous = 0;
+
+//default driver, every HX711 shares SCK so one burst of clocks shifts a conversion out of all of them together
+static portMUX_TYPE clock_lock = portMUX_INITIALIZER_UNLOCKED;
+
+static bool hx711_is_ready() {
+  for (uint8_t ch = 0; ch < SCALE_CHANNELS; ch++) {
+    if (digitalRead(data_pins[ch]) == HIGH) return false;
+  }
+  return true;
+}
+
+static void hx711_read_raw(int32_t raw[SCALE_CHANNELS]) {
+  uint32_t bits[SCALE_CHANNELS] = {};
+  //SCK high for over 60 us powers the chips down, nothing may stretch a pulse
+  portENTER_CRITICAL(&clock_lock);
+  for (int i = 0; i < 24; i++) {
+    digitalWrite(SCALE_CLK_PIN, HIGH);
+    delayMicroseconds(1);
+    for (uint8_t ch = 0; ch < SCALE_CHANNELS; ch++) {
+      bits[ch] = (bits[ch] << 1) | (digitalRead(data_pins[ch]) == HIGH);
+    }
+    digitalWrite(SCALE_CLK_PIN, LOW);
+    delayMicroseconds(1);
+  }
+  //25th pulse keeps channel A at gain 128 for the next conversion
+  digitalWrite(SCALE_CLK_PIN, HIGH);
+  delayMicroseconds(1);
+  digitalWrite(SCALE_CLK_PIN, LOW);
+  portEXIT_CRITICAL(&clock_lock);
+  for (uint8_t ch = 0; ch < SCALE_CHANNELS; ch++) {
+    raw[ch] = (int32_t)(bits[ch] << 8) >> 8;  //24 bit two's complement
+  }
+}
+
+static const ScaleDriver hx711_driver = { hx711_is_ready, hx711_read_raw };
+static const ScaleDriver *driver = &hx711_driver;
+
+//everything the sampler keeps for one bottle pad
+struct ScaleChannel {
+  //single producer (sampler task) / single consumer ring of timestamped samples
+  ScaleSample ring[SCALE_RING_SIZE];
+  std::atomic<uint32_t> ring_head;  //next slot the sampler writes
+  std::atomic<uint32_t> ring_tail;  //next slot the consumer reads
+  //filter pipeline from config.h, only touched by the sampler
+  ScaleFilter filter;
+  //latest settled weight, NAN while the scale is moving
+  std::atomic<float> settled_grams;
+  ScaleChannelStats stats;
+};
+static ScaleChannel channels[SCALE_CHANNELS];
+static portMUX_TYPE stats_lock = portMUX_INITIALIZER_UNLOCKED;
+static float last_settled = 0;  //last weight that did settle, only used by the consumer
+
+static TaskHandle_t sampler_task = NULL;
+static volatile bool reading = false;  //DOUT toggles while clocking bits out, ignore those edges
+
+//any DOUT falling may complete the set, the sampler checks whether they are all ready
+void IRAM_ATTR scaleReadyISR() {
+  if (reading || sampler_task == NULL) return;
+  BaseType_t woken = pdFALSE;
+  vTaskNotifyGiveFromISR(sampler_task, &woken);
+  portYIELD_FROM_ISR(woken);
+}
 
 void scale_init()
 {
-  scale.begin(SCALE_DATA_PIN, SCALE_CLK_PIN);
-  scale.set_scale(SCALE_CALIBRATION_VAL);
-  scale.tare();
+  pinMode(SCALE_CLK_PIN, OUTPUT);
+  digitalWrite(SCALE_CLK_PIN, LOW);
+  //no blocking tare here, a stored calibration is used as is and the sampler tares when there is none
+  calibration_init();
+  for (uint8_t ch = 0; ch < SCALE_CHANNELS; ch++) {
+    pinMode(data_pins[ch], INPUT);
+    scale_filter_init(&channels[ch].filter);
+    channels[ch].settled_grams.store(NAN);
+    attachInterrupt(digitalPinToInterrupt(data_pins[ch]), scaleReadyISR, FALLING);
+  }
+}
+
+//swaps the sample source, passing NULL restores the HX711
+void scale_set_driver(const ScaleDriver *driver_param) {
+  driver = (driver_param == NULL) ? &hx711_driver : driver_param;
+}
+
+//task that gets woken by the data ready interrupt
+void scale_set_sampler_task(TaskHandle_t task) {
+  sampler_task = task;
+}
+
+//wakes the sampler as if DOUT had just fallen, for edges that happened while the chip slept
+void scale_notify_ready() {
+  if (sampler_task != NULL) xTaskNotifyGive(sampler_task);
+}
+
+uint8_t scale_data_pin(uint8_t channel) {
+  return data_pins[channel];
+}
+
+//true when one burst would read every channel
+bool scale_all_ready() {
+  return driver->is_ready();
+}
+
+//blocks the sampler until DOUT signals a conversion or the timeout passes, returns whether all channels are ready
+bool scale_wait_ready(TickType_t timeout) {
+  ulTaskNotifyTake(pdTRUE, timeout);
+  return driver->is_ready();
+}
+
+//runs one channel's conversion through calibration and the filters and pushes it into its ring
+static void scale_push(ScaleChannel *c, uint8_t ch, int32_t raw, uint32_t now_ms) {
+  //filtered weight only counts as settled once the stability detector agrees
+  float grams = calibration_apply(ch, raw, now_ms);
+  float filtered = scale_filter_update(&c->filter, now_ms, grams);
+  bool stable = scale_filter_stable(&c->filter);
+  calibration_track(ch, filtered, stable);
+  c->settled_grams.store(stable ? filtered : NAN);
+
+  uint32_t head = c->ring_head.load(std::memory_order_relaxed);
+  //ring full, drop the oldest sample so the sampler never waits on a consumer
+  if (head - c->ring_tail.load(std::memory_order_acquire) >= SCALE_RING_SIZE) {
+    c->ring_tail.fetch_add(1, std::memory_order_acq_rel);
+  }
+  ScaleSample *slot = &c->ring[head % SCALE_RING_SIZE];
+  slot->time_ms = now_ms;
+  slot->grams = grams;
+  slot->filtered = filtered;
+  slot->stable = stable;
+  c->ring_head.store(head + 1, std::memory_order_release);
+}
+
+//reads one conversion from every channel once they all have one ready, returns whether samples were taken
+bool scale_sample_poll(uint32_t now_ms) {
+  if (!driver->is_ready()) return false;
+
+  int32_t raw[SCALE_CHANNELS];
+  reading = true;
+  uint32_t start = metrics_cycles();
+  driver->read_raw(raw);
+  uint32_t read_cycles = metrics_cycles() - start;
+  metrics_record(METRIC_SCALE_READ_TIME, read_cycles);
+  metrics_count(METRIC_SCALE_READS, SCALE_CHANNELS);
+  reading = false;
+  //edges seen while clocking the bits out are not new conversions
+  ulTaskNotifyTake(pdTRUE, 0);
+
+  for (uint8_t ch = 0; ch < SCALE_CHANNELS; ch++) {
+    uint32_t ch_start = metrics_cycles();
+    scale_push(&channels[ch], ch, raw[ch], now_ms);
+    uint32_t cycles = metrics_cycles() - ch_start + read_cycles / SCALE_CHANNELS;
+    portENTER_CRITICAL(&stats_lock);
+    channels[ch].stats.samples++;
+    channels[ch].stats.cycles += cycles;
+    portEXIT_CRITICAL(&stats_lock);
+  }
+  return true;
+}
+
+//takes the oldest unread sample of a channel, returns false when its ring is empty
+bool scale_pop_sample(uint8_t channel, ScaleSample *sample) {
+  ScaleChannel *c = &channels[channel];
+  uint32_t tail = c->ring_tail.load(std::memory_order_acquire);
+  while (tail != c->ring_head.load(std::memory_order_acquire)) {
+    *sample = c->ring[tail % SCALE_RING_SIZE];
+    //the sampler may have dropped this slot while it was being copied
+    if (c->ring_tail.compare_exchange_weak(tail, tail + 1, std::memory_order_acq_rel)) {
+      return true;
+    }
+  }
+  return false;
+}
+
+void scale_get_channel_stats(uint8_t channel, ScaleChannelStats *out) {
+  portENTER_CRITICAL(&stats_lock);
+  *out = channels[channel].stats;
+  portEXIT_CRITICAL(&stats_lock);
+}
+
+//latest settled weight without waiting, returns false while the scale is still moving
+bool scale_get_settled_weight(uint8_t channel, float *grams) {
+  float w = channels[channel].settled_grams.load();
+  if (isnan(w)) return false;
+  *grams = w;
+  return true;
 }
 
 float scale_read_delta()
 {
-    // read until stable
-    float w1 = scale.get_units(10);
-    delay(100);
-    float w2 = scale.get_units();
-
-    while (fabs(w1 - w2) > 10)
-    {
-        w1 = w2;
-        w2 = scale.get_units();
-        delay(100);
+    float w1;
+    if (!scale_get_settled_weight(SCALE_SESSION_CHANNEL, &w1)) {
+        return 0;   // still moving, nothing to report yet
     }
 
     // If the scale is basically empty, don't report delta
@@ -47,19 +220,12 @@ float scale_read_delta()
 
 float scale_read_weight()
 {
-    float w1 = scale.get_units(10);
-    delay(100);
-    float w2 = scale.get_units();
-
-    while (fabs(w1 - w2) > 10)
-    {
-        w1 = w2;
-        w2 = scale.get_units();
-        delay(100);
+    float w;
+    // while the bottle is moving keep reporting the last weight that settled
+    if (scale_get_settled_weight(SCALE_SESSION_CHANNEL, &w)) {
+        last_settled = w;
     }
-
-    return w2;
+    return last_settled;
 }
 
 //  -- END OF FILE --
-
@@ -1,6 +1,25 @@
 #ifndef SCALE_H
 #define SCALE_H
+#include <Arduino.h>
+#include "config.h"
+
+// hardware seam for the sampler so a simulated HX711 can stand in for the real ones
+struct ScaleDriver {
+  bool (*is_ready)();                           // true when every channel has a conversion waiting (DOUT low)
+  void (*read_raw)(int32_t raw[SCALE_CHANNELS]); // reads one conversion per channel as raw counts, calibration.cpp turns them into grams
+};
+
 void scale_init();
+void scale_set_driver(const ScaleDriver *driver);
+void scale_set_sampler_task(TaskHandle_t task);
+void scale_notify_ready();
+uint8_t scale_data_pin(uint8_t channel);
+bool scale_all_ready();
+bool scale_wait_ready(TickType_t timeout);
+bool scale_sample_poll(uint32_t now_ms);
+bool scale_pop_sample(uint8_t channel, ScaleSample *sample);
+bool scale_get_settled_weight(uint8_t channel, float *grams);
+void scale_get_channel_stats(uint8_t channel, ScaleChannelStats *out);
 float scale_read_delta();
 float scale_read_weight();
 #endif
@@ -0,0 +1,198 @@
+#include "series.h"
+#include "journal.h"
+#include "entry_codec.h"
+
+#define SERIES_CODEC_VERSION 1
+
+//the running session, written by the scale task and copied out by the web task
+static SeriesData live;
+static bool live_active = false;
+static uint32_t live_start_ms = 0;
+static portMUX_TYPE live_lock = portMUX_INITIALIZER_UNLOCKED;
+
+static uint16_t series_ml(float grams) {
+  uint32_t ml = entry_quantise_ml(grams);
+  return (ml > 0xFFFF) ? 0xFFFF : ml;
+}
+
+static void bucket_merge(SeriesBucket *into, const SeriesBucket *b) {
+  if (b->intake_min < into->intake_min) into->intake_min = b->intake_min;
+  if (b->intake_max > into->intake_max) into->intake_max = b->intake_max;
+  if (b->pacer_min < into->pacer_min) into->pacer_min = b->pacer_min;
+  if (b->pacer_max > into->pacer_max) into->pacer_max = b->pacer_max;
+}
+
+//merges neighbouring buckets pairwise, the resolution halves and the bucket edges stay aligned
+static void series_halve(SeriesData *s) {
+  uint16_t n = 0;
+  for (uint16_t i = 0; i < s->count; i += 2, n++) {
+    s->buckets[n] = s->buckets[i];
+    if (i + 1 < s->count) bucket_merge(&s->buckets[n], &s->buckets[i + 1]);
+  }
+  s->count = n;
+  s->bucket_ms *= 2;
+}
+
+//adds one reading of the running session, the first call after series_end starts a new one
+void series_record(uint32_t now_ms, float intake_grams, float pacer_grams) {
+  SeriesBucket b;
+  b.intake_min = b.intake_max = series_ml(intake_grams);
+  b.pacer_min = b.pacer_max = series_ml(pacer_grams);
+
+  portENTER_CRITICAL(&live_lock);
+  if (!live_active) {
+    live.session = 0;
+    live.bucket_ms = SERIES_BASE_BUCKET_MS;
+    live.count = 0;
+    live_start_ms = now_ms;
+    live_active = true;
+  }
+
+  uint32_t index = (now_ms - live_start_ms) / live.bucket_ms;
+  while (index >= SERIES_MAX_BUCKETS) {
+    series_halve(&live);
+    index = (now_ms - live_start_ms) / live.bucket_ms;
+  }
+  if (index < live.count) {
+    bucket_merge(&live.buckets[index], &b);
+  }
+  else {
+    //buckets the scale task skipped over just hold this reading
+    while (live.count <= index) live.buckets[live.count++] = b;
+  }
+  portEXIT_CRITICAL(&live_lock);
+}
+
+//CODEC ----------------------------------------------------------------
+//version byte, session, bucket_ms and count, then per bucket the zigzag change in
+//intake_max and pacer_min from the bucket before and each bucket's spread
+//returns 0 if it doesn't fit in len
+static size_t series_encode(const SeriesData *s, uint8_t *out, size_t len) {
+  //worst case for the fixed part and one bucket
+  const size_t header_max = 1 + 3 * 5;
+  const size_t bucket_max = 4 * 5;
+  if (len < header_max) return 0;
+
+  size_t n = 0;
+  out[n++] = SERIES_CODEC_VERSION;
+  n += varint_put(out + n, s->session);
+  n += varint_put(out + n, s->bucket_ms);
+  n += varint_put(out + n, s->count);
+
+  uint16_t prev_intake = 0, prev_pacer = 0;
+  for (uint16_t i = 0; i < s->count; i++) {
+    if (n + bucket_max > len) return 0;
+    const SeriesBucket *b = &s->buckets[i];
+    n += varint_put(out + n, zigzag_encode((int32_t)b->intake_max - prev_intake));
+    n += varint_put(out + n, b->intake_max - b->intake_min);
+    n += varint_put(out + n, zigzag_encode((int32_t)b->pacer_min - prev_pacer));
+    n += varint_put(out + n, b->pacer_max - b->pacer_min);
+    prev_intake = b->intake_max;
+    prev_pacer = b->pacer_min;
+  }
+  return n;
+}
+
+//unpacks a JREC_SERIES payload, false if it is malformed or from an unknown version
+bool series_decode(const uint8_t *in, size_t len, SeriesData *s) {
+  if (len < 1 || in[0] != SERIES_CODEC_VERSION) return false;
+  size_t n = 1, used;
+  uint32_t v[4];
+  for (int i = 0; i < 3; i++) {
+    if ((used = varint_get(in + n, len - n, &v[i])) == 0) return false;
+    n += used;
+  }
+  if (v[2] > SERIES_MAX_BUCKETS || v[1] == 0) return false;
+  s->session = v[0];
+  s->bucket_ms = v[1];
+  s->count = v[2];
+
+  uint16_t prev_intake = 0, prev_pacer = 0;
+  for (uint16_t i = 0; i < s->count; i++) {
+    for (int j = 0; j < 4; j++) {
+      if ((used = varint_get(in + n, len - n, &v[j])) == 0) return false;
+      n += used;
+    }
+    SeriesBucket *b = &s->buckets[i];
+    b->intake_max = prev_intake + zigzag_decode(v[0]);
+    b->intake_min = b->intake_max - v[1];
+    b->pacer_min = prev_pacer + zigzag_decode(v[2]);
+    b->pacer_max = b->pacer_min + v[3];
+    prev_intake = b->intake_max;
+    prev_pacer = b->pacer_min;
+  }
+  return true;
+}
+
+//PERSISTENCE ----------------------------------------------------------
+//journals the running session's curve under its session id and clears it
+void series_end(uint32_t session) {
+  static SeriesData copy;
+  static uint8_t packed[JOURNAL_MAX_RECORD];
+
+  portENTER_CRITICAL(&live_lock);
+  bool active = live_active;
+  copy = live;
+  live_active = false;
+  portEXIT_CRITICAL(&live_lock);
+  if (!active || session == 0) return;
+
+  //a very jumpy session can outgrow one record, drop resolution until it fits
+  copy.session = session;
+  size_t n;
+  while ((n = series_encode(&copy, packed, sizeof(packed))) == 0 && copy.count > 1) {
+    series_halve(&copy);
+  }
+  if (n > 0) journal_append(JREC_SERIES, packed, n);
+}
+
+//copies the running session, false if none is running
+bool series_get_live(SeriesData *out) {
+  portENTER_CRITICAL(&live_lock);
+  bool active = live_active;
+  if (active) *out = live;
+  portEXIT_CRITICAL(&live_lock);
+  return active;
+}
+
+struct SeriesSearch {
+  uint32_t session;
+  SeriesData *out;
+  bool found;
+};
+
+static bool series_find_record(uint8_t type, uint32_t id, const uint8_t *data, uint16_t len, void *ctx) {
+  SeriesSearch *search = (SeriesSearch *)ctx;
+  if (type != JREC_SERIES || id <= search->session) return true;
+  //the series follows its session, decode the first one and check it belongs to it
+  search->found = series_decode(data, len, search->out) && search->out->session == search->session;
+  return false;
+}
+
+//reads a finished session's curve back from the journal
+bool series_load(uint32_t session, SeriesData *out) {
+  SeriesSearch search = { session, out, false };
+  journal_iterate_from(session, series_find_record, &search);
+  return search.found;
+}
+
+//QUERIES --------------------------------------------------------------
+//merges the buckets between from_ms and to_ms into at most points ranges, returns how many were written
+uint16_t series_query(const SeriesData *data, uint32_t from_ms, uint32_t to_ms, uint16_t points, SeriesPoint *out) {
+  if (points == 0 || data->count == 0) return 0;
+  uint32_t first = from_ms / data->bucket_ms;
+  uint32_t last = (to_ms == UINT32_MAX) ? data->count : to_ms / data->bucket_ms + (to_ms % data->bucket_ms != 0);
+  if (last > data->count) last = data->count;
+  if (first >= last) return 0;
+
+  uint32_t group = (last - first + points - 1) / points;
+  uint16_t n = 0;
+  for (uint32_t i = first; i < last; i += group, n++) {
+    out[n].time_ms = i * data->bucket_ms;
+    out[n].value = data->buckets[i];
+    for (uint32_t j = i + 1; j < i + group && j < last; j++) {
+      bucket_merge(&out[n].value, &data->buckets[j]);
+    }
+  }
+  return n;
+}
@@ -0,0 +1,15 @@
+#ifndef SERIES_H
+#define SERIES_H
+
+#include <Arduino.h>
+#include "config.h"
+
+//per session intake and pacer curve, bounded by SERIES_MAX_BUCKETS however long the session runs
+void series_record(uint32_t now_ms, float intake_grams, float pacer_grams);
+void series_end(uint32_t session);
+bool series_get_live(SeriesData *out);
+bool series_load(uint32_t session, SeriesData *out);
+uint16_t series_query(const SeriesData *data, uint32_t from_ms, uint32_t to_ms, uint16_t points, SeriesPoint *out);
+bool series_decode(const uint8_t *in, size_t len, SeriesData *s);
+
+#endif // SERIES_H
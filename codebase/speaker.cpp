@@ -1,30 +1,301 @@
 #include "speaker.h"
+#include "storage.h"
+#include "stats.h"
+#include "power.h"
+#include <esp_timer.h>
+#include <atomic>
 
-static unsigned long last_alert_time = 0;
-static bool alert_enabled = false;
+//PATTERNS -------------------------------------------------------------
+#define F ALERT_FREQUENCY
+static const ToneStep alert_gentle[] = { {F, 120}, {0, 80}, {F, 120} };
+static const ToneStep alert_firm[] = { {F, 150}, {0, 60}, {F * 5 / 4, 150}, {0, 60}, {F * 3 / 2, 250} };
+static const ToneStep alert_urgent[] = {
+  {F * 2, 100}, {0, 60}, {F * 2, 100}, {0, 60}, {F * 2, 100}, {0, 60}, {F * 2, 100}, {0, 60}, {F * 2, 100}
+};
+static const ToneStep done_chime[] = { {F, 100}, {F * 5 / 4, 100}, {F * 3 / 2, 100}, {F * 2, 250} };
+#undef F
 
+//escalation levels, each one is played SPEAKER_ESCALATE_AFTER times before moving to the next
+static const TonePattern alert_levels[] = {
+  { alert_gentle, sizeof(alert_gentle) / sizeof(ToneStep) },
+  { alert_firm, sizeof(alert_firm) / sizeof(ToneStep) },
+  { alert_urgent, sizeof(alert_urgent) / sizeof(ToneStep) },
+};
+static const uint8_t alert_level_count = sizeof(alert_levels) / sizeof(TonePattern);
+static const TonePattern done_pattern = { done_chime, sizeof(done_chime) / sizeof(ToneStep) };
+
+//LEDC BACKEND ---------------------------------------------------------
+static bool ledc_attached = false;
+
+static void ledc_tone(uint16_t freq_hz) {
+  //LEDC stops in light sleep
+  power_hold(POWER_HOLD_SPEAKER, true);
+  power_set_level(POWER_RAIL_SPEAKER, 255, millis());
+  if (!ledc_attached) ledc_attached = ledcAttach(SPEAKER_PIN, freq_hz, 8);  // pin, frequency, 8-bit resolution
+  else ledcChangeFrequency(SPEAKER_PIN, freq_hz, 8);
+  ledcWrite(SPEAKER_PIN, SPEAKER_DUTY);
+}
+
+static void ledc_silence() {
+  if (ledc_attached) {
+    ledcWrite(SPEAKER_PIN, 0);
+    ledcDetach(SPEAKER_PIN);
+    ledc_attached = false;
+  }
+  digitalWrite(SPEAKER_PIN, LOW);
+  power_set_level(POWER_RAIL_SPEAKER, 0, millis());
+  power_hold(POWER_HOLD_SPEAKER, false);
+}
+
+static const SpeakerBackend ledc_backend = { ledc_tone, ledc_silence };
+static const SpeakerBackend *backend = &ledc_backend;
+
+//REQUESTS -------------------------------------------------------------
+//other tasks only leave requests here, speaker_tick() is the one place that acts on them
+static portMUX_TYPE request_lock = portMUX_INITIALIZER_UNLOCKED;
+static const TonePattern *queue[SPEAKER_QUEUE_LEN];
+static uint8_t queue_head = 0, queue_count = 0;
+static bool alert_requested = false;
+static bool stop_requested = false;
+static uint32_t snooze_requested_ms = 0;
+static int16_t quiet_start_min = SPEAKER_QUIET_START_MIN;
+static int16_t quiet_end_min = SPEAKER_QUIET_END_MIN;
+
+static esp_timer_handle_t timer = NULL;
+static std::atomic<bool> kick_pending(false);
+
+//SEQUENCER STATE, only touched by speaker_tick() ----------------------
+static const TonePattern *playing = NULL;
+static uint8_t step = 0;
+static uint32_t step_end_ms = 0;
+static bool alerting = false;
+static uint8_t alert_level = 0;
+static uint8_t alerts_at_level = 0;
+static uint32_t next_alert_ms = 0;
+static bool snoozed = false;
+static uint32_t snooze_until_ms = 0;
+
+//wraparound safe a >= b for millis() values
+static bool time_reached(uint32_t now, uint32_t t) {
+  return (int32_t)(now - t) >= 0;
+}
+
+static bool queue_push(const TonePattern *pattern) {
+  if (queue_count == SPEAKER_QUEUE_LEN) return false;
+  queue[(queue_head + queue_count) % SPEAKER_QUEUE_LEN] = pattern;
+  queue_count++;
+  return true;
+}
+
+static const TonePattern *queue_pop() {
+  if (queue_count == 0) return NULL;
+  const TonePattern *pattern = queue[queue_head];
+  queue_head = (queue_head + 1) % SPEAKER_QUEUE_LEN;
+  queue_count--;
+  return pattern;
+}
+
+static bool in_quiet_hours(int16_t start, int16_t end) {
+  if (start == end) return false;
+  int16_t minute = stats_local_minute(storage_get_tz());
+  if (minute < 0) return false;
+  if (start < end) return minute >= start && minute < end;
+  return minute >= start || minute < end;  //wraps past midnight
+}
+
+static bool is_alert(const TonePattern *pattern) {
+  return pattern >= alert_levels && pattern < alert_levels + alert_level_count;
+}
+
+//the user caught up, cut the alert that is playing and drop the queued ones, other patterns carry on
+static void cancel_alerts() {
+  portENTER_CRITICAL(&request_lock);
+  uint8_t kept = 0;
+  for (uint8_t i = 0; i < queue_count; i++) {
+    const TonePattern *pattern = queue[(queue_head + i) % SPEAKER_QUEUE_LEN];
+    if (!is_alert(pattern)) queue[(queue_head + kept++) % SPEAKER_QUEUE_LEN] = pattern;
+  }
+  queue_count = kept;
+  portEXIT_CRITICAL(&request_lock);
+  if (playing && is_alert(playing)) {
+    playing = NULL;
+    backend->silence();
+  }
+}
+
+static void start_step(uint32_t now_ms) {
+  const ToneStep *s = &playing->steps[step];
+  if (s->freq_hz) backend->tone(s->freq_hz);
+  else backend->silence();
+  step_end_ms = now_ms + s->ms;
+}
+
+//queues the next alert once it's due, unless snoozed or in quiet hours, and escalates ignored alerts
+static void schedule_alert(uint32_t now_ms, int16_t quiet_start, int16_t quiet_end) {
+  if (!alerting || !time_reached(now_ms, next_alert_ms)) return;
+  if (snoozed) {
+    if (!time_reached(now_ms, snooze_until_ms)) {
+      next_alert_ms = snooze_until_ms;
+      return;
+    }
+    snoozed = false;
+  }
+  if (in_quiet_hours(quiet_start, quiet_end)) {
+    next_alert_ms = now_ms + SPEAKER_QUIET_RECHECK_MS;
+    return;
+  }
+
+  portENTER_CRITICAL(&request_lock);
+  queue_push(&alert_levels[alert_level]);
+  portEXIT_CRITICAL(&request_lock);
+  next_alert_ms = now_ms + (ALERT_INTERVAL >> alert_level);
+  if (++alerts_at_level >= SPEAKER_ESCALATE_AFTER && alert_level + 1 < alert_level_count) {
+    alert_level++;
+    alerts_at_level = 0;
+  }
+}
+
+//runs the sequencer at now_ms, returns the ms until it needs to run again, 0 when there's nothing left to do
+//the esp_timer callback is the only caller on the device, host tests call it with a virtual clock
+uint32_t speaker_tick(uint32_t now_ms) {
+  portENTER_CRITICAL(&request_lock);
+  bool want_alert = alert_requested;
+  bool stop = stop_requested;
+  uint32_t snooze_ms = snooze_requested_ms;
+  int16_t quiet_start = quiet_start_min, quiet_end = quiet_end_min;
+  stop_requested = false;
+  snooze_requested_ms = 0;
+  if (stop) queue_count = 0;
+  portEXIT_CRITICAL(&request_lock);
+
+  if (stop && playing) {
+    playing = NULL;
+    backend->silence();
+  }
+  if (snooze_ms) {
+    snoozed = true;
+    snooze_until_ms = now_ms + snooze_ms;
+  }
+  //a fresh critical spell starts gentle and right away
+  if (want_alert && !alerting) {
+    alert_level = 0;
+    alerts_at_level = 0;
+    next_alert_ms = now_ms;
+  }
+  if (!want_alert && alerting) cancel_alerts();
+  alerting = want_alert;
+  schedule_alert(now_ms, quiet_start, quiet_end);
+
+  //advance through every step that is due, then start the next queued pattern
+  while (true) {
+    if (!playing) {
+      portENTER_CRITICAL(&request_lock);
+      playing = queue_pop();
+      portEXIT_CRITICAL(&request_lock);
+      if (!playing) break;
+      step = 0;
+      start_step(now_ms);
+      continue;
+    }
+    if (!time_reached(now_ms, step_end_ms)) break;
+    if (++step < playing->count) {
+      start_step(now_ms);
+    }
+    else {
+      playing = NULL;
+      backend->silence();
+    }
+  }
+
+  //sleep until the current note ends or the next alert is due
+  uint32_t wait = 0;
+  if (playing) wait = step_end_ms - now_ms;
+  if (alerting) {
+    uint32_t alert_wait = time_reached(now_ms, next_alert_ms) ? 1 : next_alert_ms - now_ms;
+    if (wait == 0 || alert_wait < wait) wait = alert_wait;
+  }
+  return wait;
+}
+
+//TIMER ----------------------------------------------------------------
+static void speaker_timer_cb(void *arg) {
+  uint32_t wait;
+  //a request that arrived while this was running would otherwise wait for the current deadline
+  do {
+    kick_pending.store(false);
+    wait = speaker_tick(millis());
+  } while (kick_pending.load());
+  if (wait) esp_timer_start_once(timer, (uint64_t)wait * 1000);
+}
+
+//runs the sequencer as soon as possible on the timer task
+static void speaker_kick() {
+  kick_pending.store(true);
+  if (!timer) return;
+  //restart only takes an armed timer and start_once only an idle one, the callback can re-arm in between
+  while (esp_timer_restart(timer, 0) != ESP_OK && esp_timer_start_once(timer, 0) != ESP_OK) {
+  }
+}
+
+//PUBLIC ---------------------------------------------------------------
 void speaker_init() {
   pinMode(SPEAKER_PIN, OUTPUT);
   digitalWrite(SPEAKER_PIN, LOW);
-  last_alert_time = 0;
+  esp_timer_create_args_t args = {};
+  args.callback = speaker_timer_cb;
+  args.dispatch_method = ESP_TIMER_TASK;
+  args.name = "speaker";
+  esp_timer_create(&args, &timer);
 }
 
-void speaker_alert() {  
-    // Generate tone using PWM
-    ledcAttach(SPEAKER_PIN, ALERT_FREQUENCY, 8);  // pin, frequency, 8-bit resolution
-    ledcWrite(SPEAKER_PIN, 128);  // 50% duty cycle
-    
-    delay(ALERT_DURATION);
-    
-    // Stop tone
-    ledcWrite(SPEAKER_PIN, 0);
-    ledcDetach(SPEAKER_PIN);
-    
-    last_alert_time = millis();
+void speaker_set_backend(const SpeakerBackend *b) {
+  backend = b ? b : &ledc_backend;
+}
+
+//queues a pattern behind whatever is playing, false if the queue is full
+bool speaker_play(const TonePattern *pattern) {
+  portENTER_CRITICAL(&request_lock);
+  bool queued = queue_push(pattern);
+  portEXIT_CRITICAL(&request_lock);
+  if (queued) speaker_kick();
+  return queued;
+}
+
+//short rising chime for reaching the goal
+void speaker_play_done() {
+  speaker_play(&done_pattern);
+}
+
+//alerts repeat and escalate for as long as this is on
+void speaker_set_alerting(bool on) {
+  portENTER_CRITICAL(&request_lock);
+  bool changed = alert_requested != on;
+  alert_requested = on;
+  portEXIT_CRITICAL(&request_lock);
+  if (changed) speaker_kick();
 }
 
+//holds alerts back for ms, patterns that are already queued still play
+void speaker_snooze(uint32_t ms) {
+  portENTER_CRITICAL(&request_lock);
+  snooze_requested_ms = ms ? ms : 1;
+  portEXIT_CRITICAL(&request_lock);
+  speaker_kick();
+}
+
+//local minutes of the day, alerts are held back from start to end, start == end turns quiet hours off
+void speaker_set_quiet_hours(int16_t start_min, int16_t end_min) {
+  portENTER_CRITICAL(&request_lock);
+  quiet_start_min = start_min;
+  quiet_end_min = end_min;
+  portEXIT_CRITICAL(&request_lock);
+  speaker_kick();
+}
+
+//cuts the current pattern and drops anything queued
 void speaker_stop() {
-  ledcWrite(SPEAKER_PIN, 0);
-  ledcDetach(SPEAKER_PIN);
-  digitalWrite(SPEAKER_PIN, LOW);
-}
\ No newline at end of file
+  portENTER_CRITICAL(&request_lock);
+  stop_requested = true;
+  portEXIT_CRITICAL(&request_lock);
+  speaker_kick();
+}
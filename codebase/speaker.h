@@ -4,12 +4,16 @@
 #include <Arduino.h>
 #include "config.h"
 
+//non-blocking tone sequencer, patterns play from a queue off an esp_timer so no task ever waits on a note
 
-// Function prototypes
 void speaker_init();
-void speaker_alert();
+void speaker_set_backend(const SpeakerBackend *backend);
+bool speaker_play(const TonePattern *pattern);
+void speaker_play_done();
+void speaker_set_alerting(bool alerting);
+void speaker_snooze(uint32_t ms);
+void speaker_set_quiet_hours(int16_t start_min, int16_t end_min);
 void speaker_stop();
-bool speaker_should_alert();
-void speaker_task_handler();
+uint32_t speaker_tick(uint32_t now_ms);
 
-#endif // SPEAKER_H
\ No newline at end of file
+#endif // SPEAKER_H
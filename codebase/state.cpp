@@ -3,9 +3,57 @@
 //holds the state of the system, which can either be waiting for the user input or currently tracking hydration
 SystemState current_state = STATE_WAITING_USER_INPUT;
 
+//tasks to wake and the EVT_ bits each one cares about
+struct Subscriber {
+  TaskHandle_t task;
+  uint32_t events;
+};
+static Subscriber subscribers[STATE_MAX_SUBSCRIBERS];
+static int subscriber_count = 0;
+static portMUX_TYPE subscriber_lock = portMUX_INITIALIZER_UNLOCKED;
+
 SystemState get_state() {
   return current_state;
 }
 void set_state(SystemState state_param) {
+  if (state_param == current_state) return;
   current_state = state_param;
-}
\ No newline at end of file
+  state_notify(state_param == STATE_RUNNING ? EVT_SESSION_START : EVT_SESSION_END);
+}
+
+//registers the calling task to be woken by the given EVT_ bits
+void state_subscribe(uint32_t events) {
+  portENTER_CRITICAL(&subscriber_lock);
+  if (subscriber_count < STATE_MAX_SUBSCRIBERS) {
+    subscribers[subscriber_count].task = xTaskGetCurrentTaskHandle();
+    subscribers[subscriber_count].events = events;
+    subscriber_count++;
+  }
+  portEXIT_CRITICAL(&subscriber_lock);
+}
+
+//wakes every subscribed task that cares about any of the given bits, bits stay latched until the task waits
+void state_notify(uint32_t events) {
+  for (int i = 0; i < subscriber_count; i++) {
+    if (subscribers[i].events & events) {
+      xTaskNotify(subscribers[i].task, subscribers[i].events & events, eSetBits);
+    }
+  }
+}
+
+void state_notify_from_isr(uint32_t events) {
+  BaseType_t woken = pdFALSE;
+  for (int i = 0; i < subscriber_count; i++) {
+    if (subscribers[i].events & events) {
+      xTaskNotifyFromISR(subscribers[i].task, subscribers[i].events & events, eSetBits, &woken);
+    }
+  }
+  portYIELD_FROM_ISR(woken);
+}
+
+//blocks the calling task until one of its events fires or the timeout passes, returns the bits that fired (0 on timeout)
+uint32_t state_wait(TickType_t timeout) {
+  uint32_t events = 0;
+  xTaskNotifyWait(0, 0xFFFFFFFF, &events, timeout);
+  return events;
+}
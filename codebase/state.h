@@ -8,4 +8,9 @@ SystemState get_state();
 void set_state(SystemState state);
 extern SystemState current_state;
 
-#endif 
\ No newline at end of file
+void state_subscribe(uint32_t events);
+void state_notify(uint32_t events);
+void state_notify_from_isr(uint32_t events);
+uint32_t state_wait(TickType_t timeout);
+
+#endif 
@@ -0,0 +1,81 @@
+#include "stats.h"
+#include <time.h>
+#include <sys/time.h>
+
+//anything before this means the clock was never set since boot
+#define STATS_CLOCK_MIN 1600000000
+
+void stats_init(StatsRollup *stats) {
+  memset(stats, 0, sizeof(*stats));
+  stats->last_goal_day = -1;
+}
+
+//1970-01-01 was a Thursday, shifting by 3 makes weeks start on Monday
+static int32_t stats_week(int32_t day) {
+  return (day + 3) / 7;
+}
+
+//moves the day and week windows forward so day_ml[0] is day, older buckets shift out
+void stats_roll_to(StatsRollup *stats, int32_t day) {
+  if (day <= stats->last_day) return;
+
+  int32_t days = day - stats->last_day;
+  for (int i = STATS_DAYS - 1; i >= 0; i--) {
+    stats->day_ml[i] = (i >= days) ? stats->day_ml[i - days] : 0;
+  }
+  int32_t weeks = stats_week(day) - stats_week(stats->last_day);
+  for (int i = STATS_WEEKS - 1; i >= 0; i--) {
+    stats->week_ml[i] = (i >= weeks) ? stats->week_ml[i - weeks] : 0;
+  }
+  stats->last_day = day;
+}
+
+//folds one finished session into the rollups, day is the local day it ended on
+void stats_add_session(StatsRollup *stats, int32_t day, const Entry *entry) {
+  //a session from before the newest day (clock went backwards) still counts, in today's bucket
+  stats_roll_to(stats, day);
+  day = stats->last_day;
+
+  stats->day_ml[0] += entry->grams_drank;
+  stats->week_ml[0] += entry->grams_drank;
+  stats->sessions++;
+  stats->total_ml += entry->grams_drank;
+  stats->total_s += entry->duration;
+
+  if (entry->goal > 0 && entry->grams_drank >= entry->goal) {
+    stats->goals_hit++;
+    if (day != stats->last_goal_day) {
+      stats->streak = (day == stats->last_goal_day + 1) ? stats->streak + 1 : 1;
+      stats->last_goal_day = day;
+      if (stats->streak > stats->longest_streak) stats->longest_streak = stats->streak;
+    }
+  }
+}
+
+//the streak only survives while today or yesterday had a goal met
+uint16_t stats_current_streak(const StatsRollup *stats, int32_t today) {
+  if (stats->last_goal_day < 0 || today > stats->last_goal_day + 1) return 0;
+  return stats->streak;
+}
+
+//CLOCK ----------------------------------------------------------------
+//there is no RTC or network time, the dashboard hands over the phone's clock with each new goal
+void stats_set_clock(uint32_t unix_s) {
+  struct timeval tv = { (time_t)unix_s, 0 };
+  settimeofday(&tv, NULL);
+}
+
+bool stats_clock_valid() {
+  return time(NULL) >= STATS_CLOCK_MIN;
+}
+
+//days since 1970 in local time, only meaningful while stats_clock_valid()
+int32_t stats_local_day(int16_t tz_min) {
+  return (int32_t)((time(NULL) + (int32_t)tz_min * 60) / 86400);
+}
+
+//minute of the local day, -1 until a phone set the clock
+int16_t stats_local_minute(int16_t tz_min) {
+  if (!stats_clock_valid()) return -1;
+  return (int16_t)(((time(NULL) + (int32_t)tz_min * 60) % 86400) / 60);
+}
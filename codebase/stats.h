@@ -0,0 +1,19 @@
+#ifndef STATS_H
+#define STATS_H
+
+#include <Arduino.h>
+#include "config.h"
+
+//daily/weekly rollups and goal streaks, every update and read is constant work
+
+void stats_init(StatsRollup *stats);
+void stats_add_session(StatsRollup *stats, int32_t day, const Entry *entry);
+void stats_roll_to(StatsRollup *stats, int32_t day);
+uint16_t stats_current_streak(const StatsRollup *stats, int32_t today);
+
+void stats_set_clock(uint32_t unix_s);
+bool stats_clock_valid();
+int32_t stats_local_day(int16_t tz_min);
+int16_t stats_local_minute(int16_t tz_min);
+
+#endif // STATS_H
@@ -1,56 +1,249 @@
 #include "status_led.h"
+#include "power.h"
+#include <esp_timer.h>
+#include <atomic>
 
-static LEDColor current_color = COLOR_OFF;
 Adafruit_NeoPixel rgb(NUM_LEDS, LED_PIN, NEO_GRB + NEO_KHZ800);
 
-void status_led_set_color(LEDColor color);
-void status_led_set_from_hydration_state(HydrationState state);
+//TABLES ---------------------------------------------------------------
+//perceived brightness to PWM level, gamma 2.2
+static const uint8_t gamma_lut[256] = {
+  0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 1,
+  1, 1, 1, 1, 1, 1, 1, 1, 1, 2, 2, 2, 2, 2, 2, 2,
+  3, 3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 6, 6, 6,
+  6, 7, 7, 7, 8, 8, 8, 9, 9, 9, 10, 10, 11, 11, 11, 12,
+  12, 13, 13, 13, 14, 14, 15, 15, 16, 16, 17, 17, 18, 18, 19, 19,
+  20, 20, 21, 22, 22, 23, 23, 24, 25, 25, 26, 26, 27, 28, 28, 29,
+  30, 30, 31, 32, 33, 33, 34, 35, 35, 36, 37, 38, 39, 39, 40, 41,
+  42, 43, 43, 44, 45, 46, 47, 48, 49, 49, 50, 51, 52, 53, 54, 55,
+  56, 57, 58, 59, 60, 61, 62, 63, 64, 65, 66, 67, 68, 69, 70, 71,
+  73, 74, 75, 76, 77, 78, 79, 81, 82, 83, 84, 85, 87, 88, 89, 90,
+  91, 93, 94, 95, 97, 98, 99, 100, 102, 103, 105, 106, 107, 109, 110, 111,
+  113, 114, 116, 117, 119, 120, 121, 123, 124, 126, 127, 129, 130, 132, 133, 135,
+  137, 138, 140, 141, 143, 145, 146, 148, 149, 151, 153, 154, 156, 158, 159, 161,
+  163, 165, 166, 168, 170, 172, 173, 175, 177, 179, 181, 182, 184, 186, 188, 190,
+  192, 194, 196, 197, 199, 201, 203, 205, 207, 209, 211, 213, 215, 217, 219, 221,
+  223, 225, 227, 229, 231, 234, 236, 238, 240, 242, 244, 246, 248, 251, 253, 255
+};
 
+//sine ease in/out over 64 steps, used for fades and breathing
+#define EASE_STEPS 64
+static const uint8_t ease_lut[EASE_STEPS + 1] = {
+  0, 0, 1, 1, 2, 4, 5, 7, 10, 12, 15, 18, 21, 25, 29, 33,
+  37, 42, 47, 52, 57, 62, 67, 73, 79, 85, 90, 97, 103, 109, 115, 121,
+  127, 134, 140, 146, 152, 158, 165, 170, 176, 182, 188, 193, 198, 203, 208, 213,
+  218, 222, 226, 230, 234, 237, 240, 243, 245, 248, 250, 251, 253, 254, 254, 255,
+  255
+};
+
+//NEOPIXEL BACKEND -----------------------------------------------------
+static void neopixel_show(LEDColor color) {
+  rgb.setPixelColor(0, rgb.Color(color.red, color.green, color.blue));
+  rgb.show();
+  power_set_level(POWER_RAIL_LED, ((uint16_t)color.red + color.green + color.blue) / 3, millis());
+}
+
+static const LedBackend neopixel_backend = { neopixel_show };
+static const LedBackend *backend = &neopixel_backend;
+
+//REQUESTS -------------------------------------------------------------
+//the LED task only leaves the wanted look here, status_led_tick() is the one place that draws
+static portMUX_TYPE request_lock = portMUX_INITIALIZER_UNLOCKED;
+static LEDColor requested_color = COLOR_OFF;
+static LedEffect requested_effect = LED_SOLID;
+static bool request_pending = false;
+
+static esp_timer_handle_t timer = NULL;
+static std::atomic<bool> kick_pending(false);
+
+//ENGINE STATE, only touched by status_led_tick() ----------------------
+static LEDColor color = COLOR_OFF;      //colour of the current effect, before gamma
+static LedEffect effect = LED_SOLID;
+static uint32_t effect_start_ms = 0;
+static LEDColor fade_from = COLOR_OFF;  //what was showing when the effect changed, before gamma
+static uint32_t fade_start_ms = 0;
+static bool fading = false;
+static LEDColor drawn = COLOR_OFF;      //last frame before gamma, where the next fade starts
+static LEDColor shown = COLOR_OFF;      //last frame pushed to the LED
+static bool shown_valid = false;
+static LedStats stats;
+
+static uint8_t ease(uint32_t pos, uint32_t span) {
+  if (pos >= span) return ease_lut[EASE_STEPS];
+  return ease_lut[pos * EASE_STEPS / span];
+}
+
+static uint8_t scale8(uint8_t value, uint8_t level) {
+  return (uint16_t)value * level / 255;
+}
+
+static uint8_t mix8(uint8_t from, uint8_t to, uint8_t amount) {
+  return from + ((int16_t)to - from) * amount / 255;
+}
+
+//brightness of the effect at now_ms, and how long until it changes
+static uint8_t effect_level(uint32_t now_ms, uint32_t *wait) {
+  uint32_t t = now_ms - effect_start_ms;
+  switch (effect) {
+    case LED_BREATHE: {
+      uint32_t phase = t % LED_BREATHE_MS, half = LED_BREATHE_MS / 2;
+      uint32_t x = (phase < half) ? phase : LED_BREATHE_MS - phase;
+      *wait = LED_BREATHE_FRAME_MS;
+      return LED_BREATHE_MIN + (uint16_t)(255 - LED_BREATHE_MIN) * ease(x, half) / 255;
+    }
+    case LED_BLINK: {
+      uint32_t phase = t % LED_BLINK_MS, half = LED_BLINK_MS / 2;
+      *wait = (phase < half) ? half - phase : LED_BLINK_MS - phase;
+      return (phase < half) ? 255 : 0;
+    }
+    case LED_SOLID:
+    default:
+      *wait = 0;
+      return 255;
+  }
+}
+
+//draws the frame for now_ms, returns the ms until the next one is needed, 0 when the LED is static
+//the esp_timer callback is the only caller on the device, host tests call it with a virtual clock
+uint32_t status_led_tick(uint32_t now_ms) {
+  portENTER_CRITICAL(&request_lock);
+  bool changed = request_pending;
+  LEDColor new_color = requested_color;
+  LedEffect new_effect = requested_effect;
+  request_pending = false;
+  portEXIT_CRITICAL(&request_lock);
+
+  //a new look crossfades from whatever is showing right now
+  if (changed) {
+    fade_from = drawn;
+    fade_start_ms = now_ms;
+    fading = true;
+    color = new_color;
+    effect = new_effect;
+    effect_start_ms = now_ms;
+  }
+
+  uint32_t wait;
+  uint8_t level = effect_level(now_ms, &wait);
+  LEDColor frame = { scale8(color.red, level), scale8(color.green, level), scale8(color.blue, level) };
+  if (fading) {
+    uint32_t t = now_ms - fade_start_ms;
+    if (t >= LED_FADE_MS) {
+      fading = false;
+    }
+    else {
+      uint8_t amount = ease(t, LED_FADE_MS);
+      frame.red = mix8(fade_from.red, frame.red, amount);
+      frame.green = mix8(fade_from.green, frame.green, amount);
+      frame.blue = mix8(fade_from.blue, frame.blue, amount);
+      wait = LED_FRAME_MS;
+    }
+  }
+  drawn = frame;
+
+  //only push frames the LED isn't already showing
+  LEDColor out = { gamma_lut[frame.red], gamma_lut[frame.green], gamma_lut[frame.blue] };
+  if (shown_valid && out.red == shown.red && out.green == shown.green && out.blue == shown.blue) {
+    portENTER_CRITICAL(&request_lock);
+    stats.skipped++;
+    portEXIT_CRITICAL(&request_lock);
+  }
+  else {
+    int64_t start_us = esp_timer_get_time();
+    backend->show(out);
+    int64_t took_us = esp_timer_get_time() - start_us;
+    portENTER_CRITICAL(&request_lock);
+    stats.show_us += took_us;
+    stats.frames++;
+    portEXIT_CRITICAL(&request_lock);
+    shown = out;
+    shown_valid = true;
+  }
+  return wait;
+}
+
+//TIMER ----------------------------------------------------------------
+static void status_led_timer_cb(void *arg) {
+  uint32_t wait;
+  //a request that arrived while this was drawing would otherwise wait for the next frame or forever
+  do {
+    kick_pending.store(false);
+    wait = status_led_tick(millis());
+  } while (kick_pending.load());
+  if (wait) esp_timer_start_once(timer, (uint64_t)wait * 1000);
+}
+
+static void status_led_kick() {
+  kick_pending.store(true);
+  if (!timer) return;
+  //restart only takes an armed timer and start_once only an idle one, the callback can re-arm in between
+  while (esp_timer_restart(timer, 0) != ESP_OK && esp_timer_start_once(timer, 0) != ESP_OK) {
+  }
+}
+
+//PUBLIC ---------------------------------------------------------------
 void status_led_init() {
   rgb.begin();
   rgb.show();
+  esp_timer_create_args_t args = {};
+  args.callback = status_led_timer_cb;
+  args.dispatch_method = ESP_TIMER_TASK;
+  args.name = "status_led";
+  esp_timer_create(&args, &timer);
 }
 
-//white LED to show that system is waiting for user input
-void status_led_show_waiting() {
-  rgb.setPixelColor(0, rgb.Color(120, 120, 120));
-  rgb.show();
+void status_led_set_backend(const LedBackend *b) {
+  backend = b ? b : &neopixel_backend;
+  shown_valid = false;
 }
 
-//sets the LED to the passed in color
-void status_led_set_color(LEDColor color) {
-  rgb.setPixelColor(0, rgb.Color(color.red, color.green, color.blue));
-  rgb.show();
+//asks for a colour and effect, nothing happens if that is already what's showing
+void status_led_set(LEDColor new_color, LedEffect new_effect) {
+  portENTER_CRITICAL(&request_lock);
+  bool same = new_effect == requested_effect && new_color.red == requested_color.red
+           && new_color.green == requested_color.green && new_color.blue == requested_color.blue;
+  if (!same) {
+    requested_color = new_color;
+    requested_effect = new_effect;
+    request_pending = true;
+  }
+  portEXIT_CRITICAL(&request_lock);
+  if (!same) status_led_kick();
 }
 
-//passes in the corresponding color to the passed in hydration state
-void status_led_set_from_hydration_state(HydrationState state) {
-  LEDColor color;
-    switch(state) {
-        case HYDRATED:
-          color = COLOR_GOOD;
-          break;
-          
-        case NEEDS_WATER:
-          color = COLOR_OK;
-          break;
-          
-        case CRITICAL:
-          color = COLOR_CRITICAL;
-          break;
-        
-        case COMPLETED:
-          color = COLOR_COMPLETED;
-          break;
-
-        default:
-          color = COLOR_OFF;
-          break;
-      }
-  status_led_set_color(color);
+//slow white breath to show that system is waiting for user input
+void status_led_show_waiting() {
+  status_led_set(COLOR_WAITING, LED_BREATHE);
 }
 
+//passes in the corresponding color to the passed in hydration state
 void status_led_update(HydrationState state) {
-  // Get current hydration state and update LED accordingly
-  status_led_set_from_hydration_state(state);
-}
\ No newline at end of file
+  switch(state) {
+    case HYDRATED:
+      status_led_set(COLOR_GOOD, LED_SOLID);
+      break;
+
+    case NEEDS_WATER:
+      status_led_set(COLOR_OK, LED_SOLID);
+      break;
+
+    case CRITICAL:
+      status_led_set(COLOR_CRITICAL, LED_BLINK);
+      break;
+
+    case COMPLETED:
+      status_led_set(COLOR_COMPLETED, LED_SOLID);
+      break;
+
+    default:
+      status_led_set(COLOR_OFF, LED_SOLID);
+      break;
+  }
+}
+
+//frame counters and time spent pushing frames since boot
+void status_led_get_stats(LedStats *out) {
+  portENTER_CRITICAL(&request_lock);
+  *out = stats;
+  portEXIT_CRITICAL(&request_lock);
+}
@@ -6,9 +6,15 @@
 #include "config.h"
 #include "state.h"
 
+//change driven LED engine, frames come off an esp_timer and only reach the LED when they differ
+
 // Function prototypes
 void status_led_init();
+void status_led_set_backend(const LedBackend *backend);
+void status_led_set(LEDColor color, LedEffect effect);
 void status_led_update(HydrationState state);
 void status_led_show_waiting();
+uint32_t status_led_tick(uint32_t now_ms);
+void status_led_get_stats(LedStats *out);
 
 #endif // STATUS_LED_H
\ No newline at end of file
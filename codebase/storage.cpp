@@ -1,71 +1,349 @@
 #include "storage.h"
+#include "journal.h"
+#include "entry_codec.h"
+#include "stats.h"
+#include "metrics.h"
 #include <Arduino.h>
 #include <time.h>
 #include <nvs_flash.h>
 #include <nvs.h>
+#include <atomic>
 
 static const char* STORAGE_NAMESPACE = "hydrate";
-Entry entries[MAX_ENTRIES]; //holds storage data
+Entry entries[MAX_ENTRIES]; //latest sessions, newest first, rebuilt from the journal at boot
+static bool journal_ready = false;  //false if the journal partition is missing, history then falls back to the old NVS blob
+static uint32_t entry_ids[MAX_ENTRIES]; //journal id of each cached session, 0 if it has none
+static StatsRollup stats;   //rollups over every session since the last reset
+static portMUX_TYPE entries_lock = portMUX_INITIALIZER_UNLOCKED;  //guards entries, entry_ids and stats
+static EntryCodec encoder;  //previous session appended, deltas are taken from it
+static uint32_t encoder_seq = 0;  //journal segment the encoder's previous session went to
+
+//NVS stays open for the life of the program, writes wait in RAM and go out together in storage_flush()
+static nvs_handle_t nvs;
+static bool nvs_ready = false;
+static std::atomic<bool> blob_dirty(false);   //fallback history changed, set from the web task too
+static std::atomic<bool> stats_dirty(false);
+static CalibrationData calibration[SCALE_CHANNELS];   //guarded by entries_lock, written by the sampler and read back at flush
+static std::atomic<uint32_t> calibration_dirty(0);     //one bit per channel
+static uint32_t last_commit_ms = 0;
+
+//running session checkpoint, only touched by the scale task
+enum CheckpointState {
+  CHECKPOINT_CLEAN,   //NVS matches RAM
+  CHECKPOINT_DIRTY,   //RAM has a newer checkpoint
+  CHECKPOINT_CLEAR    //session ended, the NVS copy has to go
+};
+static SessionCheckpoint checkpoint;
+static CheckpointState checkpoint_state = CHECKPOINT_CLEAN;
+static bool checkpoint_active = false; //checkpoint belongs to the running session
+static bool checkpoint_saved = false;  //NVS holds a checkpoint
+
+//every commit is timed, a slow flash erase shows up in the nvs_commit histogram
+static void storage_commit() {
+  uint32_t start = metrics_cycles();
+  nvs_commit(nvs);
+  metrics_record_since(METRIC_NVS_COMMIT_TIME, start);
+  metrics_count(METRIC_NVS_COMMITS);
+}
+
+static void storage_load_blob(Entry out[MAX_ENTRIES]);
+static void storage_save_entries(const Entry entries[MAX_ENTRIES]);
+
+//puts entry at the front of the cache, the oldest one drops off the end
+static void storage_push_entry(const Entry *entry, uint32_t id) {
+  portENTER_CRITICAL(&entries_lock);
+  for (int i = MAX_ENTRIES - 1; i > 0; i--) {
+    entries[i] = entries[i - 1];
+    entry_ids[i] = entry_ids[i - 1];
+  }
+  entries[0] = *entry;
+  entry_ids[0] = id;
+  portEXIT_CRITICAL(&entries_lock);
+}
+
+//empties the cache
+static void storage_clear_entries() {
+  portENTER_CRITICAL(&entries_lock);
+  memset(entries, 0, sizeof(entries));
+  memset(entry_ids, 0, sizeof(entry_ids));
+  portEXIT_CRITICAL(&entries_lock);
+}
+
+//packs entry and appends it, the first session in every segment is a keyframe so any segment decodes on its own
+//other records (a session's series) can move the journal to a new segment between two sessions
+//returns the session's journal id
+static uint32_t storage_append_session(const Entry *entry) {
+  uint8_t packed[ENTRY_CODEC_MAX_BYTES];
+  bool keyframe = !journal_fits(ENTRY_CODEC_MAX_BYTES) || journal_head_seq() != encoder_seq;
+  size_t n = entry_encode(&encoder, entry, keyframe, packed);
+  uint32_t id = journal_append(JREC_SESSION_PACKED, packed, n);
+  encoder_seq = journal_head_seq();
+  return id;
+}
+
+//journal visitor that replays sessions and resets into the cache, ctx is the decoder
+static bool storage_replay_record(uint8_t type, uint32_t id, const uint8_t *data, uint16_t len, void *ctx) {
+  Entry entry;
+  if (type == JREC_SESSION_PACKED) {
+    if (entry_decode((EntryCodec *)ctx, data, len, &entry) > 0) storage_push_entry(&entry, id);
+  }
+  else if (type == JREC_SESSION && len == sizeof(Entry)) {
+    memcpy(&entry, data, sizeof(entry));
+    storage_push_entry(&entry, id);
+  }
+  else if (type == JREC_RESET) {
+    storage_clear_entries();
+  }
+  return true;
+}
+
+//moves sessions saved by older firmware into the journal, then drops the blob
+static void storage_migrate_blob() {
+  Entry old[MAX_ENTRIES];
+  storage_load_blob(old);
+  for (int i = MAX_ENTRIES - 1; i >= 0; i--) {
+    if (old[i].duration == 0 && old[i].goal == 0) continue;
+    storage_append_session(&old[i]);
+  }
+
+  if (nvs_ready) {
+    nvs_erase_key(nvs, "history");
+    storage_commit();
+  }
+}
 
 void storage_init() {
   nvs_flash_init();
-  // Load existing data
-  storage_load_entries(entries);
-}
+  nvs_ready = nvs_open(STORAGE_NAMESPACE, NVS_READWRITE, &nvs) == ESP_OK;
+  if (!nvs_ready && DEBUG) Serial.println("NVS open failed");
+  storage_clear_entries();
+  entry_codec_init(&encoder);
+  encoder_seq = 0;
+
+  size_t stats_size = sizeof(stats);
+  if (!nvs_ready || nvs_get_blob(nvs, "stats", &stats, &stats_size) != ESP_OK || stats_size != sizeof(stats)) {
+    stats_init(&stats);
+  }
 
-//loads past session data into entries array
-void storage_load_entries(Entry entries[MAX_ENTRIES]) {
-  nvs_handle_t handle;
-  if (nvs_open(STORAGE_NAMESPACE, NVS_READWRITE, &handle) != ESP_OK) {
-    if (DEBUG) Serial.println("NVS open failed");
+  journal_ready = journal_mount(NULL);
+  if (!journal_ready) {
+    storage_load_blob(entries);
     return;
   }
+  if (journal_next_id() == 1) {
+    storage_migrate_blob();
+  }
+  //the latest sessions are always in the newest few segments, see JOURNAL_RECENT_SEGMENTS
+  EntryCodec decoder;
+  entry_codec_init(&decoder);
+  journal_iterate_recent(JOURNAL_RECENT_SEGMENTS, storage_replay_record, &decoder);
+}
+
+//copies the latest sessions, newest first
+void storage_load_entries(Entry out[MAX_ENTRIES]) {
+  portENTER_CRITICAL(&entries_lock);
+  memcpy(out, entries, sizeof(Entry) * MAX_ENTRIES);
+  portEXIT_CRITICAL(&entries_lock);
+}
+
+//journal ids of the same sessions, these name a session in /series
+void storage_load_entry_ids(uint32_t out[MAX_ENTRIES]) {
+  portENTER_CRITICAL(&entries_lock);
+  memcpy(out, entry_ids, sizeof(entry_ids));
+  portEXIT_CRITICAL(&entries_lock);
+}
+
+//reads the history blob older firmware kept in NVS
+static void storage_load_blob(Entry out[MAX_ENTRIES]) {
+  memset(out, 0, sizeof(Entry) * MAX_ENTRIES);
+  if (!nvs_ready) return;
 
   size_t required_size = sizeof(Entry) * MAX_ENTRIES;
-  esp_err_t err = nvs_get_blob(handle, "history", entries, &required_size);
+  esp_err_t err = nvs_get_blob(nvs, "history", out, &required_size);
 
-  if (err == ESP_ERR_NVS_NOT_FOUND) {
+  if (err != ESP_OK) {
       // If no saved data, zero out
-      memset(entries, 0, sizeof(Entry) * MAX_ENTRIES);
+      memset(out, 0, sizeof(Entry) * MAX_ENTRIES);
   }
-  nvs_close(handle);
 }
 
-//saves entries array into memory
-void storage_save_entries(const Entry entries[MAX_ENTRIES]) {
-  nvs_handle_t handle;
-  if (nvs_open(STORAGE_NAMESPACE, NVS_READWRITE, &handle) != ESP_OK) {
-    if (DEBUG) Serial.println("NVS open failed");
-    return;
-  }
+//writes the cache as the history blob, only used without a journal partition, caller commits
+static void storage_save_entries(const Entry entries[MAX_ENTRIES]) {
+  nvs_set_blob(nvs, "history", entries, sizeof(Entry) * MAX_ENTRIES);
+}
+
+//appends one session to the journal and the cache, intake and goal are kept in whole millilitres
+//returns the session's journal id, 0 without a journal
+uint32_t storage_add_entry(float grams_drank, float goal, float duration) {
+  Entry entry;
+  entry.grams_drank = entry_quantise_ml(grams_drank);
+  entry.goal = entry_quantise_ml(goal);
+  entry.duration = duration;
 
-  nvs_set_blob(handle, "history", entries, sizeof(Entry) * MAX_ENTRIES);
-  nvs_commit(handle);
-  nvs_close(handle);
+  portENTER_CRITICAL(&entries_lock);
+  int32_t day = stats_clock_valid() ? stats_local_day(stats.tz_min) : stats.last_day;
+  stats_add_session(&stats, day, &entry);
+  portEXIT_CRITICAL(&entries_lock);
+  stats_dirty = true;
+
+  uint32_t id = 0;
+  if (journal_ready) {
+    id = storage_append_session(&entry);
+    storage_push_entry(&entry, id);
+  }
+  else {
+    storage_push_entry(&entry, 0);
+    blob_dirty = true;
+  }
+  return id;
 }
 
-//adds entry data to past session data and automatically saves to memory
-void storage_add_entry(float grams_drank, float goal, float duration) {
-  // Shift old entries: 6 <- 5 <- 4 ... <- 0
-  for (int i = MAX_ENTRIES - 1; i > 0; i--) {
-    entries[i] = entries[i - 1];
+//resets past session data, the journal keeps the old sessions behind a reset marker
+void storage_reset_entries() {
+  storage_clear_entries();
+  portENTER_CRITICAL(&entries_lock);
+  int16_t tz_min = stats.tz_min;
+  stats_init(&stats);
+  stats.tz_min = tz_min;
+  portEXIT_CRITICAL(&entries_lock);
+  stats_dirty = true;
+
+  if (journal_ready) {
+    journal_append(JREC_RESET, NULL, 0);
+  }
+  else {
+    blob_dirty = true;
   }
+}
 
-  // Put new entry in position 0
-  entries[0].grams_drank = grams_drank;
-  entries[0].goal = goal;
-  entries[0].duration = duration;
+//STATS ----------------------------------------------------------------
+//copy of the rollups with the day and week windows moved up to today, *today is -1 without a clock
+void storage_get_stats(StatsRollup *out, int32_t *today) {
+  portENTER_CRITICAL(&entries_lock);
+  *out = stats;
+  portEXIT_CRITICAL(&entries_lock);
+  *today = stats_clock_valid() ? stats_local_day(out->tz_min) : -1;
+  if (*today >= 0) stats_roll_to(out, *today);
+}
 
-  // Save the updated array to memory
-  storage_save_entries(entries);
+//wall clock from the dashboard, days are counted in its timezone
+void storage_set_clock(uint32_t unix_s, int16_t tz_min) {
+  stats_set_clock(unix_s);
+  portENTER_CRITICAL(&entries_lock);
+  bool changed = stats.tz_min != tz_min;
+  stats.tz_min = tz_min;
+  portEXIT_CRITICAL(&entries_lock);
+  if (changed) stats_dirty = true;
 }
 
-//resets past session data
-void storage_reset_entries() {
-  for (int i = 0; i < MAX_ENTRIES; i++) {
-    entries[i].grams_drank = 0;
-    entries[i].goal = 0;
-    entries[i].duration = 0;
+//UTC offset of the phone that last set the clock, minutes
+int16_t storage_get_tz() {
+  portENTER_CRITICAL(&entries_lock);
+  int16_t tz_min = stats.tz_min;
+  portEXIT_CRITICAL(&entries_lock);
+  return tz_min;
+}
+
+//CALIBRATION ----------------------------------------------------------
+//each channel has its own key, "calib0" and on
+static void calibration_key(uint8_t channel, char key[12]) {
+  snprintf(key, 12, "calib%u", (unsigned)channel);
+}
+
+//reads the calibration a previous boot stored for a channel, false if there is none
+bool storage_get_calibration(uint8_t channel, CalibrationData *out) {
+  if (!nvs_ready) return false;
+  char key[12];
+  calibration_key(channel, key);
+  size_t size = sizeof(*out);
+  if (nvs_get_blob(nvs, key, out, &size) != ESP_OK || size != sizeof(*out)) return false;
+  return out->counts_per_gram != 0;
+}
+
+//goes out with the next flush, cheap enough for the sampler to call
+void storage_set_calibration(uint8_t channel, const CalibrationData *data) {
+  portENTER_CRITICAL(&entries_lock);
+  calibration[channel] = *data;
+  portEXIT_CRITICAL(&entries_lock);
+  calibration_dirty.fetch_or(1UL << channel);
+}
+
+//CHECKPOINTS ----------------------------------------------------------
+//notes where the running session is, only marked for writing when it moved enough to be worth a flash write
+void storage_checkpoint_session(const SessionCheckpoint *cp) {
+  bool changed = !checkpoint_active
+              || cp->goal != checkpoint.goal || cp->duration_s != checkpoint.duration_s
+              || cp->total_grams != checkpoint.total_grams
+              || cp->elapsed_ms - checkpoint.elapsed_ms >= STORAGE_CHECKPOINT_MS;
+  if (!changed) return;
+  checkpoint = *cp;
+  checkpoint_active = true;
+  checkpoint_state = CHECKPOINT_DIRTY;
+}
+
+//session finished and is in the history, it must not be resumed
+void storage_end_session() {
+  checkpoint_active = false;
+  checkpoint_state = checkpoint_saved ? CHECKPOINT_CLEAR : CHECKPOINT_CLEAN;
+}
+
+//reads the checkpoint a reboot interrupted, false if no session was running
+bool storage_load_checkpoint(SessionCheckpoint *cp) {
+  if (!nvs_ready) return false;
+  size_t size = sizeof(*cp);
+  if (nvs_get_blob(nvs, "session", cp, &size) != ESP_OK || size != sizeof(*cp)) return false;
+  checkpoint = *cp;
+  checkpoint_active = true;
+  checkpoint_saved = true;
+  return cp->goal > 0 && cp->duration_s > 0;
+}
+
+//writes whatever is pending in one commit, at most once per STORAGE_COMMIT_MIN_MS unless forced
+void storage_flush(uint32_t now_ms, bool force) {
+  if (!nvs_ready) return;
+  if (!force && now_ms - last_commit_ms < STORAGE_COMMIT_MIN_MS) return;
+
+  bool wrote = false;
+  if (blob_dirty.exchange(false)) {
+    Entry copy[MAX_ENTRIES];
+    storage_load_entries(copy);
+    storage_save_entries(copy);
+    wrote = true;
+  }
+  if (stats_dirty.exchange(false)) {
+    StatsRollup copy;
+    portENTER_CRITICAL(&entries_lock);
+    copy = stats;
+    portEXIT_CRITICAL(&entries_lock);
+    nvs_set_blob(nvs, "stats", &copy, sizeof(copy));
+    wrote = true;
+  }
+  uint32_t calibrated = calibration_dirty.exchange(0);
+  for (uint8_t ch = 0; ch < SCALE_CHANNELS; ch++) {
+    if (!(calibrated & (1UL << ch))) continue;
+    CalibrationData copy;
+    portENTER_CRITICAL(&entries_lock);
+    copy = calibration[ch];
+    portEXIT_CRITICAL(&entries_lock);
+    char key[12];
+    calibration_key(ch, key);
+    nvs_set_blob(nvs, key, &copy, sizeof(copy));
+    wrote = true;
+  }
+  if (checkpoint_state == CHECKPOINT_DIRTY) {
+    nvs_set_blob(nvs, "session", &checkpoint, sizeof(checkpoint));
+    checkpoint_saved = true;
+    wrote = true;
+  }
+  else if (checkpoint_state == CHECKPOINT_CLEAR) {
+    nvs_erase_key(nvs, "session");
+    checkpoint_saved = false;
+    wrote = true;
+  }
+  checkpoint_state = CHECKPOINT_CLEAN;
+
+  if (wrote) {
+    storage_commit();
+    last_commit_ms = now_ms;
   }
-  storage_save_entries(entries);
 }
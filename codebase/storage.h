@@ -5,8 +5,18 @@
 #include "config.h"
 
 void storage_init();
-void storage_add_entry(float grams_drank, float goal, float duration);
+uint32_t storage_add_entry(float grams_drank, float goal, float duration);
 void storage_load_entries(Entry entries[MAX_ENTRIES]);
+void storage_load_entry_ids(uint32_t ids[MAX_ENTRIES]);
 void storage_reset_entries();
+void storage_checkpoint_session(const SessionCheckpoint *cp);
+void storage_end_session();
+bool storage_load_checkpoint(SessionCheckpoint *cp);
+void storage_flush(uint32_t now_ms, bool force);
+void storage_get_stats(StatsRollup *out, int32_t *today);
+void storage_set_clock(uint32_t unix_s, int16_t tz_min);
+int16_t storage_get_tz();
+bool storage_get_calibration(uint8_t channel, CalibrationData *out);
+void storage_set_calibration(uint8_t channel, const CalibrationData *data);
 
 #endif // STORAGE_H
\ No newline at end of file
@@ -0,0 +1,84 @@
+#!/usr/bin/env python3
+"""Builds web_assets.h from the dashboard sources in web/.
+
+Inlines style.css and app.js into index.html, minifies the result, gzips it
+and writes it out as a const byte array the firmware serves straight from
+flash with Content-Encoding: gzip. Run from the codebase directory after
+editing anything in web/:
+
+    python3 tools/build_web_assets.py
+"""
+import gzip
+import hashlib
+import os
+import re
+import sys
+
+ROOT = os.path.dirname(os.path.dirname(os.path.abspath(__file__)))
+WEB_DIR = os.path.join(ROOT, "web")
+OUT_PATH = os.path.join(ROOT, "web_assets.h")
+
+
+def read(name):
+    with open(os.path.join(WEB_DIR, name), encoding="utf-8") as f:
+        return f.read()
+
+
+def minify_css(css):
+    css = re.sub(r"/\*.*?\*/", "", css, flags=re.S)
+    css = re.sub(r"\s+", " ", css)
+    css = re.sub(r"\s*([{}:;,])\s*", r"\1", css)
+    return css.replace(";}", "}").strip()
+
+
+def minify_js(js):
+    # only whole-line comments are dropped, so strings and template literals are never touched
+    lines = []
+    for line in js.splitlines():
+        stripped = line.strip()
+        if stripped and not stripped.startswith("//"):
+            lines.append(stripped)
+    return "\n".join(lines)
+
+
+def minify_html(html):
+    html = re.sub(r"<!--.*?-->", "", html, flags=re.S)
+    html = re.sub(r"\s+", " ", html)
+    html = re.sub(r">\s+<", "><", html)
+    return html.strip()
+
+
+def build_page():
+    html = minify_html(read("index.html"))
+    html = html.replace("<link rel='stylesheet' href='style.css'>",
+                        "<style>" + minify_css(read("style.css")) + "</style>")
+    html = html.replace("<script src='app.js'></script>",
+                        "<script>" + minify_js(read("app.js")) + "</script>")
+    return html.encode("utf-8")
+
+
+def main():
+    page = build_page()
+    # mtime=0 keeps the output byte for byte reproducible
+    packed = gzip.compress(page, compresslevel=9, mtime=0)
+    etag = hashlib.sha1(packed).hexdigest()[:16]
+
+    rows = []
+    for i in range(0, len(packed), 16):
+        rows.append("  " + ", ".join("0x%02x" % b for b in packed[i:i + 16]) + ",")
+
+    with open(OUT_PATH, "w", encoding="utf-8") as f:
+        f.write("// generated by tools/build_web_assets.py from web/, do not edit\n")
+        f.write("#ifndef WEB_ASSETS_H\n#define WEB_ASSETS_H\n\n#include <Arduino.h>\n\n")
+        f.write("// dashboard page, %d bytes minified, %d bytes gzipped\n" % (len(page), len(packed)))
+        f.write("#define WEB_INDEX_ETAG \"\\\"%s\\\"\"\n" % etag)
+        f.write("#define WEB_INDEX_GZ_LEN %d\n" % len(packed))
+        f.write("static const uint8_t WEB_INDEX_GZ[WEB_INDEX_GZ_LEN] PROGMEM = {\n")
+        f.write("\n".join(rows))
+        f.write("\n};\n\n#endif // WEB_ASSETS_H\n")
+
+    print("index.html: %d bytes minified, %d bytes gzipped" % (len(page), len(packed)), file=sys.stderr)
+
+
+if __name__ == "__main__":
+    main()
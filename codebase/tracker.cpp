@@ -0,0 +1,119 @@
+#include "tracker.h"
+#include "scale.h"
+#include "events.h"
+#include "hydration.h"
+#include "storage.h"
+#include "web.h"
+#include "state.h"
+#include "series.h"
+
+static Entry html_page_entries[MAX_ENTRIES]; //holds data from storage to be populated to web
+static uint32_t html_page_ids[MAX_ENTRIES];   //journal ids of those sessions
+static TaskHandle_t tracker_task = NULL;      //task running tracker_step(), woken for each new sample
+//every channel's intake since the session started, the session channel's is also in hydration.cpp
+static ChannelTally tallies[SCALE_CHANNELS];
+static portMUX_TYPE tally_lock = portMUX_INITIALIZER_UNLOCKED;
+static bool was_running = false;
+
+void tracker_set_task(TaskHandle_t task) {
+  tracker_task = task;
+}
+
+//asks for a tracker pass now, a new sample arrived or a pacing deadline passed
+void tracker_notify() {
+  if (tracker_task != NULL) xTaskNotifyGive(tracker_task);
+}
+
+//scale event listener, counts sips on every channel while a session is running
+static void tracker_on_scale_event(const ScaleEvent *event) {
+  if (event->type != EVENT_SIP || get_state() != STATE_RUNNING) return;
+  portENTER_CRITICAL(&tally_lock);
+  tallies[event->channel].intake_grams += event->grams;
+  tallies[event->channel].sips++;
+  portEXIT_CRITICAL(&tally_lock);
+}
+
+void tracker_get_tally(uint8_t channel, ChannelTally *out) {
+  portENTER_CRITICAL(&tally_lock);
+  *out = tallies[channel];
+  portEXIT_CRITICAL(&tally_lock);
+}
+
+void tracker_init() {
+  events_add_listener(tracker_on_scale_event);
+  storage_load_entries(html_page_entries);  //load entries from non-volatile memory to html_page_entries
+  storage_load_entry_ids(html_page_ids);
+  set_history(html_page_entries, html_page_ids); //sends data to website
+
+  //a reboot interrupted a session, carry on where the last checkpoint left it
+  SessionCheckpoint cp;
+  if (storage_load_checkpoint(&cp)) {
+    set_goal(cp.goal);
+    set_time_length(cp.duration_s);
+    set_pacing_curve((PacingCurve)cp.curve);
+    reset();
+    hydration_resume(cp.elapsed_ms, cp.total_grams);
+    set_state(STATE_RUNNING);
+    if (DEBUG) Serial.println("resumed session from checkpoint");
+  }
+}
+
+//one pass over whatever the sampler read since the last call
+void tracker_step() {
+  //a new session starts every channel's tally from zero
+  bool running = get_state() == STATE_RUNNING;
+  if (running && !was_running) {
+    portENTER_CRITICAL(&tally_lock);
+    memset(tallies, 0, sizeof(tallies));
+    portEXIT_CRITICAL(&tally_lock);
+  }
+  was_running = running;
+
+  //classify everything the sampler read since the last pass, sips reach hydration.cpp through its event listener
+  //this also runs while waiting for user input so the bottle weight is known when the session starts
+  ScaleSample sample;
+  for (uint8_t ch = 0; ch < SCALE_CHANNELS; ch++) {
+    while (scale_pop_sample(ch, &sample)) {
+      events_process(ch, &sample);
+    }
+  }
+  //pending NVS writes go out together, rate limited
+  storage_flush(millis(), false);
+
+  //while waiting for user input, do not track hydration
+  if (get_state() == STATE_WAITING_USER_INPUT) {
+    return;
+  }
+
+  update_hydration_status();
+  series_record(millis(), get_total_grams(), get_pacer());
+
+  SessionCheckpoint cp;
+  cp.goal = get_goal_grams();
+  cp.duration_s = get_time_length();
+  cp.elapsed_ms = get_elapsed_ms();
+  cp.total_grams = get_total_grams();
+  cp.curve = get_pacing_curve();
+  storage_checkpoint_session(&cp);
+
+  //the session ends when its time is up
+  if (hydration_session_over()) {
+    //store the sessions total water intake, the goal, and the session length in memory
+    uint32_t session = storage_add_entry(get_total_grams(), get_goal_grams(), get_time_length());
+    //the intake curve goes right after its session in the journal
+    series_end(session);
+    //nothing left to resume, drop the checkpoint now rather than at the next commit slot
+    storage_end_session();
+    storage_flush(millis(), true);
+
+    //load past sessions into web page
+    storage_load_entries(html_page_entries);
+    storage_load_entry_ids(html_page_ids);
+    set_history(html_page_entries, html_page_ids);
+
+    //tell open dashboards so the user input overlay appears automatically
+    web_session_ended(get_total_grams(), get_goal_grams());
+    //user needs to input new information for new session after this session ends
+    set_state(STATE_WAITING_USER_INPUT);
+  }
+}
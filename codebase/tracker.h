@@ -0,0 +1,14 @@
+#ifndef TRACKER_H
+#define TRACKER_H
+
+#include <Arduino.h>
+#include "config.h"
+
+//session logic behind taskReadScale, kept free of task and delay calls so it can be stepped by anything
+void tracker_init();
+void tracker_step();
+void tracker_set_task(TaskHandle_t task);
+void tracker_notify();
+void tracker_get_tally(uint8_t channel, ChannelTally *out);
+
+#endif // TRACKER_H
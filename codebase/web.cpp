@@ -3,13 +3,85 @@
 #include "storage.h"
 #include "state.h"
 #include "hydration.h"
+#include "events.h"
+#include "web_assets.h"
+#include "http_request.h"
+#include "entry_codec.h"
+#include "series.h"
+#include "stats.h"
+#include "exporter.h"
+#include "pacing.h"
+#include "speaker.h"
+#include "power.h"
+#include "metrics.h"
+#include "data_json.h"
+#include "calibration.h"
+#include "scale.h"
+#include "tracker.h"
+#include <atomic>
+#include <stdarg.h>
+#include <lwip/sockets.h>
 
 Entry web_entries[MAX_ENTRIES]; //holds past session data from storage
-float web_goal_grams; //holds hydration goal for session
-float web_total_grams;  //holds total hydration intake for session
+static uint32_t web_entry_ids[MAX_ENTRIES]; //journal ids of web_entries, the session number /series takes
 bool web_request = false; //flag that is used to turn enable web functionality
-bool refresh_flag = false;  //flag to indicate whether website should be refreshed
-WiFiServer server(80);
+volatile bool history_dirty = true; //set when web_entries changes
+
+//cached /data body, rebuilt only when something it shows changes
+static char data_json[WEB_DATA_JSON_SIZE];
+static size_t data_json_len = 0;
+static size_t data_live_len = 0;    //length of the part before the history array
+static uint32_t data_version = 0;   //bumped on every rebuild, sent as "v" and the ETag
+static uint32_t history_version = 0; //version the history last changed in
+static bool data_waiting;
+static float data_goal, data_total;
+//open /events streams
+static WiFiClient sse_clients[WEB_SSE_MAX_CLIENTS];
+static uint32_t sse_version = 0;    //data version the streams last got
+static uint32_t sse_last_send = 0;  //millis() of the last write to the streams, for keepalive pings
+static char sse_buf[WEB_DATA_JSON_SIZE + 32];
+//only the web task answers /series, so one set of buffers is enough
+static SeriesData series_data;
+static SeriesPoint series_points[SERIES_MAX_BUCKETS];
+static char series_json[WEB_SERIES_JSON_SIZE];
+static char channels_json[WEB_CHANNELS_JSON_SIZE];
+//one /export at a time, streamed a few chunks per pass so other clients keep getting served
+static WiFiClient export_client;
+static Exporter exporter;
+static uint8_t export_buf[8 + WEB_EXPORT_CHUNK + 2];  //room for the chunk size line and trailing CRLF
+static const uint8_t *export_pending = NULL;  //what of the last chunk the socket hasn't taken yet
+static size_t export_pending_len = 0;
+static bool export_finished = false;          //the pending bytes are the terminating chunk
+static uint32_t export_bytes = 0;
+static unsigned long export_start_ms = 0;
+
+//notices handed from the scale task to the web task for the streams
+enum WebEventType {
+  WEB_EVENT_SIP,
+  WEB_EVENT_SESSION_END
+};
+struct WebEvent {
+  WebEventType type;
+  float grams;          //sip size, or session total for session end
+  float goal;           //session goal for session end
+  uint32_t time_ms;
+};
+//single producer (scale task) / single consumer (web task) ring
+static WebEvent web_events[WEB_EVENT_QUEUE];
+static std::atomic<uint32_t> web_events_head(0);
+static std::atomic<uint32_t> web_events_tail(0);
+
+//pool of client connections the web task services in turn
+struct HttpConn {
+  WiFiClient client;
+  HttpRequest req;              //parser state for the request being read
+  unsigned long last_active;    //millis() of the last byte received
+  bool in_use;
+};
+static HttpConn conns[WEB_MAX_CONNECTIONS];
+
+//listening socket, opened here rather than through WiFiServer so the web task can block on it in select()
+static int listen_fd = -1;
 unsigned long last_isr = 0; //ISR Button debouncing
 
 //WiFi configurations
@@ -21,14 +93,18 @@ void IRAM_ATTR buttonISR() {
     unsigned long now = millis();
     if (now - last_isr > 50) {  // 50ms debounce
         web_request = true;
+        state_notify_from_isr(EVT_WEB_BUTTON);
     }
     last_isr = now;
 }
 
 //function prototypes
-String webserver_read_request(WiFiClient& client);
-void webserver_send_page(WiFiClient &client);
+struct HttpConn;
+static void webserver_release(HttpConn &conn, bool close);
+void webserver_send_page(WiFiClient &client, const HttpRequest &req);
 void set_web_pin_state(uint8_t state);
+static void webserver_listen();
+static void web_on_scale_event(const ScaleEvent *event);
 
 void web_init() {
   pinMode(WEB_STATUS_PIN, OUTPUT);
@@ -38,12 +114,16 @@ void web_init() {
         buttonISR,
         FALLING             
   );
+  events_add_listener(web_on_scale_event);
 }
 
 //turns on website
 void web_enable() {
   if (DEBUG)
     Serial.println("Starting WiFi AP...");
+  //the softAP stops in light sleep, stay awake while it is up
+  power_hold(POWER_HOLD_WEB, true);
+  power_set_level(POWER_RAIL_RADIO, 255, millis());
   WiFi.softAP(ssid, password);
 
   if (DEBUG) {
@@ -52,406 +132,910 @@ void web_enable() {
   }
     
 
-  server.begin();
+  webserver_listen();
   set_web_pin_state(HIGH);
 }
 
 //turns off website
 void web_disable() {
   if (DEBUG) Serial.println("Stopping server and turning off WiFi.");
+  for (int i = 0; i < WEB_SSE_MAX_CLIENTS; i++) {
+    sse_clients[i].stop();
+  }
+  export_client.stop();
+  for (int i = 0; i < WEB_MAX_CONNECTIONS; i++) {
+    if (conns[i].in_use) webserver_release(conns[i], true);
+  }
+  if (listen_fd >= 0) close(listen_fd);
+  listen_fd = -1;
   WiFi.softAPdisconnect(true);
   WiFi.mode(WIFI_OFF);
   set_web_pin_state(LOW);
+  power_set_level(POWER_RAIL_RADIO, 0, millis());
+  power_hold(POWER_HOLD_WEB, false);
 }
 
 
 
-// Read HTTP Request Header
-String webserver_read_request(WiFiClient &client) {
-  String request = "";
-  unsigned long timeout = millis();
+//every byte sent to a client goes through here so /metrics can count it
+static size_t webserver_write(WiFiClient &client, const uint8_t *data, size_t len) {
+  size_t sent = client.write(data, len);
+  metrics_count(METRIC_HTTP_BYTES_SENT, sent);
+  return sent;
+}
 
-  while (client.connected() && millis() - timeout < 2000) {
-    if (client.available()) {
-      char c = client.read();
-      request += c;
+//writes only what the socket takes right now, for the streams and the export so a slow reader can't stall the task
+//returns -1 once the connection is gone
+static int webserver_write_nowait(WiFiClient &client, const uint8_t *data, size_t len) {
+  int n = send(client.fd(), data, len, MSG_DONTWAIT);
+  if (n < 0) return (errno == EAGAIN || errno == EWOULDBLOCK) ? 0 : -1;
+  metrics_count(METRIC_HTTP_BYTES_SENT, n);
+  return n;
+}
 
-      // End of headers (blank line)
-      if (request.endsWith("\r\n\r\n")) {
-        break;
-      }
-    }
+//appends to a body of size bytes that holds n, returns the new length
+//a body that fills up is cut short there instead of being written past its end
+static size_t body_append(char *body, size_t size, size_t n, const char *fmt, ...) __attribute__((format(printf, 4, 5)));
+static size_t body_append(char *body, size_t size, size_t n, const char *fmt, ...) {
+  if (n >= size - 1) return size - 1;
+  va_list args;
+  va_start(args, fmt);
+  int k = vsnprintf(body + n, size - n, fmt, args);
+  va_end(args);
+  if (k < 0) return n;
+  return (n + k < size) ? n + k : size - 1;
+}
+
+//value for the Connection header, the pool keeps the connection if the client asked for it
+static const char *connection_header(const HttpRequest &req) {
+  return req.keep_alive ? "keep-alive" : "close";
+}
+
+//short plain text reply in a single write
+static void webserver_send_text(WiFiClient &client, const HttpRequest &req, const char *status, const char *body) {
+  char buf[160];
+  int len = snprintf(buf, sizeof(buf),
+    "HTTP/1.1 %s\r\n"
+    "Content-Type: text/plain\r\n"
+    "Content-Length: %u\r\n"
+    "Connection: %s\r\n\r\n%s",
+    status, (unsigned)strlen(body), connection_header(req), body);
+  webserver_write(client, (const uint8_t *)buf, len);
+}
+
+//a few segment sized writes instead of one per line
+static void webserver_write_body(WiFiClient &client, const uint8_t *body, size_t len) {
+  for (size_t sent = 0; sent < len; sent += WEB_WRITE_CHUNK) {
+    size_t n = len - sent;
+    if (n > WEB_WRITE_CHUNK) n = WEB_WRITE_CHUNK;
+    webserver_write(client, body + sent, n);
   }
-  return request;
+}
+
+//rebuilds the cached /data body if anything it shows changed since the last build
+static void webserver_update_data_json() {
+  HydrationSnapshot snap;
+  hydration_get_snapshot(&snap);
+  bool waiting = get_state() == STATE_WAITING_USER_INPUT;
+  bool history_changed = history_dirty;
+
+  if (data_json_len > 0 && !history_changed && waiting == data_waiting
+      && snap.goal == data_goal && snap.total_grams == data_total) {
+    return;
+  }
+  history_dirty = false;
+  data_waiting = waiting;
+  data_goal = snap.goal;
+  data_total = snap.total_grams;
+  data_version++;
+  if (history_changed) history_version = data_version;
+
+  data_json_len = data_json_render(data_json, sizeof(data_json), data_version, waiting, snap.goal, snap.total_grams,
+                                   web_entries, web_entry_ids, &data_live_len);
 }
 
 // Handle AJAX data endpoint  (/data)
-void webserver_handle_data(WiFiClient &client) {
-  client.println("HTTP/1.1 200 OK");
-  client.println("Content-Type: application/json");
-  client.println("Connection: close");
-  client.println();
-
-  //when waiting for user input, load in the past session data, and don't display any goal or total water intake readigns
-  if (get_state() == STATE_WAITING_USER_INPUT && refresh_flag == false) {
-      client.println("{\"web_goal_grams\":\"--\",");
-      client.println("\"web_total_grams\":\"--\",");
-      client.print("\"history\":[");
-      for (int i = 0; i < MAX_ENTRIES; i++) {
-        client.print("{\"d\":");
-        client.print(web_entries[i].grams_drank);
-        client.print(",\"g\":");
-        client.print(web_entries[i].goal);
-        client.print(",\"t\":");
-        client.print(web_entries[i].duration);
-        client.print("}");
-        if (i < MAX_ENTRIES - 1) client.print(",");
-      }
-      client.print("],");
-      client.print("\"refresh\":false");
-      client.println("}");
-      return;
+//answers If-None-Match and ?since=<v> with a 304 when nothing changed, and leaves out history the client already has
+void webserver_handle_data(WiFiClient &client, const HttpRequest &req) {
+  webserver_update_data_json();
+
+  char etag[16];
+  snprintf(etag, sizeof(etag), "\"v%lu\"", (unsigned long)data_version);
+
+  long since = -1;
+  http_query_get_long(&req, "since", &since);
+
+  char header[192];
+  int len;
+  if (since == (long)data_version || strcmp(req.if_none_match, etag) == 0) {
+    len = snprintf(header, sizeof(header),
+      "HTTP/1.1 304 Not Modified\r\n"
+      "ETag: %s\r\n"
+      "Connection: %s\r\n\r\n", etag, connection_header(req));
+    webserver_write(client, (const uint8_t *)header, len);
+    return;
   }
-  //pass in goal and water intake measurements
-  client.print("{\"web_goal_grams\":");
-  client.print(web_goal_grams, 1);
-  client.print(",\"web_total_grams\":");
-  client.print(web_total_grams, 1);
 
-  //send historical session data as an array
-  client.print(",\"history\":[");
-  for (int i = 0; i < MAX_ENTRIES; i++) {
-    client.print("{\"d\":");
-    client.print(web_entries[i].grams_drank);
-    client.print(",\"g\":");
-    client.print(web_entries[i].goal);
-    client.print(",\"t\":");
-    client.print(web_entries[i].duration);
-    client.print("}");
-    if (i < MAX_ENTRIES - 1) client.print(",");
-  }
-  //refresh capability
-  client.print("],\"refresh\":");
-  client.print(refresh_flag ? "true" : "false");
-  refresh_flag = false;
-  client.print("}");
-}
-
-//HTML page
-void webserver_send_page(WiFiClient &client) {
-  client.println("HTTP/1.1 200 OK");
-  client.println("Content-Type: text/html");
-  client.println("Connection: close");
-  client.println();
-
-  client.println("<!DOCTYPE html><html>");
-  client.println("<head><title>Hydration Monitor</title></head>");
-  client.println("<body style='font-family:sans-serif; text-align:center;'>");
-  client.println("<h1 style='font-size:48px;'>Hydration Monitor</h1>");
-  client.println("<p style='font-size:10px;'>Your Goal This Session Is <span id='web_goal_grams'>--</span> mL</p>");
-  client.println("<p style='font-size:10px;'>You Drank <span id='web_total_grams'><b>--</b></span> mL This Session</p>");
-
-
-  // Overlay for user input
-  if (get_state() == STATE_WAITING_USER_INPUT) {
-    client.println(R"rawliteral(
-    <style>
-      /* Fullscreen semi-transparent background */
-    #overlay { 
-        position: fixed; 
-        top: 0; left: 0; 
-        width: 100%; height: 100%; 
-        background: rgba(0,0,0,0.6); 
-        display: flex; 
-        justify-content: center; 
-        align-items: center; 
-        z-index: 1000; 
-    }
+  //client is only behind on the live fields, skip the history
+  bool live_only = since >= 0 && (uint32_t)since >= history_version && (uint32_t)since < data_version;
+  size_t body_len = live_only ? data_live_len + 1 : data_json_len;
+
+  len = snprintf(header, sizeof(header),
+    "HTTP/1.1 200 OK\r\n"
+    "Content-Type: application/json\r\n"
+    "Content-Length: %u\r\n"
+    "ETag: %s\r\n"
+    "Cache-Control: no-cache\r\n"
+    "Connection: %s\r\n\r\n", (unsigned)body_len, etag, connection_header(req));
+  webserver_write(client, (const uint8_t *)header, len);
+  webserver_write(client, (const uint8_t *)data_json, data_live_len);
+  if (live_only) {
+    webserver_write(client, (const uint8_t *)"}", 1);
+  }
+  else {
+    webserver_write(client, (const uint8_t *)data_json + data_live_len, data_json_len - data_live_len);
+  }
+}
 
-    /* Centered overlay box */
-    #overlay-box { 
-        background: white; 
-        padding: 60px 50px;       /* bigger padding */
-        border-radius: 20px;      /* slightly more rounded */
-        text-align: center; 
-        min-width: 400px;         /* wider */
-        box-shadow: 0 8px 25px rgba(0,0,0,0.3);
-    }
+//EVENT STREAM (/events) -----------------------------------------------
+
+//queues a notice for the streams, dropped if the web task has fallen behind
+static void web_queue_event(WebEventType type, float grams, float goal) {
+  uint32_t head = web_events_head.load(std::memory_order_relaxed);
+  if (head - web_events_tail.load(std::memory_order_acquire) >= WEB_EVENT_QUEUE) return;
+  WebEvent &e = web_events[head % WEB_EVENT_QUEUE];
+  e.type = type;
+  e.grams = grams;
+  e.goal = goal;
+  e.time_ms = millis();
+  web_events_head.store(head + 1, std::memory_order_release);
+}
 
-    #overlay-box h2 { 
-        margin-bottom: 30px; 
-        font-size: 36px;           /* bigger heading */
-        color: #333; 
+//scale event listener, forwards sips to open streams
+static void web_on_scale_event(const ScaleEvent *event) {
+  if (event->type == EVENT_SIP && event->channel == SCALE_SESSION_CHANNEL && get_state() == STATE_RUNNING) {
+    web_queue_event(WEB_EVENT_SIP, event->grams, 0);
+  }
+}
+
+//writes to every open stream, dropping any that can't keep up
+static void sse_broadcast(const char *buf, size_t len) {
+  for (int i = 0; i < WEB_SSE_MAX_CLIENTS; i++) {
+    if (sse_clients[i] && webserver_write_nowait(sse_clients[i], (const uint8_t *)buf, len) != (int)len) {
+      sse_clients[i].stop();
     }
+  }
+  sse_last_send = millis();
+}
+
+//formats the cached /data body as a "data" event, live fields only unless the history is wanted
+static size_t sse_format_data(bool with_history) {
+  size_t n = snprintf(sse_buf, sizeof(sse_buf), "event: data\ndata: ");
+  size_t body = with_history ? data_json_len : data_live_len;
+  memcpy(sse_buf + n, data_json, body);
+  n += body;
+  if (!with_history) sse_buf[n++] = '}';
+  sse_buf[n++] = '\n';
+  sse_buf[n++] = '\n';
+  return n;
+}
 
-    #overlay-box div { 
-        margin: 20px 0; 
-        font-size: 20px;           /* bigger labels */
-        color: #444; 
+//takes over the connection as a server-sent event stream and sends it the full state
+static void webserver_open_stream(WiFiClient &client) {
+  int slot = -1;
+  for (int i = 0; i < WEB_SSE_MAX_CLIENTS; i++) {
+    if (!sse_clients[i] || !sse_clients[i].connected()) {
+      slot = i;
+      break;
     }
+  }
+  if (slot < 0) {
+    //all slots taken, the page falls back to polling /data
+    const char *busy = "HTTP/1.1 503 Service Unavailable\r\nConnection: close\r\n\r\n";
+    webserver_write(client, (const uint8_t *)busy, strlen(busy));
+    client.stop();
+    return;
+  }
+
+  const char *header =
+    "HTTP/1.1 200 OK\r\n"
+    "Content-Type: text/event-stream\r\n"
+    "Cache-Control: no-cache\r\n"
+    "Connection: keep-alive\r\n\r\n";
+  webserver_write(client, (const uint8_t *)header, strlen(header));
+  webserver_update_data_json();
+  size_t n = sse_format_data(true);
+  webserver_write(client, (const uint8_t *)sse_buf, n);
+  sse_clients[slot] = client;
+}
 
-    #overlay-box input { 
-        width: 180px;              /* bigger input */
-        padding: 12px; 
-        font-size: 20px; 
-        margin-left: 15px; 
-        border: 1px solid #ccc; 
-        border-radius: 6px; 
+//pushes state changes and queued notices to the open streams, returns whether any stream is open
+bool web_push_events() {
+  bool open = false;
+  for (int i = 0; i < WEB_SSE_MAX_CLIENTS; i++) {
+    if (sse_clients[i] && !sse_clients[i].connected()) sse_clients[i].stop();
+    if (sse_clients[i]) open = true;
+  }
+
+  //notices first so the page sees a sip before the total it produced
+  uint32_t tail = web_events_tail.load(std::memory_order_relaxed);
+  while (tail != web_events_head.load(std::memory_order_acquire)) {
+    const WebEvent &e = web_events[tail % WEB_EVENT_QUEUE];
+    if (open) {
+      int n;
+      if (e.type == WEB_EVENT_SIP) {
+        n = snprintf(sse_buf, sizeof(sse_buf), "event: sip\ndata: {\"grams\":%.1f,\"t\":%lu}\n\n",
+                     e.grams, (unsigned long)e.time_ms);
+      }
+      else {
+        n = snprintf(sse_buf, sizeof(sse_buf), "event: session_end\ndata: {\"d\":%.1f,\"g\":%.1f}\n\n",
+                     e.grams, e.goal);
+      }
+      sse_broadcast(sse_buf, n);
     }
+    tail++;
+    web_events_tail.store(tail, std::memory_order_release);
+  }
+  if (!open) return false;
+
+  webserver_update_data_json();
+  if (data_version != sse_version) {
+    size_t n = sse_format_data(history_version > sse_version);
+    sse_broadcast(sse_buf, n);
+    sse_version = data_version;
+  }
+  //comment line keeps idle connections open and finds dead ones
+  else if (millis() - sse_last_send > WEB_SSE_PING_MS) {
+    sse_broadcast(": ping\n\n", 8);
+  }
+  return true;
+}
+
+//called by the scale task when a session finishes
+void web_session_ended(float total_grams, float goal_grams) {
+  web_queue_event(WEB_EVENT_SESSION_END, total_grams, goal_grams);
+}
 
-    #overlay-box button { 
-        margin-top: 30px; 
-        padding: 15px 35px;        /* bigger button */
-        font-size: 20px; 
-        background-color: white; 
-        color: black; 
-        border: 2px solid black; 
-        border-radius: 10px; 
-        cursor: pointer; 
+//HTML page, served gzipped straight from flash (see web/ and tools/build_web_assets.py)
+void webserver_send_page(WiFiClient &client, const HttpRequest &req) {
+  char header[192];
+  int len;
+
+  //browser already has this build of the page
+  if (strcmp(req.if_none_match, WEB_INDEX_ETAG) == 0) {
+    len = snprintf(header, sizeof(header),
+      "HTTP/1.1 304 Not Modified\r\n"
+      "ETag: " WEB_INDEX_ETAG "\r\n"
+      "Connection: %s\r\n\r\n", connection_header(req));
+    webserver_write(client, (const uint8_t *)header, len);
+    return;
+  }
+
+  len = snprintf(header, sizeof(header),
+    "HTTP/1.1 200 OK\r\n"
+    "Content-Type: text/html\r\n"
+    "Content-Encoding: gzip\r\n"
+    "Content-Length: %u\r\n"
+    "ETag: " WEB_INDEX_ETAG "\r\n"
+    "Cache-Control: no-cache\r\n"
+    "Connection: %s\r\n\r\n",
+    (unsigned)WEB_INDEX_GZ_LEN, connection_header(req));
+  webserver_write(client, (const uint8_t *)header, len);
+
+  webserver_write_body(client, WEB_INDEX_GZ, WEB_INDEX_GZ_LEN);
+}
+
+//HTML for reset button, which resets the past session entries
+static void webserver_handle_action(WiFiClient &client, const HttpRequest &req) {
+  storage_reset_entries();
+  webserver_send_text(client, req, "200 OK", "Action completed.");
+}
+
+// Handle goal/duration update
+static void webserver_handle_set_goal(WiFiClient &client, const HttpRequest &req) {
+  long duration;
+  float goal;
+  if (!http_query_get_float(&req, "goal", &goal) || !http_query_get_long(&req, "duration", &duration)
+      || goal <= 0 || duration <= 0) {
+    webserver_send_text(client, req, "400 Bad Request", "goal and duration are required.");
+    return;
+  }
+
+  //the phone's clock, the device has no other way to know which day it is
+  long now, tz = 0;
+  if (http_query_get_long(&req, "now", &now) && now > 0) {
+    http_query_get_long(&req, "tz", &tz);
+    storage_set_clock((uint32_t)now, (int16_t)tz);
+  }
+
+  //optional pacing curve, linear unless the overlay picked another
+  char curve_name[8];
+  PacingCurve curve = PACING_DEFAULT_CURVE;
+  if (http_query_get(&req, "curve", curve_name, sizeof(curve_name)) && !pacing_parse_curve(curve_name, &curve)) {
+    webserver_send_text(client, req, "400 Bad Request", "unknown curve.");
+    return;
+  }
+
+  //pass in user input for goal and session duration for hydration.cpp calculations
+  set_pacing_curve(curve);
+  set_goal(goal);
+  set_time_length(duration);
+  reset();  //necessary for hydration.cpp to lock in new user input values
+  set_state(STATE_RUNNING);  //state should be running to unlock rest of system
+  webserver_send_text(client, req, "200 OK", "Goal and duration updated.");
+}
+
+//duty cycle and estimated current of each rail since boot, and the battery life that works out to
+static void webserver_handle_power(WiFiClient &client, const HttpRequest &req) {
+  PowerReport report;
+  power_get_report(millis(), &report);
+
+  char body[WEB_POWER_JSON_SIZE];
+  size_t n = body_append(body, sizeof(body), 0,
+    "{\"uptime_s\":%lu,\"sleep\":%s,\"sleeps\":%lu,\"slept_s\":%lu,\"avg_ma\":%.2f,\"battery_h\":%.1f,\"rails\":{",
+    (unsigned long)(report.uptime_ms / 1000), report.sleep_enabled ? "true" : "false", (unsigned long)report.sleeps,
+    (unsigned long)(report.slept_ms / 1000), report.avg_ma, report.battery_hours);
+  for (int i = 0; i < POWER_RAIL_COUNT; i++) {
+    n = body_append(body, sizeof(body), n, "%s\"%s\":{\"duty\":%u,\"ma\":%.2f}", i ? "," : "",
+                    power_rail_name((PowerRail)i), report.rails[i].duty_permille, report.rails[i].avg_ma);
+  }
+  n = body_append(body, sizeof(body), n, "}}");
+
+  char header[160];
+  int len = snprintf(header, sizeof(header),
+    "HTTP/1.1 200 OK\r\n"
+    "Content-Type: application/json\r\n"
+    "Content-Length: %u\r\n"
+    "Cache-Control: no-cache\r\n"
+    "Connection: %s\r\n\r\n", (unsigned)n, connection_header(req));
+  webserver_write(client, (const uint8_t *)header, len);
+  webserver_write(client, (const uint8_t *)body, n);
+}
+
+//counters, histograms, stacks and heap in Prometheus text format, rendered a chunk at a time
+static void webserver_handle_metrics(WiFiClient &client, const HttpRequest &req) {
+  static MetricsSnapshot snap;
+  static char chunk[WEB_METRICS_CHUNK];
+  metrics_snapshot(&snap);
+
+  //one pass with no room to find the length, then the page a chunk at a time
+  size_t total = 0;
+  for (size_t n; (n = metrics_render(&snap, chunk, sizeof(chunk), total)) > 0; ) total += n;
+
+  char header[192];
+  int len = snprintf(header, sizeof(header),
+    "HTTP/1.1 200 OK\r\n"
+    "Content-Type: text/plain; version=0.0.4\r\n"
+    "Content-Length: %u\r\n"
+    "Cache-Control: no-cache\r\n"
+    "Connection: %s\r\n\r\n", (unsigned)total, connection_header(req));
+  webserver_write(client, (const uint8_t *)header, len);
+  for (size_t sent = 0; sent < total; ) {
+    size_t n = metrics_render(&snap, chunk, sizeof(chunk), sent);
+    if (n == 0) break;
+    webserver_write(client, (const uint8_t *)chunk, n);
+    sent += n;
+  }
+}
+
+//holds back hydration alerts for minutes (default SPEAKER_SNOOZE_MS), minutes=0 just ends the current pattern
+static void webserver_handle_snooze(WiFiClient &client, const HttpRequest &req) {
+  long minutes = SPEAKER_SNOOZE_MS / 60000;
+  http_query_get_long(&req, "minutes", &minutes);
+  if (minutes < 0 || minutes > 24 * 60) {
+    webserver_send_text(client, req, "400 Bad Request", "minutes must be 0 to 1440.");
+    return;
+  }
+  speaker_stop();
+  if (minutes > 0) speaker_snooze((uint32_t)minutes * 60000);
+  webserver_send_text(client, req, "200 OK", "Alerts snoozed.");
+}
+
+//quiet hours as local minutes of the day, start=end turns them off
+static void webserver_handle_quiet(WiFiClient &client, const HttpRequest &req) {
+  long start, end;
+  if (!http_query_get_long(&req, "start", &start) || !http_query_get_long(&req, "end", &end)
+      || start < 0 || start >= 24 * 60 || end < 0 || end >= 24 * 60) {
+    webserver_send_text(client, req, "400 Bad Request", "start and end are minutes 0 to 1439.");
+    return;
+  }
+  speaker_set_quiet_hours(start, end);
+  webserver_send_text(client, req, "200 OK", "Quiet hours updated.");
+}
+
+//reads the optional ch parameter, the session channel when it's missing, false if it names no channel
+static bool webserver_get_channel(const HttpRequest &req, uint8_t *channel) {
+  long ch = SCALE_SESSION_CHANNEL;
+  http_query_get_long(&req, "ch", &ch);
+  if (ch < 0 || ch >= SCALE_CHANNELS) return false;
+  *channel = ch;
+  return true;
+}
+
+//action=tare zeroes an empty plate, grams=N learns the scale factor from N grams on the plate, ch picks the scale channel
+//both average the next few conversions, the reply is the channel's calibration as it stands
+static void webserver_handle_calibrate(WiFiClient &client, const HttpRequest &req) {
+  char action[8];
+  float grams;
+  uint8_t ch;
+  if (!webserver_get_channel(req, &ch)) {
+    webserver_send_text(client, req, "400 Bad Request", "no such channel.");
+    return;
+  }
+  if (http_query_get(&req, "action", action, sizeof(action))) {
+    if (strcmp(action, "tare") != 0) {
+      webserver_send_text(client, req, "400 Bad Request", "unknown action.");
+      return;
+    }
+    if (!calibration_request_tare(ch)) {
+      webserver_send_text(client, req, "409 Conflict", "calibration already running.");
+      return;
     }
-    </style>
-
-    <div id='overlay'>
-  <div id='overlay-box'>
-    <h2>Set Session Goal</h2>
-
-    <div style='margin-top:10px; font-size:20px; display:flex; align-items:center; gap:10px; justify-content:center;'>
-  <label style='font-size:20px;'>Duration:</label>
-
-  <!-- Hours input -->
-  <input 
-    type='number' 
-    id='inputHours' 
-    min='0'
-    max='24'
-    oninput='checkInputs()'
-    style='width:70px; border:none; border-bottom:2px solid black; text-align:center; font-size:20px; outline:none;'>
-  <span style='font-size:20px;'>hr</span>
-
-  <!-- Minutes input -->
-  <input 
-    type='number' 
-    id='inputMinutes' 
-    min='0'
-    max='59'
-    oninput='checkInputs()'
-    style='width:70px; border:none; border-bottom:2px solid black; text-align:center; font-size:20px; outline:none;'>
-  <span style='font-size:20px;'>min</span>
-
-  <!-- Seconds input -->
-  <input 
-    type='number' 
-    id='inputSeconds' 
-    min='0'
-    max='59'
-    oninput='checkInputs()'
-    style='width:70px; border:none; border-bottom:2px solid black; text-align:center; font-size:20px; outline:none;'>
-  <span style='font-size:20px;'>s</span>
-  </div>
-
-  <div style='margin-top:25px; font-size:20px; display:flex; align-items:center; gap:10px; justify-content:center;'>
-    <label style='font-size:20px;'>Goal (mL):</label>
-    <input 
-      type='number' 
-      id='inputGoal' 
-      min='100'
-      oninput='checkInputs()'
-      style='width:120px; border:none; border-bottom:2px solid black; text-align:center; font-size:20px; outline:none;'>
-  </div>
-
-      <button id='submitBtn' onclick='submitOverlay()' disabled>Enter</button>
-    </div>
-  </div>
-
-  <script>
-  function checkInputs() {
-    const h = document.getElementById('inputHours').value;
-    const m = document.getElementById('inputMinutes').value;
-    const s = document.getElementById('inputSeconds').value;
-    const g = document.getElementById('inputGoal').value;
-
-    const btn = document.getElementById('submitBtn');
-
-    // Enable button only if all fields are non-empty
-    if ((h + m + s) > 0 && g > 0) {
-      btn.disabled = false;
-    } else {
-      btn.disabled = true;
+  }
+  else if (http_query_get_float(&req, "grams", &grams)) {
+    if (grams < CAL_MIN_REFERENCE_G) {
+      webserver_send_text(client, req, "400 Bad Request", "reference weight too small.");
+      return;
+    }
+    if (!calibration_request_reference(ch, grams)) {
+      webserver_send_text(client, req, "409 Conflict", "tare first, or wait for the running calibration.");
+      return;
     }
   }
 
-  function submitOverlay() {
-    const hr = parseInt(document.getElementById('inputHours').value) || 0;
-    const min = parseInt(document.getElementById('inputMinutes').value) || 0;
-    const sec = parseInt(document.getElementById('inputSeconds').value) || 0;
+  static const char *const state_names[] = { "idle", "tare", "reference" };
+  static const char *const error_names[] = { "none", "no_load", "wrong_sign" };
+  CalibrationStatus status;
+  calibration_get_status(ch, &status);
+  char body[224];
+  int n = snprintf(body, sizeof(body),
+    "{\"ch\":%u,\"state\":\"%s\",\"error\":\"%s\",\"stored\":%s,\"offset\":%ld,\"counts_per_gram\":%.4f,\"zero_drift_g\":%.2f,\"creep_g\":%.2f}",
+    (unsigned)ch, state_names[status.state], error_names[status.error], status.stored ? "true" : "false", (long)status.data.offset,
+    status.data.counts_per_gram, status.zero_drift_g, status.creep_g);
+  if (n >= (int)sizeof(body)) n = sizeof(body) - 1;
+
+  char header[160];
+  int len = snprintf(header, sizeof(header),
+    "HTTP/1.1 200 OK\r\n"
+    "Content-Type: application/json\r\n"
+    "Content-Length: %u\r\n"
+    "Cache-Control: no-cache\r\n"
+    "Connection: %s\r\n\r\n", (unsigned)n, connection_header(req));
+  webserver_write(client, (const uint8_t *)header, len);
+  webserver_write(client, (const uint8_t *)body, n);
+}
 
-    // Convert to total seconds
-    const totalDuration = hr * 3600 + min * 60 + sec;
+//every scale channel: settled weight, intake this session, and what sampling it costs
+static void webserver_handle_channels(WiFiClient &client, const HttpRequest &req) {
+  uint32_t now = millis();
+  float cycles_per_ms = getCpuFrequencyMhz() * 1000.0f;
+  char *body = channels_json;
+  const size_t size = sizeof(channels_json);
+  size_t n = body_append(body, size, 0, "{\"session_ch\":%u,\"channels\":[", (unsigned)SCALE_SESSION_CHANNEL);
+  for (uint8_t ch = 0; ch < SCALE_CHANNELS; ch++) {
+    float weight;
+    bool settled = scale_get_settled_weight(ch, &weight);
+    ChannelTally tally;
+    tracker_get_tally(ch, &tally);
+    ScaleChannelStats stats;
+    scale_get_channel_stats(ch, &stats);
+    //rate and CPU share are averages since boot, us per sample covers the clock burst share, calibration and filters
+    float sps = now ? stats.samples * 1000.0f / now : 0;
+    float us_per_sample = stats.samples ? stats.cycles / (cycles_per_ms / 1000.0f) / stats.samples : 0;
+    float cpu_permille = now ? stats.cycles / (cycles_per_ms * now) * 1000.0f : 0;
+    n = body_append(body, size, n, "%s{\"ch\":%u,\"grams\":", ch ? "," : "", (unsigned)ch);
+    if (settled) n = body_append(body, size, n, "%.1f", weight);
+    else n = body_append(body, size, n, "null");
+    n = body_append(body, size, n,
+                  ",\"intake_grams\":%.1f,\"sips\":%lu,\"samples\":%lu,\"sps\":%.2f,\"us_per_sample\":%.1f,\"cpu_permille\":%.3f}",
+                  tally.intake_grams, (unsigned long)tally.sips, (unsigned long)stats.samples, sps, us_per_sample, cpu_permille);
+  }
+  n = body_append(body, size, n, "]}");
+
+  char header[160];
+  int len = snprintf(header, sizeof(header),
+    "HTTP/1.1 200 OK\r\n"
+    "Content-Type: application/json\r\n"
+    "Content-Length: %u\r\n"
+    "Cache-Control: no-cache\r\n"
+    "Connection: %s\r\n\r\n", (unsigned)n, connection_header(req));
+  webserver_write(client, (const uint8_t *)header, len);
+  webserver_write(client, (const uint8_t *)body, n);
+}
 
-    const goal = document.getElementById('inputGoal').value;
-    document.getElementById('overlay').style.display='none';
+//intake and pacer curve of one session, session=0 is the running one
+//from and to are seconds into the session, the reply never has more than points (at most SERIES_MAX_BUCKETS) entries
+static void webserver_handle_series(WiFiClient &client, const HttpRequest &req) {
+  long session, from = 0, to = -1, points = SERIES_MAX_BUCKETS;
+  if (!http_query_get_long(&req, "session", &session) || session < 0) {
+    webserver_send_text(client, req, "400 Bad Request", "session is required.");
+    return;
+  }
+  http_query_get_long(&req, "from", &from);
+  http_query_get_long(&req, "to", &to);
+  http_query_get_long(&req, "points", &points);
+  if (points < 1 || points > SERIES_MAX_BUCKETS) points = SERIES_MAX_BUCKETS;
+  if (from < 0) from = 0;
+  //seconds past what a uint32_t of milliseconds holds would wrap round to the start of the session
+  if (from > (long)(UINT32_MAX / 1000)) from = UINT32_MAX / 1000;
+  if (to > (long)(UINT32_MAX / 1000)) to = UINT32_MAX / 1000;
+
+  bool found = (session == 0) ? series_get_live(&series_data) : series_load(session, &series_data);
+  if (!found) {
+    webserver_send_text(client, req, "404 Not Found", "No series for that session.");
+    return;
+  }
 
-    fetch(`/set_goal?duration=${totalDuration}&goal=${goal}`)
-      .then(r => r.text())
-      .then(d => console.log(d));
-    }
-    </script>
-    )rawliteral");
-  }
-
-  //Hydration circle
-  client.println(R"rawliteral(
-  <div style='margin:20px auto; width:300;'>
-    <svg id='hydrationCircle' viewBox='0 0 36 36' style='width:300px; height:300px;'>
-      <!-- Background circle (uncovered portion) -->
-      <path stroke='#00aaff' stroke-opacity='0.2' stroke-width='4' fill='none'
-            d='M18 2 a 16 16 0 1 1 0 32 a 16 16 0 1 1 0 -32'></path>
-
-      <!-- Progress circle (covered portion) -->
-      <path id='hydrationProgress' stroke='#00aaff' stroke-width='4' fill='none'
-            stroke-linecap='round' stroke-dasharray='0,100'
-            d='M18 2 a 16 16 0 1 1 0 32 a 16 16 0 1 1 0 -32'></path>
-
-      <!-- Center text -->
-      <text id='hydrationText' x='18' y='20' font-size='8' text-anchor='middle' fill='#000'>0%</text>
-    </svg>
-    <div id='hydrationAmount' style='font-size:20px; font-weight:bold; margin-top:10px;'>0 mL</div>
-  </div>
-
-  <script>
-  function updateHydrationCircle(percent, amount){
-    const circle = document.getElementById('hydrationProgress');
-    const text = document.getElementById('hydrationText');
-    // percent between 0 and 100
-    circle.setAttribute('stroke-dasharray', percent + ',100');
-    text.textContent = percent + '%';
-    document.getElementById('hydrationAmount').textContent = amount + ' mL';
-  }
-  </script>
-  )rawliteral");
-
-  // Past session data
-  client.println("<div style='margin-top:30px;'></div>");
-  client.println("<h2 style='font-size:36px;'>Your Past 7 Sessions</h2>");  
-  client.println("<div id='historyCards' style='width:80%; margin:20px auto;'></div>");
-  client.println("<button onclick=\"fetch('/action')\" style='padding:15px 30px; font-size:30px; background-color:white; border:2px solid #000000; border-radius:12px; cursor:pointer;'>Reset History</button>");
-
-  // AJAX update
-  client.println(R"rawliteral(
-  <script>
-  setInterval(function(){
-    fetch('/data')
-      .then(r => r.json())
-      .then(d => {
-        document.getElementById('web_goal_grams').innerHTML = d.web_goal_grams;
-        document.getElementById('web_total_grams').innerHTML = '<b>' + d.web_total_grams + '</b>';
-        if(d.refresh) location.reload();
-        let cardsHTML='';
-        for(let i=0;i<d.history.length;i++){
-          const bgColor =
-          (d.history[i].d === 0 && d.history[i].g === 0)
-            ? '#ffffff'
-            : (d.history[i].d < d.history[i].g)
-              ? '#ffe6e6'
-              : '#e6ffe6';
-          cardsHTML += `<div style='border:1px solid black;border-radius:10px;padding:12px;margin-bottom:20px;background:${bgColor};'>
-            <div><b>Session Length:</b> ${d.history[i].t} s</div>
-            <div><b>Drank:</b> ${d.history[i].d} mL</div>
-            <div><b>Goal:</b> ${d.history[i].g} mL</div>
-          </div>`;
-        }
-        document.getElementById('historyCards').innerHTML = cardsHTML;
-        let pct = Math.round((d.web_total_grams / d.web_goal_grams) * 100);
-        updateHydrationCircle(pct || 0, d.web_total_grams);
-      });
-  },1000);
-  </script>
-  )rawliteral");
+  uint32_t to_ms = (to < 0) ? UINT32_MAX : (uint32_t)to * 1000;
+  uint16_t count = series_query(&series_data, (uint32_t)from * 1000, to_ms, points, series_points);
 
-  client.println("</body></html>");
+  //points are [seconds, intake min, intake max, pacer min, pacer max]
+  size_t n = body_append(series_json, sizeof(series_json), 0, "{\"session\":%ld,\"bucket_s\":%lu,\"points\":[",
+                         session, (unsigned long)(series_data.bucket_ms / 1000));
+  for (uint16_t i = 0; i < count; i++) {
+    const SeriesBucket &v = series_points[i].value;
+    n = body_append(series_json, sizeof(series_json), n, "%s[%lu,%u,%u,%u,%u]", (i > 0) ? "," : "",
+                    (unsigned long)(series_points[i].time_ms / 1000), v.intake_min, v.intake_max, v.pacer_min, v.pacer_max);
+  }
+  n = body_append(series_json, sizeof(series_json), n, "]}");
+
+  char header[160];
+  int len = snprintf(header, sizeof(header),
+    "HTTP/1.1 200 OK\r\n"
+    "Content-Type: application/json\r\n"
+    "Content-Length: %u\r\n"
+    "Cache-Control: no-cache\r\n"
+    "Connection: %s\r\n\r\n", (unsigned)n, connection_header(req));
+  webserver_write(client, (const uint8_t *)header, len);
+  webserver_write_body(client, (const uint8_t *)series_json, n);
 }
 
-//main webserver handler
-bool webserver_handle_client() {
-  WiFiClient client = server.available();
-  if (!client) return false;
+//rollups kept by storage, reading them is constant work however long the history is
+static void webserver_handle_stats(WiFiClient &client, const HttpRequest &req) {
+  StatsRollup stats;
+  int32_t today;
+  storage_get_stats(&stats, &today);
 
-  // Read request
-  String request = webserver_read_request(client);
+  char body[WEB_STATS_JSON_SIZE];
+  size_t n = body_append(body, sizeof(body), 0, "{\"clock\":%s,\"days\":[", (today >= 0) ? "true" : "false");
+  for (int i = 0; i < STATS_DAYS; i++) {
+    n = body_append(body, sizeof(body), n, "%s%lu", i ? "," : "", (unsigned long)entry_quantise_ml(stats.day_ml[i]));
+  }
+  n = body_append(body, sizeof(body), n, "],\"weeks\":[");
+  for (int i = 0; i < STATS_WEEKS; i++) {
+    n = body_append(body, sizeof(body), n, "%s%lu", i ? "," : "", (unsigned long)entry_quantise_ml(stats.week_ml[i]));
+  }
+  //pace is mL per hour of session time
+  n = body_append(body, sizeof(body), n,
+    "],\"sessions\":%lu,\"goals_hit\":%lu,\"goal_hit_rate\":%.2f,\"avg_pace\":%.0f,\"streak\":%u,\"longest_streak\":%u}",
+    (unsigned long)stats.sessions, (unsigned long)stats.goals_hit,
+    stats.sessions ? (float)stats.goals_hit / stats.sessions : 0.0f,
+    stats.total_s ? stats.total_ml * 3600.0f / stats.total_s : 0.0f,
+    (today >= 0) ? stats_current_streak(&stats, today) : stats.streak, stats.longest_streak);
+
+  char header[160];
+  int len = snprintf(header, sizeof(header),
+    "HTTP/1.1 200 OK\r\n"
+    "Content-Type: application/json\r\n"
+    "Content-Length: %u\r\n"
+    "Cache-Control: no-cache\r\n"
+    "Connection: %s\r\n\r\n", (unsigned)n, connection_header(req));
+  webserver_write(client, (const uint8_t *)header, len);
+  webserver_write(client, (const uint8_t *)body, n);
+}
 
-  // AJAX endpoint
-  if (request.indexOf("GET /data") >= 0) {
-    webserver_handle_data(client);
+//full history straight from the journal, format=csv|ndjson|bin, sent with chunked transfer encoding
+static void webserver_handle_export(WiFiClient &client, const HttpRequest &req) {
+  char name[8] = "csv";
+  ExportFormat format;
+  http_query_get(&req, "format", name, sizeof(name));
+  if (!exporter_parse_format(name, &format)) {
+    webserver_send_text(client, req, "400 Bad Request", "format must be csv, ndjson or bin.");
     client.stop();
-    return true;
-  }
-
-  //HTML for reset button, which resets the past session entries
-  if (request.indexOf("GET /action") >= 0) {
-      storage_reset_entries();
-      client.println("HTTP/1.1 200 OK");
-      client.println("Content-Type: text/plain");
-      client.println("Connection: close");
-      client.println();
-      client.println("Action completed.");
-      client.stop();
-      return true;
+    return;
+  }
+  if (export_client.connected()) {
+    webserver_send_text(client, req, "503 Service Unavailable", "Export already running.");
+    client.stop();
+    return;
   }
 
-  // Handle goal/duration update
-  if (request.indexOf("GET /set_goal") >= 0) {
-    // Parse query parameters
-    int idxGoal = request.indexOf("goal=");
-    int idxDuration = request.indexOf("duration=");
-    if (idxGoal >= 0 && idxDuration >= 0) {
-      float goal = request.substring(idxGoal + 5, request.indexOf('&', idxGoal)).toFloat();
-      float duration = request.substring(idxDuration + 9, request.indexOf(' ', idxDuration)).toFloat();
-      
-      //pass in user input for goal and session duration for hydration.cpp calculations
-      set_goal(goal);
-      set_time_length(duration);
-      reset();  //necessary for hydration.cpp to lock in new user input values
-      set_state(STATE_RUNNING);  //state should be running to unlock rest of system
-
-      client.println("HTTP/1.1 200 OK");
-      client.println("Content-Type: text/plain");
-      client.println("Connection: close");
-      client.println();
-      client.println("Goal and duration updated.");
-      client.stop();
-      return true;
+  static const char *types[] = { "text/csv", "application/x-ndjson", "application/octet-stream" };
+  char header[224];
+  int len = snprintf(header, sizeof(header),
+    "HTTP/1.1 200 OK\r\n"
+    "Content-Type: %s\r\n"
+    "Content-Disposition: attachment; filename=\"hydration.%s\"\r\n"
+    "Transfer-Encoding: chunked\r\n"
+    "Connection: close\r\n\r\n", types[format], name);
+  webserver_write(client, (const uint8_t *)header, len);
+
+  exporter_begin(&exporter, format);
+  export_client = client;
+  export_pending_len = 0;
+  export_finished = false;
+  export_bytes = 0;
+  export_start_ms = millis();
+}
+
+//writes the next few chunks of a running export, returns whether one is running
+//a chunk the socket only took part of is finished first, select() wakes the task once there is room for it
+static bool web_pump_export() {
+  if (!export_client) return false;
+  if (!export_client.connected()) {
+    export_client.stop();
+    return false;
+  }
+
+  for (int i = 0; i < WEB_EXPORT_CHUNKS_PER_PASS; i++) {
+    if (export_pending_len == 0) {
+      if (export_finished) {
+        export_client.stop();
+        unsigned long ms = millis() - export_start_ms;
+        metrics_count(METRIC_EXPORT_BYTES, export_bytes);
+        metrics_count(METRIC_EXPORT_MS, ms);
+        if (DEBUG) {
+          Serial.print("export done bytes=");
+          Serial.print(export_bytes);
+          Serial.print(" ms=");
+          Serial.println(ms);
+        }
+        return false;
+      }
+
+      size_t n = exporter_read(&exporter, export_buf + 8, WEB_EXPORT_CHUNK);
+      if (n == 0) {
+        export_pending = (const uint8_t *)"0\r\n\r\n";
+        export_pending_len = 5;
+        export_finished = true;
+      }
+      else {
+        //size line goes right in front of the data so each chunk is one write
+        char size_line[9];
+        int k = snprintf(size_line, sizeof(size_line), "%x\r\n", (unsigned)n);
+        uint8_t *start = export_buf + 8 - k;
+        memcpy(start, size_line, k);
+        export_buf[8 + n] = '\r';
+        export_buf[8 + n + 1] = '\n';
+        export_pending = start;
+        export_pending_len = k + n + 2;
+        export_bytes += n;
+      }
+    }
+
+    int sent = webserver_write_nowait(export_client, export_pending, export_pending_len);
+    if (sent < 0) {
+      export_client.stop();
+      return false;
+    }
+    export_pending += sent;
+    export_pending_len -= sent;
+    if (export_pending_len > 0) break;
+  }
+  return true;
+}
+
+// live event stream, the connection stays open
+static void webserver_handle_events(WiFiClient &client, const HttpRequest &req) {
+  webserver_open_stream(client);
+}
+
+typedef void (*HttpHandler)(WiFiClient &client, const HttpRequest &req);
+
+struct HttpRoute {
+  const char *method;
+  const char *path;
+  HttpHandler handler;
+  bool keep_open;   //handler took over the connection
+};
+
+static const HttpRoute routes[] = {
+  { "GET", "/",         webserver_send_page,       false },
+  { "GET", "/data",     webserver_handle_data,     false },
+  { "GET", "/events",   webserver_handle_events,   true },
+  { "GET", "/action",   webserver_handle_action,   false },
+  { "GET", "/set_goal", webserver_handle_set_goal, false },
+  { "GET", "/series",   webserver_handle_series,   false },
+  { "GET", "/stats",    webserver_handle_stats,    false },
+  { "GET", "/power",    webserver_handle_power,    false },
+  { "GET", "/metrics",  webserver_handle_metrics,  false },
+  { "GET", "/snooze",   webserver_handle_snooze,   false },
+  { "GET", "/quiet",    webserver_handle_quiet,    false },
+  { "GET", "/calibrate", webserver_handle_calibrate, false },
+  { "GET", "/channels", webserver_handle_channels,  false },
+  { "GET", "/export",   webserver_handle_export,   true },
+};
+
+//what happens to a pooled connection after a request is answered
+enum ConnNext {
+  CONN_KEEP,        //keep-alive, wait for the next request
+  CONN_CLOSE,       //close the socket
+  CONN_HANDED_OFF   //a handler took the socket over, let go of it without closing
+};
+
+//answers one parsed request
+static ConnNext webserver_dispatch(WiFiClient &client, HttpRequest &req) {
+  for (size_t i = 0; i < sizeof(routes) / sizeof(routes[0]); i++) {
+    if (strcmp(req.path, routes[i].path) == 0 && strcmp(req.method, routes[i].method) == 0) {
+      uint32_t start = metrics_cycles();
+      routes[i].handler(client, req);
+      metrics_record_since(METRIC_HTTP_TIME, start);
+      metrics_count(METRIC_HTTP_REQUESTS);
+      if (routes[i].keep_open) return CONN_HANDED_OFF;
+      return req.keep_alive ? CONN_KEEP : CONN_CLOSE;
     }
   }
-  //--------------------------------------------------
-  // Main HTML page
-  //--------------------------------------------------
-  webserver_send_page(client);
-  client.stop();
+  metrics_count(METRIC_HTTP_REQUESTS);
+  webserver_send_text(client, req, "404 Not Found", "Not found.");
+  return req.keep_alive ? CONN_KEEP : CONN_CLOSE;
+}
 
+//frees a pool slot, closing the socket unless a handler took it over
+static void webserver_release(HttpConn &conn, bool close) {
+  if (close) conn.client.stop();
+  conn.client = WiFiClient();
+  conn.in_use = false;
   if (DEBUG) Serial.println("Client disconnected.");
 }
 
-//GETTERS AND SETTERS
-bool get_web_request() {
-  return web_request;
+//reads whatever a connection has waiting and answers any complete requests, never blocks
+static bool webserver_service(HttpConn &conn, unsigned long now) {
+  char buf[128];
+  bool served = false;
+
+  int available = conn.client.available();
+  if (available <= 0) {
+    //peer went away, or sat idle (or mid header) for too long
+    unsigned long limit = (conn.req.header_bytes > 0) ? HTTP_READ_TIMEOUT_MS : WEB_KEEPALIVE_MS;
+    if (!conn.client.connected() || now - conn.last_active > limit) {
+      webserver_release(conn, true);
+    }
+    return false;
+  }
+
+  int n = conn.client.read((uint8_t *)buf, (available < (int)sizeof(buf)) ? available : sizeof(buf));
+  if (n <= 0) return false;
+  conn.last_active = now;
+
+  //a read can hold the end of one request and the start of the next
+  size_t off = 0;
+  while (off < (size_t)n) {
+    size_t used;
+    HttpParseResult result = http_request_feed(&conn.req, buf + off, n - off, &used);
+    off += used;
+    if (result == HTTP_PARSE_MORE) break;
+
+    if (result != HTTP_PARSE_DONE) {
+      conn.req.keep_alive = false;
+      webserver_send_text(conn.client, conn.req,
+        (result == HTTP_PARSE_TOO_LARGE) ? "431 Request Header Fields Too Large" : "400 Bad Request", "");
+      webserver_release(conn, true);
+      return true;
+    }
+
+    ConnNext next = webserver_dispatch(conn.client, conn.req);
+    served = true;
+    if (next != CONN_KEEP) {
+      webserver_release(conn, next == CONN_CLOSE);
+      return true;
+    }
+    http_request_init(&conn.req);
+  }
+  return served;
 }
 
-void set_refresh_flag(bool v) {
-  refresh_flag = v;
+//opens the listening socket, non-blocking so accept() only takes what is already waiting
+static void webserver_listen() {
+  if (listen_fd >= 0) return;
+  listen_fd = socket(AF_INET, SOCK_STREAM, 0);
+  if (listen_fd < 0) return;
+  int on = 1;
+  setsockopt(listen_fd, SOL_SOCKET, SO_REUSEADDR, &on, sizeof(on));
+  struct sockaddr_in addr = {};
+  addr.sin_family = AF_INET;
+  addr.sin_addr.s_addr = htonl(INADDR_ANY);
+  addr.sin_port = htons(WEB_PORT);
+  if (bind(listen_fd, (struct sockaddr *)&addr, sizeof(addr)) < 0 || listen(listen_fd, WEB_LISTEN_BACKLOG) < 0) {
+    if (DEBUG) Serial.println("web server could not listen");
+    close(listen_fd);
+    listen_fd = -1;
+    return;
+  }
+  fcntl(listen_fd, F_SETFL, fcntl(listen_fd, F_GETFL, 0) | O_NONBLOCK);
 }
 
-void set_goal_grams(float goal_grams_param) {
-  web_goal_grams = goal_grams_param;
+//a connection waiting in the backlog, or an empty client
+static WiFiClient webserver_accept() {
+  if (listen_fd < 0) return WiFiClient();
+  int fd = accept(listen_fd, NULL, NULL);
+  if (fd < 0) return WiFiClient();
+  return WiFiClient(fd);
 }
 
-void set_total_grams(float total_grams_param) {
-  web_total_grams = total_grams_param;
+//main webserver handler, accepts new connections into the pool and services every open one
+//returns true if any client is connected
+bool webserver_handle_client() {
+  unsigned long now = millis();
+
+  //take new connections while there are free slots, the rest wait in the listen backlog
+  for (int i = 0; i < WEB_MAX_CONNECTIONS; i++) {
+    if (conns[i].in_use) continue;
+    WiFiClient client = webserver_accept();
+    if (!client) break;
+    client.setNoDelay(true);
+    conns[i].client = client;
+    conns[i].in_use = true;
+    conns[i].last_active = now;
+    http_request_init(&conns[i].req);
+  }
+
+  bool connected = web_pump_export();
+  for (int i = 0; i < WEB_MAX_CONNECTIONS; i++) {
+    if (!conns[i].in_use) continue;
+    webserver_service(conns[i], now);
+    if (conns[i].in_use) connected = true;
+  }
+  return connected;
+}
+
+static void webserver_watch(int fd, fd_set *set, int *max_fd) {
+  if (fd < 0) return;
+  FD_SET(fd, set);
+  if (fd > *max_fd) *max_fd = fd;
+}
+
+//blocks the web task until a socket has something for it or the nearest timeout is due, at most timeout_ms
+//wakes on a new connection while a pool slot is free, request bytes or a hang up on a pooled connection,
+//and room in the export's socket. open streams are fed from other tasks, so they cap the wait at WEB_STREAM_POLL_MS
+void webserver_wait(uint32_t timeout_ms) {
+  fd_set readable, writable;
+  FD_ZERO(&readable);
+  FD_ZERO(&writable);
+  int max_fd = -1;
+  uint32_t wait_ms = timeout_ms;
+  unsigned long now = millis();
+
+  bool slot_free = false;
+  for (int i = 0; i < WEB_MAX_CONNECTIONS; i++) {
+    if (!conns[i].in_use) {
+      slot_free = true;
+      continue;
+    }
+    webserver_watch(conns[i].client.fd(), &readable, &max_fd);
+    //the slot is let go at its read or keep-alive timeout, same limit as webserver_service()
+    unsigned long limit = (conns[i].req.header_bytes > 0) ? HTTP_READ_TIMEOUT_MS : WEB_KEEPALIVE_MS;
+    unsigned long idle = now - conns[i].last_active;
+    unsigned long left = (idle >= limit) ? 0 : limit - idle + 1;
+    if (left < wait_ms) wait_ms = left;
+  }
+  if (slot_free) webserver_watch(listen_fd, &readable, &max_fd);
+  if (export_client) webserver_watch(export_client.fd(), &writable, &max_fd);
+  for (int i = 0; i < WEB_SSE_MAX_CLIENTS; i++) {
+    if (sse_clients[i] && wait_ms > WEB_STREAM_POLL_MS) wait_ms = WEB_STREAM_POLL_MS;
+  }
+  if (wait_ms == 0) return;
+  if (max_fd < 0) {
+    vTaskDelay(pdMS_TO_TICKS(wait_ms));
+    return;
+  }
+
+  struct timeval tv;
+  tv.tv_sec = wait_ms / 1000;
+  tv.tv_usec = (wait_ms % 1000) * 1000;
+  select(max_fd + 1, &readable, &writable, NULL, &tv);
+}
+
+//GETTERS AND SETTERS
+bool get_web_request() {
+  return web_request;
 }
 
-void set_history(Entry entries[]) {
+void set_history(Entry entries[], const uint32_t ids[]) {
   for (int i = 0; i < MAX_ENTRIES; i++) {
       web_entries[i] = entries[i];
+      web_entry_ids[i] = ids[i];
   }
+  history_dirty = true;
 }
 
 void set_web_pin_state(uint8_t state) {
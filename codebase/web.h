@@ -5,13 +5,13 @@
 
 void web_init();
 bool webserver_handle_client();
-void set_goal_grams(float goal_grams_param);
-void set_total_grams(float total_grams_param);
-void set_history(Entry entries[]);
+void webserver_wait(uint32_t timeout_ms);
+void set_history(Entry entries[], const uint32_t ids[]);
 bool get_web_request();
 void set_web_request(bool input);
 void web_enable();
 void web_disable();
-void set_refresh_flag(bool v);
+bool web_push_events();
+void web_session_ended(float total_grams, float goal_grams);
 
 #endif
\ No newline at end of file
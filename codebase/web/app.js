@@ -0,0 +1,168 @@
+// set once the goal is submitted, keeps the overlay hidden until the device reports the session is running
+let submitted = false;
+
+function checkInputs() {
+  const h = document.getElementById('inputHours').value;
+  const m = document.getElementById('inputMinutes').value;
+  const s = document.getElementById('inputSeconds').value;
+  const g = document.getElementById('inputGoal').value;
+
+  const btn = document.getElementById('submitBtn');
+
+  // Enable button only if all fields are non-empty
+  if ((h + m + s) > 0 && g > 0) {
+    btn.disabled = false;
+  } else {
+    btn.disabled = true;
+  }
+}
+
+function submitOverlay() {
+  const hr = parseInt(document.getElementById('inputHours').value) || 0;
+  const min = parseInt(document.getElementById('inputMinutes').value) || 0;
+  const sec = parseInt(document.getElementById('inputSeconds').value) || 0;
+
+  // Convert to total seconds
+  const totalDuration = hr * 3600 + min * 60 + sec;
+
+  const goal = document.getElementById('inputGoal').value;
+  const curve = document.getElementById('inputCurve').value;
+  submitted = true;
+  document.getElementById('overlay').style.display = 'none';
+
+  // the device has no clock of its own, daily totals use this one
+  const now = Math.floor(Date.now() / 1000);
+  const tz = -new Date().getTimezoneOffset();
+  fetch(`/set_goal?duration=${totalDuration}&goal=${goal}&now=${now}&tz=${tz}&curve=${curve}`)
+    .then(r => r.text())
+    .then(d => console.log(d));
+}
+
+// tare or reference weight, the device averages a second of readings so check back once it's done
+function calibrate(query) {
+  const status = document.getElementById('calibrationStatus');
+  fetch('/calibrate?' + query)
+    .then(r => r.ok ? r.json() : r.text().then(t => { throw t; }))
+    .then(() => setTimeout(() => fetch('/calibrate').then(r => r.json()).then(c => {
+      const failed = { no_load: 'Failed: nothing on the plate, old calibration kept',
+                       wrong_sign: 'Failed: read as weight taken off, old calibration kept' };
+      status.textContent = (c.state !== 'idle') ? 'Still measuring' : (failed[c.error] || 'Saved');
+    }), 1500))
+    .catch(e => { status.textContent = e; });
+}
+
+function updateHydrationCircle(percent, amount) {
+  const circle = document.getElementById('hydrationProgress');
+  const text = document.getElementById('hydrationText');
+  // percent between 0 and 100
+  circle.setAttribute('stroke-dasharray', percent + ',100');
+  text.textContent = percent + '%';
+  document.getElementById('hydrationAmount').textContent = amount + ' mL';
+}
+
+// session shown in the chart, 0 is the running one
+let selectedSession = 0;
+
+// draws a /series reply, intake against the ideal intake the pacer implies
+function drawSeries(d) {
+  const pts = d ? d.points : [];
+  let intake = '', pace = '';
+  if (pts.length > 0) {
+    const goal = pts[0][4];
+    const end = pts[pts.length - 1][0] + d.bucket_s;
+    const top = Math.max(goal, pts[pts.length - 1][2], 1);
+    for (const p of pts) {
+      const x = (p[0] / end * 300).toFixed(1);
+      intake += `${x},${(100 - p[2] / top * 100).toFixed(1)} `;
+      pace += `${x},${(100 - (goal - p[3]) / top * 100).toFixed(1)} `;
+    }
+  }
+  document.getElementById('seriesIntake').setAttribute('points', intake);
+  document.getElementById('seriesPace').setAttribute('points', pace);
+}
+
+function loadSeries(session) {
+  selectedSession = session;
+  document.getElementById('seriesTitle').textContent = session ? 'Past Session' : 'This Session';
+  fetch(`/series?session=${session}&points=60`)
+    .then(r => r.ok ? r.json() : null)
+    .then(drawSeries);
+}
+
+// daily/weekly rollups, refreshed whenever the history changes
+function loadStats() {
+  fetch('/stats')
+    .then(r => r.json())
+    .then(s => {
+      const today = s.clock ? `Today: ${s.days[0]} mL · This week: ${s.weeks[0]} mL · ` : '';
+      document.getElementById('statsLine').textContent =
+        `${today}Goals met: ${Math.round(s.goal_hit_rate * 100)}% of ${s.sessions} · ` +
+        `Streak: ${s.streak} days (best ${s.longest_streak}) · Pace: ${s.avg_pace} mL/h`;
+    });
+}
+
+// version of the last /data reply, the device answers 304 or leaves out unchanged history
+let version = -1;
+let pollTimer = null;
+
+// applies a /data body, from the event stream or a poll
+function applyData(d) {
+  version = d.v;
+  // overlay is only up while the device waits for a new session
+  if (!d.waiting) submitted = false;
+  document.getElementById('overlay').style.display = (d.waiting && !submitted) ? 'flex' : 'none';
+  document.getElementById('web_goal_grams').innerHTML = d.web_goal_grams;
+  document.getElementById('web_total_grams').innerHTML = '<b>' + d.web_total_grams + '</b>';
+  // history is only sent when it changed since our version
+  if (d.history) {
+    let cardsHTML = '';
+    for (let i = 0; i < d.history.length; i++) {
+      const bgColor =
+        (d.history[i].d === 0 && d.history[i].g === 0)
+          ? '#ffffff'
+          : (d.history[i].d < d.history[i].g)
+            ? '#ffe6e6'
+            : '#e6ffe6';
+      const click = d.history[i].id ? `onclick='loadSeries(${d.history[i].id})' ` : '';
+      cardsHTML += `<div ${click}style='border:1px solid black;border-radius:10px;padding:12px;margin-bottom:20px;background:${bgColor};cursor:pointer;'>
+        <div><b>Session Length:</b> ${d.history[i].t} s</div>
+        <div><b>Drank:</b> ${d.history[i].d} mL</div>
+        <div><b>Goal:</b> ${d.history[i].g} mL</div>
+      </div>`;
+    }
+    document.getElementById('historyCards').innerHTML = cardsHTML;
+    loadStats();
+  }
+  let pct = Math.round((d.web_total_grams / d.web_goal_grams) * 100);
+  updateHydrationCircle(pct || 0, d.web_total_grams);
+  // the live curve follows the running session
+  if (selectedSession === 0 && !d.waiting) loadSeries(0);
+}
+
+// AJAX update, only used when the event stream is unavailable
+function startPolling() {
+  if (pollTimer) return;
+  pollTimer = setInterval(function () {
+    fetch('/data?since=' + version)
+      .then(r => (r.status === 304) ? null : r.json())
+      .then(d => { if (d) applyData(d); });
+  }, 1000);
+}
+
+// live updates pushed by the device
+if (window.EventSource) {
+  const stream = new EventSource('/events');
+  stream.addEventListener('data', e => applyData(JSON.parse(e.data)));
+  stream.addEventListener('sip', e => console.log('sip', JSON.parse(e.data)));
+  stream.addEventListener('session_end', () => {
+    // ask for the next session's goal straight away
+    submitted = false;
+    document.getElementById('overlay').style.display = 'flex';
+  });
+  // the device turns the stream away when all its slots are taken
+  stream.onerror = () => {
+    if (stream.readyState === EventSource.CLOSED) startPolling();
+  };
+} else {
+  startPolling();
+}
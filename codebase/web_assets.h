@@ -0,0 +1,226 @@
+// generated by tools/build_web_assets.py from web/, do not edit
+#ifndef WEB_ASSETS_H
+#define WEB_ASSETS_H
+
+#include <Arduino.h>
+
+// dashboard page, 10620 bytes minified, 3393 bytes gzipped
+#define WEB_INDEX_ETAG "\"d093214360afcd77\""
+#define WEB_INDEX_GZ_LEN 3393
+static const uint8_t WEB_INDEX_GZ[WEB_INDEX_GZ_LEN] PROGMEM = {
+  0x1f, 0x8b, 0x08, 0x00, 0x00, 0x00, 0x00, 0x00, 0x02, 0x03, 0xd5, 0x5a, 0xe9, 0x72, 0xdb, 0x46,
+  0x12, 0xfe, 0xaf, 0xa7, 0x18, 0xc7, 0xb6, 0x00, 0xd8, 0x22, 0x78, 0x49, 0x8a, 0xcc, 0xcb, 0xe5,
+  0xc8, 0xce, 0xda, 0x5b, 0x72, 0xec, 0x0a, 0x55, 0x5b, 0x95, 0x72, 0xa9, 0x24, 0x10, 0x18, 0x92,
+  0x88, 0x40, 0x00, 0x01, 0x86, 0xa2, 0x68, 0x85, 0xcf, 0xb5, 0xff, 0xf7, 0xc9, 0xf6, 0xeb, 0x99,
+  0x01, 0x08, 0x80, 0xa4, 0xa4, 0x64, 0x8f, 0x24, 0x3a, 0x08, 0x60, 0xa6, 0xbb, 0xa7, 0xaf, 0xe9,
+  0x63, 0xc0, 0xde, 0x93, 0xb7, 0x9f, 0x4e, 0xcf, 0x7f, 0xfa, 0xfc, 0x8e, 0x4d, 0xc5, 0x2c, 0x18,
+  0xf4, 0xf4, 0x27, 0x77, 0xbc, 0x41, 0x6f, 0xc6, 0x85, 0xc3, 0xdc, 0xa9, 0x93, 0xa4, 0x5c, 0xf4,
+  0x8d, 0xb9, 0x18, 0xd7, 0x4e, 0x8c, 0x41, 0x4f, 0xf8, 0x22, 0xe0, 0x83, 0xf7, 0x4b, 0x2f, 0x71,
+  0x84, 0x1f, 0x85, 0xec, 0x63, 0x14, 0xfa, 0x22, 0x4a, 0x7a, 0x75, 0x35, 0xd1, 0x4b, 0xc5, 0x12,
+  0x97, 0xa7, 0xd1, 0x0d, 0x4f, 0x02, 0x67, 0x79, 0x17, 0x47, 0xa9, 0x4f, 0x70, 0x9d, 0xb1, 0x7f,
+  0xcb, 0xbd, 0xae, 0x88, 0xe2, 0x4e, 0xa3, 0x1b, 0xf0, 0xb1, 0xc0, 0x65, 0xe1, 0x7b, 0x62, 0xda,
+  0x69, 0x36, 0x1a, 0xcf, 0xbb, 0x53, 0xee, 0x4f, 0xa6, 0x42, 0xdd, 0x8f, 0x1c, 0xf7, 0x7a, 0x92,
+  0x44, 0xf3, 0xd0, 0xeb, 0x24, 0x93, 0x91, 0x63, 0x36, 0x0e, 0xe4, 0xaf, 0x7d, 0x6c, 0x75, 0x7f,
+  0x9e, 0xa7, 0xc2, 0x1f, 0x2f, 0x6b, 0x6e, 0x14, 0x0a, 0x1e, 0x8a, 0x8e, 0x8b, 0x0f, 0x9e, 0x74,
+  0x9d, 0xc0, 0x9f, 0x84, 0x35, 0x5f, 0xf0, 0x59, 0x9a, 0x0d, 0x7d, 0xad, 0xf9, 0xa1, 0xc7, 0x6f,
+  0x89, 0x62, 0x63, 0x95, 0x71, 0x53, 0x1b, 0x45, 0xb7, 0x77, 0x05, 0xf2, 0x8b, 0x29, 0x70, 0xba,
+  0xb1, 0xe3, 0x79, 0x7e, 0x38, 0xe9, 0x1c, 0x37, 0xe2, 0x5b, 0x76, 0x84, 0x8f, 0xee, 0x28, 0x4a,
+  0x3c, 0x9e, 0xd4, 0x12, 0xc7, 0xf3, 0xe7, 0x69, 0xa7, 0x45, 0x43, 0x82, 0xdf, 0x8a, 0x9a, 0x5c,
+  0x27, 0x5b, 0x61, 0xe6, 0x87, 0x35, 0x25, 0xc1, 0x61, 0x43, 0x21, 0xdd, 0xd6, 0xd2, 0xa9, 0xe3,
+  0x45, 0x8b, 0x4e, 0x83, 0x9d, 0x80, 0x54, 0xeb, 0x08, 0x1f, 0x25, 0x09, 0xda, 0x56, 0x89, 0x15,
+  0x36, 0x6d, 0xdd, 0xcd, 0x9c, 0x64, 0x02, 0x42, 0xa3, 0x48, 0x88, 0x68, 0xd6, 0x69, 0x13, 0xa1,
+  0x31, 0x84, 0xab, 0xa5, 0xfe, 0x57, 0xde, 0x69, 0x1f, 0xe3, 0xd1, 0x8d, 0x82, 0x28, 0xe9, 0x3c,
+  0x6d, 0xb7, 0xdb, 0x65, 0x64, 0xcf, 0xbf, 0xd1, 0xd8, 0x92, 0x43, 0xd6, 0x28, 0x20, 0x4a, 0x96,
+  0x35, 0xe2, 0xe1, 0xe1, 0x61, 0x19, 0xd1, 0x0f, 0xe3, 0xb9, 0xb8, 0xd3, 0xca, 0x3f, 0x21, 0xc8,
+  0x4c, 0x03, 0xcd, 0x56, 0x69, 0x79, 0x49, 0x45, 0x33, 0x28, 0x4d, 0xd6, 0x3c, 0xca, 0x95, 0xd3,
+  0x69, 0x62, 0xc9, 0x34, 0x0a, 0x7c, 0x8f, 0x3d, 0x75, 0x5d, 0xb7, 0xa2, 0x32, 0xf0, 0x5d, 0x5e,
+  0x73, 0x34, 0x87, 0x7c, 0x61, 0x26, 0x2d, 0x79, 0x41, 0xbb, 0xb4, 0x30, 0xa9, 0xaa, 0x7d, 0xb4,
+  0xb9, 0xfa, 0xda, 0x58, 0x35, 0x25, 0x8e, 0x32, 0x99, 0xba, 0x1f, 0x05, 0x98, 0xcd, 0xf8, 0x69,
+  0xe5, 0xfc, 0x14, 0x87, 0x33, 0x86, 0x9a, 0x52, 0x21, 0xf3, 0x24, 0x05, 0x5a, 0x1c, 0xf9, 0x64,
+  0xc0, 0x55, 0xaf, 0xae, 0x7c, 0xb5, 0x57, 0x57, 0xfe, 0x3e, 0x8a, 0xbc, 0x25, 0x93, 0x43, 0x7d,
+  0x43, 0xb2, 0x31, 0x76, 0x66, 0x7e, 0xb0, 0xec, 0xa4, 0x4e, 0x98, 0xd6, 0x52, 0x9e, 0xf8, 0xe3,
+  0x2e, 0xdb, 0x74, 0x03, 0x6c, 0x89, 0x69, 0xb3, 0x84, 0x26, 0xb9, 0x3f, 0x84, 0x07, 0x60, 0x6e,
+  0xcb, 0x3e, 0x99, 0x36, 0x07, 0xbd, 0x78, 0x13, 0x41, 0x72, 0x68, 0x0c, 0x7e, 0x8a, 0xe6, 0x09,
+  0xfb, 0x5b, 0xe4, 0x04, 0xec, 0x7c, 0xea, 0xa7, 0x6c, 0xc8, 0xd3, 0x94, 0xb0, 0x3f, 0xa4, 0xac,
+  0x97, 0xc6, 0x4e, 0xc8, 0x7c, 0xaf, 0x6f, 0x2c, 0xf8, 0xe8, 0x72, 0x02, 0x90, 0xcb, 0x49, 0xe2,
+  0xcc, 0x52, 0x63, 0x50, 0xab, 0x41, 0x14, 0x4c, 0x0e, 0xd8, 0xec, 0xac, 0x57, 0x8f, 0x1f, 0x20,
+  0xcf, 0xde, 0x26, 0x4e, 0x78, 0x5d, 0x21, 0x27, 0x22, 0xb1, 0xa6, 0xd7, 0x1b, 0x49, 0x92, 0xa3,
+  0xc1, 0x9a, 0x6c, 0x89, 0x1b, 0xb9, 0x06, 0xdc, 0x4f, 0x62, 0x6b, 0x2b, 0x1b, 0xd9, 0x92, 0x9e,
+  0x9f, 0xc6, 0x78, 0xee, 0x84, 0x51, 0xc8, 0x49, 0x39, 0x15, 0x38, 0xf2, 0x06, 0x52, 0x59, 0x6b,
+  0x30, 0xe4, 0x22, 0x17, 0x8f, 0x04, 0x86, 0x66, 0x5a, 0x0a, 0x5c, 0x53, 0x2a, 0x38, 0x8b, 0xe4,
+  0x9e, 0x55, 0x7c, 0x83, 0x65, 0x4b, 0x8d, 0x03, 0x8e, 0xa7, 0x2d, 0x41, 0x80, 0x4d, 0x9c, 0x0c,
+  0x77, 0x47, 0xe4, 0x00, 0x2b, 0x81, 0x33, 0xe2, 0xc1, 0xa6, 0xc2, 0x5a, 0x4a, 0x61, 0x6f, 0xe7,
+  0xca, 0x7e, 0x9d, 0x5e, 0x5d, 0x02, 0x0e, 0x7a, 0x72, 0xfb, 0x30, 0xb1, 0x8c, 0x01, 0x1e, 0xce,
+  0x67, 0x23, 0x9e, 0x18, 0x52, 0x40, 0x39, 0xfe, 0x1e, 0xe6, 0x4b, 0x0d, 0x86, 0xd8, 0xd0, 0x37,
+  0x1a, 0xb8, 0x3a, 0xb7, 0x7d, 0xa3, 0x75, 0x68, 0x30, 0x18, 0x9f, 0xa6, 0xfb, 0x86, 0x3b, 0xe5,
+  0xee, 0xf5, 0x07, 0xba, 0x4f, 0x4d, 0x2b, 0x57, 0x9a, 0xda, 0x8c, 0xdf, 0x4a, 0x4e, 0xb5, 0x3f,
+  0x4b, 0xfd, 0xe9, 0x87, 0x2c, 0x3c, 0x54, 0x7d, 0x7c, 0x8b, 0x3b, 0x6e, 0x28, 0x29, 0x9a, 0x8b,
+  0xc0, 0x0f, 0x79, 0x6e, 0x0f, 0x69, 0xf6, 0x5d, 0xd2, 0x4e, 0x13, 0x6d, 0xf2, 0xfb, 0xa5, 0xfc,
+  0xe8, 0x87, 0x73, 0xc1, 0xab, 0x72, 0x1e, 0xbd, 0xfa, 0xcb, 0xc8, 0x09, 0xbe, 0x1f, 0x25, 0xe8,
+  0x90, 0xc3, 0x5f, 0xbc, 0xbf, 0xb0, 0xa0, 0x69, 0x26, 0x66, 0x1d, 0x1b, 0x6b, 0xd7, 0xee, 0xa2,
+  0x44, 0xf5, 0xc7, 0xec, 0x2e, 0x19, 0xe8, 0xcc, 0xd9, 0x99, 0xf5, 0xc8, 0xed, 0x45, 0xf0, 0xda,
+  0x18, 0x48, 0xec, 0x8f, 0xb4, 0x42, 0xb3, 0xf5, 0xff, 0x30, 0xc3, 0x7d, 0x0a, 0xfe, 0xe3, 0xc2,
+  0xd7, 0x67, 0xc7, 0xa5, 0xfc, 0x9a, 0x6b, 0x37, 0xe5, 0x01, 0x77, 0xc5, 0x5a, 0xa1, 0xa7, 0xf3,
+  0xe4, 0x86, 0x1b, 0x3b, 0xd0, 0x7f, 0x93, 0xca, 0xaa, 0xfa, 0x88, 0x62, 0x99, 0xf6, 0x6e, 0x9c,
+  0x60, 0x0e, 0xca, 0x34, 0xe5, 0x24, 0xc6, 0x60, 0x28, 0x90, 0x6a, 0x97, 0xbd, 0xba, 0x9a, 0xad,
+  0x42, 0x8d, 0x13, 0x30, 0x60, 0x0c, 0xbe, 0xa7, 0x4b, 0x2d, 0x88, 0x1c, 0x8f, 0x7b, 0xbb, 0x40,
+  0x67, 0xdc, 0x09, 0x90, 0xaa, 0xde, 0xc8, 0xda, 0x80, 0xc9, 0xa7, 0x5d, 0xa0, 0x2e, 0x74, 0x17,
+  0xcd, 0x8c, 0xc1, 0xa9, 0xbc, 0xae, 0xa1, 0xea, 0x4a, 0x19, 0x99, 0xe9, 0x54, 0x89, 0x22, 0x55,
+  0x93, 0xce, 0x47, 0x33, 0x5f, 0x7c, 0x27, 0x42, 0xf2, 0x30, 0x37, 0xf0, 0xdd, 0xeb, 0x6c, 0xec,
+  0x93, 0xca, 0x62, 0xe4, 0x63, 0x30, 0x9f, 0x33, 0x0a, 0xb8, 0x37, 0x78, 0x47, 0xa6, 0x40, 0xba,
+  0x94, 0xf8, 0x19, 0xb5, 0x12, 0xcd, 0x8c, 0xc8, 0x37, 0x63, 0x2e, 0xdc, 0xa9, 0x69, 0xd4, 0xd3,
+  0x30, 0x8a, 0xbe, 0x72, 0xc3, 0xfa, 0x26, 0xd3, 0x7c, 0x56, 0x08, 0x51, 0xdd, 0xd8, 0x3c, 0x2e,
+  0x7b, 0x8b, 0x7a, 0xde, 0x51, 0x09, 0xb1, 0x8d, 0xf2, 0xe7, 0x69, 0x43, 0xfe, 0xe4, 0x06, 0xcb,
+  0x2a, 0x20, 0xaa, 0xed, 0x58, 0xb9, 0x04, 0x82, 0x9d, 0x86, 0x92, 0x13, 0xf6, 0x26, 0xe0, 0x89,
+  0x48, 0x59, 0xf3, 0x88, 0xc9, 0xd0, 0x98, 0xc9, 0xf2, 0x38, 0x77, 0x56, 0x0c, 0x3e, 0xce, 0x9d,
+  0x4f, 0xee, 0xf7, 0xe6, 0xaa, 0xc2, 0x5c, 0xd0, 0x19, 0x21, 0x03, 0x73, 0xd3, 0x70, 0x5c, 0x32,
+  0x5b, 0x5f, 0x38, 0xc9, 0x9f, 0x42, 0x71, 0xe7, 0xe0, 0x63, 0xad, 0x28, 0x15, 0xb5, 0xf2, 0x6d,
+  0xf5, 0x23, 0x1f, 0xf3, 0x84, 0x87, 0x2e, 0xb6, 0x56, 0x39, 0x92, 0xc9, 0xd0, 0x75, 0x84, 0xc8,
+  0x05, 0x55, 0xb9, 0x7c, 0x1a, 0x05, 0x58, 0xa8, 0x6f, 0xa8, 0xba, 0xab, 0x1c, 0xb5, 0x4e, 0xb6,
+  0x2a, 0xf9, 0x3f, 0xd9, 0x91, 0xf7, 0xe8, 0x56, 0x32, 0xd0, 0x37, 0xd8, 0x4b, 0xe6, 0x45, 0xee,
+  0x7c, 0x06, 0x73, 0xd8, 0x13, 0x2e, 0xde, 0x05, 0x9c, 0x6e, 0xbf, 0x5b, 0x7e, 0xf0, 0xcc, 0xaa,
+  0x5c, 0x96, 0x2d, 0x77, 0xd7, 0x9f, 0xc0, 0x10, 0xa7, 0x99, 0x18, 0x6b, 0x6b, 0xe4, 0xa5, 0x6d,
+  0x26, 0x22, 0x1c, 0x67, 0x28, 0x1c, 0x31, 0xa7, 0xe2, 0xf6, 0xfe, 0x84, 0xa8, 0x7a, 0x29, 0x67,
+  0x2e, 0xa2, 0x2e, 0x53, 0x86, 0x68, 0x83, 0x13, 0x4a, 0xb3, 0x37, 0x13, 0x49, 0x72, 0x9a, 0x55,
+  0xf4, 0xa7, 0x7e, 0xe2, 0x06, 0x30, 0xf0, 0x8d, 0xcf, 0x17, 0xdf, 0x45, 0x28, 0x0b, 0x1a, 0xac,
+  0xc1, 0xda, 0xc7, 0xf8, 0xab, 0x58, 0xb2, 0x2d, 0xdb, 0x43, 0xa6, 0x5b, 0x5c, 0xf5, 0x04, 0x82,
+  0xb1, 0x23, 0xa6, 0x00, 0x4c, 0xa2, 0x6b, 0x40, 0x42, 0x64, 0xc7, 0x19, 0x8f, 0x0d, 0x3d, 0x50,
+  0x8b, 0x62, 0x04, 0x6e, 0xb1, 0x04, 0x51, 0xbb, 0x95, 0x0f, 0x4a, 0x72, 0x7d, 0x03, 0xe5, 0xe4,
+  0xd8, 0x0f, 0x02, 0x38, 0x15, 0x0c, 0x8b, 0x38, 0xd4, 0x37, 0x3e, 0x36, 0x4f, 0x58, 0x8b, 0x39,
+  0xd0, 0x3b, 0xfd, 0x35, 0x58, 0x13, 0xbf, 0xe0, 0x65, 0x73, 0xa8, 0xd6, 0x6e, 0x91, 0x06, 0x68,
+  0x69, 0xcd, 0x40, 0x49, 0xa4, 0xcf, 0x49, 0x34, 0x49, 0x50, 0x92, 0x1b, 0x3b, 0xf9, 0xda, 0xce,
+  0x82, 0x9e, 0x24, 0x6f, 0x73, 0x9d, 0xb8, 0x6f, 0x48, 0x23, 0xe7, 0xc3, 0x9e, 0x83, 0xb6, 0x38,
+  0x49, 0x1c, 0x92, 0xe6, 0x40, 0xa6, 0xed, 0xdf, 0xcd, 0x32, 0xe5, 0xe5, 0x32, 0xcb, 0xe7, 0x18,
+  0x31, 0x18, 0xb4, 0xdf, 0x3c, 0x31, 0x18, 0x56, 0x68, 0x81, 0x7c, 0xee, 0x78, 0x7d, 0x03, 0x83,
+  0x2a, 0x97, 0x87, 0xee, 0x34, 0xc2, 0x4e, 0x9b, 0xf9, 0x9e, 0x47, 0x46, 0x53, 0xdc, 0x93, 0xa3,
+  0x19, 0x83, 0xc6, 0xf3, 0x5e, 0x9d, 0x80, 0xc8, 0x35, 0x6e, 0x26, 0xeb, 0x8e, 0x25, 0x5f, 0xe3,
+  0xcd, 0x0c, 0xf2, 0x88, 0x9d, 0x59, 0x52, 0x3e, 0x2f, 0x94, 0x75, 0x47, 0xd8, 0xd1, 0x5d, 0x56,
+  0x8d, 0x95, 0x58, 0x43, 0xb6, 0x66, 0x85, 0xcc, 0x30, 0x6d, 0xa9, 0x4c, 0x83, 0xb6, 0x92, 0xa7,
+  0xe7, 0x74, 0x74, 0xb2, 0x8d, 0xfe, 0xa1, 0x44, 0x2e, 0xf7, 0x5e, 0xd4, 0x25, 0x65, 0xce, 0xa8,
+  0xd0, 0x4f, 0xa1, 0x5e, 0x51, 0x75, 0xc4, 0x06, 0x14, 0x48, 0xba, 0x8e, 0x61, 0x50, 0x8e, 0x24,
+  0xff, 0x26, 0x8d, 0x91, 0xec, 0x7e, 0x24, 0x81, 0xd6, 0x66, 0x2b, 0xc5, 0x9b, 0xe7, 0xb9, 0x8f,
+  0x36, 0x8f, 0x8a, 0xe9, 0xbf, 0x59, 0x0d, 0x2c, 0x5b, 0x5a, 0x6b, 0xf2, 0xe7, 0x28, 0x58, 0x92,
+  0x07, 0x14, 0x18, 0x43, 0xf5, 0xc1, 0xb7, 0x79, 0x0a, 0x34, 0xff, 0xea, 0xd5, 0xab, 0xaa, 0x53,
+  0x35, 0xb7, 0x79, 0xcc, 0xe1, 0x41, 0x1b, 0x32, 0xd0, 0x66, 0x47, 0x7c, 0x92, 0x8e, 0xa0, 0x97,
+  0xd9, 0xba, 0xe0, 0x87, 0x50, 0x38, 0xd7, 0xbb, 0x96, 0xdc, 0xee, 0xca, 0xad, 0x5d, 0xe4, 0xd7,
+  0xce, 0xb0, 0x99, 0x01, 0xdb, 0x5a, 0xe6, 0xdc, 0x96, 0x1b, 0xa6, 0x93, 0x47, 0x37, 0xba, 0x9d,
+  0xff, 0xec, 0xa4, 0x82, 0x7d, 0x9b, 0x59, 0x30, 0x55, 0x26, 0x8c, 0x15, 0xdb, 0x88, 0x4a, 0xe9,
+  0x99, 0x1f, 0x6e, 0xb3, 0x7e, 0xf3, 0x58, 0x2f, 0x52, 0xe8, 0xb6, 0xe1, 0x09, 0x22, 0x4a, 0x96,
+  0xa7, 0x4e, 0xe2, 0xa5, 0xdb, 0x0c, 0xb8, 0x11, 0xc4, 0x8c, 0x87, 0x4a, 0x11, 0x95, 0x56, 0xb7,
+  0x64, 0x54, 0x75, 0x26, 0x53, 0xc9, 0x42, 0xea, 0xf9, 0x7f, 0x14, 0xc9, 0x7f, 0x84, 0xa7, 0x0a,
+  0xf6, 0x5e, 0x89, 0xb8, 0x8e, 0xe6, 0xf1, 0x4e, 0xd5, 0xbc, 0x8d, 0x16, 0x21, 0x95, 0x89, 0x6c,
+  0x3c, 0x0f, 0x02, 0xa6, 0x75, 0xd3, 0x61, 0x3d, 0x87, 0x4d, 0x13, 0x3e, 0xee, 0x1b, 0x75, 0x7e,
+  0x1b, 0x47, 0x89, 0x78, 0x3d, 0x8e, 0x92, 0x99, 0x23, 0xfa, 0x6e, 0x7a, 0x83, 0x74, 0x31, 0xfc,
+  0x47, 0xaf, 0xee, 0x0c, 0xd8, 0xbf, 0xfe, 0xb9, 0x13, 0x2e, 0xf4, 0x7e, 0x4e, 0xa1, 0x92, 0xc1,
+  0x0f, 0x6f, 0xff, 0x3e, 0xfc, 0xf4, 0x03, 0x41, 0x4b, 0x1b, 0xa4, 0x6e, 0xe2, 0xc7, 0x62, 0x10,
+  0x80, 0x47, 0x55, 0x0c, 0x0a, 0xee, 0xb1, 0x3e, 0x1b, 0xa3, 0xf4, 0xe4, 0xdd, 0xbd, 0xf1, 0x3c,
+  0x94, 0x9a, 0x64, 0xa5, 0x56, 0x84, 0xdd, 0xed, 0xa1, 0xc8, 0x81, 0xf9, 0xa7, 0x80, 0xbc, 0x3f,
+  0xb7, 0xaa, 0xa3, 0x03, 0x9d, 0x57, 0xbb, 0x1a, 0x6d, 0xf6, 0x20, 0x5a, 0xd6, 0x8b, 0x57, 0x10,
+  0xd3, 0x07, 0x11, 0xb3, 0xde, 0xb6, 0x82, 0x38, 0x79, 0x10, 0x51, 0x36, 0x61, 0x15, 0xac, 0x91,
+  0x08, 0xef, 0xc3, 0x5b, 0x17, 0xd4, 0x56, 0x77, 0xcf, 0x1f, 0x33, 0xd3, 0x9c, 0xa2, 0xd6, 0x98,
+  0xe1, 0x3f, 0xb5, 0xd8, 0x00, 0xe1, 0x6a, 0x7f, 0x1f, 0x0b, 0xe3, 0x86, 0x14, 0x06, 0x5a, 0x76,
+  0x56, 0x5c, 0xaf, 0xf5, 0xbb, 0x62, 0x1c, 0xd7, 0xcd, 0x69, 0x91, 0x10, 0x17, 0x2b, 0xfc, 0xe6,
+  0x16, 0xa8, 0x94, 0xea, 0x6b, 0x1b, 0x24, 0x80, 0x8f, 0xe9, 0x3c, 0x1b, 0x71, 0xc2, 0xfc, 0x0d,
+  0xd6, 0xb0, 0xd8, 0xaf, 0xbf, 0xb2, 0x46, 0x6e, 0x13, 0x3f, 0x7c, 0x3c, 0x9d, 0x8a, 0x79, 0xca,
+  0x94, 0x52, 0xee, 0x3e, 0x9e, 0x52, 0xc5, 0x5e, 0x65, 0x4a, 0xf2, 0xfc, 0x2e, 0x3b, 0xab, 0x02,
+  0x4d, 0x88, 0xfa, 0x02, 0x95, 0x08, 0x92, 0xc0, 0x4b, 0xc9, 0xef, 0x0b, 0x76, 0x4c, 0xb7, 0x58,
+  0x30, 0xb7, 0x33, 0xb5, 0xde, 0xbf, 0xc7, 0xd4, 0x2e, 0xb5, 0x8c, 0x0f, 0x62, 0xaa, 0xc6, 0x32,
+  0x47, 0x2d, 0x6e, 0x18, 0x65, 0xb1, 0x9d, 0xe8, 0xd9, 0x81, 0xa2, 0x65, 0xcb, 0x6d, 0x6f, 0xeb,
+  0xbe, 0x02, 0x88, 0x2a, 0xa0, 0x67, 0x7c, 0x84, 0xd1, 0x02, 0x63, 0x1f, 0x51, 0x17, 0xd8, 0xe3,
+  0x20, 0x8a, 0x12, 0xf3, 0x2d, 0x6a, 0x40, 0x1b, 0xa3, 0xb0, 0x78, 0x9d, 0x72, 0x5f, 0xc3, 0xca,
+  0xb5, 0xf3, 0x15, 0x90, 0xb5, 0x90, 0x2f, 0x18, 0xc1, 0x98, 0x16, 0xad, 0x79, 0xee, 0xcf, 0xf8,
+  0x57, 0xd0, 0xfb, 0x34, 0x1e, 0x23, 0xea, 0x98, 0x80, 0x55, 0x11, 0xf1, 0x0a, 0x6d, 0xa1, 0x90,
+  0xc7, 0xab, 0xaf, 0x3d, 0xad, 0xcf, 0xfe, 0xb3, 0xbb, 0x92, 0x7e, 0x57, 0xfb, 0x34, 0x8d, 0x51,
+  0xba, 0xac, 0xf6, 0xb1, 0x24, 0xee, 0xf1, 0xb9, 0xda, 0x17, 0x5f, 0x09, 0xf6, 0xeb, 0x6a, 0x5f,
+  0x2a, 0x09, 0xf7, 0xf2, 0xba, 0xba, 0xb2, 0xf6, 0x6c, 0x31, 0xe5, 0xa1, 0x09, 0x07, 0x1c, 0xb0,
+  0xc4, 0xa6, 0x6a, 0xc3, 0xb4, 0xb2, 0x41, 0x8f, 0x06, 0x89, 0xd1, 0x08, 0xd2, 0x06, 0xd1, 0xc4,
+  0xf4, 0x2c, 0xab, 0x5b, 0xf4, 0xe7, 0x75, 0xa1, 0xfe, 0xcb, 0x9c, 0x27, 0xcb, 0xb5, 0x43, 0xa7,
+  0xb2, 0xa6, 0xbd, 0xcf, 0x16, 0x9b, 0x05, 0x70, 0x2e, 0xa8, 0x51, 0xcf, 0xe9, 0xbe, 0xa6, 0xca,
+  0x5f, 0xd1, 0x2e, 0x33, 0x1a, 0x5d, 0xb3, 0xd7, 0xb8, 0x50, 0x38, 0x84, 0x56, 0x3b, 0x39, 0xeb,
+  0x0a, 0x48, 0x10, 0xd0, 0x1d, 0x13, 0xd3, 0x04, 0xa6, 0x10, 0x5d, 0xb6, 0xca, 0x45, 0x02, 0x30,
+  0xa6, 0x52, 0xa5, 0x65, 0xf4, 0x21, 0x7a, 0x60, 0x63, 0x61, 0xc3, 0x2a, 0x2d, 0xa7, 0xd6, 0xd1,
+  0x63, 0xae, 0xa4, 0xae, 0x25, 0x1d, 0x3b, 0xbe, 0xda, 0xee, 0x77, 0xb0, 0xfb, 0x25, 0xc5, 0xfc,
+  0x0e, 0x33, 0xbe, 0x97, 0x83, 0x1d, 0x8c, 0x88, 0x29, 0x32, 0x16, 0x72, 0x1b, 0x78, 0xe1, 0xd4,
+  0x5a, 0x09, 0x7e, 0xc0, 0x50, 0x89, 0xb1, 0x82, 0xf8, 0xec, 0x9a, 0xc7, 0xc2, 0x38, 0xd8, 0x5b,
+  0x24, 0x51, 0x38, 0xb9, 0x4c, 0xe9, 0x68, 0x67, 0x4d, 0x21, 0xe1, 0x48, 0x22, 0x4e, 0xca, 0x54,
+  0x15, 0xc7, 0xa8, 0x88, 0x40, 0xaa, 0x1c, 0x8f, 0x77, 0x50, 0x61, 0x2b, 0x78, 0xb4, 0x54, 0xa7,
+  0xd4, 0xc7, 0xa9, 0x6a, 0x63, 0xc1, 0x9d, 0xe9, 0xda, 0x34, 0xce, 0xd9, 0x93, 0x3e, 0xdc, 0xd5,
+  0xa7, 0x52, 0xd3, 0x82, 0x06, 0x8d, 0xa1, 0x40, 0x41, 0x42, 0xa7, 0x14, 0xe9, 0x3c, 0x01, 0xa7,
+  0x06, 0x54, 0x69, 0x2a, 0x91, 0xbe, 0xb8, 0x36, 0x4f, 0x92, 0x28, 0xb9, 0xa0, 0xed, 0x6c, 0x0c,
+  0x9d, 0x1b, 0xee, 0x91, 0x89, 0x56, 0xd6, 0x01, 0x9a, 0x71, 0xb8, 0x30, 0x34, 0xea, 0x3a, 0xa4,
+  0x35, 0xae, 0x94, 0xbd, 0x75, 0x59, 0x4e, 0xba, 0x2f, 0xb9, 0xcc, 0x3c, 0xf6, 0xc0, 0xc6, 0xfb,
+  0x72, 0xaf, 0x62, 0xc6, 0x3c, 0xa1, 0x56, 0xfb, 0x80, 0x39, 0xb2, 0xa2, 0x5d, 0x3b, 0x92, 0x2b,
+  0xe7, 0xef, 0x73, 0xa4, 0xcd, 0x1e, 0x61, 0xbd, 0xbb, 0xa8, 0x28, 0x7f, 0x0c, 0xaa, 0xac, 0xd5,
+  0x09, 0x4d, 0xae, 0x66, 0xc3, 0x3d, 0xde, 0x08, 0x91, 0xf8, 0xc8, 0xf3, 0x68, 0x41, 0xab, 0xa5,
+  0x9f, 0x71, 0xc0, 0x34, 0xbb, 0xf0, 0x4d, 0x43, 0xf6, 0x0d, 0x40, 0xa5, 0xb5, 0x2a, 0xc2, 0x17,
+  0xa0, 0x9e, 0x1b, 0xf7, 0xc4, 0x95, 0x6a, 0x39, 0x6f, 0x55, 0xe8, 0x28, 0x9d, 0x10, 0x19, 0xd4,
+  0xea, 0x06, 0x69, 0x53, 0x66, 0x7a, 0x79, 0x46, 0xc4, 0xbd, 0xec, 0x4d, 0x45, 0x9f, 0x62, 0x6e,
+  0xae, 0x66, 0x50, 0x5c, 0x0c, 0x65, 0xe5, 0x89, 0x4d, 0x9b, 0x6b, 0x33, 0x16, 0x72, 0x4f, 0xc2,
+  0xf0, 0x9e, 0xad, 0x6a, 0x4b, 0xd8, 0xfb, 0xcb, 0x45, 0x57, 0x12, 0xf4, 0x65, 0x89, 0x4a, 0xd1,
+  0x8c, 0x24, 0x44, 0x81, 0x2c, 0x6f, 0x55, 0x56, 0x04, 0xa2, 0x1d, 0xf0, 0x70, 0x82, 0xbe, 0x4c,
+  0xe7, 0xc2, 0x52, 0xac, 0xc6, 0xf4, 0x97, 0xc6, 0xc5, 0x97, 0xc3, 0x8b, 0x4c, 0xf3, 0x3c, 0xf4,
+  0xf4, 0x70, 0x01, 0xb3, 0xc6, 0x9a, 0x17, 0x00, 0xa3, 0x5e, 0xde, 0x1e, 0xcd, 0xdd, 0x6b, 0x44,
+  0xb3, 0x74, 0x9d, 0x26, 0xe2, 0x2c, 0x66, 0xce, 0x9c, 0x5b, 0x93, 0xe8, 0x1e, 0x6c, 0xc5, 0x6f,
+  0x5d, 0xc0, 0xff, 0x28, 0x54, 0x44, 0x09, 0x9c, 0x5a, 0x49, 0x85, 0x0d, 0x41, 0xb0, 0x6b, 0xb6,
+  0x6e, 0xc9, 0xe3, 0x63, 0x5a, 0xab, 0x2e, 0x59, 0x79, 0x41, 0x5d, 0x07, 0xd4, 0x1a, 0x7d, 0x4f,
+  0xef, 0x7a, 0x4d, 0xc2, 0xd7, 0xd2, 0xbe, 0xec, 0xb3, 0xab, 0x67, 0x77, 0xb7, 0xab, 0x83, 0x67,
+  0x77, 0x26, 0x2c, 0x89, 0x35, 0x62, 0x2c, 0x01, 0x34, 0x62, 0xe8, 0x05, 0x05, 0xeb, 0x22, 0xda,
+  0x8a, 0x5d, 0x75, 0xf7, 0xa4, 0x6a, 0x36, 0xf1, 0x24, 0xcf, 0x12, 0xbf, 0x7d, 0x61, 0xdd, 0x4b,
+  0x80, 0x4a, 0x82, 0xdd, 0x05, 0x49, 0xb1, 0x5d, 0xb0, 0x2a, 0xae, 0xa8, 0x6c, 0x06, 0xf3, 0x28,
+  0xee, 0xad, 0xee, 0x43, 0x74, 0x64, 0x9f, 0xb3, 0x93, 0x0a, 0x49, 0x52, 0xde, 0x9d, 0x14, 0xbf,
+  0xb4, 0xdb, 0xa4, 0xca, 0xaf, 0x48, 0xa9, 0x9b, 0xae, 0xa6, 0x27, 0x1f, 0x5c, 0x5f, 0xf5, 0x8f,
+  0x55, 0x87, 0xd6, 0xd8, 0x14, 0x7f, 0x64, 0x07, 0xa2, 0xe9, 0x52, 0xf0, 0x31, 0x8a, 0x2d, 0xa5,
+  0x51, 0x4c, 0x7d, 0x44, 0xee, 0xb5, 0xc6, 0x44, 0xfe, 0xd2, 0x77, 0xab, 0x7d, 0xdd, 0x23, 0x1d,
+  0x37, 0xae, 0x1e, 0x48, 0x11, 0x21, 0x4a, 0xf1, 0x3c, 0xb3, 0xe5, 0xdb, 0x63, 0x8b, 0xfc, 0xd4,
+  0xf9, 0xc8, 0xe2, 0x2c, 0x3f, 0x14, 0xa5, 0x11, 0xa3, 0x42, 0x5e, 0xa7, 0x04, 0x3d, 0x98, 0x16,
+  0x73, 0x82, 0x88, 0x3c, 0x59, 0x16, 0xa4, 0xb6, 0x1b, 0x44, 0x2e, 0xb1, 0x71, 0x75, 0x4e, 0x43,
+  0x1d, 0x06, 0xbe, 0x6d, 0xdc, 0xd0, 0x6e, 0x59, 0xd1, 0xcb, 0x4b, 0xd4, 0xfa, 0x52, 0xe0, 0x05,
+  0xe7, 0xd7, 0x6a, 0x96, 0xee, 0x8a, 0xd3, 0x57, 0xa4, 0x94, 0xfb, 0xa2, 0xc7, 0xba, 0x51, 0xab,
+  0xa8, 0x79, 0xef, 0x8a, 0xaa, 0x03, 0xac, 0xb6, 0xa2, 0x62, 0x29, 0x45, 0x90, 0x17, 0xb4, 0x84,
+  0xdc, 0x63, 0xb2, 0x45, 0x32, 0x53, 0x5b, 0xbe, 0xac, 0x45, 0x8b, 0x74, 0x49, 0x39, 0x4f, 0xbb,
+  0xeb, 0xea, 0x39, 0xed, 0x27, 0xe2, 0x45, 0xeb, 0x38, 0x5d, 0x29, 0x46, 0x5e, 0xee, 0x5d, 0x0d,
+  0x05, 0x12, 0x92, 0xe6, 0x34, 0x95, 0xf7, 0x2b, 0x46, 0xf2, 0x30, 0x73, 0xc4, 0x21, 0x38, 0x0d,
+  0x07, 0xc8, 0x62, 0xb8, 0xbf, 0xd4, 0xd3, 0x16, 0xe1, 0x92, 0x1b, 0x2a, 0x24, 0xe7, 0x66, 0x72,
+  0x49, 0x6e, 0x47, 0xe2, 0xd5, 0xa7, 0xb4, 0x19, 0xac, 0x2c, 0xa0, 0xa1, 0xba, 0xd2, 0xde, 0x55,
+  0x6b, 0xaa, 0x88, 0x84, 0x96, 0x37, 0xa0, 0x3c, 0x4d, 0xd5, 0x31, 0x59, 0xaf, 0x10, 0xdf, 0x9c,
+  0x38, 0x0e, 0x96, 0xa8, 0x99, 0x1c, 0x15, 0xde, 0xd6, 0xb8, 0x9e, 0x7d, 0xa3, 0x42, 0xd6, 0x13,
+  0xcf, 0x5e, 0x38, 0xbe, 0x40, 0x52, 0xb3, 0xb6, 0x75, 0x45, 0xbf, 0xa3, 0xca, 0x33, 0x73, 0x8a,
+  0xd4, 0x15, 0x3c, 0xc9, 0x89, 0xca, 0x44, 0x4a, 0x87, 0xcb, 0xd2, 0x81, 0x75, 0x29, 0xb8, 0x93,
+  0x7e, 0xe5, 0x1d, 0xb9, 0x65, 0xfb, 0x61, 0xc8, 0x93, 0xf7, 0xe7, 0x1f, 0xcf, 0x24, 0xf7, 0xe5,
+  0xe9, 0x07, 0xe8, 0x14, 0x5f, 0x8e, 0x97, 0x09, 0x19, 0xbd, 0xd1, 0x40, 0x9e, 0x9a, 0xda, 0x15,
+  0x38, 0x4a, 0x23, 0xf4, 0x06, 0x5d, 0x07, 0x76, 0xcf, 0xd6, 0xcd, 0x29, 0x69, 0x91, 0x74, 0xee,
+  0x52, 0x03, 0x9f, 0x11, 0x31, 0x74, 0x9c, 0x95, 0xe9, 0x41, 0x66, 0x18, 0x5c, 0x7a, 0x2c, 0x47,
+  0xd2, 0x91, 0x19, 0xa3, 0x2f, 0x5f, 0xae, 0xa3, 0xef, 0x68, 0x72, 0x4a, 0xbd, 0x37, 0x3c, 0x70,
+  0x4d, 0xfe, 0x8b, 0x7f, 0x61, 0x43, 0xfb, 0x28, 0x3e, 0x64, 0x4b, 0x55, 0x1a, 0x9f, 0xa8, 0x71,
+  0x6b, 0x0f, 0x6a, 0x7c, 0x3a, 0x96, 0x3f, 0xc6, 0x5e, 0x87, 0x55, 0x91, 0x7b, 0x15, 0xac, 0x0c,
+  0x9e, 0x1f, 0xf3, 0x63, 0x82, 0x37, 0x9e, 0xf2, 0x63, 0x7a, 0xca, 0xeb, 0x70, 0x79, 0x9e, 0x20,
+  0x95, 0x5a, 0x40, 0xf3, 0x29, 0xfb, 0x5d, 0xe5, 0x2f, 0x4f, 0x0a, 0x01, 0xef, 0xd9, 0x5d, 0x05,
+  0x70, 0x65, 0x19, 0xf9, 0xf6, 0x5b, 0xab, 0x85, 0x22, 0xbf, 0x3c, 0xf5, 0x40, 0x0d, 0x4d, 0x34,
+  0x56, 0xfa, 0x0c, 0x60, 0xc7, 0x99, 0xd4, 0x96, 0x23, 0xa9, 0xd2, 0x97, 0x5a, 0xca, 0x5f, 0xb3,
+  0xa9, 0x7c, 0xb5, 0xa4, 0xf3, 0xec, 0x4e, 0x2b, 0x73, 0xd5, 0xdd, 0x38, 0x94, 0xd8, 0xeb, 0xa9,
+  0xe3, 0x93, 0x41, 0x16, 0x96, 0xcf, 0xa4, 0x31, 0x3a, 0x64, 0x5d, 0x56, 0x11, 0x46, 0xac, 0x58,
+  0xaa, 0x8e, 0x5b, 0x72, 0x2c, 0xf9, 0x65, 0x8b, 0xad, 0xc0, 0xde, 0x2a, 0x3f, 0x13, 0xcc, 0xa1,
+  0x29, 0x84, 0x6c, 0x05, 0x9e, 0x14, 0x81, 0xe5, 0x45, 0x66, 0xb8, 0xdd, 0xc5, 0x4e, 0xf1, 0x9c,
+  0xa8, 0xec, 0xb3, 0xb9, 0x8e, 0xb1, 0xfb, 0xd7, 0x71, 0x38, 0x0b, 0x0f, 0xb1, 0x2b, 0xb2, 0x0a,
+  0x41, 0x45, 0x2f, 0x73, 0xd3, 0xb7, 0xeb, 0x1b, 0x1b, 0xc8, 0xd2, 0x41, 0xad, 0xbb, 0xb7, 0xa3,
+  0xf0, 0x04, 0x55, 0x6a, 0x57, 0x0f, 0x36, 0x77, 0x8a, 0x3e, 0x10, 0xd8, 0x48, 0x7e, 0x99, 0x0f,
+  0x17, 0x03, 0x4c, 0xc1, 0x8d, 0x1a, 0xe5, 0x8c, 0x82, 0xf0, 0x9c, 0x88, 0xcf, 0x08, 0x64, 0x80,
+  0x93, 0x49, 0x45, 0x96, 0x53, 0x59, 0x60, 0xb3, 0x50, 0xe0, 0x8b, 0x79, 0x82, 0x44, 0x5a, 0x8c,
+  0x75, 0x48, 0xd7, 0x1f, 0xc8, 0xc8, 0x68, 0x51, 0xcd, 0x9c, 0x50, 0x29, 0x23, 0x41, 0x14, 0xe7,
+  0x75, 0xea, 0x87, 0x2e, 0x97, 0xef, 0x46, 0x74, 0xf8, 0x2b, 0x65, 0x28, 0x33, 0xb1, 0xb3, 0x2e,
+  0x0c, 0x1c, 0xb7, 0x1b, 0x87, 0x14, 0xa6, 0x28, 0x8a, 0xca, 0x6e, 0xa9, 0x9c, 0xbd, 0x3c, 0x55,
+  0xc2, 0xcb, 0x80, 0x60, 0x95, 0x62, 0xab, 0xae, 0xdf, 0x0f, 0xb2, 0xb6, 0x75, 0x25, 0xf9, 0x5f,
+  0xf8, 0xa1, 0x17, 0x2d, 0xec, 0x77, 0x37, 0x30, 0xeb, 0x30, 0x9a, 0xa3, 0xcc, 0x2d, 0xb6, 0x7e,
+  0x88, 0xfb, 0x74, 0x3a, 0x44, 0x5d, 0x6d, 0x01, 0x02, 0x5c, 0x73, 0x7a, 0x92, 0xf5, 0xb9, 0x02,
+  0xb2, 0xb1, 0x11, 0x24, 0xc4, 0x19, 0x9c, 0x82, 0xc3, 0x11, 0x4c, 0x83, 0x04, 0x43, 0x65, 0x22,
+  0x7b, 0x8a, 0x35, 0x1f, 0x74, 0xda, 0x65, 0xcb, 0xd3, 0x08, 0x13, 0x01, 0x19, 0x23, 0x96, 0x75,
+  0x1f, 0x91, 0xd4, 0x8f, 0x33, 0x1a, 0xc5, 0xee, 0x55, 0x8f, 0xff, 0x56, 0x62, 0xca, 0xee, 0x97,
+  0xa8, 0x23, 0x81, 0xac, 0xda, 0xc5, 0xbb, 0xbd, 0xff, 0x4e, 0x46, 0x51, 0x59, 0x43, 0x25, 0x41,
+  0xcd, 0x00, 0xb2, 0x07, 0x75, 0x5d, 0x94, 0x6e, 0xf4, 0x52, 0xd2, 0x09, 0xd5, 0x24, 0x75, 0x83,
+  0xcb, 0xa1, 0xec, 0xe3, 0xc8, 0xa8, 0x05, 0xed, 0xda, 0xa7, 0x67, 0x9f, 0x86, 0xef, 0xde, 0x5a,
+  0x15, 0x7f, 0x03, 0xe9, 0xc2, 0x01, 0xd5, 0xc6, 0x5c, 0xaf, 0xae, 0x8f, 0x0e, 0xb1, 0xb3, 0x23,
+  0x6f, 0x49, 0x5f, 0x38, 0xa3, 0xaf, 0x59, 0xfe, 0x1b, 0xed, 0xa1, 0x54, 0x53, 0x7c, 0x29, 0x00,
+  0x00,
+};
+
+#endif // WEB_ASSETS_H